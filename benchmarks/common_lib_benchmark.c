@@ -0,0 +1,960 @@
+/**
+ * @file    common_lib_benchmark.c
+ * @brief   Host benchmarks for common_lib, reporting ns/op and throughput so regressions are visible before flashing a board.
+ * @details Built with -DRP2040_PERIPHERALS_HOST_BUILD=ON. Absolute numbers are for the host CPU, compare runs against each other.
+ *          The SPSC and MPMC buffers are also shared between threads, checking every element arrives exactly once (and in
+ *          order for SPSC); a mismatch there or in the framing round trips makes the run exit non-zero.
+ *          Usage: common_lib_benchmark [iterations]
+ */
+
+#define _POSIX_C_SOURCE 199309L
+
+#include <pthread.h>
+#include <sched.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#include "circular_buffer.h"
+#include "circular_buffer_typed.h"
+#include "circular_buffer_mpmc.h"
+#include "vector_lib.h"
+#include "timestamped_buffer.h"
+#include "edf.h"
+#include "telemetry_frame.h"
+#include "telemetry_batch.h"
+
+#define BENCHMARK_DEFAULT_ITERATIONS    1000000u
+#define BENCHMARK_BULK_CHUNK            32u
+#define BENCHMARK_MAX_ELEMENT_SIZE      64u
+#define BENCHMARK_MAX_EDF_TASKS         127u
+#define BENCHMARK_SAMPLE_PERIOD_US      1000u
+#define BENCHMARK_MPMC_CAPACITY         256u
+#define BENCHMARK_MAX_MPMC_THREADS      4u
+#define BENCHMARK_MAX_FRAME_PAYLOAD     600u
+#define BENCHMARK_BATCH_SAMPLES         1000u
+#define BENCHMARK_BATCH_SIZE            16u
+
+// Typed circular buffers matching some of the type-erased configurations
+typedef struct {
+    uint8_t bytes[BENCHMARK_MAX_ELEMENT_SIZE];
+} benchmark_element_64_t;
+
+CIRCULAR_BUFFER_TYPED_DEFINE(benchmark_typed_u8, uint8_t, 256)
+CIRCULAR_BUFFER_TYPED_DEFINE(benchmark_typed_u32, uint32_t, 256)
+CIRCULAR_BUFFER_TYPED_DEFINE(benchmark_typed_64, benchmark_element_64_t, 256)
+
+// Written to after each benchmark so the compiler can't optimize the measured work away
+static volatile uint32_t benchmark_sink;
+
+// Get the host's monotonic time in nanoseconds
+static uint64_t now_ns(void) {
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (uint64_t)now.tv_sec * 1000000000u + (uint64_t)now.tv_nsec;
+}
+
+// Print a benchmark result as ns/op, ops/s and, when bytes were moved, MB/s
+static void report(const char * name, const char * config, uint64_t ops, uint64_t bytes, uint64_t elapsed_ns) {
+    double ns_per_op = (double)elapsed_ns / (double)ops;
+    double mops_per_s = (double)ops * 1.0e3 / (double)elapsed_ns;
+
+    if(bytes > 0) {
+        double mb_per_s = (double)bytes * 1.0e3 / (double)elapsed_ns;
+        printf("%-24s %-22s %10.2f ns/op %10.2f Mops/s %10.2f MB/s\n", name, config, ns_per_op, mops_per_s, mb_per_s);
+    }
+    else {
+        printf("%-24s %-22s %10.2f ns/op %10.2f Mops/s\n", name, config, ns_per_op, mops_per_s);
+    }
+}
+
+// Initialize a type-erased circular buffer in the requested mode
+static void init_circular_buffer(circular_buffer_t * circular_buffer, circular_buffer_mode_t mode, void * storage, uint16_t capacity, uint8_t element_size) {
+    if(mode == CIRCULAR_BUFFER_MODE_SPSC) {
+        circular_buffer_init_spsc(circular_buffer, storage, capacity, element_size);
+    }
+    else {
+        circular_buffer_init(circular_buffer, storage, capacity, element_size);
+    }
+}
+
+// Benchmark single-element push followed by pop, with the buffer kept half full
+static void benchmark_push_pop(circular_buffer_mode_t mode, uint8_t element_size, uint16_t capacity, uint32_t iterations) {
+    void * storage = calloc(capacity, element_size);
+    uint8_t element[BENCHMARK_MAX_ELEMENT_SIZE] = {0};
+    circular_buffer_t circular_buffer;
+    init_circular_buffer(&circular_buffer, mode, storage, capacity, element_size);
+
+    for(uint16_t i = 0; i < capacity / 2; i++) {
+        circular_buffer_push(&circular_buffer, element, element_size);
+    }
+
+    uint64_t start = now_ns();
+    for(uint32_t i = 0; i < iterations; i++) {
+        element[0] = (uint8_t)i;
+        circular_buffer_push(&circular_buffer, element, element_size);
+        circular_buffer_pop(&circular_buffer, element, element_size);
+    }
+    uint64_t elapsed = now_ns() - start;
+    benchmark_sink = element[0];
+
+    char config[32];
+    snprintf(config, sizeof(config), "%s size=%u cap=%u", (mode == CIRCULAR_BUFFER_MODE_SPSC) ? "spsc" : "default", element_size, capacity);
+    report("push+pop", config, 2ull * iterations, 2ull * iterations * element_size, elapsed);
+
+    free(storage);
+}
+
+// Benchmark push_n followed by pop_n of a fixed chunk, with the buffer kept half full
+static void benchmark_push_n_pop_n(circular_buffer_mode_t mode, uint8_t element_size, uint16_t capacity, uint32_t iterations) {
+    void * storage = calloc(capacity, element_size);
+    uint8_t * chunk = calloc(BENCHMARK_BULK_CHUNK, element_size);
+    circular_buffer_t circular_buffer;
+    init_circular_buffer(&circular_buffer, mode, storage, capacity, element_size);
+
+    uint16_t transferred;
+    for(uint16_t i = 0; i < capacity / 2; i += BENCHMARK_BULK_CHUNK) {
+        circular_buffer_push_n(&circular_buffer, chunk, BENCHMARK_BULK_CHUNK, &transferred);
+    }
+
+    uint64_t elements = 0;
+    uint64_t start = now_ns();
+    for(uint32_t i = 0; i < iterations; i++) {
+        chunk[0] = (uint8_t)i;
+        circular_buffer_push_n(&circular_buffer, chunk, BENCHMARK_BULK_CHUNK, &transferred);
+        elements += transferred;
+        circular_buffer_pop_n(&circular_buffer, chunk, BENCHMARK_BULK_CHUNK, &transferred);
+        elements += transferred;
+    }
+    uint64_t elapsed = now_ns() - start;
+    benchmark_sink = chunk[0];
+
+    char config[32];
+    snprintf(config, sizeof(config), "%s size=%u cap=%u", (mode == CIRCULAR_BUFFER_MODE_SPSC) ? "spsc" : "default", element_size, capacity);
+    report("push_n+pop_n (x32)", config, 2ull * iterations, elements * element_size, elapsed);
+
+    free(chunk);
+    free(storage);
+}
+
+// Benchmark get_size on a buffer in a wrapped state
+static void benchmark_get_size(circular_buffer_mode_t mode, uint16_t capacity, uint32_t iterations) {
+    uint8_t * storage = calloc(capacity, 1);
+    uint8_t * scratch = calloc(capacity, 1);
+    circular_buffer_t circular_buffer;
+    init_circular_buffer(&circular_buffer, mode, storage, capacity, 1);
+
+    // Move head past the end of the byte array so the wraparound branch is taken
+    uint16_t transferred;
+    circular_buffer_push_n(&circular_buffer, scratch, capacity - 1, &transferred);
+    circular_buffer_pop_n(&circular_buffer, scratch, capacity - 1, &transferred);
+    circular_buffer_push_n(&circular_buffer, scratch, capacity / 2, &transferred);
+
+    uint32_t sum = 0;
+    uint64_t start = now_ns();
+    for(uint32_t i = 0; i < iterations; i++) {
+        sum += circular_buffer_get_size(&circular_buffer);
+    }
+    uint64_t elapsed = now_ns() - start;
+    benchmark_sink = sum;
+
+    char config[32];
+    snprintf(config, sizeof(config), "%s cap=%u", (mode == CIRCULAR_BUFFER_MODE_SPSC) ? "spsc" : "default", capacity);
+    report("get_size", config, iterations, 0, elapsed);
+
+    free(scratch);
+    free(storage);
+}
+
+// Benchmark the typed circular buffers against the type-erased push+pop results
+static void benchmark_typed_push_pop(uint32_t iterations) {
+    static benchmark_typed_u8_t buffer_u8;
+    static benchmark_typed_u32_t buffer_u32;
+    static benchmark_typed_64_t buffer_64;
+    benchmark_typed_u8_init(&buffer_u8);
+    benchmark_typed_u32_init(&buffer_u32);
+    benchmark_typed_64_init(&buffer_64);
+
+    uint8_t element_u8 = 0;
+    uint64_t start = now_ns();
+    for(uint32_t i = 0; i < iterations; i++) {
+        element_u8 = (uint8_t)i;
+        benchmark_typed_u8_push(&buffer_u8, &element_u8);
+        benchmark_typed_u8_pop(&buffer_u8, &element_u8);
+    }
+    uint64_t elapsed = now_ns() - start;
+    benchmark_sink = element_u8;
+    report("typed push+pop", "size=1 cap=256", 2ull * iterations, 2ull * iterations, elapsed);
+
+    uint32_t element_u32 = 0;
+    start = now_ns();
+    for(uint32_t i = 0; i < iterations; i++) {
+        element_u32 = i;
+        benchmark_typed_u32_push(&buffer_u32, &element_u32);
+        benchmark_typed_u32_pop(&buffer_u32, &element_u32);
+    }
+    elapsed = now_ns() - start;
+    benchmark_sink = element_u32;
+    report("typed push+pop", "size=4 cap=256", 2ull * iterations, 8ull * iterations, elapsed);
+
+    benchmark_element_64_t element_64 = {0};
+    start = now_ns();
+    for(uint32_t i = 0; i < iterations; i++) {
+        element_64.bytes[0] = (uint8_t)i;
+        benchmark_typed_64_push(&buffer_64, &element_64);
+        benchmark_typed_64_pop(&buffer_64, &element_64);
+    }
+    elapsed = now_ns() - start;
+    benchmark_sink = element_64.bytes[0];
+    report("typed push+pop", "size=64 cap=256", 2ull * iterations, 128ull * iterations, elapsed);
+}
+
+// Benchmark the vector_lib set and copy operations
+static void benchmark_vector_lib(uint32_t iterations) {
+    vec_double_t src = {0.0, 0.0, 0.0};
+    vec_double_t dst = {0.0, 0.0, 0.0};
+
+    uint64_t start = now_ns();
+    for(uint32_t i = 0; i < iterations; i++) {
+        set_double_vector(&src, (double)i, 1.0, 2.0);
+        copy_double_vector(&src, &dst);
+    }
+    uint64_t elapsed = now_ns() - start;
+    benchmark_sink = (uint32_t)dst.x;
+    report("vec_double set+copy", "", iterations, iterations * sizeof(vec_double_t), elapsed);
+
+    vec_int16_t src_int16 = {0, 0, 0};
+    vec_int16_t dst_int16 = {0, 0, 0};
+    start = now_ns();
+    for(uint32_t i = 0; i < iterations; i++) {
+        set_int16_vector(&src_int16, (int16_t)i, 1, 2);
+        copy_int16_vector(&src_int16, &dst_int16);
+    }
+    elapsed = now_ns() - start;
+    benchmark_sink = (uint32_t)dst_int16.x;
+    report("vec_int16 set+copy", "", iterations, iterations * sizeof(vec_int16_t), elapsed);
+}
+
+// Check capacity for the timestamped buffer correctness pass, small enough to wrap with a few pushes
+#define CHECK_TIMESTAMPED_CAPACITY 16u
+#define CHECK_TIMESTAMPED_PUSHES   24u
+
+// Helper function that compares an interpolated vector against the expected one, within floating point error
+static bool is_vec_near(const vec_double_t * actual, double x, double y, double z) {
+    const double epsilon = 1e-9;
+    return actual->x - x < epsilon && x - actual->x < epsilon &&
+           actual->y - y < epsilon && y - actual->y < epsilon &&
+           actual->z - z < epsilon && z - actual->z < epsilon;
+}
+
+// Fill a timestamped buffer past capacity so the stored samples wrap around the end of the array, then check find,
+// since and interpolate against the expected samples and that an earlier timestamp is rejected. Returns false on any
+// mismatch
+static bool check_timestamped_buffer(void) {
+    static timestamped_sample_t storage[CHECK_TIMESTAMPED_CAPACITY];
+    timestamped_buffer_t timestamped_buffer;
+    bool is_ok = timestamped_buffer_init(&timestamped_buffer, storage, CHECK_TIMESTAMPED_CAPACITY) == TIMESTAMPED_BUFFER_RC_OK;
+
+    // Sample i is at i ms with value {i, 2i, -i}, only the newest capacity - 1 are kept
+    for(uint32_t i = 0; i < CHECK_TIMESTAMPED_PUSHES; i++) {
+        vec_double_t value = {(double)i, 2.0 * i, -(double)i};
+        is_ok &= timestamped_buffer_push(&timestamped_buffer, (uint64_t)i * BENCHMARK_SAMPLE_PERIOD_US, &value) == TIMESTAMPED_BUFFER_RC_OK;
+    }
+    const uint16_t size = CHECK_TIMESTAMPED_CAPACITY - 1;
+    const uint32_t oldest = CHECK_TIMESTAMPED_PUSHES - size;
+    const uint32_t newest = CHECK_TIMESTAMPED_PUSHES - 1;
+    is_ok &= timestamped_buffer_get_size(&timestamped_buffer) == size;
+
+    timestamped_sample_t latest;
+    is_ok &= timestamped_buffer_get_latest(&timestamped_buffer, &latest) == TIMESTAMPED_BUFFER_RC_OK;
+    is_ok &= latest.timestamp_us == (uint64_t)newest * BENCHMARK_SAMPLE_PERIOD_US && latest.value.x == (double)newest;
+
+    // An earlier timestamp is rejected and leaves the buffer as it was
+    vec_double_t late = {-1.0, -1.0, -1.0};
+    is_ok &= timestamped_buffer_push(&timestamped_buffer, (uint64_t)(newest - 1) * BENCHMARK_SAMPLE_PERIOD_US, &late) ==
+             TIMESTAMPED_BUFFER_RC_OUT_OF_ORDER;
+    is_ok &= timestamped_buffer_get_size(&timestamped_buffer) == size;
+    is_ok &= timestamped_buffer_get_latest(&timestamped_buffer, &latest) == TIMESTAMPED_BUFFER_RC_OK && latest.value.x == (double)newest;
+
+    // Find gives the oldest sample at or after the time: an exact sample, the next one between two samples, the oldest
+    // before the oldest sample and out of range after the newest
+    uint16_t index = UINT16_MAX;
+    is_ok &= timestamped_buffer_find(&timestamped_buffer, (uint64_t)(oldest + 3) * BENCHMARK_SAMPLE_PERIOD_US, &index) ==
+             TIMESTAMPED_BUFFER_RC_OK && index == 3;
+    is_ok &= timestamped_buffer_find(&timestamped_buffer, (uint64_t)(oldest + 3) * BENCHMARK_SAMPLE_PERIOD_US + 500u, &index) ==
+             TIMESTAMPED_BUFFER_RC_OK && index == 4;
+    is_ok &= timestamped_buffer_find(&timestamped_buffer, (uint64_t)(oldest - 4) * BENCHMARK_SAMPLE_PERIOD_US, &index) ==
+             TIMESTAMPED_BUFFER_RC_OK && index == 0;
+    is_ok &= timestamped_buffer_find(&timestamped_buffer, (uint64_t)newest * BENCHMARK_SAMPLE_PERIOD_US + 500u, &index) ==
+             TIMESTAMPED_BUFFER_RC_OUT_OF_RANGE;
+
+    // Since from a sample stored before the end of the array spans both regions, in full and truncated by max_count
+    timestamped_sample_t samples[CHECK_TIMESTAMPED_CAPACITY];
+    const uint32_t since_first = oldest + 3;
+    const uint16_t max_counts[] = {CHECK_TIMESTAMPED_CAPACITY, 6};
+    for(size_t m = 0; m < sizeof(max_counts) / sizeof(max_counts[0]); m++) {
+        uint16_t count = UINT16_MAX;
+        uint16_t expected_count = newest - since_first + 1;
+        if(expected_count > max_counts[m]) {
+            expected_count = max_counts[m];
+        }
+        is_ok &= timestamped_buffer_since(&timestamped_buffer, (uint64_t)since_first * BENCHMARK_SAMPLE_PERIOD_US, samples, max_counts[m],
+                                          &count) == TIMESTAMPED_BUFFER_RC_OK && count == expected_count;
+        for(uint16_t s = 0; s < count && s < expected_count; s++) {
+            uint32_t expected = since_first + s;
+            is_ok &= samples[s].timestamp_us == (uint64_t)expected * BENCHMARK_SAMPLE_PERIOD_US &&
+                     is_vec_near(&samples[s].value, expected, 2.0 * expected, -(double)expected);
+        }
+    }
+    uint16_t count = UINT16_MAX;
+    is_ok &= timestamped_buffer_since(&timestamped_buffer, (uint64_t)newest * BENCHMARK_SAMPLE_PERIOD_US + 1u, samples,
+                                      CHECK_TIMESTAMPED_CAPACITY, &count) == TIMESTAMPED_BUFFER_RC_OK && count == 0;
+
+    // Interpolate gives the sample itself at an exact time, a linear blend between two samples and is out of range
+    // before the oldest sample
+    vec_double_t value;
+    const uint32_t at = oldest + 6;
+    is_ok &= timestamped_buffer_interpolate(&timestamped_buffer, (uint64_t)at * BENCHMARK_SAMPLE_PERIOD_US, &value) ==
+             TIMESTAMPED_BUFFER_RC_OK && is_vec_near(&value, at, 2.0 * at, -(double)at);
+    is_ok &= timestamped_buffer_interpolate(&timestamped_buffer, (uint64_t)at * BENCHMARK_SAMPLE_PERIOD_US + 250u, &value) ==
+             TIMESTAMPED_BUFFER_RC_OK && is_vec_near(&value, at + 0.25, 2.0 * (at + 0.25), -(at + 0.25));
+    is_ok &= timestamped_buffer_interpolate(&timestamped_buffer, (uint64_t)oldest * BENCHMARK_SAMPLE_PERIOD_US - 500u, &value) ==
+             TIMESTAMPED_BUFFER_RC_OUT_OF_RANGE;
+
+    printf("%-24s %-22s %10u samples %s\n", "timestamped_buffer", "find/since/interpolate", size, is_ok ? "ok" : "MISMATCH");
+    return is_ok;
+}
+
+// Benchmark timestamped buffer lookups by time against the number of stored samples
+static void benchmark_timestamped_buffer(uint16_t capacity, uint32_t iterations) {
+    timestamped_sample_t * storage = calloc(capacity, sizeof(timestamped_sample_t));
+    timestamped_buffer_t timestamped_buffer;
+    timestamped_buffer_init(&timestamped_buffer, storage, capacity);
+
+    // Fill past capacity so the stored samples wrap around the end of the array
+    vec_double_t value = {0.0, 0.0, 0.0};
+    uint32_t num_samples = capacity + capacity / 2;
+    for(uint32_t i = 0; i < num_samples; i++) {
+        value.x = (double)i;
+        timestamped_buffer_push(&timestamped_buffer, (uint64_t)i * BENCHMARK_SAMPLE_PERIOD_US, &value);
+    }
+    uint64_t oldest_us = (uint64_t)(num_samples - timestamped_buffer_get_size(&timestamped_buffer)) * BENCHMARK_SAMPLE_PERIOD_US;
+    uint64_t span_us = (uint64_t)(timestamped_buffer_get_size(&timestamped_buffer) - 1) * BENCHMARK_SAMPLE_PERIOD_US;
+
+    uint32_t sum = 0;
+    uint16_t index;
+    uint64_t start = now_ns();
+    for(uint32_t i = 0; i < iterations; i++) {
+        timestamped_buffer_find(&timestamped_buffer, oldest_us + (i * 7919u) % span_us, &index);
+        sum += index;
+    }
+    uint64_t elapsed = now_ns() - start;
+    benchmark_sink = sum;
+
+    char config[32];
+    snprintf(config, sizeof(config), "samples=%u", timestamped_buffer_get_size(&timestamped_buffer));
+    report("timestamped find", config, iterations, 0, elapsed);
+
+    start = now_ns();
+    for(uint32_t i = 0; i < iterations; i++) {
+        timestamped_buffer_interpolate(&timestamped_buffer, oldest_us + (i * 7919u) % span_us, &value);
+    }
+    elapsed = now_ns() - start;
+    benchmark_sink = (uint32_t)value.x;
+    report("timestamped interpolate", config, iterations, 0, elapsed);
+
+    free(storage);
+}
+
+typedef struct {
+    circular_buffer_t * circular_buffer;
+    uint32_t count;             // Elements to push or pop
+    bool is_bulk;               // Whether to use push_n/pop_n in varying chunks instead of push/pop
+    uint32_t out_of_order;      // Elements popped that weren't the next one pushed, for the consumer
+} benchmark_spsc_thread_t;
+
+// Push the elements 0 to count - 1 in order, retrying while the buffer is full
+static void * spsc_producer(void * arg) {
+    benchmark_spsc_thread_t * thread = arg;
+    uint32_t elements[BENCHMARK_BULK_CHUNK];
+    for(uint32_t next = 0; next < thread->count;) {
+        uint16_t chunk = thread->is_bulk ? (uint16_t)(next % BENCHMARK_BULK_CHUNK + 1) : 1;
+        if(chunk > thread->count - next) {
+            chunk = (uint16_t)(thread->count - next);
+        }
+        for(uint16_t i = 0; i < chunk; i++) {
+            elements[i] = next + i;
+        }
+
+        uint16_t pushed = 0;
+        if(thread->is_bulk) {
+            circular_buffer_push_n(thread->circular_buffer, elements, chunk, &pushed);
+        }
+        else if(circular_buffer_push(thread->circular_buffer, elements, sizeof(elements[0])) == CIRCULAR_BUFFER_RC_OK) {
+            pushed = 1;
+        }
+        if(pushed == 0) {
+            sched_yield();
+        }
+        next += pushed;
+    }
+    return NULL;
+}
+
+// Pop count elements, counting every one that isn't the next in order
+static void * spsc_consumer(void * arg) {
+    benchmark_spsc_thread_t * thread = arg;
+    uint32_t elements[BENCHMARK_BULK_CHUNK];
+    for(uint32_t next = 0; next < thread->count;) {
+        uint16_t popped = 0;
+        if(thread->is_bulk) {
+            circular_buffer_pop_n(thread->circular_buffer, elements, (uint16_t)(next % BENCHMARK_BULK_CHUNK + 1), &popped);
+        }
+        else if(circular_buffer_pop(thread->circular_buffer, elements, sizeof(elements[0])) == CIRCULAR_BUFFER_RC_OK) {
+            popped = 1;
+        }
+        if(popped == 0) {
+            sched_yield();
+        }
+        for(uint16_t i = 0; i < popped; i++, next++) {
+            thread->out_of_order += (elements[i] != next);
+        }
+    }
+    return NULL;
+}
+
+// Benchmark an SPSC buffer shared by a producer and a consumer thread, checking every element arrives once and in order
+static bool benchmark_spsc_threads(bool is_bulk, uint32_t iterations) {
+    static uint32_t storage[BENCHMARK_MPMC_CAPACITY];
+    circular_buffer_t circular_buffer;
+    circular_buffer_init_spsc(&circular_buffer, storage, BENCHMARK_MPMC_CAPACITY, sizeof(uint32_t));
+
+    benchmark_spsc_thread_t producer = {&circular_buffer, iterations, is_bulk, 0};
+    benchmark_spsc_thread_t consumer = {&circular_buffer, iterations, is_bulk, 0};
+    pthread_t threads[2];
+
+    uint64_t start = now_ns();
+    pthread_create(&threads[0], NULL, spsc_consumer, &consumer);
+    pthread_create(&threads[1], NULL, spsc_producer, &producer);
+    pthread_join(threads[0], NULL);
+    pthread_join(threads[1], NULL);
+    uint64_t elapsed = now_ns() - start;
+
+    // The consumer stops after count elements, so a duplicate or a loss shows up as an element out of order
+    bool is_consistent = (consumer.out_of_order == 0) && circular_buffer_is_empty(&circular_buffer);
+
+    report(is_consistent ? "spsc threads" : "spsc threads (OUT OF ORDER)", is_bulk ? "push_n/pop_n cap=256" : "push/pop cap=256",
+           iterations, (uint64_t)iterations * sizeof(uint32_t), elapsed);
+
+    return is_consistent;
+}
+
+// Benchmark MPMC push followed by pop from a single thread, the cost of the lock without contention
+static void benchmark_mpmc_push_pop(uint32_t iterations) {
+    static uint32_t storage[BENCHMARK_MPMC_CAPACITY];
+    circular_buffer_mpmc_t circular_buffer_mpmc;
+    circular_buffer_mpmc_init_with_spin_lock(&circular_buffer_mpmc, storage, BENCHMARK_MPMC_CAPACITY, sizeof(uint32_t), 0);
+
+    uint32_t element = 0;
+    uint64_t start = now_ns();
+    for(uint32_t i = 0; i < iterations; i++) {
+        element = i;
+        circular_buffer_mpmc_push(&circular_buffer_mpmc, &element, sizeof(element));
+        circular_buffer_mpmc_pop(&circular_buffer_mpmc, &element, sizeof(element));
+    }
+    uint64_t elapsed = now_ns() - start;
+    benchmark_sink = element;
+
+    report("mpmc push+pop", "size=4 cap=256", 2ull * iterations, 8ull * iterations, elapsed);
+}
+
+typedef struct {
+    circular_buffer_mpmc_t * circular_buffer_mpmc;
+    uint32_t id;
+    uint32_t count;             // Elements to push, for producers
+    volatile uint32_t * remaining;  // Elements left to pop across all consumers, for consumers
+    uint64_t sum;               // Sum of the elements pushed or popped, to check nothing was lost or duplicated
+} benchmark_mpmc_thread_t;
+
+// Push count unique elements, retrying while the buffer is full
+static void * mpmc_producer(void * arg) {
+    benchmark_mpmc_thread_t * thread = arg;
+    for(uint32_t i = 0; i < thread->count; i++) {
+        uint32_t element = (thread->id << 24) | i;
+        while(circular_buffer_mpmc_push(thread->circular_buffer_mpmc, &element, sizeof(element)) != CIRCULAR_BUFFER_RC_OK) {
+            sched_yield();
+        }
+        thread->sum += element;
+    }
+    return NULL;
+}
+
+// Pop elements until every pushed element has been popped by some consumer
+static void * mpmc_consumer(void * arg) {
+    benchmark_mpmc_thread_t * thread = arg;
+    while(__atomic_load_n(thread->remaining, __ATOMIC_ACQUIRE) > 0) {
+        uint32_t element;
+        if(circular_buffer_mpmc_pop(thread->circular_buffer_mpmc, &element, sizeof(element)) == CIRCULAR_BUFFER_RC_OK) {
+            thread->sum += element;
+            __atomic_fetch_sub(thread->remaining, 1, __ATOMIC_ACQ_REL);
+        }
+        else {
+            sched_yield();
+        }
+    }
+    return NULL;
+}
+
+// Benchmark an MPMC buffer shared by producer and consumer threads, checking every element arrives exactly once
+static bool benchmark_mpmc_contention(uint32_t num_producers, uint32_t num_consumers, uint32_t iterations) {
+    static uint32_t storage[BENCHMARK_MPMC_CAPACITY];
+    circular_buffer_mpmc_t circular_buffer_mpmc;
+    circular_buffer_mpmc_init_with_spin_lock(&circular_buffer_mpmc, storage, BENCHMARK_MPMC_CAPACITY, sizeof(uint32_t), 0);
+
+    pthread_t threads[2 * BENCHMARK_MAX_MPMC_THREADS];
+    benchmark_mpmc_thread_t producers[BENCHMARK_MAX_MPMC_THREADS] = {0};
+    benchmark_mpmc_thread_t consumers[BENCHMARK_MAX_MPMC_THREADS] = {0};
+    uint32_t per_producer = iterations / num_producers;
+    volatile uint32_t remaining = per_producer * num_producers;
+
+    uint64_t start = now_ns();
+    for(uint32_t i = 0; i < num_consumers; i++) {
+        consumers[i] = (benchmark_mpmc_thread_t){&circular_buffer_mpmc, i, 0, &remaining, 0};
+        pthread_create(&threads[i], NULL, mpmc_consumer, &consumers[i]);
+    }
+    for(uint32_t i = 0; i < num_producers; i++) {
+        producers[i] = (benchmark_mpmc_thread_t){&circular_buffer_mpmc, i, per_producer, NULL, 0};
+        pthread_create(&threads[num_consumers + i], NULL, mpmc_producer, &producers[i]);
+    }
+    for(uint32_t i = 0; i < num_consumers + num_producers; i++) {
+        pthread_join(threads[i], NULL);
+    }
+    uint64_t elapsed = now_ns() - start;
+
+    uint64_t pushed_sum = 0;
+    uint64_t popped_sum = 0;
+    for(uint32_t i = 0; i < num_producers; i++) {
+        pushed_sum += producers[i].sum;
+    }
+    for(uint32_t i = 0; i < num_consumers; i++) {
+        popped_sum += consumers[i].sum;
+    }
+    bool is_consistent = (pushed_sum == popped_sum) && circular_buffer_mpmc_is_empty(&circular_buffer_mpmc);
+
+    char config[32];
+    snprintf(config, sizeof(config), "producers=%u consumers=%u", num_producers, num_consumers);
+    uint64_t elements = (uint64_t)per_producer * num_producers;
+    report(is_consistent ? "mpmc contention" : "mpmc contention (LOST)", config, elements, elements * sizeof(uint32_t), elapsed);
+
+    return is_consistent;
+}
+
+// Benchmark the EDF scheduling decision against the number of tasks in the tasklist
+static void benchmark_edf_select(uint8_t num_tasks, uint32_t iterations) {
+    edf_task_t tasklist[BENCHMARK_MAX_EDF_TASKS];
+
+    // Pseudo-random deadlines with every fourth task suspended, so the selection isn't trivially the first or last task
+    uint32_t seed = 12345u;
+    for(uint8_t i = 0; i < num_tasks; i++) {
+        seed = seed * 1103515245u + 12345u;
+        tasklist[i].task_handle = NULL;
+        tasklist[i].task_deadline = (seed >> 8) % 100000u;
+        tasklist[i].task_period = 0;
+        tasklist[i].task_state = (i % 4 == 3) ? EDF_TASK_SUSPENDED : EDF_TASK_READY;
+    }
+
+    int32_t sum = 0;
+    uint64_t start = now_ns();
+    for(uint32_t i = 0; i < iterations; i++) {
+        // Move one deadline each iteration so the decision can't be hoisted out of the loop
+        tasklist[i % num_tasks].task_deadline += 1;
+        sum += edf_select_task(tasklist, num_tasks);
+    }
+    uint64_t elapsed = now_ns() - start;
+    benchmark_sink = (uint32_t)sum;
+
+    char config[32];
+    snprintf(config, sizeof(config), "tasks=%u", num_tasks);
+    report("edf_select_task", config, iterations, 0, elapsed);
+}
+
+// Fill a payload with one of several patterns, including ones made of the bytes COBS and the delimiter have to escape
+static void fill_payload(uint8_t * payload, uint16_t len, uint8_t pattern, uint32_t * seed) {
+    for(uint16_t i = 0; i < len; i++) {
+        *seed = *seed * 1103515245u + 12345u;
+        switch(pattern) {
+            case 0:  payload[i] = (uint8_t)(*seed >> 16); break;
+            case 1:  payload[i] = 0; break;
+            case 2:  payload[i] = TELEMETRY_FRAME_DELIMITER; break;
+            case 3:  payload[i] = (*seed >> 16) & 1 ? 0 : TELEMETRY_FRAME_DELIMITER; break;
+            default: payload[i] = 0xFF; break;
+        }
+    }
+}
+
+static uint32_t decoder_frames_seen;
+static bool decoder_frames_match;
+static const uint8_t * decoder_expected;
+static uint16_t decoder_expected_len;
+
+// Stream decoder handler that checks every frame carries the expected payload
+static void check_decoded_frame(uint8_t msg_id, const uint8_t * payload, uint16_t payload_len, void * context) {
+    (void)context;
+    decoder_frames_match &= (msg_id == TELEMETRY_MSG_USER) && (payload_len == decoder_expected_len) &&
+                            (memcmp(payload, decoder_expected, payload_len) == 0);
+    decoder_frames_seen++;
+}
+
+// Round trip every payload length and pattern through split encoding, decoding and the stream decoder; corrupted
+// frames must be rejected. Returns false on any mismatch
+static bool check_telemetry_frame(void) {
+    static uint8_t payload[BENCHMARK_MAX_FRAME_PAYLOAD];
+    static uint8_t decoded[BENCHMARK_MAX_FRAME_PAYLOAD];
+    static uint8_t frame[TELEMETRY_FRAME_MAX_ENCODED_LEN(BENCHMARK_MAX_FRAME_PAYLOAD)];
+    static uint8_t stream[4 * TELEMETRY_FRAME_MAX_ENCODED_LEN(BENCHMARK_MAX_FRAME_PAYLOAD) + 16];
+    static uint8_t decoder_buffer[TELEMETRY_FRAME_MAX_ENCODED_LEN(BENCHMARK_MAX_FRAME_PAYLOAD)];
+    uint32_t seed = 1u;
+    uint32_t frames_checked = 0;
+    bool is_ok = true;
+
+    for(uint16_t len = 0; len <= BENCHMARK_MAX_FRAME_PAYLOAD && is_ok; len++) {
+        for(uint8_t pattern = 0; pattern < 5 && is_ok; pattern++) {
+            fill_payload(payload, len, pattern, &seed);
+            uint16_t max_len = TELEMETRY_FRAME_MAX_ENCODED_LEN(len);
+
+            // Split the frame at a different point each time, like a wrapping circular buffer would
+            uint16_t split = (uint16_t)(seed % (max_len + 1));
+            uint16_t frame_len;
+            is_ok &= telemetry_frame_encode_split(TELEMETRY_MSG_USER, payload, len, frame, split, &frame[split], max_len - split, &frame_len) == TELEMETRY_FRAME_RC_OK;
+            is_ok &= frame_len <= max_len && memchr(frame, TELEMETRY_FRAME_DELIMITER, frame_len - 1) == NULL && frame[frame_len - 1] == TELEMETRY_FRAME_DELIMITER;
+
+            uint8_t msg_id;
+            uint16_t decoded_len;
+            is_ok &= telemetry_frame_decode(frame, frame_len, &msg_id, decoded, sizeof(decoded), &decoded_len) == TELEMETRY_FRAME_RC_OK;
+            is_ok &= msg_id == TELEMETRY_MSG_USER && decoded_len == len && memcmp(decoded, payload, len) == 0;
+
+            // Flipping any bit of the frame body must not decode to a valid frame
+            uint16_t corrupt_at = (uint16_t)(seed % (frame_len - 1));
+            frame[corrupt_at] ^= (uint8_t)(1u << (seed % 8));
+            if(frame[corrupt_at] != TELEMETRY_FRAME_DELIMITER) {
+                is_ok &= telemetry_frame_decode(frame, frame_len, &msg_id, decoded, sizeof(decoded), &decoded_len) != TELEMETRY_FRAME_RC_OK;
+            }
+            frame[corrupt_at] ^= (uint8_t)(1u << (seed % 8));
+
+            // Stream the frame three times after some garbage, fed in uneven chunks
+            size_t stream_len = 0;
+            stream[stream_len++] = 0x55;
+            stream[stream_len++] = TELEMETRY_FRAME_DELIMITER;
+            for(int copy = 0; copy < 3; copy++) {
+                memcpy(&stream[stream_len], frame, frame_len);
+                stream_len += frame_len;
+            }
+            telemetry_frame_decoder_t decoder;
+            telemetry_frame_decoder_init(&decoder, decoder_buffer, sizeof(decoder_buffer));
+            decoder_frames_seen = 0;
+            decoder_frames_match = true;
+            decoder_expected = payload;
+            decoder_expected_len = len;
+            for(size_t offset = 0, chunk = 1; offset < stream_len; offset += chunk, chunk = chunk * 3 % 61 + 1) {
+                size_t feed_len = (stream_len - offset < chunk) ? stream_len - offset : chunk;
+                telemetry_frame_decoder_feed(&decoder, &stream[offset], feed_len, check_decoded_frame, NULL);
+            }
+            is_ok &= decoder_frames_match && decoder_frames_seen == 3 && decoder.frames_dropped == 1;
+            frames_checked++;
+        }
+    }
+
+    printf("%-24s %-22s %10u frames %s\n", "telemetry_frame", "round trip", frames_checked, is_ok ? "ok" : "MISMATCH");
+    return is_ok;
+}
+
+// Benchmark sending an IMU sample as a binary frame against formatting it as text the way the demos do
+static void benchmark_telemetry_frame(uint32_t iterations) {
+    uint8_t frame[TELEMETRY_FRAME_MAX_ENCODED_LEN(sizeof(telemetry_imu_raw_t))];
+    char text[128];
+    telemetry_imu_raw_t sample = {.timestamp_us = 0, .accel = {120, -16000, 4000}, .gyro = {-3, 250, 0}};
+    uint32_t checksum = 0;
+    uint16_t frame_len = 0;
+    int text_len = 0;
+
+    uint64_t start = now_ns();
+    for(uint32_t i = 0; i < iterations; i++) {
+        sample.timestamp_us = i;
+        telemetry_frame_encode(TELEMETRY_MSG_IMU_RAW, &sample, sizeof(sample), frame, sizeof(frame), &frame_len);
+        checksum += frame[frame_len / 2];
+    }
+    report("telemetry_frame_encode", "imu raw", iterations, (uint64_t)iterations * frame_len, now_ns() - start);
+
+    start = now_ns();
+    for(uint32_t i = 0; i < iterations; i++) {
+        uint8_t msg_id;
+        uint8_t payload[sizeof(telemetry_imu_raw_t)];
+        uint16_t payload_len;
+        telemetry_frame_decode(frame, frame_len, &msg_id, payload, sizeof(payload), &payload_len);
+        checksum += payload[i % sizeof(payload)];
+    }
+    report("telemetry_frame_decode", "imu raw", iterations, (uint64_t)iterations * frame_len, now_ns() - start);
+
+    // Only a third of the iterations, text formatting is slow enough
+    start = now_ns();
+    for(uint32_t i = 0; i < iterations / 3; i++) {
+        text_len = snprintf(text, sizeof(text), "%f/%f/%f\n%f/%f/%f\n", sample.accel[0] / 16384.0, sample.accel[1] / 16384.0,
+                            sample.accel[2] / 16384.0, sample.gyro[0] / 131.0, sample.gyro[1] / 131.0, sample.gyro[2] / 131.0);
+        checksum += (uint8_t)text[text_len / 2];
+    }
+    report("snprintf %f", "imu as text", iterations / 3, (uint64_t)(iterations / 3) * text_len, now_ns() - start);
+    printf("%-24s %-22s %10u bytes/sample as a frame, %d as text\n", "telemetry_frame", "size", frame_len, text_len);
+
+    benchmark_sink = checksum;
+}
+
+// Generate IMU sample i of a test signal: 0 is slowly varying with a little noise, like an IMU sampled well above the
+// motion's bandwidth, 1 is full scale noise, 2 alternates between the extremes so every delta wraps
+static void make_imu_sample(telemetry_imu_raw_t * sample, uint8_t pattern, uint32_t i, uint32_t * seed) {
+    sample->timestamp_us = 0xFFFF0000u + i * 10000u + (i % 3);
+    for(uint8_t axis = 0; axis < 6; axis++) {
+        *seed = *seed * 1103515245u + 12345u;
+        int32_t value;
+        switch(pattern) {
+            case 0: {
+                // Triangle wave of a few hundred LSB per period plus +-4 LSB of noise
+                int32_t phase = (int32_t)((i * (axis + 1) + axis * 37u) % 200u);
+                value = (axis == 2 ? 16384 : 0) + 4 * (phase < 100 ? phase : 200 - phase) + (int32_t)((*seed >> 16) % 9u) - 4;
+                break;
+            }
+            case 1:  value = (int16_t)(*seed >> 16); break;
+            default: value = (i + axis) & 1 ? INT16_MAX : INT16_MIN; break;
+        }
+        if(axis < 3) {
+            sample->accel[axis] = (int16_t)value;
+        }
+        else {
+            sample->gyro[axis - 3] = (int16_t)value;
+        }
+    }
+}
+
+static const telemetry_imu_raw_t * batch_expected;
+static uint32_t batch_samples_seen;
+static bool batch_samples_match;
+
+// Batch decoder handler that checks every sample against the next expected one
+static void check_decoded_sample(const telemetry_imu_raw_t * sample, void * context) {
+    (void)context;
+    batch_samples_match &= memcmp(sample, &batch_expected[batch_samples_seen], sizeof(*sample)) == 0;
+    batch_samples_seen++;
+}
+
+// Round trip each test signal through the batch encoder and decoder at several batch sizes, including a partial last
+// batch; truncated batches and trailing bytes must be rejected. Returns false on any mismatch
+static bool check_telemetry_batch(void) {
+    static telemetry_imu_raw_t samples[BENCHMARK_BATCH_SAMPLES];
+    static uint8_t buffer[TELEMETRY_BATCH_MAX_LEN(TELEMETRY_BATCH_MAX_SAMPLES + 1) + 1];
+    const uint8_t batch_sizes[] = {1, 7, BENCHMARK_BATCH_SIZE, TELEMETRY_BATCH_MAX_SAMPLES};
+    uint32_t seed = 1u;
+    uint32_t batches_checked = 0;
+    bool is_ok = true;
+
+    // The largest batch fits a frame at worst case length, and one sample more is refused even with the room for it
+    telemetry_batch_encoder_t oversized;
+    is_ok &= TELEMETRY_BATCH_MAX_LEN(TELEMETRY_BATCH_MAX_SAMPLES) <= TELEMETRY_FRAME_MAX_PAYLOAD;
+    is_ok &= TELEMETRY_BATCH_MAX_LEN(TELEMETRY_BATCH_MAX_SAMPLES + 1) > TELEMETRY_FRAME_MAX_PAYLOAD;
+    is_ok &= telemetry_batch_encoder_init(&oversized, buffer, sizeof(buffer), TELEMETRY_BATCH_MAX_SAMPLES + 1) == TELEMETRY_BATCH_RC_BAD_ARG;
+
+    for(uint8_t pattern = 0; pattern < 3; pattern++) {
+        for(uint32_t i = 0; i < BENCHMARK_BATCH_SAMPLES; i++) {
+            make_imu_sample(&samples[i], pattern, i, &seed);
+        }
+
+        for(size_t b = 0; b < sizeof(batch_sizes) / sizeof(batch_sizes[0]); b++) {
+            telemetry_batch_encoder_t encoder;
+            is_ok &= telemetry_batch_encoder_init(&encoder, buffer, TELEMETRY_BATCH_MAX_LEN(batch_sizes[b]) - 1, batch_sizes[b]) == TELEMETRY_BATCH_RC_BAD_ARG;
+            is_ok &= telemetry_batch_encoder_init(&encoder, buffer, TELEMETRY_BATCH_MAX_LEN(batch_sizes[b]), batch_sizes[b]) == TELEMETRY_BATCH_RC_OK;
+            batch_expected = samples;
+            batch_samples_seen = 0;
+            batch_samples_match = true;
+
+            for(uint32_t i = 0; i < BENCHMARK_BATCH_SAMPLES; i++) {
+                is_ok &= telemetry_batch_encoder_add(&encoder, &samples[i]) == TELEMETRY_BATCH_RC_OK;
+                bool is_last = (i == BENCHMARK_BATCH_SAMPLES - 1);
+                if(!telemetry_batch_encoder_is_full(&encoder) && !is_last) {
+                    continue;
+                }
+                is_ok &= !telemetry_batch_encoder_is_full(&encoder) || telemetry_batch_encoder_add(&encoder, &samples[i]) == TELEMETRY_BATCH_RC_FULL;
+
+                const uint8_t * batch;
+                uint16_t batch_len;
+                is_ok &= telemetry_batch_encoder_flush(&encoder, &batch, &batch_len) == TELEMETRY_BATCH_RC_OK;
+                is_ok &= batch_len > 1 && batch_len <= TELEMETRY_BATCH_MAX_LEN(batch[0]);
+
+                // A truncated batch or one with a trailing byte fails; only the full one delivers new samples
+                uint32_t seen = batch_samples_seen;
+                is_ok &= telemetry_batch_decode(batch, batch_len - 1, check_decoded_sample, NULL) == TELEMETRY_BATCH_RC_BAD_BATCH;
+                batch_samples_seen = seen;
+                buffer[batch_len] = 0;
+                is_ok &= telemetry_batch_decode(batch, batch_len + 1, check_decoded_sample, NULL) == TELEMETRY_BATCH_RC_BAD_BATCH;
+                batch_samples_seen = seen;
+                is_ok &= telemetry_batch_decode(batch, batch_len, check_decoded_sample, NULL) == TELEMETRY_BATCH_RC_OK;
+                batches_checked++;
+            }
+
+            const uint8_t * batch;
+            uint16_t batch_len;
+            is_ok &= telemetry_batch_encoder_flush(&encoder, &batch, &batch_len) == TELEMETRY_BATCH_RC_OK && batch_len == 0;
+            is_ok &= batch_samples_match && batch_samples_seen == BENCHMARK_BATCH_SAMPLES;
+        }
+    }
+
+    printf("%-24s %-22s %10u batches %s\n", "telemetry_batch", "round trip", batches_checked, is_ok ? "ok" : "MISMATCH");
+    return is_ok;
+}
+
+// Batch decoder handler that only folds the sample into the checksum
+static void sink_decoded_sample(const telemetry_imu_raw_t * sample, void * context) {
+    *(uint32_t *)context += (uint16_t)sample->accel[0];
+}
+
+// Benchmark batching IMU samples, and compare the framed bytes per sample against sending each one as a raw frame
+static void benchmark_telemetry_batch(uint32_t iterations) {
+    static telemetry_imu_raw_t samples[BENCHMARK_BATCH_SAMPLES];
+    static uint8_t buffer[TELEMETRY_BATCH_MAX_LEN(BENCHMARK_BATCH_SIZE)];
+    static uint8_t frame[TELEMETRY_FRAME_MAX_ENCODED_LEN(TELEMETRY_BATCH_MAX_LEN(BENCHMARK_BATCH_SIZE))];
+    const uint16_t raw_frame_len = TELEMETRY_FRAME_MAX_ENCODED_LEN(sizeof(telemetry_imu_raw_t));
+    const char * pattern_names[] = {"slowly varying", "full scale noise"};
+    telemetry_batch_encoder_t encoder;
+    uint32_t checksum = 0;
+    uint32_t seed = 1u;
+
+    for(uint8_t pattern = 0; pattern < 2; pattern++) {
+        for(uint32_t i = 0; i < BENCHMARK_BATCH_SAMPLES; i++) {
+            make_imu_sample(&samples[i], pattern, i, &seed);
+        }
+        telemetry_batch_encoder_init(&encoder, buffer, sizeof(buffer), BENCHMARK_BATCH_SIZE);
+
+        const uint8_t * batch;
+        uint16_t batch_len = 0;
+        uint64_t encoded_bytes = 0;
+        uint64_t start = now_ns();
+        for(uint32_t i = 0; i < iterations; i++) {
+            telemetry_batch_encoder_add(&encoder, &samples[i % BENCHMARK_BATCH_SAMPLES]);
+            if(telemetry_batch_encoder_is_full(&encoder)) {
+                telemetry_batch_encoder_flush(&encoder, &batch, &batch_len);
+                encoded_bytes += batch_len;
+                checksum += batch[batch_len / 2];
+            }
+        }
+        report("telemetry_batch_encode", pattern_names[pattern], iterations, encoded_bytes, now_ns() - start);
+
+        // Decode the last full batch over and over
+        uint32_t batches = iterations / BENCHMARK_BATCH_SIZE;
+        start = now_ns();
+        for(uint32_t i = 0; i < batches; i++) {
+            telemetry_batch_decode(batch, batch_len, sink_decoded_sample, &checksum);
+        }
+        report("telemetry_batch_decode", pattern_names[pattern], (uint64_t)batches * BENCHMARK_BATCH_SIZE, (uint64_t)batches * batch_len, now_ns() - start);
+
+        // Average framed size over one pass of the signal
+        uint64_t framed_bytes = 0;
+        uint32_t framed_samples = 0;
+        telemetry_batch_encoder_init(&encoder, buffer, sizeof(buffer), BENCHMARK_BATCH_SIZE);
+        for(uint32_t i = 0; i + BENCHMARK_BATCH_SIZE <= BENCHMARK_BATCH_SAMPLES; i += BENCHMARK_BATCH_SIZE) {
+            for(uint32_t j = 0; j < BENCHMARK_BATCH_SIZE; j++) {
+                telemetry_batch_encoder_add(&encoder, &samples[i + j]);
+            }
+            uint16_t frame_len;
+            telemetry_batch_encoder_flush(&encoder, &batch, &batch_len);
+            telemetry_frame_encode(TELEMETRY_MSG_IMU_BATCH, batch, batch_len, frame, sizeof(frame), &frame_len);
+            framed_bytes += frame_len;
+            framed_samples += BENCHMARK_BATCH_SIZE;
+        }
+        double bytes_per_sample = (double)framed_bytes / (double)framed_samples;
+        printf("%-24s %-22s %10.2f bytes/sample framed, %u as imu raw frames (%.2fx)\n", "telemetry_batch", pattern_names[pattern],
+               bytes_per_sample, raw_frame_len, raw_frame_len / bytes_per_sample);
+    }
+
+    benchmark_sink = checksum;
+}
+
+int main(int argc, char * argv[]) {
+    uint32_t iterations = BENCHMARK_DEFAULT_ITERATIONS;
+    if(argc > 1) {
+        iterations = (uint32_t)strtoul(argv[1], NULL, 10);
+        if(iterations == 0) {
+            fprintf(stderr, "usage: %s [iterations]\n", argv[0]);
+            return 1;
+        }
+    }
+
+    const uint8_t element_sizes[] = {1, 4, 16, 64};
+    const uint16_t capacities[] = {16, 256, 4096};
+    const circular_buffer_mode_t modes[] = {CIRCULAR_BUFFER_MODE_DEFAULT, CIRCULAR_BUFFER_MODE_SPSC};
+
+    printf("common_lib benchmarks, %u iterations each\n\n", iterations);
+
+    for(size_t m = 0; m < sizeof(modes) / sizeof(modes[0]); m++) {
+        for(size_t s = 0; s < sizeof(element_sizes) / sizeof(element_sizes[0]); s++) {
+            for(size_t c = 0; c < sizeof(capacities) / sizeof(capacities[0]); c++) {
+                benchmark_push_pop(modes[m], element_sizes[s], capacities[c], iterations);
+            }
+        }
+    }
+    printf("\n");
+
+    for(size_t m = 0; m < sizeof(modes) / sizeof(modes[0]); m++) {
+        for(size_t s = 0; s < sizeof(element_sizes) / sizeof(element_sizes[0]); s++) {
+            for(size_t c = 1; c < sizeof(capacities) / sizeof(capacities[0]); c++) {
+                benchmark_push_n_pop_n(modes[m], element_sizes[s], capacities[c], iterations / BENCHMARK_BULK_CHUNK);
+            }
+        }
+    }
+    printf("\n");
+
+    for(size_t m = 0; m < sizeof(modes) / sizeof(modes[0]); m++) {
+        for(size_t c = 0; c < sizeof(capacities) / sizeof(capacities[0]); c++) {
+            benchmark_get_size(modes[m], capacities[c], iterations);
+        }
+    }
+    printf("\n");
+
+    benchmark_typed_push_pop(iterations);
+    printf("\n");
+
+    benchmark_vector_lib(iterations);
+    printf("\n");
+
+    // Elements passed between a producer and a consumer thread without a lock, a mismatch fails the run
+    bool is_consistent = true;
+    is_consistent &= benchmark_spsc_threads(false, iterations);
+    is_consistent &= benchmark_spsc_threads(true, iterations);
+    printf("\n");
+
+    // Elements pushed/popped per second with every operation taking the lock, a mismatch fails the run
+    benchmark_mpmc_push_pop(iterations);
+    for(uint32_t threads = 1; threads <= BENCHMARK_MAX_MPMC_THREADS; threads <<= 1) {
+        is_consistent &= benchmark_mpmc_contention(threads, threads, iterations);
+    }
+    printf("\n");
+
+    // Lookups by time are checked against the expected samples first, a mismatch fails the run
+    is_consistent &= check_timestamped_buffer();
+    for(size_t c = 0; c < sizeof(capacities) / sizeof(capacities[0]); c++) {
+        benchmark_timestamped_buffer(capacities[c], iterations);
+    }
+    printf("\n");
+
+    const uint8_t task_counts[] = {1, 2, 4, 8, 16, 32, 64, BENCHMARK_MAX_EDF_TASKS};
+    for(size_t t = 0; t < sizeof(task_counts) / sizeof(task_counts[0]); t++) {
+        benchmark_edf_select(task_counts[t], iterations);
+    }
+    printf("\n");
+
+    // Framing is checked for correctness first, a failed round trip fails the run
+    is_consistent &= check_telemetry_frame();
+    benchmark_telemetry_frame(iterations);
+    printf("\n");
+
+    is_consistent &= check_telemetry_batch();
+    benchmark_telemetry_batch(iterations);
+
+    return is_consistent ? 0 : 1;
+}
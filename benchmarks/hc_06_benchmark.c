@@ -0,0 +1,554 @@
+/**
+ * @file    hc_06_benchmark.c
+ * @brief   Host benchmark for the HC-06 driver's transmit and receive modes, run against the simulated UART and DMA in host/.
+ * @details Reports how often the CPU is interrupted per message in interrupt and DMA transmit mode, and checks that the
+ *          characters leave the UART in exactly the order they were queued.
+ *          FIFO levels repeats interrupt transmit and receive at each UART FIFO trigger level, using the driver's own counters.
+ *          Receive streams messages into the UART back to back at several baud rates while the application polls
+ *          hc06_rx_msg at a fixed period, and checks every message arrives intact and in order.
+ *          Scatter-gather builds each message from a header, payload and checksum fragment with hc06_tx_msgv, and checks that
+ *          a message that doesn't fit leaves the tx buffer untouched, so only whole messages leave the UART.
+ *          Telemetry frames sends IMU samples with hc06_tx_frame and decodes what leaves the UART with the stream decoder.
+ *          Dual link transmits telemetry on uart0 while receiving commands on uart1, both in DMA mode on a shared DMA irq,
+ *          and reports the combined throughput of the two links.
+ *          Blocking streams messages through hc06_receive and hc06_send, whose waits run the simulation until the irq
+ *          notifies the task, and compares the simulated time taken with the time the line needs to carry the data.
+ *          Backpressure sends IMU frames with the blocking hc06_send_frame, and streams more into the UART than the rx buffer
+ *          holds while the application stalls, with and without RTS flow control; only flow control must not lose any.
+ *          It then receives a line longer than the rx buffer with hc06_receive, which must flush the full rx buffer.
+ *          Exits non-zero if any mode garbles or loses data.
+ *          Usage: hc_06_benchmark
+ */
+
+#include <stdio.h>
+
+#include "hc_06.h"
+#include "hc_06_rtos.h"
+#include "host_hardware.h"
+
+#define BENCHMARK_MESSAGES          200u
+#define BENCHMARK_MAX_MSG_LEN       120u
+#define BENCHMARK_MAX_STEPS         1000000u
+#define BENCHMARK_BAUDRATE          115200u
+#define BENCHMARK_RX_MESSAGES       2000u
+#define BENCHMARK_RX_POLL_US        1000u
+
+static uint8_t tx_buffer[HC06_DEFAULT_BUFFER_SIZE];
+static uint8_t rx_buffer[HC06_DEFAULT_BUFFER_SIZE] __attribute__((aligned(HC06_DEFAULT_BUFFER_SIZE)));
+static hc06_t hc06_device;
+
+// Second link on uart1 for the dual link benchmark
+static uint8_t command_tx_buffer[HC06_DEFAULT_BUFFER_SIZE];
+static uint8_t command_rx_buffer[HC06_DEFAULT_BUFFER_SIZE] __attribute__((aligned(HC06_DEFAULT_BUFFER_SIZE)));
+static hc06_t command_device;
+static uint8_t command_expected[BENCHMARK_MESSAGES * BENCHMARK_MAX_MSG_LEN];
+static uint8_t command_received[BENCHMARK_MESSAGES * BENCHMARK_MAX_MSG_LEN + HC06_DEFAULT_BUFFER_SIZE];
+
+// FIFO trigger levels applied after each hc06_init, changed by the FIFO level sweep
+static hc06_fifo_level_t rx_fifo_level = HC06_FIFO_LEVEL_1_2;
+static hc06_fifo_level_t tx_fifo_level = HC06_FIFO_LEVEL_1_4;
+
+// Everything queued for transmission and everything that left the UART, in order
+static uint8_t expected[BENCHMARK_RX_MESSAGES * BENCHMARK_MAX_MSG_LEN];
+static uint8_t transmitted[BENCHMARK_RX_MESSAGES * BENCHMARK_MAX_MSG_LEN + HC06_DEFAULT_BUFFER_SIZE];
+
+// Build a newline terminated message of pseudo-random length and content
+static uint16_t make_message(char * msg, uint32_t * seed) {
+    *seed = *seed * 1103515245u + 12345u;
+    uint16_t len = 2 + (*seed >> 8) % (BENCHMARK_MAX_MSG_LEN - 2);
+    for(uint16_t i = 0; i < len - 1; i++) {
+        *seed = *seed * 1103515245u + 12345u;
+        msg[i] = 'a' + (*seed >> 16) % 26;
+    }
+    msg[len - 1] = '\n';
+    return len;
+}
+
+// Send messages in bursts, letting the simulated hardware run after each burst, and check what came out of the UART
+static bool benchmark_tx(bool use_dma, uint16_t messages_per_burst) {
+    hc06_init(&hc06_device, uart0, 0, 1, BENCHMARK_BAUDRATE, UART0_IRQ, tx_buffer, sizeof(tx_buffer), rx_buffer, sizeof(rx_buffer));
+    hc06_set_fifo_levels(&hc06_device, rx_fifo_level, tx_fifo_level);
+    if(use_dma && hc06_enable_tx_dma(&hc06_device, DMA_IRQ_0) != HC06_RC_OK) {
+        printf("Could not enable DMA transmit\n");
+        return false;
+    }
+
+    // Enabling it again would claim channels over the ones in use
+    if(use_dma && hc06_enable_tx_dma(&hc06_device, DMA_IRQ_0) != HC06_RC_BAD_ARG) {
+        printf("DMA transmit was enabled twice\n");
+        return false;
+    }
+
+    uint32_t irqs_before = host_irq_get_count(UART0_IRQ) + host_irq_get_count(DMA_IRQ_0);
+    size_t expected_len = 0;
+    size_t transmitted_len = 0;
+    uint32_t seed = 42u;
+
+    for(uint32_t message = 0; message < BENCHMARK_MESSAGES;) {
+        for(uint16_t i = 0; i < messages_per_burst && message < BENCHMARK_MESSAGES; i++, message++) {
+            char msg[BENCHMARK_MAX_MSG_LEN];
+            uint16_t len = make_message(msg, &seed);
+
+            // Only what fit in the tx buffer is expected to be sent
+            uint16_t chars_sent;
+            hc06_tx_msg(&hc06_device, msg, len, &chars_sent);
+            memcpy(&expected[expected_len], msg, chars_sent);
+            expected_len += chars_sent;
+        }
+
+        host_hardware_run(BENCHMARK_MAX_STEPS);
+        transmitted_len += host_uart_take_tx(uart0, &transmitted[transmitted_len], sizeof(transmitted) - transmitted_len);
+    }
+
+    uint32_t irqs = host_irq_get_count(UART0_IRQ) + host_irq_get_count(DMA_IRQ_0) - irqs_before;
+    bool is_ordered = (transmitted_len == expected_len) && (memcmp(transmitted, expected, expected_len) == 0);
+    bool is_ok = is_ordered && hc06_device.message_sent;
+
+    printf("%-10s burst=%-3u %8zu chars %8.2f irqs/msg %8.2f chars/irq  %s\n", use_dma ? "dma" : "irq", messages_per_burst,
+           transmitted_len, (double)irqs / BENCHMARK_MESSAGES, (irqs > 0) ? (double)transmitted_len / irqs : 0.0,
+           is_ok ? "ok" : "OUT OF ORDER");
+
+    return is_ok;
+}
+
+// Stream messages into the UART at a baud rate while polling hc06_rx_msg, and check what the application received
+static bool benchmark_rx(bool use_dma, uint32_t baudrate) {
+    hc06_init(&hc06_device, uart0, 0, 1, baudrate, UART0_IRQ, tx_buffer, sizeof(tx_buffer), rx_buffer, sizeof(rx_buffer));
+    hc06_set_fifo_levels(&hc06_device, rx_fifo_level, tx_fifo_level);
+    if(use_dma && hc06_enable_rx_dma(&hc06_device, DMA_IRQ_0) != HC06_RC_OK) {
+        printf("Could not enable DMA receive\n");
+        return false;
+    }
+
+    // Enabling it again would claim a channel over the one writing the rx buffer
+    if(use_dma && hc06_enable_rx_dma(&hc06_device, DMA_IRQ_0) != HC06_RC_BAD_ARG) {
+        printf("DMA receive was enabled twice\n");
+        return false;
+    }
+
+    size_t expected_len = 0;
+    uint32_t seed = 7u;
+    for(uint32_t message = 0; message < BENCHMARK_RX_MESSAGES; message++) {
+        expected_len += make_message((char *)&expected[expected_len], &seed);
+    }
+    host_uart_inject_rx(uart0, expected, expected_len);
+
+    // A character takes 10 bit times, and the line moves HOST_UART_CHARS_PER_STEP characters per step
+    uint32_t chars_per_poll = (uint32_t)((uint64_t)baudrate * BENCHMARK_RX_POLL_US / 10u / 1000000u);
+    uint32_t steps_per_poll = (chars_per_poll + HOST_UART_CHARS_PER_STEP - 1) / HOST_UART_CHARS_PER_STEP;
+
+    uint32_t irqs_before = host_irq_get_count(UART0_IRQ) + host_irq_get_count(DMA_IRQ_0);
+    size_t received_len = 0;
+    uint32_t idle_polls = 0;
+    while(idle_polls < 2 && received_len < expected_len) {
+        uint32_t steps = host_hardware_run(steps_per_poll);
+
+        // Drain every complete message, as an application task woken every poll period would; stop once the line has settled
+        while(hc06_rx_frames_pending(&hc06_device) > 0 && sizeof(transmitted) - received_len > sizeof(rx_buffer)) {
+            uint16_t chars_received = 0;
+            hc06_rx_msg(&hc06_device, (char *)&transmitted[received_len], sizeof(rx_buffer), &chars_received);
+            received_len += chars_received;
+        }
+        idle_polls = (steps < steps_per_poll) ? idle_polls + 1 : 0;
+    }
+
+    uint32_t irqs = host_irq_get_count(UART0_IRQ) + host_irq_get_count(DMA_IRQ_0) - irqs_before;
+    bool is_ok = (received_len == expected_len) && (memcmp(transmitted, expected, expected_len) == 0) && (hc06_device.rx_overrun_count == 0);
+
+    printf("%-10s %7u baud %8zu chars %8.2f irqs/msg %8.2f chars/irq  %s\n", use_dma ? "dma" : "irq", baudrate,
+           received_len, (double)irqs / BENCHMARK_RX_MESSAGES, (irqs > 0) ? (double)received_len / irqs : 0.0,
+           is_ok ? "ok" : "LOST OR OUT OF ORDER");
+
+    return is_ok;
+}
+
+// Queue header/payload/checksum fragments with hc06_tx_msgv, retrying whatever didn't fit once the UART has drained
+static bool benchmark_tx_msgv(bool use_dma) {
+    hc06_init(&hc06_device, uart0, 0, 1, BENCHMARK_BAUDRATE, UART0_IRQ, tx_buffer, sizeof(tx_buffer), rx_buffer, sizeof(rx_buffer));
+    if(use_dma && hc06_enable_tx_dma(&hc06_device, DMA_IRQ_0) != HC06_RC_OK) {
+        printf("Could not enable DMA transmit\n");
+        return false;
+    }
+
+    const char header[] = "$HC06,";
+    size_t expected_len = 0;
+    size_t transmitted_len = 0;
+    uint32_t rejected = 0;
+    bool is_atomic = true;
+    uint32_t seed = 5u;
+    for(uint32_t message = 0; message < BENCHMARK_MESSAGES; message++) {
+        char payload[BENCHMARK_MAX_MSG_LEN];
+        uint16_t payload_len = make_message(payload, &seed) - 1;
+        uint8_t checksum = 0;
+        for(uint16_t i = 0; i < payload_len; i++) {
+            checksum ^= (uint8_t)payload[i];
+        }
+        char trailer[8];
+        int trailer_len = snprintf(trailer, sizeof(trailer), "*%02X\n", checksum);
+
+        hc06_iovec_t iov[] = {{header, sizeof(header) - 1}, {payload, payload_len}, {trailer, (uint16_t)trailer_len}};
+        uint16_t size_before = circular_buffer_get_size(&hc06_device.tx_buffer);
+        while(hc06_tx_msgv(&hc06_device, iov, 3) != HC06_RC_OK) {
+            is_atomic &= (circular_buffer_get_size(&hc06_device.tx_buffer) == size_before);
+            rejected++;
+            host_hardware_run(BENCHMARK_MAX_STEPS);
+            transmitted_len += host_uart_take_tx(uart0, &transmitted[transmitted_len], sizeof(transmitted) - transmitted_len);
+            size_before = circular_buffer_get_size(&hc06_device.tx_buffer);
+        }
+        for(size_t i = 0; i < sizeof(iov) / sizeof(iov[0]); i++) {
+            memcpy(&expected[expected_len], iov[i].data, iov[i].len);
+            expected_len += iov[i].len;
+        }
+    }
+    host_hardware_run(BENCHMARK_MAX_STEPS);
+    transmitted_len += host_uart_take_tx(uart0, &transmitted[transmitted_len], sizeof(transmitted) - transmitted_len);
+
+    bool is_ok = is_atomic && (transmitted_len == expected_len) && (memcmp(transmitted, expected, expected_len) == 0);
+
+    printf("%-10s %8zu chars, %4u messages deferred whole while the tx buffer was full  %s\n", use_dma ? "dma" : "irq",
+           transmitted_len, rejected, is_ok ? "ok" : "PARTIAL OR OUT OF ORDER");
+
+    return is_ok;
+}
+
+static uint32_t imu_samples_decoded;
+static bool imu_samples_in_order;
+
+// Stream decoder handler that checks the IMU samples arrive whole and in order
+static void check_imu_sample(uint8_t msg_id, const uint8_t * payload, uint16_t payload_len, void * context) {
+    (void)context;
+    telemetry_imu_raw_t sample;
+    memcpy(&sample, payload, sizeof(sample));
+    imu_samples_in_order &= (msg_id == TELEMETRY_MSG_IMU_RAW) && (payload_len == sizeof(sample)) &&
+                            (sample.timestamp_us == imu_samples_decoded) && (sample.gyro[2] == (int16_t)imu_samples_decoded);
+    imu_samples_decoded++;
+}
+
+// Send IMU samples as binary frames in DMA mode, and decode the UART's output as a host tool would
+static bool benchmark_tx_frames(void) {
+    static uint8_t decoder_buffer[TELEMETRY_FRAME_MAX_ENCODED_LEN(sizeof(telemetry_imu_raw_t))];
+    telemetry_frame_decoder_t decoder;
+    telemetry_frame_decoder_init(&decoder, decoder_buffer, sizeof(decoder_buffer));
+    imu_samples_decoded = 0;
+    imu_samples_in_order = true;
+
+    hc06_init(&hc06_device, uart0, 0, 1, BENCHMARK_BAUDRATE, UART0_IRQ, tx_buffer, sizeof(tx_buffer), rx_buffer, sizeof(rx_buffer));
+    if(hc06_enable_tx_dma(&hc06_device, DMA_IRQ_0) != HC06_RC_OK) {
+        printf("Could not enable DMA transmit\n");
+        return false;
+    }
+
+    // Queue samples until the tx buffer is full, let the UART drain it, repeat
+    uint32_t samples_sent = 0;
+    size_t transmitted_len = 0;
+    while(samples_sent < BENCHMARK_RX_MESSAGES) {
+        telemetry_imu_raw_t sample = {.timestamp_us = samples_sent, .accel = {120, -16000, 4000}, .gyro = {-3, 250, (int16_t)samples_sent}};
+        if(hc06_tx_frame(&hc06_device, TELEMETRY_MSG_IMU_RAW, &sample, sizeof(sample)) == HC06_RC_OK) {
+            samples_sent++;
+            continue;
+        }
+
+        host_hardware_run(BENCHMARK_MAX_STEPS);
+        size_t len = host_uart_take_tx(uart0, transmitted, sizeof(transmitted));
+        transmitted_len += len;
+        telemetry_frame_decoder_feed(&decoder, transmitted, len, check_imu_sample, NULL);
+    }
+    host_hardware_run(BENCHMARK_MAX_STEPS);
+    size_t len = host_uart_take_tx(uart0, transmitted, sizeof(transmitted));
+    transmitted_len += len;
+    telemetry_frame_decoder_feed(&decoder, transmitted, len, check_imu_sample, NULL);
+
+    bool is_ok = imu_samples_in_order && imu_samples_decoded == samples_sent && decoder.frames_dropped == 0;
+    double bytes_per_sample = (double)transmitted_len / samples_sent;
+
+    printf("%u imu samples, %5.1f bytes/sample, %6.0f samples/s at %u baud, %6.0f at 921600  %s\n", samples_sent,
+           bytes_per_sample, BENCHMARK_BAUDRATE / 10.0 / bytes_per_sample, BENCHMARK_BAUDRATE, 92160.0 / bytes_per_sample,
+           is_ok ? "ok" : "LOST OR OUT OF ORDER");
+
+    return is_ok;
+}
+
+// Send telemetry on uart0 while receiving commands on uart1, each link with its own instance, and check both
+static bool benchmark_dual_link(void) {
+    hc06_init(&hc06_device, uart0, 0, 1, BENCHMARK_BAUDRATE, UART0_IRQ, tx_buffer, sizeof(tx_buffer), rx_buffer, sizeof(rx_buffer));
+    hc06_init(&command_device, uart1, 4, 5, BENCHMARK_BAUDRATE, UART1_IRQ, command_tx_buffer, sizeof(command_tx_buffer),
+              command_rx_buffer, sizeof(command_rx_buffer));
+    if(hc06_enable_tx_dma(&hc06_device, DMA_IRQ_0) != HC06_RC_OK || hc06_enable_rx_dma(&command_device, DMA_IRQ_0) != HC06_RC_OK) {
+        printf("Could not enable DMA\n");
+        return false;
+    }
+
+    size_t command_len = 0;
+    uint32_t command_seed = 11u;
+    for(uint32_t message = 0; message < BENCHMARK_MESSAGES; message++) {
+        command_len += make_message((char *)&command_expected[command_len], &command_seed);
+    }
+    host_uart_inject_rx(uart1, command_expected, command_len);
+
+    uint32_t chars_per_poll = (uint32_t)((uint64_t)BENCHMARK_BAUDRATE * BENCHMARK_RX_POLL_US / 10u / 1000000u);
+    uint32_t steps_per_poll = (chars_per_poll + HOST_UART_CHARS_PER_STEP - 1) / HOST_UART_CHARS_PER_STEP;
+
+    size_t telemetry_len = 0;
+    size_t transmitted_len = 0;
+    size_t received_len = 0;
+    uint32_t telemetry_seed = 42u;
+    uint32_t telemetry_messages = 0;
+    uint32_t total_steps = 0;
+    uint32_t idle_polls = 0;
+    while(idle_polls < 2) {
+        // Queue telemetry for as long as whole messages fit in the tx buffer, so the uart0 line never goes idle
+        while(telemetry_messages < BENCHMARK_MESSAGES && circular_buffer_get_size(&hc06_device.tx_buffer) <= sizeof(tx_buffer) - BENCHMARK_MAX_MSG_LEN) {
+            uint16_t len = make_message((char *)&expected[telemetry_len], &telemetry_seed);
+            uint16_t chars_sent;
+            hc06_tx_msg(&hc06_device, (char *)&expected[telemetry_len], len, &chars_sent);
+            telemetry_len += chars_sent;
+            telemetry_messages++;
+        }
+
+        uint32_t steps = host_hardware_run(steps_per_poll);
+        total_steps += steps;
+
+        transmitted_len += host_uart_take_tx(uart0, &transmitted[transmitted_len], sizeof(transmitted) - transmitted_len);
+        while(hc06_rx_frames_pending(&command_device) > 0 && sizeof(command_received) - received_len > sizeof(command_rx_buffer)) {
+            uint16_t chars_received = 0;
+            hc06_rx_msg(&command_device, (char *)&command_received[received_len], sizeof(command_rx_buffer), &chars_received);
+            received_len += chars_received;
+        }
+        idle_polls = (steps < steps_per_poll && telemetry_messages == BENCHMARK_MESSAGES) ? idle_polls + 1 : 0;
+    }
+
+    bool is_telemetry_ok = (transmitted_len == telemetry_len) && (memcmp(transmitted, expected, telemetry_len) == 0);
+    bool is_command_ok = (received_len == command_len) && (memcmp(command_received, command_expected, command_len) == 0);
+
+    printf("uart0 tx %8zu chars %s, uart1 rx %8zu chars %s, %5.2f chars/step combined (one line moves %u)\n",
+           transmitted_len, is_telemetry_ok ? "ok" : "OUT OF ORDER", received_len, is_command_ok ? "ok" : "LOST OR OUT OF ORDER",
+           (double)(transmitted_len + received_len) / total_steps, HOST_UART_CHARS_PER_STEP);
+
+    return is_telemetry_ok && is_command_ok;
+}
+
+// Receive and send messages with the blocking calls, each woken by the irq, and check the data and the time taken
+static bool benchmark_blocking(bool use_dma) {
+    hc06_init(&hc06_device, uart0, 0, 1, BENCHMARK_BAUDRATE, UART0_IRQ, tx_buffer, sizeof(tx_buffer), rx_buffer, sizeof(rx_buffer));
+    if(use_dma && hc06_enable_tx_dma(&hc06_device, DMA_IRQ_0) != HC06_RC_OK) {
+        printf("Could not enable DMA transmit\n");
+        return false;
+    }
+    hc06_rtos_t hc06_rtos;
+    hc06_rtos_init(&hc06_rtos, &hc06_device);
+
+    size_t expected_len = 0;
+    uint32_t seed = 3u;
+    for(uint32_t message = 0; message < BENCHMARK_MESSAGES; message++) {
+        expected_len += make_message((char *)&expected[expected_len], &seed);
+    }
+
+    // Receive every message as it completes, the line needs one step per HOST_UART_CHARS_PER_STEP characters
+    host_uart_inject_rx(uart0, expected, expected_len);
+    uint64_t rx_start = host_hardware_get_step_count();
+    size_t received_len = 0;
+    uint32_t messages_received = 0;
+    while(messages_received < BENCHMARK_MESSAGES) {
+        uint16_t chars_received = 0;
+        if(hc06_receive(&hc06_rtos, (char *)&transmitted[received_len], sizeof(rx_buffer), pdMS_TO_TICKS(100), &chars_received) != HC06_RC_OK) {
+            break;
+        }
+        received_len += chars_received;
+        messages_received++;
+    }
+    uint64_t rx_steps = host_hardware_get_step_count() - rx_start;
+    bool is_rx_ok = (received_len == expected_len) && (memcmp(transmitted, expected, expected_len) == 0);
+
+    // Nothing more arrives, so the next receive times out
+    uint16_t chars_received = 0;
+    is_rx_ok &= (hc06_receive(&hc06_rtos, (char *)transmitted, sizeof(rx_buffer), pdMS_TO_TICKS(10), &chars_received) == HC06_RC_TIMEOUT);
+
+    // Send every message back, blocking whenever the tx buffer is full
+    uint64_t tx_start = host_hardware_get_step_count();
+    bool is_tx_ok = true;
+    for(size_t offset = 0; offset < expected_len;) {
+        uint16_t len = (uint16_t)((const uint8_t *)memchr(&expected[offset], '\n', expected_len - offset) - &expected[offset]) + 1;
+        uint16_t chars_sent;
+        is_tx_ok &= (hc06_send(&hc06_rtos, (const char *)&expected[offset], len, pdMS_TO_TICKS(100), &chars_sent) == HC06_RC_OK);
+        offset += chars_sent;
+    }
+    host_hardware_run(BENCHMARK_MAX_STEPS);
+    uint64_t tx_steps = host_hardware_get_step_count() - tx_start;
+    size_t transmitted_len = host_uart_take_tx(uart0, transmitted, sizeof(transmitted));
+    is_tx_ok &= (transmitted_len == expected_len) && (memcmp(transmitted, expected, expected_len) == 0);
+
+    uint64_t line_steps = (expected_len + HOST_UART_CHARS_PER_STEP - 1) / HOST_UART_CHARS_PER_STEP;
+    printf("%-10s receive %6zu chars in %6llu steps %s, send %6zu chars in %6llu steps %s, line needs %6llu steps\n",
+           use_dma ? "dma" : "irq", received_len, (unsigned long long)rx_steps, is_rx_ok ? "ok" : "LOST OR OUT OF ORDER",
+           transmitted_len, (unsigned long long)tx_steps, is_tx_ok ? "ok" : "LOST OR OUT OF ORDER", (unsigned long long)line_steps);
+
+    return is_rx_ok && is_tx_ok;
+}
+
+// Repeat interrupt transmit and receive at every FIFO trigger level, reporting the interrupt load the driver counted
+static bool benchmark_fifo_levels(void) {
+    const char * level_names[] = {"1/8", "1/4", "1/2", "3/4", "7/8"};
+    bool is_ok = true;
+
+    for(hc06_fifo_level_t level = HC06_FIFO_LEVEL_1_8; level <= HC06_FIFO_LEVEL_7_8; level++) {
+        rx_fifo_level = level;
+        tx_fifo_level = level;
+
+        printf("level %s\n", level_names[level]);
+        is_ok &= benchmark_tx(false, 4);
+        float tx_irqs_per_char = hc06_get_irqs_per_char(&hc06_device);
+        is_ok &= benchmark_rx(false, 921600);
+        float rx_irqs_per_char = hc06_get_irqs_per_char(&hc06_device);
+        printf("           tx %.4f irqs/char, rx %.4f irqs/char, %u rx overruns\n\n", tx_irqs_per_char, rx_irqs_per_char,
+               hc06_device.rx_overrun_count);
+    }
+
+    rx_fifo_level = HC06_FIFO_LEVEL_1_2;
+    tx_fifo_level = HC06_FIFO_LEVEL_1_4;
+
+    return is_ok;
+}
+
+// Stream messages in while the application stalls until the line settles, then read them; returns the characters received
+static size_t stall_and_receive(size_t expected_len) {
+    size_t received_len = 0;
+    uint32_t idle_rounds = 0;
+    while(idle_rounds < 2 && received_len < expected_len) {
+        uint32_t steps = host_hardware_run(BENCHMARK_MAX_STEPS);
+        uint16_t chars_received = 1;
+        while(chars_received > 0 && sizeof(transmitted) - received_len > sizeof(rx_buffer)) {
+            hc06_rx_msg(&hc06_device, (char *)&transmitted[received_len], sizeof(rx_buffer), &chars_received);
+            received_len += chars_received;
+        }
+        idle_rounds = (steps <= 1) ? idle_rounds + 1 : 0;
+    }
+    return received_len;
+}
+
+// Send frames with the blocking call, then overfill the rx buffer with and without RTS flow control
+static bool benchmark_backpressure(void) {
+    static uint8_t decoder_buffer[TELEMETRY_FRAME_MAX_ENCODED_LEN(sizeof(telemetry_imu_raw_t))];
+    telemetry_frame_decoder_t decoder;
+    telemetry_frame_decoder_init(&decoder, decoder_buffer, sizeof(decoder_buffer));
+    imu_samples_decoded = 0;
+    imu_samples_in_order = true;
+
+    hc06_init(&hc06_device, uart0, 0, 1, BENCHMARK_BAUDRATE, UART0_IRQ, tx_buffer, sizeof(tx_buffer), rx_buffer, sizeof(rx_buffer));
+    hc06_rtos_t hc06_rtos;
+    hc06_rtos_init(&hc06_rtos, &hc06_device);
+
+    // Every frame is queued whole, the task sleeping until the tx buffer has room for it
+    uint32_t samples_sent = 0;
+    uint32_t timeouts = 0;
+    uint64_t tx_start = host_hardware_get_step_count();
+    while(samples_sent < BENCHMARK_RX_MESSAGES) {
+        telemetry_imu_raw_t sample = {.timestamp_us = samples_sent, .accel = {120, -16000, 4000}, .gyro = {-3, 250, (int16_t)samples_sent}};
+        if(hc06_send_frame(&hc06_rtos, TELEMETRY_MSG_IMU_RAW, &sample, sizeof(sample), pdMS_TO_TICKS(100)) != HC06_RC_OK) {
+            timeouts++;
+            break;
+        }
+        samples_sent++;
+    }
+    host_hardware_run(BENCHMARK_MAX_STEPS);
+    uint64_t tx_steps = host_hardware_get_step_count() - tx_start;
+    size_t transmitted_len = host_uart_take_tx(uart0, transmitted, sizeof(transmitted));
+    telemetry_frame_decoder_feed(&decoder, transmitted, transmitted_len, check_imu_sample, NULL);
+    bool is_tx_ok = imu_samples_in_order && imu_samples_decoded == BENCHMARK_RX_MESSAGES && timeouts == 0 && decoder.frames_dropped == 0;
+
+    printf("blocking frames  %6u sent, %u timeouts, %6zu chars in %6llu steps (line needs %6zu)  %s\n", samples_sent, timeouts,
+           transmitted_len, (unsigned long long)tx_steps, (transmitted_len + HOST_UART_CHARS_PER_STEP - 1) / HOST_UART_CHARS_PER_STEP,
+           is_tx_ok ? "ok" : "LOST OR OUT OF ORDER");
+
+    // Four rx buffers' worth of messages arrive while the application isn't reading
+    size_t expected_len = 0;
+    uint32_t seed = 13u;
+    while(expected_len < 4 * sizeof(rx_buffer)) {
+        expected_len += make_message((char *)&expected[expected_len], &seed);
+    }
+
+    bool is_rx_ok = true;
+    for(int use_flow_control = 0; use_flow_control <= 1; use_flow_control++) {
+        hc06_init(&hc06_device, uart0, 0, 1, BENCHMARK_BAUDRATE, UART0_IRQ, tx_buffer, sizeof(tx_buffer), rx_buffer, sizeof(rx_buffer));
+        if(use_flow_control) {
+            hc06_enable_flow_control(&hc06_device, 2, 3);
+        }
+        host_uart_inject_rx(uart0, expected, expected_len);
+        size_t received_len = stall_and_receive(expected_len);
+        bool is_intact = (received_len == expected_len) && (memcmp(transmitted, expected, expected_len) == 0);
+
+        printf("%-16s %6zu of %6zu chars received after stalling, %u rx overruns  %s\n", use_flow_control ? "rts/cts" : "no flow control",
+               received_len, expected_len, hc06_device.rx_overrun_count, is_intact ? "ok" : use_flow_control ? "LOST" : "lost, as expected");
+        if(use_flow_control) {
+            is_rx_ok = is_intact;
+        }
+    }
+
+    // A line longer than the rx buffer stops the rx irqs once the buffer is full; the blocking call must flush it anyway
+    hc06_init(&hc06_device, uart0, 0, 1, BENCHMARK_BAUDRATE, UART0_IRQ, tx_buffer, sizeof(tx_buffer), rx_buffer, sizeof(rx_buffer));
+    hc06_enable_flow_control(&hc06_device, 2, 3);
+    hc06_rtos_init(&hc06_rtos, &hc06_device);
+    size_t line_len = sizeof(rx_buffer) + 100;
+    for(size_t i = 0; i < line_len - 1; i++) {
+        expected[i] = 'a' + i % 26;
+    }
+    expected[line_len - 1] = '\n';
+    host_uart_inject_rx(uart0, expected, line_len);
+
+    size_t received_len = 0;
+    uint32_t receives = 0;
+    while(received_len < line_len) {
+        uint16_t chars_received = 0;
+        if(hc06_receive(&hc06_rtos, (char *)&transmitted[received_len], sizeof(rx_buffer), pdMS_TO_TICKS(100), &chars_received) != HC06_RC_OK) {
+            break;
+        }
+        received_len += chars_received;
+        receives++;
+    }
+    bool is_line_ok = (received_len == line_len) && (memcmp(transmitted, expected, line_len) == 0);
+
+    printf("long line        %6zu of %6zu chars received in %u blocking receives  %s\n", received_len, line_len, receives,
+           is_line_ok ? "ok" : "STUCK ON A FULL RX BUFFER");
+
+    return is_tx_ok && is_rx_ok && is_line_ok;
+}
+
+int main(void) {
+    const uint16_t bursts[] = {1, 2, 4};
+    bool is_ok = true;
+
+    printf("hc_06 transmit, %u messages of up to %u chars each\n\n", BENCHMARK_MESSAGES, BENCHMARK_MAX_MSG_LEN);
+    for(size_t i = 0; i < sizeof(bursts) / sizeof(bursts[0]); i++) {
+        is_ok &= benchmark_tx(false, bursts[i]);
+        is_ok &= benchmark_tx(true, bursts[i]);
+    }
+
+    const uint32_t baudrates[] = {115200, 460800, 921600};
+    printf("\nhc_06 receive, %u messages of up to %u chars each, polled every %u us\n\n", BENCHMARK_RX_MESSAGES,
+           BENCHMARK_MAX_MSG_LEN, BENCHMARK_RX_POLL_US);
+    for(size_t i = 0; i < sizeof(baudrates) / sizeof(baudrates[0]); i++) {
+        is_ok &= benchmark_rx(false, baudrates[i]);
+        is_ok &= benchmark_rx(true, baudrates[i]);
+    }
+
+    printf("\nhc_06 FIFO levels, interrupt transmit and receive at 921600 baud\n\n");
+    is_ok &= benchmark_fifo_levels();
+
+    printf("hc_06 scatter-gather transmit, %u messages of 3 fragments each\n\n", BENCHMARK_MESSAGES);
+    is_ok &= benchmark_tx_msgv(false);
+    is_ok &= benchmark_tx_msgv(true);
+
+    printf("\nhc_06 telemetry frames\n\n");
+    is_ok &= benchmark_tx_frames();
+
+    printf("\nhc_06 backpressure\n\n");
+    is_ok &= benchmark_backpressure();
+
+    printf("\nhc_06 dual link, %u telemetry messages out and %u command messages in\n\n", BENCHMARK_MESSAGES, BENCHMARK_MESSAGES);
+    is_ok &= benchmark_dual_link();
+
+    printf("\nhc_06 blocking send/receive, %u messages each way\n\n", BENCHMARK_MESSAGES);
+    is_ok &= benchmark_blocking(false);
+    is_ok &= benchmark_blocking(true);
+
+    return is_ok ? 0 : 1;
+}
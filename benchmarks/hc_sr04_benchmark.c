@@ -0,0 +1,742 @@
+/**
+ * @file    hc_sr04_benchmark.c
+ * @brief   Host benchmark for the HC-SR04 driver's PIO echo capture, run against the simulated PIO and GPIOs in host/.
+ * @details Everything runs on the host's fake clock, so alarms fire at exact times and the PIO is run 125 cycles per
+ *          microsecond of fake time.
+ *          PIO capture drives the echo pin high for a known number of system clock cycles, at a random phase against the
+ *          state machine, for distances across the sensor's range, and checks the distance the driver reports is within
+ *          one count of the true pulse width. It also checks that no reading is reported before the echo ends, and that a
+ *          pulse already in progress when the sensor is reset is not counted.
+ *          Alarms checks the trigger pulse is ended by its alarm after exactly its width, that a measurement with no echo
+ *          times out after exactly the echo timeout and the sensor then measures normally, and times an IRQ mode echo.
+ *          Conversion times the fixed-point pulse width to distance conversion against the float formula it replaced,
+ *          each behind a call the compiler can't inline, and checks its error across the sensor's range
+ *          in both pulse width units. The host has an FPU, so the gap on the FPU-less RP2040, where every float operation
+ *          is a soft-float call, is larger than shown. With HCSR04_ENABLE_TEMPERATURE_COMPENSATION it also checks the
+ *          speed of sound lookup.
+ *          Filter checks the streaming median, mean and variance against recomputing them from the window after every
+ *          reading, for window sizes up to the largest, and times an update against sorting the window. It then feeds
+ *          it a noisy target with max-range and multipath spikes and a step, and checks the median rejects the spikes but
+ *          follows the step.
+ *          Adaptive runs the adaptive measurement rate against a target that is far, approaches, is close, recedes and
+ *          then leaves, and checks the rate rises as it gets close or moves, that no trigger is sent before the last
+ *          echo is back, and that the echo's round trip bounds the period when nothing else does. It then runs it as an EDF
+ *          task's jobs, and checks each trigger follows the last by the period chosen in the job before it.
+ *          Array runs four simulated sensors through the array manager, two facing the same way, one facing
+ *          elsewhere and one facing open space that never echoes. Echo edges are played back through
+ *          hcsr04_array_handle_echo_edge at the times the sensors' distances give. It checks no two sensors in a group are
+ *          ever pinged closer than the group spacing, and reports the rate each sensor achieves, against putting all the
+ *          sensors in one group. With no trigger pulse blocking the loop, every reading must match its distance.
+ *          Exits non-zero if any reading is wrong.
+ *          Usage: hc_sr04_benchmark
+ */
+
+#include <stdio.h>
+#include <time.h>
+
+#include "hc_sr04.h"
+#include "hc_sr04_array.h"
+#include "hc_sr04_filter.h"
+#include "hc_sr04_adaptive.h"
+#include "edf.h"
+#include "host_hardware.h"
+
+#define BENCHMARK_TRIGGER_PIN       7u
+#define BENCHMARK_ECHO_PIN          6u
+#define BENCHMARK_READINGS          100u
+#define BENCHMARK_MIN_DISTANCE_CM   2.0
+#define BENCHMARK_MAX_DISTANCE_CM   400.0
+#define BENCHMARK_SPEED_OF_SOUND    0.0343
+
+#define BENCHMARK_ARRAY_SENSORS     4u
+#define BENCHMARK_ARRAY_RUN_US      1000000u
+#define BENCHMARK_GROUP_SPACING_US  25000u
+#define BENCHMARK_ECHO_TIMEOUT_US   20000u
+#define BENCHMARK_ECHO_DELAY_US     200u
+#define BENCHMARK_TOLERANCE_CM      0.05f
+
+#define BENCHMARK_IRQ_TRIGGER_PIN   9u
+#define BENCHMARK_IRQ_ECHO_PIN      8u
+#define BENCHMARK_CYCLES_PER_US     (HOST_CLK_SYS_HZ / 1000000u)
+#define BENCHMARK_TRIGGER_PULSE_US  10u     // The driver's trigger pulse width
+#define BENCHMARK_CONVERSIONS       10000000u
+#define BENCHMARK_MAX_PULSE_US      23324u  // Echo from 400 cm
+
+#define BENCHMARK_FILTER_READINGS   20000u
+#define BENCHMARK_FILTER_PERIOD_US  50000u
+#define BENCHMARK_FILTER_RATE_MM_S  2000u
+#define BENCHMARK_FILTER_REJECTS    3u
+
+#define BENCHMARK_ADAPTIVE_MIN_PERIOD_US    10000u
+#define BENCHMARK_ADAPTIVE_MAX_PERIOD_US    200000u
+#define BENCHMARK_ADAPTIVE_CHANGE_PERCENT   5u
+#define BENCHMARK_ADAPTIVE_MIN_SPEED_MM_S   500u
+#define BENCHMARK_ADAPTIVE_PHASES           5u
+#define BENCHMARK_ADAPTIVE_EDF_RUN_US       2000000u
+
+static hcsr04_t hcsr04;
+static hcsr04_t irq_hcsr04;
+
+// Cycles the PIO has been run for, to keep fake time in step with it
+static uint64_t run_cycles;
+
+// Simulated sensors for the array benchmark; a distance of 0 never echoes
+static hcsr04_t array_sensors[BENCHMARK_ARRAY_SENSORS];
+static const float array_distances[BENCHMARK_ARRAY_SENSORS] = {30.0f, 60.0f, 150.0f, 0.0f};
+
+typedef struct {
+    bool is_pending;
+    bool has_risen;
+    uint32_t rise_us;
+    uint32_t fall_us;
+    uint32_t trigger_time_us;   // The trigger the echo belongs to, to spot new ones
+} simulated_echo_t;
+
+static uint32_t array_readings_off;
+
+// A stretch of the adaptive benchmark, the target moving at a constant speed from its start; a start of 0 never echoes
+typedef struct {
+    const char * name;
+    uint32_t run_us;
+    uint32_t start_mm;
+    int32_t speed_mm_s;
+} adaptive_phase_t;
+
+typedef struct {
+    uint32_t measurements;
+    uint32_t min_interval_us;   // Shortest time between triggers
+    uint32_t overlaps;          // Triggers sent while the last echo was still coming back
+} adaptive_result_t;
+
+// The float conversion, called through a pointer so it isn't inlined, like the driver's conversion in another file
+typedef float (*float_conversion_t)(uint32_t pulse_width_us);
+
+// The conversions' sum, so the compiler can't drop the conversions
+static volatile uint32_t conversion_sink;
+
+// Get the host's monotonic time in nanoseconds, the fake clock doesn't move while converting
+static uint64_t now_ns(void) {
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (uint64_t)now.tv_sec * 1000000000u + (uint64_t)now.tv_nsec;
+}
+
+// Get the echo pulse width in system clock cycles for a distance in cm
+static uint32_t distance_to_cycles(double distance) {
+    return (uint32_t)(distance * 2.0 / BENCHMARK_SPEED_OF_SOUND * (HOST_CLK_SYS_HZ / 1000000u));
+}
+
+// Get the distance in cm for an echo pulse width in system clock cycles
+static double cycles_to_distance(double cycles) {
+    return cycles / (HOST_CLK_SYS_HZ / 1000000u) * BENCHMARK_SPEED_OF_SOUND / 2.0;
+}
+
+// Run the PIO for a number of cycles, advancing fake time, and so firing alarms, every BENCHMARK_CYCLES_PER_US cycles
+static void run_for_cycles(uint32_t cycles) {
+    while(cycles > 0) {
+        uint32_t step = BENCHMARK_CYCLES_PER_US - (uint32_t)(run_cycles % BENCHMARK_CYCLES_PER_US);
+        step = step < cycles ? step : cycles;
+        host_pio_run(step);
+        run_cycles += step;
+        cycles -= step;
+        if(run_cycles % BENCHMARK_CYCLES_PER_US == 0) {
+            host_time_advance_us(1);
+        }
+    }
+}
+
+// Start a measurement and play back an echo pulse of width_cycles after delay_cycles, returns false if the driver
+// reports the echo before it has ended
+static bool play_echo(uint32_t delay_cycles, uint32_t width_cycles) {
+    bool is_ok = hcsr04_start_measurement(&hcsr04) == HCSR04_RC_OK;
+    run_for_cycles(delay_cycles);
+    host_gpio_set_input(BENCHMARK_ECHO_PIN, true);
+    run_for_cycles(width_cycles);
+    is_ok &= hcsr04_end_measurement(&hcsr04) == HCSR04_RC_NO_ECHO;
+    host_gpio_set_input(BENCHMARK_ECHO_PIN, false);
+    run_for_cycles(8);
+    return is_ok;
+}
+
+// Measure distances across the sensor's range and compare them with the pulse widths played back
+static bool benchmark_pio_capture(void) {
+    uint32_t seed = 7u;
+    double max_error_cycles = 0.0;
+    bool is_ok = true;
+
+    for(uint32_t reading = 0; reading < BENCHMARK_READINGS && is_ok; reading++) {
+        double distance = BENCHMARK_MIN_DISTANCE_CM + (BENCHMARK_MAX_DISTANCE_CM - BENCHMARK_MIN_DISTANCE_CM) * reading / (BENCHMARK_READINGS - 1);
+        seed = seed * 1103515245u + 12345u;
+        uint32_t width_cycles = distance_to_cycles(distance) + (seed >> 16) % 7u;
+        uint32_t delay_cycles = 1 + (seed >> 8) % 97u;
+
+        is_ok &= play_echo(delay_cycles, width_cycles);
+        is_ok &= hcsr04_end_measurement(&hcsr04) == HCSR04_RC_OK;
+
+        double error_cycles = (hcsr04_get_distance_cm(&hcsr04) - cycles_to_distance(width_cycles)) / cycles_to_distance(1.0);
+        error_cycles = error_cycles < 0 ? -error_cycles : error_cycles;
+        max_error_cycles = error_cycles > max_error_cycles ? error_cycles : max_error_cycles;
+    }
+    // Float rounding of the distance adds a little on top of the count's own error at the longest range
+    is_ok &= max_error_cycles <= HCSR04_PIO_CYCLES_PER_COUNT + 0.5;
+
+    printf("%-24s %10u readings, max error %.2f cycles (%.2f um), resolution %.2f um, 0 irqs/reading %s\n", "pio capture",
+           BENCHMARK_READINGS, max_error_cycles, cycles_to_distance(max_error_cycles) * 1.0e4,
+           cycles_to_distance(HCSR04_PIO_CYCLES_PER_COUNT) * 1.0e4, is_ok ? "ok" : "MISMATCH");
+    return is_ok;
+}
+
+// Reset the sensor in the middle of an echo pulse, the rest of that pulse must not show up as a reading
+static bool benchmark_pio_reset(void) {
+    uint32_t width_cycles = distance_to_cycles(100.0);
+    bool is_ok = hcsr04_start_measurement(&hcsr04) == HCSR04_RC_OK;
+    host_gpio_set_input(BENCHMARK_ECHO_PIN, true);
+    run_for_cycles(width_cycles / 2);
+    is_ok &= hcsr04_reset(&hcsr04) == HCSR04_RC_OK;
+    run_for_cycles(width_cycles / 2);
+    host_gpio_set_input(BENCHMARK_ECHO_PIN, false);
+    run_for_cycles(8);
+    is_ok &= hcsr04_end_measurement(&hcsr04) == HCSR04_RC_NO_ECHO;
+
+    // The next full pulse measures normally
+    is_ok &= play_echo(10, width_cycles);
+    is_ok &= hcsr04_end_measurement(&hcsr04) == HCSR04_RC_OK;
+    is_ok &= hcsr04_get_distance_cm(&hcsr04) > 99.99f && hcsr04_get_distance_cm(&hcsr04) < 100.01f;
+
+    printf("%-24s %-32s %s\n", "pio capture", "reset mid-pulse", is_ok ? "ok" : "MISMATCH");
+    return is_ok;
+}
+
+// Count readings further from the sensor's simulated distance than rounding the echo to whole microseconds explains
+static void check_array_reading(uint8_t index, hcsr04_t * sensor, void * context) {
+    (void)context;
+    float error = hcsr04_get_distance_cm(sensor) - array_distances[index];
+    if(error > BENCHMARK_TOLERANCE_CM || error < -BENCHMARK_TOLERANCE_CM) {
+        array_readings_off++;
+    }
+}
+
+// Check the trigger pulse and echo timeout are timed by alarms, and an IRQ mode echo is timed exactly
+static bool benchmark_alarms(void) {
+    uint32_t pulse_us = 0;
+    bool is_ok = hcsr04_start_measurement(&hcsr04) == HCSR04_RC_OK;
+    while(gpio_get(BENCHMARK_TRIGGER_PIN) && pulse_us <= BENCHMARK_TRIGGER_PULSE_US) {
+        run_for_cycles(BENCHMARK_CYCLES_PER_US);
+        pulse_us++;
+    }
+    is_ok &= pulse_us == BENCHMARK_TRIGGER_PULSE_US;
+    printf("%-24s %-32s %u us %s\n", "alarms", "trigger pulse", pulse_us, is_ok ? "ok" : "MISMATCH");
+
+    // No echo, the measurement times out the echo timeout after the trigger pulse ends
+    uint32_t wait_us = 0;
+    hcsr04_rc_t rc = HCSR04_RC_NO_ECHO;
+    while(rc == HCSR04_RC_NO_ECHO && wait_us <= HCSR04_DEFAULT_ECHO_TIMEOUT_US) {
+        run_for_cycles(BENCHMARK_CYCLES_PER_US);
+        wait_us++;
+        rc = hcsr04_end_measurement(&hcsr04);
+    }
+    is_ok &= rc == HCSR04_RC_TIMEOUT && wait_us == HCSR04_DEFAULT_ECHO_TIMEOUT_US && hcsr04.state == HCSR04_IDLE;
+
+    // The next measurement works, with the PIO restarted
+    uint32_t width_cycles = distance_to_cycles(50.0);
+    is_ok &= play_echo(20 * BENCHMARK_CYCLES_PER_US, width_cycles);
+    is_ok &= hcsr04_end_measurement(&hcsr04) == HCSR04_RC_OK;
+    is_ok &= hcsr04_get_distance_cm(&hcsr04) > 49.99f && hcsr04_get_distance_cm(&hcsr04) < 50.01f;
+    printf("%-24s %-32s %u us %s\n", "alarms", "echo timeout", wait_us, is_ok ? "ok" : "MISMATCH");
+
+    // A 1000 us echo timed by the echo pin handlers is 17.15 cm to the microsecond
+    hcsr04_init(&irq_hcsr04, BENCHMARK_IRQ_TRIGGER_PIN, BENCHMARK_IRQ_ECHO_PIN);
+    is_ok &= hcsr04_start_measurement(&irq_hcsr04) == HCSR04_RC_OK;
+    host_time_advance_us(BENCHMARK_TRIGGER_PULSE_US + BENCHMARK_ECHO_DELAY_US);
+    hcsr04_on_echo_pin_rise(&irq_hcsr04);
+    host_time_advance_us(1000);
+    hcsr04_on_echo_pin_fall(&irq_hcsr04);
+    is_ok &= hcsr04_end_measurement(&irq_hcsr04) == HCSR04_RC_OK;
+    float irq_distance = hcsr04_get_distance_cm(&irq_hcsr04);
+    is_ok &= irq_distance > 17.14f && irq_distance < 17.16f;
+
+    // The first echo timeout was cancelled, so it doesn't time out the next measurement when it would have been due
+    is_ok &= hcsr04_start_measurement(&irq_hcsr04) == HCSR04_RC_OK;
+    host_time_advance_us(HCSR04_DEFAULT_ECHO_TIMEOUT_US - 1000);
+    is_ok &= hcsr04_end_measurement(&irq_hcsr04) == HCSR04_RC_NO_ECHO && irq_hcsr04.state == HCSR04_BUSY;
+    is_ok &= hcsr04_reset(&irq_hcsr04) == HCSR04_RC_OK;
+    printf("%-24s %-32s %.2f cm %s\n", "alarms", "irq echo", irq_distance, is_ok ? "ok" : "MISMATCH");
+
+    return is_ok;
+}
+
+// The float conversion the driver used before its fixed-point one
+static float convert_float(uint32_t pulse_width_us) {
+    return ((float)pulse_width_us * (float)BENCHMARK_SPEED_OF_SOUND) / 2.0f;
+}
+
+// Time the float conversion over pulse widths across the sensor's range, returns ns per conversion
+static double time_float_conversion(volatile float_conversion_t conversion) {
+    float sum = 0.0f;
+    uint64_t start = now_ns();
+    for(uint32_t i = 0; i < BENCHMARK_CONVERSIONS; i++) {
+        sum += conversion(i % BENCHMARK_MAX_PULSE_US);
+    }
+    uint64_t elapsed = now_ns() - start;
+    conversion_sink = (uint32_t)sum;
+    return (double)elapsed / BENCHMARK_CONVERSIONS;
+}
+
+// Time the driver's fixed-point conversion over the same pulse widths, on the IRQ mode sensor whose pulse widths are in
+// microseconds, returns ns per conversion
+static double time_fixed_conversion(void) {
+    uint32_t sum = 0;
+    uint64_t start = now_ns();
+    for(uint32_t i = 0; i < BENCHMARK_CONVERSIONS; i++) {
+        sum += hcsr04_convert_pulse_width(&irq_hcsr04, i % BENCHMARK_MAX_PULSE_US);
+    }
+    uint64_t elapsed = now_ns() - start;
+    conversion_sink = sum;
+    return (double)elapsed / BENCHMARK_CONVERSIONS;
+}
+
+// Time the fixed-point conversion against the float one and check its error in microseconds and in PIO counts
+static bool benchmark_conversion(void) {
+    bool is_ok = true;
+
+    // Microseconds, against the exact distance at the default speed of sound
+    double max_error_mm = 0.0;
+    for(uint32_t pulse_width = 0; pulse_width <= BENCHMARK_MAX_PULSE_US; pulse_width++) {
+        double exact_mm = pulse_width * (HCSR04_DEFAULT_SPEED_OF_SOUND_MM_S / 1.0e6) / 2.0;
+        double error_mm = hcsr04_convert_pulse_width(&irq_hcsr04, pulse_width) / 65536.0 - exact_mm;
+        error_mm = error_mm < 0 ? -error_mm : error_mm;
+        max_error_mm = error_mm > max_error_mm ? error_mm : max_error_mm;
+    }
+
+    // PIO counts
+    double max_pio_error_mm = 0.0;
+    for(uint32_t count = 0; count <= BENCHMARK_MAX_PULSE_US * (BENCHMARK_CYCLES_PER_US / HCSR04_PIO_CYCLES_PER_COUNT); count += 7u) {
+        double exact_mm = cycles_to_distance((double)count * HCSR04_PIO_CYCLES_PER_COUNT) * 10.0;
+        double error_mm = hcsr04_convert_pulse_width(&hcsr04, count) / 65536.0 - exact_mm;
+        error_mm = error_mm < 0 ? -error_mm : error_mm;
+        max_pio_error_mm = error_mm > max_pio_error_mm ? error_mm : max_pio_error_mm;
+    }
+    is_ok &= max_error_mm < 0.001 && max_pio_error_mm < 0.001;
+    is_ok &= hcsr04_convert_pulse_width(&irq_hcsr04, UINT32_MAX) == HCSR04_DIST_NONE_MM_Q16 - 1u;
+
+    double float_ns = time_float_conversion(convert_float);
+    double fixed_ns = time_fixed_conversion();
+    printf("%-24s %-12s %10.2f ns/conversion\n", "conversion", "float", float_ns);
+    printf("%-24s %-12s %10.2f ns/conversion, max error %.4f mm (us), %.4f mm (pio) %s\n", "conversion", "fixed point",
+           fixed_ns, max_error_mm, max_pio_error_mm, is_ok ? "ok" : "MISMATCH");
+
+#if HCSR04_ENABLE_TEMPERATURE_COMPENSATION
+    // 1000 us at 20 C, halfway between 20 C and 30 C, and clamped below -20 C
+    bool is_temperature_ok = hcsr04_set_temperature(&irq_hcsr04, 200) == HCSR04_RC_OK;
+    is_temperature_ok &= hcsr04_convert_pulse_width(&irq_hcsr04, 1000) >> 16 == 171u;
+    is_temperature_ok &= hcsr04_set_temperature(&irq_hcsr04, 250) == HCSR04_RC_OK && irq_hcsr04.speed_of_sound_mm_s == 346117u;
+    is_temperature_ok &= hcsr04_set_temperature(&irq_hcsr04, -300) == HCSR04_RC_OK && irq_hcsr04.speed_of_sound_mm_s == 318941u;
+    is_temperature_ok &= hcsr04_set_temperature(&irq_hcsr04, 500) == HCSR04_RC_OK && irq_hcsr04.speed_of_sound_mm_s == 360349u;
+    printf("%-24s %-12s %s\n", "conversion", "temperature", is_temperature_ok ? "ok" : "MISMATCH");
+    is_ok &= is_temperature_ok;
+#endif
+
+    return is_ok;
+}
+
+// Get the next pseudo-random number
+static uint32_t next_random(uint32_t * seed) {
+    *seed = *seed * 1103515245u + 12345u;
+    return *seed >> 8;
+}
+
+// Sort a small array of readings in place
+static void sort_readings(uint32_t * readings, uint8_t count) {
+    for(uint8_t i = 1; i < count; i++) {
+        uint32_t reading = readings[i];
+        uint8_t j = i;
+        for(; j > 0 && readings[j - 1] > reading; j--) {
+            readings[j] = readings[j - 1];
+        }
+        readings[j] = reading;
+    }
+}
+
+// Get the median of the last count readings by sorting them, the way the filter's median is checked and timed against
+static uint32_t sorted_median(const uint32_t * history, uint32_t end, uint8_t count) {
+    uint32_t window[HCSR04_FILTER_MAX_WINDOW];
+    for(uint8_t i = 0; i < count; i++) {
+        window[i] = history[(end - count + i) % HCSR04_FILTER_MAX_WINDOW];
+    }
+    sort_readings(window, count);
+    return (count & 1u) ? window[count / 2] : (uint32_t)(((uint64_t)window[count / 2 - 1] + window[count / 2]) / 2);
+}
+
+// Check the filter's median, mean and variance against recomputing them after every reading, for a window size
+static bool check_filter_window(uint8_t window, uint32_t * seed) {
+    hcsr04_filter_t filter;
+    uint32_t history[HCSR04_FILTER_MAX_WINDOW];
+    bool is_ok = hcsr04_filter_init(&filter, window, 0, 0) == HCSR04_RC_OK;
+
+    for(uint32_t i = 0; i < BENCHMARK_FILTER_READINGS / 4 && is_ok; i++) {
+        // Few distinct values, so there are plenty of ties
+        uint32_t reading = (next_random(seed) % 64u) << 16;
+        history[i % HCSR04_FILTER_MAX_WINDOW] = reading;
+        is_ok &= hcsr04_filter_update(&filter, reading, i) == HCSR04_RC_OK;
+
+        uint8_t count = i + 1 < window ? (uint8_t)(i + 1) : window;
+        uint64_t sum = 0;
+        uint64_t sum_q8 = 0;
+        uint64_t sum_of_squares_q16 = 0;
+        for(uint8_t j = 0; j < count; j++) {
+            uint32_t value = history[(i + 1 - count + j) % HCSR04_FILTER_MAX_WINDOW];
+            sum += value;
+            sum_q8 += value >> 8;
+            sum_of_squares_q16 += (uint64_t)(value >> 8) * (value >> 8);
+        }
+        uint64_t variance = count < 2 ? 0 : (count * sum_of_squares_q16 - sum_q8 * sum_q8) / ((uint64_t)count * count);
+
+        is_ok &= hcsr04_filter_get_median(&filter) == sorted_median(history, i + 1, count);
+        is_ok &= hcsr04_filter_get_mean(&filter) == (uint32_t)(sum / count);
+        is_ok &= hcsr04_filter_get_variance(&filter) == variance;
+    }
+    return is_ok;
+}
+
+// Check the streaming statistics, time them, and run the filter on a target with spikes and a step
+static bool benchmark_filter(void) {
+    uint32_t seed = 11u;
+    bool is_ok = true;
+
+    hcsr04_filter_t filter;
+    is_ok &= hcsr04_filter_init(&filter, 0, 0, 0) == HCSR04_RC_BAD_ARG;
+    is_ok &= hcsr04_filter_init(&filter, HCSR04_FILTER_MAX_WINDOW + 1, 0, 0) == HCSR04_RC_BAD_ARG;
+    for(uint8_t window = 1; window <= HCSR04_FILTER_MAX_WINDOW; window++) {
+        is_ok &= check_filter_window(window, &seed);
+    }
+    printf("%-24s %-32s %s\n", "filter", "median/mean/variance, 1-31", is_ok ? "ok" : "MISMATCH");
+
+    // Time an update of the largest window against sorting it for every reading
+    uint32_t readings[1024];
+    for(uint32_t i = 0; i < 1024; i++) {
+        readings[i] = next_random(&seed) % (HCSR04_FILTER_MAX_RANGE_MM << 16);
+    }
+    uint32_t sink = 0;
+    hcsr04_filter_init(&filter, HCSR04_FILTER_MAX_WINDOW, 0, 0);
+    uint64_t start = now_ns();
+    for(uint32_t i = 0; i < BENCHMARK_FILTER_READINGS * 10; i++) {
+        hcsr04_filter_update(&filter, readings[i % 1024], i);
+        sink += hcsr04_filter_get_median(&filter);
+    }
+    double filter_ns = (double)(now_ns() - start) / (BENCHMARK_FILTER_READINGS * 10);
+
+    start = now_ns();
+    for(uint32_t i = 0; i < BENCHMARK_FILTER_READINGS * 10; i++) {
+        sink += sorted_median(readings, i % 1024 + HCSR04_FILTER_MAX_WINDOW, HCSR04_FILTER_MAX_WINDOW);
+    }
+    double sort_ns = (double)(now_ns() - start) / (BENCHMARK_FILTER_READINGS * 10);
+    conversion_sink = sink;
+    printf("%-24s %-12s %10.2f ns/update, sorting the window %.2f ns/update\n", "filter", "window 31", filter_ns, sort_ns);
+
+    // A target at 1 m with +-2 mm of noise, 5% max-range and 5% multipath spikes, stepping to 0.5 m halfway
+    bool is_target_ok = hcsr04_filter_init(&filter, 5, BENCHMARK_FILTER_RATE_MM_S, BENCHMARK_FILTER_REJECTS) == HCSR04_RC_OK;
+    uint32_t raw_off = 0;
+    uint32_t median_off = 0;
+    uint32_t step_readings = 0;
+    for(uint32_t i = 0; i < BENCHMARK_FILTER_READINGS; i++) {
+        uint32_t target_mm = i < BENCHMARK_FILTER_READINGS / 2 ? 1000u : 500u;
+        uint32_t noise = next_random(&seed);
+        uint32_t reading = ((target_mm - 2u) << 16) + noise % (4u << 16);
+        if(noise % 100u < 5u) {
+            reading = (HCSR04_FILTER_MAX_RANGE_MM + 200u) << 16;
+        }
+        else if(noise % 100u < 10u) {
+            reading = (target_mm * 2u) << 16;
+        }
+
+        hcsr04_filter_update(&filter, reading, i * BENCHMARK_FILTER_PERIOD_US);
+        uint32_t median_mm = hcsr04_filter_get_median(&filter) >> 16;
+        raw_off += (reading >> 16) + 3u < target_mm || (reading >> 16) > target_mm + 3u;
+        bool is_median_off = median_mm + 3u < target_mm || median_mm > target_mm + 3u;
+        if(i >= BENCHMARK_FILTER_READINGS / 2 && is_median_off && step_readings == i - BENCHMARK_FILTER_READINGS / 2) {
+            step_readings++;
+        }
+        else {
+            median_off += is_median_off;
+        }
+    }
+    // The step takes the rejected readings and half the window to get through, allowing for spikes in between
+    is_target_ok &= median_off == 0 && step_readings <= 2u * (BENCHMARK_FILTER_REJECTS + 1u + 5u / 2u);
+    printf("%-24s %-12s %5u/%u raw readings off, %u medians off, step followed in %u readings %s\n", "filter", "spikes",
+           raw_off, BENCHMARK_FILTER_READINGS, median_off, step_readings, is_target_ok ? "ok" : "MISMATCH");
+
+    return is_ok && is_target_ok;
+}
+
+// Play back the edges of a simulated echo that are due by now through the IRQ mode handlers
+static void play_adaptive_echo(hcsr04_adaptive_t * adaptive, simulated_echo_t * echo, uint32_t now) {
+    if(echo->is_pending && !echo->has_risen && (int32_t)(now - echo->rise_us) >= 0) {
+        hcsr04_on_echo_pin_rise(adaptive->sensor);
+        echo->has_risen = true;
+    }
+    if(echo->is_pending && echo->has_risen && (int32_t)(now - echo->fall_us) >= 0) {
+        hcsr04_on_echo_pin_fall(adaptive->sensor);
+        echo->is_pending = false;
+    }
+}
+
+// Schedule the echo of a trigger from a target at distance_mm, 0 never echoes
+static void schedule_adaptive_echo(simulated_echo_t * echo, uint32_t trigger_time, int64_t distance_mm) {
+    echo->trigger_time_us = trigger_time;
+    echo->is_pending = distance_mm > 0;
+    echo->has_risen = false;
+    echo->rise_us = trigger_time + BENCHMARK_TRIGGER_PULSE_US + BENCHMARK_ECHO_DELAY_US;
+    echo->fall_us = echo->rise_us + (uint32_t)(distance_mm * 0.2 / BENCHMARK_SPEED_OF_SOUND);
+}
+
+// Run an adaptive scheduler on the fake clock for a phase, playing back its echoes through the IRQ mode handlers
+static adaptive_result_t run_adaptive_phase(hcsr04_adaptive_t * adaptive, simulated_echo_t * echo, const adaptive_phase_t * phase) {
+    adaptive_result_t result = {.measurements = 0, .min_interval_us = UINT32_MAX, .overlaps = 0};
+    uint32_t start = time_us_32();
+
+    for(uint32_t now = start; now - start < phase->run_us; host_time_advance_us(1), now = time_us_32()) {
+        play_adaptive_echo(adaptive, echo, now);
+
+        hcsr04_rc_t rc = hcsr04_adaptive_poll(adaptive);
+        result.measurements += rc == HCSR04_RC_OK || rc == HCSR04_RC_TIMEOUT;
+
+        // Schedule the echo of a new trigger from where the target is now
+        uint32_t trigger_time = adaptive->trigger_time_us;
+        if(adaptive->sensor->state != HCSR04_BUSY || trigger_time == echo->trigger_time_us) {
+            continue;
+        }
+        uint32_t interval = trigger_time - echo->trigger_time_us;
+        result.min_interval_us = interval < result.min_interval_us ? interval : result.min_interval_us;
+        result.overlaps += echo->is_pending;
+
+        int64_t distance_mm = phase->start_mm > 0 ? (int64_t)phase->start_mm + (int64_t)phase->speed_mm_s * (now - start) / 1000000 : 0;
+        schedule_adaptive_echo(echo, trigger_time, distance_mm);
+    }
+
+    return result;
+}
+
+// Run the adaptive scheduler as the integration demo's EDF task does, on the fake clock: each job collects, triggers and
+// sets its period with edf_update_task_period, then sleeps to its deadline, which then moves on a period as it does when
+// the job completes. A far scene is followed by an obstacle appearing close, and each trigger must follow the last by
+// the period the last job chose, not the one before it
+static bool benchmark_adaptive_edf(void) {
+    const uint32_t us_per_tick = 1000000u / configTICK_RATE_HZ;
+    const TickType_t first_period = pdMS_TO_TICKS(BENCHMARK_ADAPTIVE_MAX_PERIOD_US / 1000u);
+    simulated_echo_t echo = {0};
+    bool is_ok = true;
+
+    hcsr04_adaptive_t adaptive;
+    hcsr04_init(&irq_hcsr04, BENCHMARK_IRQ_TRIGGER_PIN, BENCHMARK_IRQ_ECHO_PIN);
+    is_ok &= hcsr04_adaptive_init(&adaptive, &irq_hcsr04, BENCHMARK_ADAPTIVE_MIN_PERIOD_US, BENCHMARK_ADAPTIVE_MAX_PERIOD_US,
+                                  BENCHMARK_ADAPTIVE_CHANGE_PERCENT, BENCHMARK_ADAPTIVE_MIN_SPEED_MM_S) == HCSR04_RC_OK;
+
+    // Start on a tick, so jobs are released exactly on their deadlines
+    host_time_advance_us(us_per_tick - (uint32_t)(time_us_64() % us_per_tick));
+    edf_task_t task = {.task_handle = NULL, .task_deadline = xTaskGetTickCount() + first_period, .task_period = first_period,
+                       .task_state = EDF_TASK_RUNNING};
+
+    uint32_t start = time_us_32();
+    uint32_t appear_us = start + BENCHMARK_ADAPTIVE_EDF_RUN_US / 2u;
+    uint32_t chosen_us = 0;
+    uint32_t jobs = 0;
+    uint32_t lagging = 0;
+    uint32_t seen_us = 0;
+    uint32_t follow_us = 0;
+    while(time_us_32() - start < BENCHMARK_ADAPTIVE_EDF_RUN_US) {
+        uint32_t now = time_us_32();
+        bool is_close = (int32_t)(now - appear_us) >= 0;
+
+        // The job
+        hcsr04_rc_t rc = hcsr04_adaptive_collect(&adaptive);
+        if(seen_us != 0 && follow_us == 0) {
+            follow_us = now - seen_us;
+        }
+        if(rc == HCSR04_RC_OK && is_close && seen_us == 0 && adaptive.last_distance_mm_q16 < (1000u << 16)) {
+            seen_us = now;
+        }
+        if(hcsr04_adaptive_trigger(&adaptive) == HCSR04_RC_OK) {
+            if(jobs > 0 && now - echo.trigger_time_us != chosen_us) {
+                lagging++;
+            }
+            schedule_adaptive_echo(&echo, now, is_close ? 300 : 3000);
+        }
+        TickType_t period = pdMS_TO_TICKS((hcsr04_adaptive_get_period_us(&adaptive) + 999u) / 1000u);
+        period = period > 0 ? period : 1;
+        is_ok &= edf_update_task_period(&task, period, xTaskGetTickCount());
+        chosen_us = period * us_per_tick;
+        jobs++;
+
+        // Sleep until the deadline, then complete the job
+        while(xTaskGetTickCount() < task.task_deadline) {
+            host_time_advance_us(1);
+            play_adaptive_echo(&adaptive, &echo, time_us_32());
+        }
+        task.task_deadline += task.task_period;
+    }
+
+    // Once the obstacle is read, the next trigger follows within the shortest period rounded up to a tick, not the far
+    // scene's period
+    is_ok &= lagging == 0 && follow_us > 0 && follow_us <= BENCHMARK_ADAPTIVE_MIN_PERIOD_US + us_per_tick;
+    is_ok &= hcsr04_reset(&irq_hcsr04) == HCSR04_RC_OK;
+    printf("%-24s %-14s %u jobs, %u triggers off their period, next trigger %u us after the obstacle is read %s\n", "adaptive",
+           "edf task", jobs, lagging, follow_us, is_ok ? "ok" : "MISMATCH");
+    return is_ok;
+}
+
+// Run the adaptive scheduler against a far static target, one approaching and a close one, and check the rate follows
+static bool benchmark_adaptive(void) {
+    const adaptive_phase_t phases[BENCHMARK_ADAPTIVE_PHASES] = {
+        {"far, static",     2000000u, 3000u, 0},
+        {"approaching",     2700000u, 3000u, -1000},
+        {"close, static",   2000000u, 300u, 0},
+        {"receding",        2700000u, 300u, 1000},
+        {"open space",      2000000u, 0u, 0},
+    };
+    adaptive_result_t results[BENCHMARK_ADAPTIVE_PHASES];
+    simulated_echo_t echo = {0};
+    bool is_ok = true;
+
+    hcsr04_adaptive_t adaptive;
+    hcsr04_init(&irq_hcsr04, BENCHMARK_IRQ_TRIGGER_PIN, BENCHMARK_IRQ_ECHO_PIN);
+    is_ok &= hcsr04_adaptive_init(&adaptive, &irq_hcsr04, 1, 0, 1, 1) == HCSR04_RC_BAD_ARG;
+    is_ok &= hcsr04_adaptive_init(&adaptive, &irq_hcsr04, 0, 1, 0, 1) == HCSR04_RC_BAD_ARG;
+    is_ok &= hcsr04_adaptive_init(&adaptive, &irq_hcsr04, BENCHMARK_ADAPTIVE_MIN_PERIOD_US, BENCHMARK_ADAPTIVE_MAX_PERIOD_US,
+                                  BENCHMARK_ADAPTIVE_CHANGE_PERCENT, BENCHMARK_ADAPTIVE_MIN_SPEED_MM_S) == HCSR04_RC_OK;
+
+    for(uint8_t i = 0; i < BENCHMARK_ADAPTIVE_PHASES; i++) {
+        results[i] = run_adaptive_phase(&adaptive, &echo, &phases[i]);
+        float rate = results[i].measurements * 1.0e6f / phases[i].run_us;
+        is_ok &= results[i].overlaps == 0 && results[i].min_interval_us >= BENCHMARK_ADAPTIVE_MIN_PERIOD_US;
+        printf("%-24s %-14s %6.1f/s, %6u us shortest period, %u overlapping echoes\n", "adaptive", phases[i].name, rate,
+               results[i].min_interval_us, results[i].overlaps);
+    }
+
+    // Closer or moving is measured more often, and nothing to see falls back to the longest period
+    is_ok &= results[1].measurements * 1000000u / phases[1].run_us > results[0].measurements * 1000000u / phases[0].run_us;
+    is_ok &= results[2].measurements * 1000000u / phases[2].run_us > results[1].measurements * 1000000u / phases[1].run_us;
+    is_ok &= results[3].measurements * 1000000u / phases[3].run_us > results[0].measurements * 1000000u / phases[0].run_us;
+    is_ok &= results[4].measurements <= phases[4].run_us / BENCHMARK_ADAPTIVE_MAX_PERIOD_US + 1u;
+    printf("%-24s %-14s %6.1f/s %s\n", "adaptive", "overall", hcsr04_adaptive_get_rate(&adaptive), is_ok ? "ok" : "MISMATCH");
+
+    // With no lower bound on the period, the echo's round trip at 2 m bounds it instead
+    // The first trigger follows on from the last phase, so only the steady period between later ones is checked
+    const adaptive_phase_t far_fast = {"round trip", 1000000u, 2000u, 0};
+    bool is_bound_ok = hcsr04_adaptive_init(&adaptive, &irq_hcsr04, 0, BENCHMARK_ADAPTIVE_MAX_PERIOD_US, 1, 1000000u) == HCSR04_RC_OK;
+    run_adaptive_phase(&adaptive, &echo, &far_fast);
+    adaptive_result_t bound = run_adaptive_phase(&adaptive, &echo, &far_fast);
+    uint32_t round_trip_us = (adaptive.last_distance_mm_q16 >> 16) * 2000000u / HCSR04_DEFAULT_SPEED_OF_SOUND_MM_S
+                           + HCSR04_ADAPTIVE_ECHO_GUARD_US;
+    is_bound_ok &= bound.overlaps == 0 && bound.min_interval_us == round_trip_us;
+    printf("%-24s %-14s %6.1f/s, %6u us shortest period, round trip %u us %s\n", "adaptive", far_fast.name,
+           bound.measurements * 1.0e6f / far_fast.run_us, bound.min_interval_us, round_trip_us, is_bound_ok ? "ok" : "MISMATCH");
+    is_ok &= is_bound_ok;
+
+    is_ok &= hcsr04_reset(&irq_hcsr04) == HCSR04_RC_OK;
+    return is_ok;
+}
+
+// Run the array on the fake clock with the sensors in the given groups, playing back their echoes
+static bool benchmark_array(const uint8_t * groups, const char * name) {
+    hcsr04_array_t array;
+    simulated_echo_t echoes[BENCHMARK_ARRAY_SENSORS] = {0};
+    uint32_t group_trigger_us[BENCHMARK_ARRAY_SENSORS];
+    bool group_has_triggered[BENCHMARK_ARRAY_SENSORS] = {false};
+    uint32_t spacing_violations = 0;
+    bool is_ok = true;
+
+    array_readings_off = 0;
+    is_ok &= hcsr04_array_init(&array, BENCHMARK_GROUP_SPACING_US, BENCHMARK_ECHO_TIMEOUT_US, check_array_reading, NULL) == HCSR04_RC_OK;
+    for(uint8_t i = 0; i < BENCHMARK_ARRAY_SENSORS; i++) {
+        hcsr04_init(&array_sensors[i], 10 + 2 * i, 11 + 2 * i);
+        is_ok &= hcsr04_array_add(&array, &array_sensors[i], groups[i], NULL) == HCSR04_RC_OK;
+    }
+    is_ok &= hcsr04_array_add(&array, &array_sensors[0], 0, NULL) == HCSR04_RC_BAD_ARG;
+
+    uint32_t start = time_us_32();
+    for(uint32_t now = start; now - start < BENCHMARK_ARRAY_RUN_US; host_time_advance_us(1), now = time_us_32()) {
+        for(uint8_t i = 0; i < BENCHMARK_ARRAY_SENSORS; i++) {
+            simulated_echo_t * echo = &echoes[i];
+            if(echo->is_pending && !echo->has_risen && (int32_t)(now - echo->rise_us) >= 0) {
+                hcsr04_array_handle_echo_edge(&array, array_sensors[i].echo_pin, GPIO_IRQ_EDGE_RISE);
+                echo->has_risen = true;
+            }
+            if(echo->is_pending && echo->has_risen && (int32_t)(now - echo->fall_us) >= 0) {
+                hcsr04_array_handle_echo_edge(&array, array_sensors[i].echo_pin, GPIO_IRQ_EDGE_FALL);
+                echo->is_pending = false;
+            }
+        }
+
+        hcsr04_array_poll(&array);
+
+        // Schedule the echo of every new trigger, and check it kept its distance from the last one in its group
+        for(uint8_t i = 0; i < BENCHMARK_ARRAY_SENSORS; i++) {
+            uint32_t trigger_time = array.entries[i].trigger_time_us;
+            if(array_sensors[i].state != HCSR04_BUSY || trigger_time == echoes[i].trigger_time_us) {
+                continue;
+            }
+            uint8_t group = groups[i];
+            if(group_has_triggered[group] && trigger_time - group_trigger_us[group] < BENCHMARK_GROUP_SPACING_US) {
+                spacing_violations++;
+            }
+            group_trigger_us[group] = trigger_time;
+            group_has_triggered[group] = true;
+
+            echoes[i].trigger_time_us = trigger_time;
+            echoes[i].is_pending = array_distances[i] > 0.0f;
+            echoes[i].has_risen = false;
+            echoes[i].rise_us = trigger_time + BENCHMARK_TRIGGER_PULSE_US + BENCHMARK_ECHO_DELAY_US;
+            echoes[i].fall_us = echoes[i].rise_us + (uint32_t)(array_distances[i] * 2.0f / BENCHMARK_SPEED_OF_SOUND);
+        }
+    }
+
+    uint32_t total_readings = 0;
+    printf("%-24s %-12s", "array", name);
+    for(uint8_t i = 0; i < BENCHMARK_ARRAY_SENSORS; i++) {
+        total_readings += array.entries[i].readings;
+        printf(" %6.1f/s", hcsr04_array_get_rate(&array, i));
+    }
+    float total_rate = total_readings * 1.0e6f / BENCHMARK_ARRAY_RUN_US;
+
+    // Only the sensor facing open space times out
+    is_ok &= spacing_violations == 0 && array.entries[BENCHMARK_ARRAY_SENSORS - 1].readings == 0;
+    is_ok &= array.entries[BENCHMARK_ARRAY_SENSORS - 1].timeouts > 0 && array_readings_off == 0;
+    for(uint8_t i = 0; i < BENCHMARK_ARRAY_SENSORS - 1; i++) {
+        is_ok &= array.entries[i].timeouts == 0;
+    }
+
+    printf(" total %6.1f/s, %u spacing violations, %u readings off %s\n", total_rate, spacing_violations,
+           array_readings_off, is_ok ? "ok" : "MISMATCH");
+    return is_ok;
+}
+
+int main(void) {
+    bool is_ok = true;
+
+    host_time_use_fake(0);
+
+    hcsr04_init(&hcsr04, BENCHMARK_TRIGGER_PIN, BENCHMARK_ECHO_PIN);
+    if(hcsr04_enable_pio_capture(&hcsr04, pio0) != HCSR04_RC_OK) {
+        printf("Could not enable PIO capture\n");
+        return 1;
+    }
+
+    printf("hc_sr04 PIO echo capture, %.0f to %.0f cm at %u MHz\n\n", BENCHMARK_MIN_DISTANCE_CM, BENCHMARK_MAX_DISTANCE_CM,
+           HOST_CLK_SYS_HZ / 1000000u);
+    is_ok &= benchmark_pio_capture();
+    is_ok &= benchmark_pio_reset();
+    is_ok &= benchmark_alarms();
+    is_ok &= benchmark_conversion();
+    is_ok &= benchmark_filter();
+    is_ok &= benchmark_adaptive();
+    is_ok &= benchmark_adaptive_edf();
+
+    const uint8_t interleaved_groups[BENCHMARK_ARRAY_SENSORS] = {0, 0, 1, 2};
+    const uint8_t one_group[BENCHMARK_ARRAY_SENSORS] = {0, 0, 0, 0};
+    printf("\nhc_sr04 array, %u sensors at %.0f/%.0f/%.0f cm and open space, %u us group spacing, readings per second\n\n",
+           BENCHMARK_ARRAY_SENSORS, array_distances[0], array_distances[1], array_distances[2], BENCHMARK_GROUP_SPACING_US);
+    is_ok &= benchmark_array(interleaved_groups, "interleaved");
+    is_ok &= benchmark_array(one_group, "one group");
+
+    return is_ok ? 0 : 1;
+}
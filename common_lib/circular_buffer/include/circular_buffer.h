@@ -10,6 +10,15 @@
 #include <stdbool.h>
 #include <string.h>
 
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Per-buffer statistics are compiled out unless enabled, see the CIRCULAR_BUFFER_ENABLE_STATS CMake option
+#ifndef CIRCULAR_BUFFER_ENABLE_STATS
+#define CIRCULAR_BUFFER_ENABLE_STATS 0
+#endif
+
 typedef enum {
     CIRCULAR_BUFFER_RC_OK           = 0,
     CIRCULAR_BUFFER_RC_BAD_ARG      = 1,
@@ -17,12 +26,45 @@ typedef enum {
     CIRCULAR_BUFFER_RC_UNDERFLOW    = 3,
 } circular_buffer_rc_t;
 
+typedef enum {
+    CIRCULAR_BUFFER_MODE_DEFAULT    = 0,    // Physical head/tail indices wrapped with modulo, overwrites oldest element on overflow
+    CIRCULAR_BUFFER_MODE_SPSC       = 1,    // Free-running head/tail indices wrapped with a mask, lock-free for one producer and one consumer
+} circular_buffer_mode_t;
+
+typedef enum {
+    CIRCULAR_BUFFER_OVERWRITE_OLDEST    = 0,    // Pushing to a full buffer replaces the oldest element (default mode only)
+    CIRCULAR_BUFFER_REJECT_NEWEST       = 1,    // Pushing to a full buffer drops the new element
+} circular_buffer_overflow_policy_t;
+
+#if CIRCULAR_BUFFER_ENABLE_STATS
+typedef struct {
+    uint32_t pushed;            // Elements successfully pushed or committed
+    uint32_t popped;            // Elements popped or consumed
+    uint32_t overwritten;       // Oldest elements replaced by a push to a full buffer
+    uint32_t rejected;          // New elements dropped because the buffer was full
+    uint16_t high_water_mark;   // Largest number of elements stored at once
+} circular_buffer_stats_t;
+#endif
+
+typedef struct {
+    void * first;
+    uint16_t first_count;
+    void * second;
+    uint16_t second_count;
+} circular_buffer_regions_t;
+
 typedef struct {
     void * buffer;
     uint16_t buffer_capacity;
     uint8_t element_size;
+    circular_buffer_mode_t mode;
+    circular_buffer_overflow_policy_t overflow_policy;
+    uint16_t index_mask;
     volatile uint16_t head;
     volatile uint16_t tail;
+#if CIRCULAR_BUFFER_ENABLE_STATS
+    circular_buffer_stats_t stats;
+#endif
 } circular_buffer_t;
 
 /**
@@ -38,6 +80,22 @@ typedef struct {
  */
 circular_buffer_rc_t circular_buffer_init(circular_buffer_t * circular_buffer, void * buffer, uint16_t buffer_capacity, uint16_t element_size);
 
+/**
+ * @brief   Initialize a circular buffer in single-producer/single-consumer (SPSC) mode.
+ * @details Head and tail are free-running indices that are masked into the buffer, so no division is done on push/pop.
+ *          Head is only written by the producer and tail is only written by the consumer, with acquire/release ordering between them.
+ *          This allows one context (e.g. an ISR) to push while another (e.g. a task) pops without disabling interrupts.
+ *          Unlike the default mode, all buffer_capacity elements are usable and pushing to a full buffer never overwrites.
+ * @param   circular_buffer         The circular buffer struct.
+ * @param   buffer                  The fixed-size byte array used to implement the circular buffer.
+ * @param   buffer_capacity         The number of elements in the fixed-size byte array. Must be a power of two no greater than 32768.
+ * @param   element_size            The size of a single element in the circular buffer, used to navigate buffer.
+ * @return  circular_buffer_rc_t    Return code indicating operation success/failure.
+ *                                  - CIRCULAR_BUFFER_RC_OK:        Operation successful.
+ *                                  - CIRCULAR_BUFFER_RC_BAD_ARG:   An invalid argument was provided.
+ */
+circular_buffer_rc_t circular_buffer_init_spsc(circular_buffer_t * circular_buffer, void * buffer, uint16_t buffer_capacity, uint16_t element_size);
+
 /**
  * @brief   Get the current size of the circular buffer.
  * @details Is calculated from head and tail fields opposed to being stored in struct.
@@ -67,7 +125,8 @@ bool circular_buffer_is_full(circular_buffer_t * circular_buffer);
 /**
  * @brief   Push a new element onto the circular buffer.
  * @details Datatype size pushed must be consistent with existing data in the buffer.
- *          Overwrites the oldest buffer element if overflow occurs.
+ *          Overwrites the oldest buffer element if overflow occurs, unless the overflow policy is CIRCULAR_BUFFER_REJECT_NEWEST.
+ *          In SPSC mode the new element is always dropped instead, since only the consumer may move the tail.
  * @param   circular_buffer         The circular buffer struct.
  * @param   txdata                  Pointer to data to push onto buffer.
  * @param   size                    Size of the data to push.
@@ -92,4 +151,123 @@ circular_buffer_rc_t circular_buffer_push(circular_buffer_t * circular_buffer, v
  */
 circular_buffer_rc_t circular_buffer_pop(circular_buffer_t * circular_buffer, void * rxdata, uint8_t size);
 
+/**
+ * @brief   Push an array of elements onto the circular buffer.
+ * @details Copies as many elements as currently fit using at most two memcpy calls, one per contiguous span of the buffer.
+ *          Never overwrites existing elements, regardless of mode. Follows the same producer rules as push in SPSC mode.
+ * @param   circular_buffer         The circular buffer struct.
+ * @param   txdata                  Pointer to the array of elements to push onto buffer.
+ * @param   count                   Number of elements in txdata.
+ * @param   pushed                  The number of elements that were pushed (returned by reference).
+ * @return  circular_buffer_rc_t    Return code indicating operation success/failure.
+ *                                  - CIRCULAR_BUFFER_RC_OK:        Operation successful.
+ *                                  - CIRCULAR_BUFFER_RC_BAD_ARG:   An invalid argument was provided.
+ *                                  - CIRCULAR_BUFFER_RC_OVERFLOW:  Not all elements fit, use pushed to recover as needed.
+ */
+circular_buffer_rc_t circular_buffer_push_n(circular_buffer_t * circular_buffer, const void * txdata, uint16_t count, uint16_t * pushed);
+
+/**
+ * @brief   Pop an array of elements from the circular buffer.
+ * @details Copies as many elements as are available using at most two memcpy calls, one per contiguous span of the buffer.
+ *          Follows the same consumer rules as pop in SPSC mode.
+ * @param   circular_buffer         The circular buffer struct.
+ * @param   rxdata                  Pointer to the array to pop elements into, must have room for count elements.
+ * @param   count                   Maximum number of elements to pop.
+ * @param   popped                  The number of elements that were popped (returned by reference).
+ * @return  circular_buffer_rc_t    Return code indicating operation success/failure.
+ *                                  - CIRCULAR_BUFFER_RC_OK:        Operation successful.
+ *                                  - CIRCULAR_BUFFER_RC_BAD_ARG:   An invalid argument was provided.
+ *                                  - CIRCULAR_BUFFER_RC_UNDERFLOW: Fewer than count elements were available.
+ */
+circular_buffer_rc_t circular_buffer_pop_n(circular_buffer_t * circular_buffer, void * rxdata, uint16_t count, uint16_t * popped);
+
+/**
+ * @brief   Get the free space of the circular buffer as regions that can be written to in place.
+ * @details The free space is split into at most two contiguous regions when it wraps around the end of the byte array.
+ *          Written elements are not visible to the consumer until circular_buffer_commit is called.
+ *          Follows the same producer rules as push in SPSC mode.
+ * @param   circular_buffer         The circular buffer struct.
+ * @param   regions                 The contiguous free regions, in write order (returned by reference).
+ * @return  circular_buffer_rc_t    Return code indicating operation success/failure.
+ *                                  - CIRCULAR_BUFFER_RC_OK:        Operation successful.
+ *                                  - CIRCULAR_BUFFER_RC_BAD_ARG:   An invalid argument was provided.
+ *                                  - CIRCULAR_BUFFER_RC_OVERFLOW:  The circular buffer is full, both regions are empty.
+ */
+circular_buffer_rc_t circular_buffer_reserve(circular_buffer_t * circular_buffer, circular_buffer_regions_t * regions);
+
+/**
+ * @brief   Publish elements written in place to regions obtained from circular_buffer_reserve.
+ * @param   circular_buffer         The circular buffer struct.
+ * @param   count                   Number of elements written, starting from the first region.
+ * @return  circular_buffer_rc_t    Return code indicating operation success/failure.
+ *                                  - CIRCULAR_BUFFER_RC_OK:        Operation successful.
+ *                                  - CIRCULAR_BUFFER_RC_BAD_ARG:   An invalid argument was provided.
+ *                                  - CIRCULAR_BUFFER_RC_OVERFLOW:  count is larger than the free space, nothing was committed.
+ */
+circular_buffer_rc_t circular_buffer_commit(circular_buffer_t * circular_buffer, uint16_t count);
+
+/**
+ * @brief   Get the stored elements of the circular buffer as regions that can be read in place.
+ * @details The stored elements are split into at most two contiguous regions when they wrap around the end of the byte array.
+ *          Elements stay in the buffer until circular_buffer_consume is called.
+ *          Follows the same consumer rules as pop in SPSC mode.
+ * @param   circular_buffer         The circular buffer struct.
+ * @param   regions                 The contiguous stored regions, oldest first (returned by reference).
+ * @return  circular_buffer_rc_t    Return code indicating operation success/failure.
+ *                                  - CIRCULAR_BUFFER_RC_OK:        Operation successful.
+ *                                  - CIRCULAR_BUFFER_RC_BAD_ARG:   An invalid argument was provided.
+ *                                  - CIRCULAR_BUFFER_RC_UNDERFLOW: The circular buffer is empty, both regions are empty.
+ */
+circular_buffer_rc_t circular_buffer_peek(circular_buffer_t * circular_buffer, circular_buffer_regions_t * regions);
+
+/**
+ * @brief   Release elements read in place from regions obtained from circular_buffer_peek.
+ * @param   circular_buffer         The circular buffer struct.
+ * @param   count                   Number of elements read, starting from the first region.
+ * @return  circular_buffer_rc_t    Return code indicating operation success/failure.
+ *                                  - CIRCULAR_BUFFER_RC_OK:        Operation successful.
+ *                                  - CIRCULAR_BUFFER_RC_BAD_ARG:   An invalid argument was provided.
+ *                                  - CIRCULAR_BUFFER_RC_UNDERFLOW: count is larger than the stored elements, nothing was consumed.
+ */
+circular_buffer_rc_t circular_buffer_consume(circular_buffer_t * circular_buffer, uint16_t count);
+
+/**
+ * @brief   Set what happens when an element is pushed onto a full circular buffer.
+ * @details Only affects circular_buffer_push; the bulk and reserve/commit functions never overwrite.
+ * @param   circular_buffer         The circular buffer struct.
+ * @param   overflow_policy         The policy to use on overflow.
+ * @return  circular_buffer_rc_t    Return code indicating operation success/failure.
+ *                                  - CIRCULAR_BUFFER_RC_OK:        Operation successful.
+ *                                  - CIRCULAR_BUFFER_RC_BAD_ARG:   An invalid argument was provided, SPSC mode only supports CIRCULAR_BUFFER_REJECT_NEWEST.
+ */
+circular_buffer_rc_t circular_buffer_set_overflow_policy(circular_buffer_t * circular_buffer, circular_buffer_overflow_policy_t overflow_policy);
+
+#if CIRCULAR_BUFFER_ENABLE_STATS
+/**
+ * @brief   Get a snapshot of the statistics of the circular buffer.
+ * @details Counters are updated with plain increments by the context that owns them (producer or consumer),
+ *          so a snapshot taken while the buffer is in use may be off by the operations in flight.
+ * @param   circular_buffer         The circular buffer struct.
+ * @param   stats                   The statistics snapshot (returned by reference).
+ * @return  circular_buffer_rc_t    Return code indicating operation success/failure.
+ *                                  - CIRCULAR_BUFFER_RC_OK:        Operation successful.
+ *                                  - CIRCULAR_BUFFER_RC_BAD_ARG:   An invalid argument was provided.
+ */
+circular_buffer_rc_t circular_buffer_get_stats(circular_buffer_t * circular_buffer, circular_buffer_stats_t * stats);
+
+/**
+ * @brief   Reset the statistics of the circular buffer.
+ * @details The high-water mark restarts from the current size.
+ * @param   circular_buffer         The circular buffer struct.
+ * @return  circular_buffer_rc_t    Return code indicating operation success/failure.
+ *                                  - CIRCULAR_BUFFER_RC_OK:        Operation successful.
+ *                                  - CIRCULAR_BUFFER_RC_BAD_ARG:   An invalid argument was provided.
+ */
+circular_buffer_rc_t circular_buffer_reset_stats(circular_buffer_t * circular_buffer);
+#endif
+
+#ifdef __cplusplus
+}
+#endif
+
 #endif // CIRCULAR_BUFFER_H
\ No newline at end of file
@@ -0,0 +1,142 @@
+/**
+ * @file    circular_buffer_mpmc.h
+ * @brief   Defines a circular buffer that any number of producers and consumers can use at once, including across both RP2040 cores.
+ * @details Wraps a circular_buffer_t in SPSC mode and guards every operation with an RP2040 hardware spinlock.
+ *          The spinlock also disables interrupts on the calling core while it is held, so the buffer is safe to use from ISRs.
+ *          Critical sections are one bounded memcpy long; keep bulk counts small where interrupt latency matters.
+ *          Use circular_buffer_init_spsc instead when there is exactly one producer and one consumer, it needs no lock.
+ *
+ *          The lock is only used through the hardware_sync spinlock API (spin_lock_blocking/spin_unlock).
+ *          The host build provides that API on top of host atomics, so the same code runs under host threads.
+ *
+ * @section Dependencies
+ * - 'circular_buffer.h':   Provides the underlying circular buffer and return codes.
+ * - 'hardware/sync.h':     Provides the hardware spinlocks.
+ */
+
+#ifndef CIRCULAR_BUFFER_MPMC_H
+#define CIRCULAR_BUFFER_MPMC_H
+
+#include "circular_buffer.h"
+#include "hardware/sync.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct {
+    circular_buffer_t circular_buffer;
+    spin_lock_t * spin_lock;
+} circular_buffer_mpmc_t;
+
+/**
+ * @brief   Initialize a multi-producer/multi-consumer circular buffer, claiming an unused hardware spinlock for it.
+ * @details Panics if no spinlock is left to claim, like the SDK's own queue_init.
+ * @param   circular_buffer_mpmc    The MPMC circular buffer struct.
+ * @param   buffer                  The fixed-size byte array used to implement the circular buffer.
+ * @param   buffer_capacity         The number of elements in the fixed-size byte array. Must be a power of two no greater than 32768.
+ * @param   element_size            The size of a single element in the circular buffer, used to navigate buffer.
+ * @return  circular_buffer_rc_t    Return code indicating operation success/failure.
+ *                                  - CIRCULAR_BUFFER_RC_OK:        Operation successful.
+ *                                  - CIRCULAR_BUFFER_RC_BAD_ARG:   An invalid argument was provided.
+ */
+circular_buffer_rc_t circular_buffer_mpmc_init(circular_buffer_mpmc_t * circular_buffer_mpmc, void * buffer, uint16_t buffer_capacity, uint16_t element_size);
+
+/**
+ * @brief   Initialize a multi-producer/multi-consumer circular buffer using a given hardware spinlock.
+ * @details The spinlock may be shared with other buffers, at the cost of more contention.
+ * @param   circular_buffer_mpmc    The MPMC circular buffer struct.
+ * @param   buffer                  The fixed-size byte array used to implement the circular buffer.
+ * @param   buffer_capacity         The number of elements in the fixed-size byte array. Must be a power of two no greater than 32768.
+ * @param   element_size            The size of a single element in the circular buffer, used to navigate buffer.
+ * @param   spin_lock_num           The hardware spinlock to guard the buffer with.
+ * @return  circular_buffer_rc_t    Return code indicating operation success/failure.
+ *                                  - CIRCULAR_BUFFER_RC_OK:        Operation successful.
+ *                                  - CIRCULAR_BUFFER_RC_BAD_ARG:   An invalid argument was provided.
+ */
+circular_buffer_rc_t circular_buffer_mpmc_init_with_spin_lock(circular_buffer_mpmc_t * circular_buffer_mpmc, void * buffer, uint16_t buffer_capacity, uint16_t element_size, uint spin_lock_num);
+
+/**
+ * @brief   Get the current size of the MPMC circular buffer.
+ * @details May be stale as soon as it returns if other cores or ISRs are using the buffer.
+ *          Skips null arg checking for easier usage.
+ * @param   circular_buffer_mpmc    The MPMC circular buffer struct.
+ * @return  uint16_t                The number of elements stored.
+ */
+uint16_t circular_buffer_mpmc_get_size(circular_buffer_mpmc_t * circular_buffer_mpmc);
+
+/**
+ * @brief   Determine whether the MPMC circular buffer is empty.
+ * @details May be stale as soon as it returns if other cores or ISRs are using the buffer.
+ *          Skips null arg checking for easier usage.
+ * @param   circular_buffer_mpmc    The MPMC circular buffer struct.
+ * @return  bool                    Whether the circular buffer is empty.
+ */
+bool circular_buffer_mpmc_is_empty(circular_buffer_mpmc_t * circular_buffer_mpmc);
+
+/**
+ * @brief   Determine whether the MPMC circular buffer is full.
+ * @details May be stale as soon as it returns if other cores or ISRs are using the buffer.
+ *          Skips null arg checking for easier usage.
+ * @param   circular_buffer_mpmc    The MPMC circular buffer struct.
+ * @return  bool                    Whether the circular buffer is full.
+ */
+bool circular_buffer_mpmc_is_full(circular_buffer_mpmc_t * circular_buffer_mpmc);
+
+/**
+ * @brief   Push a new element onto the MPMC circular buffer.
+ * @details Pushing to a full buffer drops the new element, see circular_buffer_push in SPSC mode.
+ * @param   circular_buffer_mpmc    The MPMC circular buffer struct.
+ * @param   txdata                  Pointer to data to push onto buffer.
+ * @param   size                    Size of the data to push.
+ * @return  circular_buffer_rc_t    Return code indicating operation success/failure.
+ *                                  - CIRCULAR_BUFFER_RC_OK:        Operation successful.
+ *                                  - CIRCULAR_BUFFER_RC_BAD_ARG:   An invalid argument was provided.
+ *                                  - CIRCULAR_BUFFER_RC_OVERFLOW:  Overflow has occurred.
+ */
+circular_buffer_rc_t circular_buffer_mpmc_push(circular_buffer_mpmc_t * circular_buffer_mpmc, void * txdata, uint8_t size);
+
+/**
+ * @brief   Pop an element from the MPMC circular buffer.
+ * @param   circular_buffer_mpmc    The MPMC circular buffer struct.
+ * @param   rxdata                  Pointer to data to pop into.
+ * @param   size                    Size of the data to pop.
+ * @return  circular_buffer_rc_t    Return code indicating operation success/failure.
+ *                                  - CIRCULAR_BUFFER_RC_OK:        Operation successful.
+ *                                  - CIRCULAR_BUFFER_RC_BAD_ARG:   An invalid argument was provided.
+ *                                  - CIRCULAR_BUFFER_RC_UNDERFLOW: Underflow has occurred.
+ */
+circular_buffer_rc_t circular_buffer_mpmc_pop(circular_buffer_mpmc_t * circular_buffer_mpmc, void * rxdata, uint8_t size);
+
+/**
+ * @brief   Push an array of elements onto the MPMC circular buffer.
+ * @details The pushed elements are contiguous in the buffer, other producers can't interleave with them.
+ * @param   circular_buffer_mpmc    The MPMC circular buffer struct.
+ * @param   txdata                  Pointer to the array of elements to push onto buffer.
+ * @param   count                   Number of elements in txdata.
+ * @param   pushed                  The number of elements that were pushed (returned by reference).
+ * @return  circular_buffer_rc_t    Return code indicating operation success/failure.
+ *                                  - CIRCULAR_BUFFER_RC_OK:        Operation successful.
+ *                                  - CIRCULAR_BUFFER_RC_BAD_ARG:   An invalid argument was provided.
+ *                                  - CIRCULAR_BUFFER_RC_OVERFLOW:  Not all elements fit, use pushed to recover as needed.
+ */
+circular_buffer_rc_t circular_buffer_mpmc_push_n(circular_buffer_mpmc_t * circular_buffer_mpmc, const void * txdata, uint16_t count, uint16_t * pushed);
+
+/**
+ * @brief   Pop an array of elements from the MPMC circular buffer.
+ * @param   circular_buffer_mpmc    The MPMC circular buffer struct.
+ * @param   rxdata                  Pointer to the array to pop elements into, must have room for count elements.
+ * @param   count                   Maximum number of elements to pop.
+ * @param   popped                  The number of elements that were popped (returned by reference).
+ * @return  circular_buffer_rc_t    Return code indicating operation success/failure.
+ *                                  - CIRCULAR_BUFFER_RC_OK:        Operation successful.
+ *                                  - CIRCULAR_BUFFER_RC_BAD_ARG:   An invalid argument was provided.
+ *                                  - CIRCULAR_BUFFER_RC_UNDERFLOW: Fewer than count elements were available.
+ */
+circular_buffer_rc_t circular_buffer_mpmc_pop_n(circular_buffer_mpmc_t * circular_buffer_mpmc, void * rxdata, uint16_t count, uint16_t * popped);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // CIRCULAR_BUFFER_MPMC_H
@@ -0,0 +1,137 @@
+/**
+ * @file    circular_buffer_typed.h
+ * @brief   Defines a macro that generates a circular buffer specialized on element type and capacity at compile time.
+ * @details The generated buffer follows the same rules as circular_buffer_t in SPSC mode (see circular_buffer_init_spsc),
+ *          but the element type and capacity are known to the compiler:
+ *          - Single-element push/pop copy the element by assignment instead of a memcpy of the runtime element size.
+ *            The bulk operations still use memcpy, with a length only known at runtime.
+ *          - There is no runtime element size or argument checking; passing the wrong type is a compile error.
+ *          - The capacity is checked to be a power of two when the buffer is defined, so wraparound is always a mask.
+ *          Use circular_buffer_t when the element type or capacity is only known at runtime.
+ *
+ *          Example:
+ *              CIRCULAR_BUFFER_TYPED_DEFINE(sample_buffer, vec_int16_t, 64)
+ *
+ *              sample_buffer_t samples;
+ *              sample_buffer_init(&samples);
+ *              sample_buffer_push(&samples, &mpu_6050.accel_raw);
+ *
+ * @section Dependencies
+ * - 'circular_buffer.h':   Provides the return codes shared with the type-erased circular buffer.
+ */
+
+#ifndef CIRCULAR_BUFFER_TYPED_H
+#define CIRCULAR_BUFFER_TYPED_H
+
+#include "circular_buffer.h"
+
+#ifdef __cplusplus
+#define CIRCULAR_BUFFER_TYPED_STATIC_ASSERT(condition, message) static_assert(condition, message)
+#else
+#define CIRCULAR_BUFFER_TYPED_STATIC_ASSERT(condition, message) _Static_assert(condition, message)
+#endif
+
+/**
+ * @brief   Define a circular buffer type and its functions, specialized on element type and capacity.
+ * @details Generates the struct name##_t and the following static inline functions:
+ *          - void name##_init(name##_t *)
+ *          - uint16_t name##_get_size(name##_t *)
+ *          - bool name##_is_empty(name##_t *)
+ *          - bool name##_is_full(name##_t *)
+ *          - circular_buffer_rc_t name##_push(name##_t *, const type *)                      (producer only)
+ *          - circular_buffer_rc_t name##_pop(name##_t *, type *)                             (consumer only)
+ *          - circular_buffer_rc_t name##_push_n(name##_t *, const type *, uint16_t, uint16_t *)  (producer only)
+ *          - circular_buffer_rc_t name##_pop_n(name##_t *, type *, uint16_t, uint16_t *)        (consumer only)
+ *          Return codes follow the equivalent circular_buffer_* functions in SPSC mode. Pointers are not null checked.
+ * @param   name        Prefix for the generated type and functions.
+ * @param   type        Element type stored in the buffer.
+ * @param   capacity    Number of elements in the buffer. Must be a power of two no greater than 32768.
+ */
+#define CIRCULAR_BUFFER_TYPED_DEFINE(name, type, capacity)                                                          \
+    CIRCULAR_BUFFER_TYPED_STATIC_ASSERT((capacity) > 0 && (capacity) <= 32768 && ((capacity) & ((capacity) - 1)) == 0, \
+                                        #name " capacity must be a power of two no greater than 32768");           \
+                                                                                                                    \
+    typedef struct {                                                                                                \
+        type buffer[capacity];                                                                                      \
+        volatile uint16_t head;                                                                                     \
+        volatile uint16_t tail;                                                                                     \
+    } name##_t;                                                                                                     \
+                                                                                                                    \
+    static inline void name##_init(name##_t * circular_buffer) {                                                    \
+        circular_buffer->head = 0;                                                                                  \
+        circular_buffer->tail = 0;                                                                                  \
+    }                                                                                                               \
+                                                                                                                    \
+    static inline uint16_t name##_get_size(name##_t * circular_buffer) {                                            \
+        uint16_t tail = __atomic_load_n(&circular_buffer->tail, __ATOMIC_ACQUIRE);                                  \
+        uint16_t head = __atomic_load_n(&circular_buffer->head, __ATOMIC_ACQUIRE);                                  \
+        return (uint16_t)(head - tail);                                                                             \
+    }                                                                                                               \
+                                                                                                                    \
+    static inline bool name##_is_empty(name##_t * circular_buffer) {                                                \
+        return circular_buffer->head == circular_buffer->tail;                                                      \
+    }                                                                                                               \
+                                                                                                                    \
+    static inline bool name##_is_full(name##_t * circular_buffer) {                                                 \
+        return name##_get_size(circular_buffer) >= (capacity);                                                      \
+    }                                                                                                               \
+                                                                                                                    \
+    static inline circular_buffer_rc_t name##_push(name##_t * circular_buffer, const type * txdata) {               \
+        uint16_t head = circular_buffer->head;                                                                      \
+        uint16_t tail = __atomic_load_n(&circular_buffer->tail, __ATOMIC_ACQUIRE);                                  \
+        if((uint16_t)(head - tail) >= (capacity)) {                                                                 \
+            return CIRCULAR_BUFFER_RC_OVERFLOW;                                                                     \
+        }                                                                                                           \
+        circular_buffer->buffer[head & ((capacity) - 1)] = *txdata;                                                 \
+        __atomic_store_n(&circular_buffer->head, (uint16_t)(head + 1), __ATOMIC_RELEASE);                           \
+        return CIRCULAR_BUFFER_RC_OK;                                                                               \
+    }                                                                                                               \
+                                                                                                                    \
+    static inline circular_buffer_rc_t name##_pop(name##_t * circular_buffer, type * rxdata) {                      \
+        uint16_t tail = circular_buffer->tail;                                                                      \
+        uint16_t head = __atomic_load_n(&circular_buffer->head, __ATOMIC_ACQUIRE);                                  \
+        if(head == tail) {                                                                                          \
+            return CIRCULAR_BUFFER_RC_UNDERFLOW;                                                                    \
+        }                                                                                                           \
+        *rxdata = circular_buffer->buffer[tail & ((capacity) - 1)];                                                 \
+        __atomic_store_n(&circular_buffer->tail, (uint16_t)(tail + 1), __ATOMIC_RELEASE);                           \
+        return CIRCULAR_BUFFER_RC_OK;                                                                               \
+    }                                                                                                               \
+                                                                                                                    \
+    static inline circular_buffer_rc_t name##_push_n(name##_t * circular_buffer, const type * txdata,               \
+                                                     uint16_t count, uint16_t * pushed) {                           \
+        uint16_t head = circular_buffer->head;                                                                      \
+        uint16_t tail = __atomic_load_n(&circular_buffer->tail, __ATOMIC_ACQUIRE);                                  \
+        uint16_t free_count = (capacity) - (uint16_t)(head - tail);                                                 \
+        uint16_t push_count = (count < free_count) ? count : free_count;                                            \
+        uint16_t position = head & ((capacity) - 1);                                                                \
+        uint16_t first_count = (capacity) - position;                                                               \
+        if(first_count > push_count) {                                                                              \
+            first_count = push_count;                                                                               \
+        }                                                                                                           \
+        memcpy(&circular_buffer->buffer[position], txdata, first_count * sizeof(type));                             \
+        memcpy(&circular_buffer->buffer[0], &txdata[first_count], (push_count - first_count) * sizeof(type));       \
+        __atomic_store_n(&circular_buffer->head, (uint16_t)(head + push_count), __ATOMIC_RELEASE);                  \
+        *pushed = push_count;                                                                                       \
+        return (push_count < count) ? CIRCULAR_BUFFER_RC_OVERFLOW : CIRCULAR_BUFFER_RC_OK;                          \
+    }                                                                                                               \
+                                                                                                                    \
+    static inline circular_buffer_rc_t name##_pop_n(name##_t * circular_buffer, type * rxdata,                      \
+                                                    uint16_t count, uint16_t * popped) {                            \
+        uint16_t tail = circular_buffer->tail;                                                                      \
+        uint16_t head = __atomic_load_n(&circular_buffer->head, __ATOMIC_ACQUIRE);                                  \
+        uint16_t size = (uint16_t)(head - tail);                                                                    \
+        uint16_t pop_count = (count < size) ? count : size;                                                         \
+        uint16_t position = tail & ((capacity) - 1);                                                                \
+        uint16_t first_count = (capacity) - position;                                                               \
+        if(first_count > pop_count) {                                                                               \
+            first_count = pop_count;                                                                                \
+        }                                                                                                           \
+        memcpy(rxdata, &circular_buffer->buffer[position], first_count * sizeof(type));                             \
+        memcpy(&rxdata[first_count], &circular_buffer->buffer[0], (pop_count - first_count) * sizeof(type));        \
+        __atomic_store_n(&circular_buffer->tail, (uint16_t)(tail + pop_count), __ATOMIC_RELEASE);                   \
+        *popped = pop_count;                                                                                        \
+        return (pop_count < count) ? CIRCULAR_BUFFER_RC_UNDERFLOW : CIRCULAR_BUFFER_RC_OK;                          \
+    }
+
+#endif // CIRCULAR_BUFFER_TYPED_H
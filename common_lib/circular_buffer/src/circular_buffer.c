@@ -1,5 +1,195 @@
 #include "circular_buffer.h"
 
+// Largest capacity supported in SPSC mode; keeps (head - tail) unambiguous in 16-bit free-running indices
+#define CIRCULAR_BUFFER_SPSC_MAX_CAPACITY   32768
+
+/**
+ * @brief   Helper function that loads a head/tail index with acquire ordering.
+ * @details Guarantees that element data published before the matching release store is visible after this load.
+ * @param   index       The head or tail index to load.
+ * @return  uint16_t    The loaded index.
+ */
+static inline uint16_t load_index_acquire(volatile uint16_t * index) {
+    return __atomic_load_n(index, __ATOMIC_ACQUIRE);
+}
+
+/**
+ * @brief   Helper function that stores a head/tail index with release ordering.
+ * @details Guarantees that element data written before this store is visible to a context that loads the index with acquire ordering.
+ * @param   index       The head or tail index to store.
+ * @param   value       The new index value.
+ */
+static inline void store_index_release(volatile uint16_t * index, uint16_t value) {
+    __atomic_store_n(index, value, __ATOMIC_RELEASE);
+}
+
+/**
+ * @brief   Helper function that records pushed elements in the buffer's statistics.
+ * @details Compiles to nothing when statistics are disabled.
+ * @param   circular_buffer     The circular buffer struct.
+ * @param   count               Number of elements pushed.
+ * @param   size                Number of elements stored after the push.
+ */
+static inline void record_push(circular_buffer_t * circular_buffer, uint16_t count, uint16_t size) {
+#if CIRCULAR_BUFFER_ENABLE_STATS
+    circular_buffer->stats.pushed += count;
+    if(size > circular_buffer->stats.high_water_mark) {
+        circular_buffer->stats.high_water_mark = size;
+    }
+#endif
+}
+
+/**
+ * @brief   Helper function that records popped elements in the buffer's statistics.
+ * @details Compiles to nothing when statistics are disabled.
+ * @param   circular_buffer     The circular buffer struct.
+ * @param   count               Number of elements popped.
+ */
+static inline void record_pop(circular_buffer_t * circular_buffer, uint16_t count) {
+#if CIRCULAR_BUFFER_ENABLE_STATS
+    circular_buffer->stats.popped += count;
+#endif
+}
+
+/**
+ * @brief   Helper function that records overflowing elements in the buffer's statistics.
+ * @details Compiles to nothing when statistics are disabled.
+ * @param   circular_buffer     The circular buffer struct.
+ * @param   overwritten         Number of oldest elements replaced.
+ * @param   rejected            Number of new elements dropped.
+ */
+static inline void record_overflow(circular_buffer_t * circular_buffer, uint16_t overwritten, uint16_t rejected) {
+#if CIRCULAR_BUFFER_ENABLE_STATS
+    circular_buffer->stats.overwritten += overwritten;
+    circular_buffer->stats.rejected += rejected;
+#endif
+}
+
+/**
+ * @brief   Helper function that calculates the number of elements between a tail and head index.
+ * @param   circular_buffer     The circular buffer struct.
+ * @param   head                Head index, as stored for the buffer's mode.
+ * @param   tail                Tail index, as stored for the buffer's mode.
+ * @return  uint16_t            Number of elements stored between tail and head.
+ */
+static inline uint16_t size_between(circular_buffer_t * circular_buffer, uint16_t head, uint16_t tail) {
+    if(circular_buffer->mode == CIRCULAR_BUFFER_MODE_SPSC) {
+        return head - tail;
+    }
+    return (head >= tail) ? (head - tail) : (circular_buffer->buffer_capacity - tail + head);
+}
+
+/**
+ * @brief   Helper function that gets the number of elements the circular buffer can hold.
+ * @details The default mode keeps one slot empty to tell a full buffer from an empty one.
+ * @param   circular_buffer     The circular buffer struct.
+ * @return  uint16_t            Maximum number of stored elements.
+ */
+static inline uint16_t usable_capacity(circular_buffer_t * circular_buffer) {
+    return (circular_buffer->mode == CIRCULAR_BUFFER_MODE_SPSC) ? circular_buffer->buffer_capacity : circular_buffer->buffer_capacity - 1;
+}
+
+/**
+ * @brief   Helper function that converts a head/tail index into an element position in the byte array.
+ * @param   circular_buffer     The circular buffer struct.
+ * @param   index               Head or tail index, as stored for the buffer's mode.
+ * @return  uint16_t            Element position in the byte array.
+ */
+static inline uint16_t physical_index(circular_buffer_t * circular_buffer, uint16_t index) {
+    return (circular_buffer->mode == CIRCULAR_BUFFER_MODE_SPSC) ? (index & circular_buffer->index_mask) : index;
+}
+
+/**
+ * @brief   Helper function that moves a head/tail index forward by a number of elements.
+ * @details count must not exceed the buffer capacity, so the default mode wraps with a subtraction instead of modulo.
+ * @param   circular_buffer     The circular buffer struct.
+ * @param   index               Head or tail index, as stored for the buffer's mode.
+ * @param   count               Number of elements to move forward by.
+ * @return  uint16_t            The advanced index.
+ */
+static inline uint16_t advance_index(circular_buffer_t * circular_buffer, uint16_t index, uint16_t count) {
+    if(circular_buffer->mode == CIRCULAR_BUFFER_MODE_SPSC) {
+        return index + count;
+    }
+    uint32_t advanced = (uint32_t)index + count;
+    return (advanced >= circular_buffer->buffer_capacity) ? (advanced - circular_buffer->buffer_capacity) : advanced;
+}
+
+/**
+ * @brief   Helper function that splits a run of elements starting at a head/tail index into contiguous regions of the byte array.
+ * @param   circular_buffer     The circular buffer struct.
+ * @param   index               Head or tail index the run starts at, as stored for the buffer's mode.
+ * @param   count               Number of elements in the run, must not exceed the buffer capacity.
+ * @param   regions             The contiguous regions covering the run (returned by reference).
+ */
+static void get_regions(circular_buffer_t * circular_buffer, uint16_t index, uint16_t count, circular_buffer_regions_t * regions) {
+    uint16_t position = physical_index(circular_buffer, index);
+
+    // First region runs from index to the end of the byte array at most, the second region holds whatever wrapped around
+    uint16_t first_count = circular_buffer->buffer_capacity - position;
+    if(first_count > count) {
+        first_count = count;
+    }
+
+    regions->first = circular_buffer->buffer + (uint32_t)position * circular_buffer->element_size;
+    regions->first_count = first_count;
+    regions->second = circular_buffer->buffer;
+    regions->second_count = count - first_count;
+}
+
+/**
+ * @brief   Helper function that pushes an element onto a circular buffer in SPSC mode.
+ * @details Must only be called from the producer context. Assumes args have already been validated.
+ * @param   circular_buffer         The circular buffer struct.
+ * @param   txdata                  Pointer to data to push onto buffer.
+ * @return  circular_buffer_rc_t    Return code indicating operation success/failure.
+ */
+static circular_buffer_rc_t spsc_push(circular_buffer_t * circular_buffer, void * txdata) {
+    // Producer owns head, consumer owns tail
+    uint16_t head = circular_buffer->head;
+    uint16_t tail = load_index_acquire(&circular_buffer->tail);
+
+    // Drop new element on overflow, the oldest element belongs to the consumer
+    uint16_t size = head - tail;
+    if(size >= circular_buffer->buffer_capacity) {
+        record_overflow(circular_buffer, 0, 1);
+        return CIRCULAR_BUFFER_RC_OVERFLOW;
+    }
+
+    // Write element before publishing it by moving head
+    uint32_t head_byte_index = (uint32_t)(head & circular_buffer->index_mask) * circular_buffer->element_size;
+    memcpy((circular_buffer->buffer + head_byte_index), txdata, circular_buffer->element_size);
+    store_index_release(&circular_buffer->head, head + 1);
+    record_push(circular_buffer, 1, size + 1);
+
+    return CIRCULAR_BUFFER_RC_OK;
+}
+
+/**
+ * @brief   Helper function that pops an element from a circular buffer in SPSC mode.
+ * @details Must only be called from the consumer context. Assumes args have already been validated.
+ * @param   circular_buffer         The circular buffer struct.
+ * @param   rxdata                  Pointer to store popped data in.
+ * @return  circular_buffer_rc_t    Return code indicating operation success/failure.
+ */
+static circular_buffer_rc_t spsc_pop(circular_buffer_t * circular_buffer, void * rxdata) {
+    // Consumer owns tail, producer owns head
+    uint16_t tail = circular_buffer->tail;
+    uint16_t head = load_index_acquire(&circular_buffer->head);
+
+    if(head == tail) {
+        return CIRCULAR_BUFFER_RC_UNDERFLOW;
+    }
+
+    // Read element before releasing its slot back to the producer by moving tail
+    uint32_t tail_byte_index = (uint32_t)(tail & circular_buffer->index_mask) * circular_buffer->element_size;
+    memcpy(rxdata, (circular_buffer->buffer + tail_byte_index), circular_buffer->element_size);
+    store_index_release(&circular_buffer->tail, tail + 1);
+    record_pop(circular_buffer, 1);
+
+    return CIRCULAR_BUFFER_RC_OK;
+}
+
 /**
  * @brief   Initialize a circular buffer.
  * @details Uses void pointers to abstract away the type of data in the circular buffer.
@@ -20,10 +210,48 @@ circular_buffer_rc_t circular_buffer_init(circular_buffer_t * circular_buffer, v
     circular_buffer->buffer = buffer;
     circular_buffer->buffer_capacity = buffer_capacity;
     circular_buffer->element_size = element_size;
+    circular_buffer->mode = CIRCULAR_BUFFER_MODE_DEFAULT;
+    circular_buffer->overflow_policy = CIRCULAR_BUFFER_OVERWRITE_OLDEST;
+    circular_buffer->index_mask = 0;
 
     // initialize circular buffer to an empty state
     circular_buffer->head = 0;
     circular_buffer->tail = 0;
+#if CIRCULAR_BUFFER_ENABLE_STATS
+    memset(&circular_buffer->stats, 0, sizeof(circular_buffer->stats));
+#endif
+
+    return CIRCULAR_BUFFER_RC_OK;
+}
+
+/**
+ * @brief   Initialize a circular buffer in single-producer/single-consumer (SPSC) mode.
+ * @details Head and tail are free-running indices that are masked into the buffer, so no division is done on push/pop.
+ *          Head is only written by the producer and tail is only written by the consumer, with acquire/release ordering between them.
+ *          This allows one context (e.g. an ISR) to push while another (e.g. a task) pops without disabling interrupts.
+ *          Unlike the default mode, all buffer_capacity elements are usable and pushing to a full buffer never overwrites.
+ * @param   circular_buffer         The circular buffer struct.
+ * @param   buffer                  The fixed-size byte array used to implement the circular buffer.
+ * @param   buffer_capacity         The number of elements in the fixed-size byte array. Must be a power of two no greater than 32768.
+ * @param   element_size            The size of a single element in the circular buffer, used to navigate buffer.
+ * @return  circular_buffer_rc_t    Return code indicating operation success/failure.
+ *                                  - CIRCULAR_BUFFER_RC_OK:        Operation successful.
+ *                                  - CIRCULAR_BUFFER_RC_BAD_ARG:   An invalid argument was provided.
+ */
+circular_buffer_rc_t circular_buffer_init_spsc(circular_buffer_t * circular_buffer, void * buffer, uint16_t buffer_capacity, uint16_t element_size) {
+    // Capacity must be a power of two for masking to replace modulo
+    if(buffer_capacity == 0 || buffer_capacity > CIRCULAR_BUFFER_SPSC_MAX_CAPACITY || (buffer_capacity & (buffer_capacity - 1)) != 0) {
+        return CIRCULAR_BUFFER_RC_BAD_ARG;
+    }
+
+    circular_buffer_rc_t rc = circular_buffer_init(circular_buffer, buffer, buffer_capacity, element_size);
+    if(rc != CIRCULAR_BUFFER_RC_OK) {
+        return rc;
+    }
+
+    circular_buffer->mode = CIRCULAR_BUFFER_MODE_SPSC;
+    circular_buffer->overflow_policy = CIRCULAR_BUFFER_REJECT_NEWEST;
+    circular_buffer->index_mask = buffer_capacity - 1;
 
     return CIRCULAR_BUFFER_RC_OK;
 }
@@ -35,6 +263,13 @@ circular_buffer_rc_t circular_buffer_init(circular_buffer_t * circular_buffer, v
  * @param   circular_buffer     The circular buffer struct.
  */
 uint16_t circular_buffer_get_size(circular_buffer_t * circular_buffer) {
+    // Free-running indices wrap naturally in 16-bit arithmetic
+    if(circular_buffer->mode == CIRCULAR_BUFFER_MODE_SPSC) {
+        uint16_t tail = load_index_acquire(&circular_buffer->tail);
+        uint16_t head = load_index_acquire(&circular_buffer->head);
+        return head - tail;
+    }
+
     // calculation depends on whether the buffer is in a wraparound state
     if(circular_buffer->head >= circular_buffer->tail) {
         return circular_buffer->head - circular_buffer->tail;
@@ -63,13 +298,18 @@ bool circular_buffer_is_empty(circular_buffer_t * circular_buffer) {
  * @return  bool                Whether the circular buffer is full.
  */
 bool circular_buffer_is_full(circular_buffer_t * circular_buffer) {
+    if(circular_buffer->mode == CIRCULAR_BUFFER_MODE_SPSC) {
+        return circular_buffer_get_size(circular_buffer) >= circular_buffer->buffer_capacity;
+    }
+
     return ((circular_buffer->head + 1) % circular_buffer->buffer_capacity) == circular_buffer->tail;
 }
 
 /**
  * @brief   Push a new element onto the circular buffer.
  * @details Datatype size pushed must be consistent with existing data in the buffer.
- *          Overwrites the oldest buffer element if overflow occurs.
+ *          Overwrites the oldest buffer element if overflow occurs, unless the overflow policy is CIRCULAR_BUFFER_REJECT_NEWEST.
+ *          In SPSC mode the new element is always dropped instead, since only the consumer may move the tail.
  * @param   circular_buffer         The circular buffer struct.
  * @param   txdata                  Pointer to data to push onto buffer.
  * @param   size                    Size of the data to push.
@@ -83,18 +323,33 @@ circular_buffer_rc_t circular_buffer_push(circular_buffer_t * circular_buffer, v
         return CIRCULAR_BUFFER_RC_BAD_ARG;
     }
 
+    if(circular_buffer->mode == CIRCULAR_BUFFER_MODE_SPSC) {
+        return spsc_push(circular_buffer, txdata);
+    }
+
     circular_buffer_rc_t rc = CIRCULAR_BUFFER_RC_OK;
 
-    // Overwrite oldest buffer element if overflow occurs by incrementing tail position
     if(circular_buffer_is_full(circular_buffer)) {
+        // Drop new element if overflow occurs and the policy says to keep the oldest data
+        if(circular_buffer->overflow_policy == CIRCULAR_BUFFER_REJECT_NEWEST) {
+            record_overflow(circular_buffer, 0, 1);
+            return CIRCULAR_BUFFER_RC_OVERFLOW;
+        }
+
+        // Overwrite oldest buffer element if overflow occurs by incrementing tail position
         circular_buffer->tail = (circular_buffer->tail + 1) % circular_buffer->buffer_capacity;
+        record_overflow(circular_buffer, 1, 0);
         rc = CIRCULAR_BUFFER_RC_OVERFLOW;
     }
 
     // Push new element to head and increment head position
-    uint16_t head_byte_index = circular_buffer->head * circular_buffer->element_size;
+    uint32_t head_byte_index = (uint32_t)circular_buffer->head * circular_buffer->element_size;
     memcpy((circular_buffer->buffer + head_byte_index), txdata, circular_buffer->element_size);
     circular_buffer->head = (circular_buffer->head + 1) % circular_buffer->buffer_capacity;
+#if CIRCULAR_BUFFER_ENABLE_STATS
+    // Only read the size back when it is recorded, head and tail are volatile so the read can't be optimized out
+    record_push(circular_buffer, 1, circular_buffer_get_size(circular_buffer));
+#endif
 
     return rc;
 }
@@ -116,15 +371,284 @@ circular_buffer_rc_t circular_buffer_pop(circular_buffer_t * circular_buffer, vo
         return CIRCULAR_BUFFER_RC_BAD_ARG;
     }
 
+    if(circular_buffer->mode == CIRCULAR_BUFFER_MODE_SPSC) {
+        return spsc_pop(circular_buffer, rxdata);
+    }
+
     // Catch popping from an empty buffer
     if(circular_buffer_is_empty(circular_buffer)) {
         return CIRCULAR_BUFFER_RC_UNDERFLOW;
     }
 
     // Pop element from circular buffer and increment tail position
-    uint16_t tail_byte_index = circular_buffer->tail * circular_buffer->element_size;
+    uint32_t tail_byte_index = (uint32_t)circular_buffer->tail * circular_buffer->element_size;
     memcpy(rxdata, (circular_buffer->buffer + tail_byte_index), circular_buffer->element_size);
     circular_buffer->tail = (circular_buffer->tail + 1) % circular_buffer->buffer_capacity;
+    record_pop(circular_buffer, 1);
+
+    return CIRCULAR_BUFFER_RC_OK;
+}
+
+/**
+ * @brief   Push an array of elements onto the circular buffer.
+ * @details Copies as many elements as currently fit using at most two memcpy calls, one per contiguous span of the buffer.
+ *          Never overwrites existing elements, regardless of mode. Follows the same producer rules as push in SPSC mode.
+ * @param   circular_buffer         The circular buffer struct.
+ * @param   txdata                  Pointer to the array of elements to push onto buffer.
+ * @param   count                   Number of elements in txdata.
+ * @param   pushed                  The number of elements that were pushed (returned by reference).
+ * @return  circular_buffer_rc_t    Return code indicating operation success/failure.
+ *                                  - CIRCULAR_BUFFER_RC_OK:        Operation successful.
+ *                                  - CIRCULAR_BUFFER_RC_BAD_ARG:   An invalid argument was provided.
+ *                                  - CIRCULAR_BUFFER_RC_OVERFLOW:  Not all elements fit, use pushed to recover as needed.
+ */
+circular_buffer_rc_t circular_buffer_push_n(circular_buffer_t * circular_buffer, const void * txdata, uint16_t count, uint16_t * pushed) {
+    if(circular_buffer == NULL || txdata == NULL || pushed == NULL) {
+        return CIRCULAR_BUFFER_RC_BAD_ARG;
+    }
+
+    // Producer owns head, consumer owns tail
+    uint16_t head = circular_buffer->head;
+    uint16_t tail = load_index_acquire(&circular_buffer->tail);
+
+    // Only push as many elements as there is free space for
+    uint16_t size = size_between(circular_buffer, head, tail);
+    uint16_t free_count = usable_capacity(circular_buffer) - size;
+    uint16_t push_count = (count < free_count) ? count : free_count;
+
+    // Copy into the region from head to the end of the byte array, then into the wrapped region at the start of the byte array
+    circular_buffer_regions_t regions;
+    get_regions(circular_buffer, head, push_count, &regions);
+    uint32_t first_bytes = (uint32_t)regions.first_count * circular_buffer->element_size;
+    memcpy(regions.first, txdata, first_bytes);
+    memcpy(regions.second, ((const uint8_t *)txdata + first_bytes), (uint32_t)regions.second_count * circular_buffer->element_size);
+
+    // Publish all pushed elements at once
+    store_index_release(&circular_buffer->head, advance_index(circular_buffer, head, push_count));
+    record_push(circular_buffer, push_count, size + push_count);
+    record_overflow(circular_buffer, 0, count - push_count);
+
+    *pushed = push_count;
+    return (push_count < count) ? CIRCULAR_BUFFER_RC_OVERFLOW : CIRCULAR_BUFFER_RC_OK;
+}
+
+/**
+ * @brief   Pop an array of elements from the circular buffer.
+ * @details Copies as many elements as are available using at most two memcpy calls, one per contiguous span of the buffer.
+ *          Follows the same consumer rules as pop in SPSC mode.
+ * @param   circular_buffer         The circular buffer struct.
+ * @param   rxdata                  Pointer to the array to pop elements into, must have room for count elements.
+ * @param   count                   Maximum number of elements to pop.
+ * @param   popped                  The number of elements that were popped (returned by reference).
+ * @return  circular_buffer_rc_t    Return code indicating operation success/failure.
+ *                                  - CIRCULAR_BUFFER_RC_OK:        Operation successful.
+ *                                  - CIRCULAR_BUFFER_RC_BAD_ARG:   An invalid argument was provided.
+ *                                  - CIRCULAR_BUFFER_RC_UNDERFLOW: Fewer than count elements were available.
+ */
+circular_buffer_rc_t circular_buffer_pop_n(circular_buffer_t * circular_buffer, void * rxdata, uint16_t count, uint16_t * popped) {
+    if(circular_buffer == NULL || rxdata == NULL || popped == NULL) {
+        return CIRCULAR_BUFFER_RC_BAD_ARG;
+    }
+
+    // Consumer owns tail, producer owns head
+    uint16_t tail = circular_buffer->tail;
+    uint16_t head = load_index_acquire(&circular_buffer->head);
+
+    // Only pop as many elements as are stored
+    uint16_t size = size_between(circular_buffer, head, tail);
+    uint16_t pop_count = (count < size) ? count : size;
+
+    // Copy from the region from tail to the end of the byte array, then from the wrapped region at the start of the byte array
+    circular_buffer_regions_t regions;
+    get_regions(circular_buffer, tail, pop_count, &regions);
+    uint32_t first_bytes = (uint32_t)regions.first_count * circular_buffer->element_size;
+    memcpy(rxdata, regions.first, first_bytes);
+    memcpy(((uint8_t *)rxdata + first_bytes), regions.second, (uint32_t)regions.second_count * circular_buffer->element_size);
+
+    // Release all popped slots back to the producer at once
+    store_index_release(&circular_buffer->tail, advance_index(circular_buffer, tail, pop_count));
+    record_pop(circular_buffer, pop_count);
+
+    *popped = pop_count;
+    return (pop_count < count) ? CIRCULAR_BUFFER_RC_UNDERFLOW : CIRCULAR_BUFFER_RC_OK;
+}
+
+/**
+ * @brief   Get the free space of the circular buffer as regions that can be written to in place.
+ * @details The free space is split into at most two contiguous regions when it wraps around the end of the byte array.
+ *          Written elements are not visible to the consumer until circular_buffer_commit is called.
+ *          Follows the same producer rules as push in SPSC mode.
+ * @param   circular_buffer         The circular buffer struct.
+ * @param   regions                 The contiguous free regions, in write order (returned by reference).
+ * @return  circular_buffer_rc_t    Return code indicating operation success/failure.
+ *                                  - CIRCULAR_BUFFER_RC_OK:        Operation successful.
+ *                                  - CIRCULAR_BUFFER_RC_BAD_ARG:   An invalid argument was provided.
+ *                                  - CIRCULAR_BUFFER_RC_OVERFLOW:  The circular buffer is full, both regions are empty.
+ */
+circular_buffer_rc_t circular_buffer_reserve(circular_buffer_t * circular_buffer, circular_buffer_regions_t * regions) {
+    if(circular_buffer == NULL || regions == NULL) {
+        return CIRCULAR_BUFFER_RC_BAD_ARG;
+    }
+
+    // Producer owns head, consumer owns tail
+    uint16_t head = circular_buffer->head;
+    uint16_t tail = load_index_acquire(&circular_buffer->tail);
+
+    // Free space starts at head
+    uint16_t free_count = usable_capacity(circular_buffer) - size_between(circular_buffer, head, tail);
+    get_regions(circular_buffer, head, free_count, regions);
+
+    return (free_count == 0) ? CIRCULAR_BUFFER_RC_OVERFLOW : CIRCULAR_BUFFER_RC_OK;
+}
+
+/**
+ * @brief   Publish elements written in place to regions obtained from circular_buffer_reserve.
+ * @param   circular_buffer         The circular buffer struct.
+ * @param   count                   Number of elements written, starting from the first region.
+ * @return  circular_buffer_rc_t    Return code indicating operation success/failure.
+ *                                  - CIRCULAR_BUFFER_RC_OK:        Operation successful.
+ *                                  - CIRCULAR_BUFFER_RC_BAD_ARG:   An invalid argument was provided.
+ *                                  - CIRCULAR_BUFFER_RC_OVERFLOW:  count is larger than the free space, nothing was committed.
+ */
+circular_buffer_rc_t circular_buffer_commit(circular_buffer_t * circular_buffer, uint16_t count) {
+    if(circular_buffer == NULL) {
+        return CIRCULAR_BUFFER_RC_BAD_ARG;
+    }
+
+    uint16_t head = circular_buffer->head;
+    uint16_t tail = load_index_acquire(&circular_buffer->tail);
+
+    // Catch committing more than was reserved
+    uint16_t size = size_between(circular_buffer, head, tail);
+    if(count > usable_capacity(circular_buffer) - size) {
+        return CIRCULAR_BUFFER_RC_OVERFLOW;
+    }
+
+    // Publish elements written in place
+    store_index_release(&circular_buffer->head, advance_index(circular_buffer, head, count));
+    record_push(circular_buffer, count, size + count);
 
     return CIRCULAR_BUFFER_RC_OK;
-}
\ No newline at end of file
+}
+
+/**
+ * @brief   Get the stored elements of the circular buffer as regions that can be read in place.
+ * @details The stored elements are split into at most two contiguous regions when they wrap around the end of the byte array.
+ *          Elements stay in the buffer until circular_buffer_consume is called.
+ *          Follows the same consumer rules as pop in SPSC mode.
+ * @param   circular_buffer         The circular buffer struct.
+ * @param   regions                 The contiguous stored regions, oldest first (returned by reference).
+ * @return  circular_buffer_rc_t    Return code indicating operation success/failure.
+ *                                  - CIRCULAR_BUFFER_RC_OK:        Operation successful.
+ *                                  - CIRCULAR_BUFFER_RC_BAD_ARG:   An invalid argument was provided.
+ *                                  - CIRCULAR_BUFFER_RC_UNDERFLOW: The circular buffer is empty, both regions are empty.
+ */
+circular_buffer_rc_t circular_buffer_peek(circular_buffer_t * circular_buffer, circular_buffer_regions_t * regions) {
+    if(circular_buffer == NULL || regions == NULL) {
+        return CIRCULAR_BUFFER_RC_BAD_ARG;
+    }
+
+    // Consumer owns tail, producer owns head
+    uint16_t tail = circular_buffer->tail;
+    uint16_t head = load_index_acquire(&circular_buffer->head);
+
+    // Stored elements start at tail
+    uint16_t size = size_between(circular_buffer, head, tail);
+    get_regions(circular_buffer, tail, size, regions);
+
+    return (size == 0) ? CIRCULAR_BUFFER_RC_UNDERFLOW : CIRCULAR_BUFFER_RC_OK;
+}
+
+/**
+ * @brief   Release elements read in place from regions obtained from circular_buffer_peek.
+ * @param   circular_buffer         The circular buffer struct.
+ * @param   count                   Number of elements read, starting from the first region.
+ * @return  circular_buffer_rc_t    Return code indicating operation success/failure.
+ *                                  - CIRCULAR_BUFFER_RC_OK:        Operation successful.
+ *                                  - CIRCULAR_BUFFER_RC_BAD_ARG:   An invalid argument was provided.
+ *                                  - CIRCULAR_BUFFER_RC_UNDERFLOW: count is larger than the stored elements, nothing was consumed.
+ */
+circular_buffer_rc_t circular_buffer_consume(circular_buffer_t * circular_buffer, uint16_t count) {
+    if(circular_buffer == NULL) {
+        return CIRCULAR_BUFFER_RC_BAD_ARG;
+    }
+
+    uint16_t tail = circular_buffer->tail;
+    uint16_t head = load_index_acquire(&circular_buffer->head);
+
+    // Catch consuming more than is stored
+    if(count > size_between(circular_buffer, head, tail)) {
+        return CIRCULAR_BUFFER_RC_UNDERFLOW;
+    }
+
+    // Release slots read in place back to the producer
+    store_index_release(&circular_buffer->tail, advance_index(circular_buffer, tail, count));
+    record_pop(circular_buffer, count);
+
+    return CIRCULAR_BUFFER_RC_OK;
+}
+
+/**
+ * @brief   Set what happens when an element is pushed onto a full circular buffer.
+ * @details Only affects circular_buffer_push; the bulk and reserve/commit functions never overwrite.
+ * @param   circular_buffer         The circular buffer struct.
+ * @param   overflow_policy         The policy to use on overflow.
+ * @return  circular_buffer_rc_t    Return code indicating operation success/failure.
+ *                                  - CIRCULAR_BUFFER_RC_OK:        Operation successful.
+ *                                  - CIRCULAR_BUFFER_RC_BAD_ARG:   An invalid argument was provided, SPSC mode only supports CIRCULAR_BUFFER_REJECT_NEWEST.
+ */
+circular_buffer_rc_t circular_buffer_set_overflow_policy(circular_buffer_t * circular_buffer, circular_buffer_overflow_policy_t overflow_policy) {
+    if(circular_buffer == NULL || (overflow_policy != CIRCULAR_BUFFER_OVERWRITE_OLDEST && overflow_policy != CIRCULAR_BUFFER_REJECT_NEWEST)) {
+        return CIRCULAR_BUFFER_RC_BAD_ARG;
+    }
+
+    // Overwriting would require the producer to move the tail, which belongs to the consumer in SPSC mode
+    if(circular_buffer->mode == CIRCULAR_BUFFER_MODE_SPSC && overflow_policy != CIRCULAR_BUFFER_REJECT_NEWEST) {
+        return CIRCULAR_BUFFER_RC_BAD_ARG;
+    }
+
+    circular_buffer->overflow_policy = overflow_policy;
+
+    return CIRCULAR_BUFFER_RC_OK;
+}
+
+#if CIRCULAR_BUFFER_ENABLE_STATS
+/**
+ * @brief   Get a snapshot of the statistics of the circular buffer.
+ * @details Counters are updated with plain increments by the context that owns them (producer or consumer),
+ *          so a snapshot taken while the buffer is in use may be off by the operations in flight.
+ * @param   circular_buffer         The circular buffer struct.
+ * @param   stats                   The statistics snapshot (returned by reference).
+ * @return  circular_buffer_rc_t    Return code indicating operation success/failure.
+ *                                  - CIRCULAR_BUFFER_RC_OK:        Operation successful.
+ *                                  - CIRCULAR_BUFFER_RC_BAD_ARG:   An invalid argument was provided.
+ */
+circular_buffer_rc_t circular_buffer_get_stats(circular_buffer_t * circular_buffer, circular_buffer_stats_t * stats) {
+    if(circular_buffer == NULL || stats == NULL) {
+        return CIRCULAR_BUFFER_RC_BAD_ARG;
+    }
+
+    *stats = circular_buffer->stats;
+
+    return CIRCULAR_BUFFER_RC_OK;
+}
+
+/**
+ * @brief   Reset the statistics of the circular buffer.
+ * @details The high-water mark restarts from the current size.
+ * @param   circular_buffer         The circular buffer struct.
+ * @return  circular_buffer_rc_t    Return code indicating operation success/failure.
+ *                                  - CIRCULAR_BUFFER_RC_OK:        Operation successful.
+ *                                  - CIRCULAR_BUFFER_RC_BAD_ARG:   An invalid argument was provided.
+ */
+circular_buffer_rc_t circular_buffer_reset_stats(circular_buffer_t * circular_buffer) {
+    if(circular_buffer == NULL) {
+        return CIRCULAR_BUFFER_RC_BAD_ARG;
+    }
+
+    memset(&circular_buffer->stats, 0, sizeof(circular_buffer->stats));
+    circular_buffer->stats.high_water_mark = circular_buffer_get_size(circular_buffer);
+
+    return CIRCULAR_BUFFER_RC_OK;
+}
+#endif
\ No newline at end of file
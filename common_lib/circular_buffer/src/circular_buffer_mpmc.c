@@ -0,0 +1,211 @@
+#include "circular_buffer_mpmc.h"
+
+/**
+ * @brief   Helper function that takes the buffer's spinlock, disabling interrupts on this core until it is released.
+ * @details All locking goes through this and unlock, so the lock can be swapped without touching the buffer operations.
+ * @param   circular_buffer_mpmc    The MPMC circular buffer struct.
+ * @return  uint32_t                The interrupt state to restore on unlock.
+ */
+static inline uint32_t lock(circular_buffer_mpmc_t * circular_buffer_mpmc) {
+    return spin_lock_blocking(circular_buffer_mpmc->spin_lock);
+}
+
+/**
+ * @brief   Helper function that releases the buffer's spinlock and restores interrupts on this core.
+ * @param   circular_buffer_mpmc    The MPMC circular buffer struct.
+ * @param   saved_irq               The interrupt state returned by lock.
+ */
+static inline void unlock(circular_buffer_mpmc_t * circular_buffer_mpmc, uint32_t saved_irq) {
+    spin_unlock(circular_buffer_mpmc->spin_lock, saved_irq);
+}
+
+/**
+ * @brief   Initialize a multi-producer/multi-consumer circular buffer, claiming an unused hardware spinlock for it.
+ * @details Panics if no spinlock is left to claim, like the SDK's own queue_init.
+ * @param   circular_buffer_mpmc    The MPMC circular buffer struct.
+ * @param   buffer                  The fixed-size byte array used to implement the circular buffer.
+ * @param   buffer_capacity         The number of elements in the fixed-size byte array. Must be a power of two no greater than 32768.
+ * @param   element_size            The size of a single element in the circular buffer, used to navigate buffer.
+ * @return  circular_buffer_rc_t    Return code indicating operation success/failure.
+ *                                  - CIRCULAR_BUFFER_RC_OK:        Operation successful.
+ *                                  - CIRCULAR_BUFFER_RC_BAD_ARG:   An invalid argument was provided.
+ */
+circular_buffer_rc_t circular_buffer_mpmc_init(circular_buffer_mpmc_t * circular_buffer_mpmc, void * buffer, uint16_t buffer_capacity, uint16_t element_size) {
+    if(circular_buffer_mpmc == NULL) {
+        return CIRCULAR_BUFFER_RC_BAD_ARG;
+    }
+
+    circular_buffer_rc_t rc = circular_buffer_init_spsc(&circular_buffer_mpmc->circular_buffer, buffer, buffer_capacity, element_size);
+    if(rc != CIRCULAR_BUFFER_RC_OK) {
+        return rc;
+    }
+
+    circular_buffer_mpmc->spin_lock = spin_lock_init((uint)spin_lock_claim_unused(true));
+
+    return CIRCULAR_BUFFER_RC_OK;
+}
+
+/**
+ * @brief   Initialize a multi-producer/multi-consumer circular buffer using a given hardware spinlock.
+ * @details The spinlock may be shared with other buffers, at the cost of more contention.
+ * @param   circular_buffer_mpmc    The MPMC circular buffer struct.
+ * @param   buffer                  The fixed-size byte array used to implement the circular buffer.
+ * @param   buffer_capacity         The number of elements in the fixed-size byte array. Must be a power of two no greater than 32768.
+ * @param   element_size            The size of a single element in the circular buffer, used to navigate buffer.
+ * @param   spin_lock_num           The hardware spinlock to guard the buffer with.
+ * @return  circular_buffer_rc_t    Return code indicating operation success/failure.
+ *                                  - CIRCULAR_BUFFER_RC_OK:        Operation successful.
+ *                                  - CIRCULAR_BUFFER_RC_BAD_ARG:   An invalid argument was provided.
+ */
+circular_buffer_rc_t circular_buffer_mpmc_init_with_spin_lock(circular_buffer_mpmc_t * circular_buffer_mpmc, void * buffer, uint16_t buffer_capacity, uint16_t element_size, uint spin_lock_num) {
+    if(circular_buffer_mpmc == NULL || spin_lock_num >= NUM_SPIN_LOCKS) {
+        return CIRCULAR_BUFFER_RC_BAD_ARG;
+    }
+
+    circular_buffer_rc_t rc = circular_buffer_init_spsc(&circular_buffer_mpmc->circular_buffer, buffer, buffer_capacity, element_size);
+    if(rc != CIRCULAR_BUFFER_RC_OK) {
+        return rc;
+    }
+
+    // Don't reset the lock, another buffer sharing it may be holding it
+    circular_buffer_mpmc->spin_lock = spin_lock_instance(spin_lock_num);
+
+    return CIRCULAR_BUFFER_RC_OK;
+}
+
+/**
+ * @brief   Get the current size of the MPMC circular buffer.
+ * @details May be stale as soon as it returns if other cores or ISRs are using the buffer.
+ *          Skips null arg checking for easier usage.
+ * @param   circular_buffer_mpmc    The MPMC circular buffer struct.
+ * @return  uint16_t                The number of elements stored.
+ */
+uint16_t circular_buffer_mpmc_get_size(circular_buffer_mpmc_t * circular_buffer_mpmc) {
+    uint32_t saved_irq = lock(circular_buffer_mpmc);
+    uint16_t size = circular_buffer_get_size(&circular_buffer_mpmc->circular_buffer);
+    unlock(circular_buffer_mpmc, saved_irq);
+
+    return size;
+}
+
+/**
+ * @brief   Determine whether the MPMC circular buffer is empty.
+ * @details May be stale as soon as it returns if other cores or ISRs are using the buffer.
+ *          Skips null arg checking for easier usage.
+ * @param   circular_buffer_mpmc    The MPMC circular buffer struct.
+ * @return  bool                    Whether the circular buffer is empty.
+ */
+bool circular_buffer_mpmc_is_empty(circular_buffer_mpmc_t * circular_buffer_mpmc) {
+    uint32_t saved_irq = lock(circular_buffer_mpmc);
+    bool is_empty = circular_buffer_is_empty(&circular_buffer_mpmc->circular_buffer);
+    unlock(circular_buffer_mpmc, saved_irq);
+
+    return is_empty;
+}
+
+/**
+ * @brief   Determine whether the MPMC circular buffer is full.
+ * @details May be stale as soon as it returns if other cores or ISRs are using the buffer.
+ *          Skips null arg checking for easier usage.
+ * @param   circular_buffer_mpmc    The MPMC circular buffer struct.
+ * @return  bool                    Whether the circular buffer is full.
+ */
+bool circular_buffer_mpmc_is_full(circular_buffer_mpmc_t * circular_buffer_mpmc) {
+    uint32_t saved_irq = lock(circular_buffer_mpmc);
+    bool is_full = circular_buffer_is_full(&circular_buffer_mpmc->circular_buffer);
+    unlock(circular_buffer_mpmc, saved_irq);
+
+    return is_full;
+}
+
+/**
+ * @brief   Push a new element onto the MPMC circular buffer.
+ * @details Pushing to a full buffer drops the new element, see circular_buffer_push in SPSC mode.
+ * @param   circular_buffer_mpmc    The MPMC circular buffer struct.
+ * @param   txdata                  Pointer to data to push onto buffer.
+ * @param   size                    Size of the data to push.
+ * @return  circular_buffer_rc_t    Return code indicating operation success/failure.
+ *                                  - CIRCULAR_BUFFER_RC_OK:        Operation successful.
+ *                                  - CIRCULAR_BUFFER_RC_BAD_ARG:   An invalid argument was provided.
+ *                                  - CIRCULAR_BUFFER_RC_OVERFLOW:  Overflow has occurred.
+ */
+circular_buffer_rc_t circular_buffer_mpmc_push(circular_buffer_mpmc_t * circular_buffer_mpmc, void * txdata, uint8_t size) {
+    if(circular_buffer_mpmc == NULL) {
+        return CIRCULAR_BUFFER_RC_BAD_ARG;
+    }
+
+    uint32_t saved_irq = lock(circular_buffer_mpmc);
+    circular_buffer_rc_t rc = circular_buffer_push(&circular_buffer_mpmc->circular_buffer, txdata, size);
+    unlock(circular_buffer_mpmc, saved_irq);
+
+    return rc;
+}
+
+/**
+ * @brief   Pop an element from the MPMC circular buffer.
+ * @param   circular_buffer_mpmc    The MPMC circular buffer struct.
+ * @param   rxdata                  Pointer to data to pop into.
+ * @param   size                    Size of the data to pop.
+ * @return  circular_buffer_rc_t    Return code indicating operation success/failure.
+ *                                  - CIRCULAR_BUFFER_RC_OK:        Operation successful.
+ *                                  - CIRCULAR_BUFFER_RC_BAD_ARG:   An invalid argument was provided.
+ *                                  - CIRCULAR_BUFFER_RC_UNDERFLOW: Underflow has occurred.
+ */
+circular_buffer_rc_t circular_buffer_mpmc_pop(circular_buffer_mpmc_t * circular_buffer_mpmc, void * rxdata, uint8_t size) {
+    if(circular_buffer_mpmc == NULL) {
+        return CIRCULAR_BUFFER_RC_BAD_ARG;
+    }
+
+    uint32_t saved_irq = lock(circular_buffer_mpmc);
+    circular_buffer_rc_t rc = circular_buffer_pop(&circular_buffer_mpmc->circular_buffer, rxdata, size);
+    unlock(circular_buffer_mpmc, saved_irq);
+
+    return rc;
+}
+
+/**
+ * @brief   Push an array of elements onto the MPMC circular buffer.
+ * @details The pushed elements are contiguous in the buffer, other producers can't interleave with them.
+ * @param   circular_buffer_mpmc    The MPMC circular buffer struct.
+ * @param   txdata                  Pointer to the array of elements to push onto buffer.
+ * @param   count                   Number of elements in txdata.
+ * @param   pushed                  The number of elements that were pushed (returned by reference).
+ * @return  circular_buffer_rc_t    Return code indicating operation success/failure.
+ *                                  - CIRCULAR_BUFFER_RC_OK:        Operation successful.
+ *                                  - CIRCULAR_BUFFER_RC_BAD_ARG:   An invalid argument was provided.
+ *                                  - CIRCULAR_BUFFER_RC_OVERFLOW:  Not all elements fit, use pushed to recover as needed.
+ */
+circular_buffer_rc_t circular_buffer_mpmc_push_n(circular_buffer_mpmc_t * circular_buffer_mpmc, const void * txdata, uint16_t count, uint16_t * pushed) {
+    if(circular_buffer_mpmc == NULL) {
+        return CIRCULAR_BUFFER_RC_BAD_ARG;
+    }
+
+    uint32_t saved_irq = lock(circular_buffer_mpmc);
+    circular_buffer_rc_t rc = circular_buffer_push_n(&circular_buffer_mpmc->circular_buffer, txdata, count, pushed);
+    unlock(circular_buffer_mpmc, saved_irq);
+
+    return rc;
+}
+
+/**
+ * @brief   Pop an array of elements from the MPMC circular buffer.
+ * @param   circular_buffer_mpmc    The MPMC circular buffer struct.
+ * @param   rxdata                  Pointer to the array to pop elements into, must have room for count elements.
+ * @param   count                   Maximum number of elements to pop.
+ * @param   popped                  The number of elements that were popped (returned by reference).
+ * @return  circular_buffer_rc_t    Return code indicating operation success/failure.
+ *                                  - CIRCULAR_BUFFER_RC_OK:        Operation successful.
+ *                                  - CIRCULAR_BUFFER_RC_BAD_ARG:   An invalid argument was provided.
+ *                                  - CIRCULAR_BUFFER_RC_UNDERFLOW: Fewer than count elements were available.
+ */
+circular_buffer_rc_t circular_buffer_mpmc_pop_n(circular_buffer_mpmc_t * circular_buffer_mpmc, void * rxdata, uint16_t count, uint16_t * popped) {
+    if(circular_buffer_mpmc == NULL) {
+        return CIRCULAR_BUFFER_RC_BAD_ARG;
+    }
+
+    uint32_t saved_irq = lock(circular_buffer_mpmc);
+    circular_buffer_rc_t rc = circular_buffer_pop_n(&circular_buffer_mpmc->circular_buffer, rxdata, count, popped);
+    unlock(circular_buffer_mpmc, saved_irq);
+
+    return rc;
+}
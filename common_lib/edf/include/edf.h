@@ -24,13 +24,14 @@ typedef enum {
     EDF_SCHEDULER_ACTION_SUSPEND_TASK = 2,
     EDF_SCHEDULER_ACTION_DELETE_TASK = 3,
     EDF_SCHEDULER_ACTION_COMPLETE_TASK = 4,
+    EDF_SCHEDULER_ACTION_SET_TASK_PERIOD = 5,
 } edf_scheduler_action_type_t;
 
 typedef struct {
     // Core info
     edf_scheduler_action_type_t action_type;
     TaskHandle_t task_handle;
-    // Additional info (only really needed for add_task)
+    // Additional info (only really needed for add_task, and task_period for set_task_period)
     TickType_t task_deadline;
     TickType_t task_period;
     bool is_suspended;
@@ -56,5 +57,9 @@ bool edf_start_task(TaskHandle_t task_handle);
 bool edf_suspend_task(TaskHandle_t task_handle);
 bool edf_delete_task(TaskHandle_t task_handle);
 bool edf_complete_task(TaskHandle_t task_handle);
+bool edf_set_task_period(TaskHandle_t task_handle, TickType_t task_period);
+
+int8_t edf_select_task(const edf_task_t tasklist[], uint8_t tasklist_length);
+bool edf_update_task_period(edf_task_t * task, TickType_t task_period, TickType_t current_time);
 
 #endif // EDF_H
\ No newline at end of file
@@ -130,6 +130,11 @@ static void complete_task(uint8_t task_idx) {
     }
 }
 
+// Helper function that changes the period of a periodic task in the tasklist, re-basing its pending deadline
+static void set_task_period(uint8_t task_idx, TickType_t task_period) {
+    edf_update_task_period(&edf_tasks[task_idx], task_period, xTaskGetTickCount());
+}
+
 // Helper function that checks for and handles any missed deadlines
 static void handle_missed_deadlines() {
     TickType_t current_time = xTaskGetTickCount();
@@ -155,22 +160,7 @@ static void handle_missed_deadlines() {
 
 // Helper function that determines the next task to work on for EDF
 static int8_t get_next_task_idx() {
-    // Defaults to this value if no task should currently be worked on
-    int8_t next_task_idx = -1;
-
-    TickType_t current_time = xTaskGetTickCount();
-    TickType_t earliest_deadline = portMAX_DELAY;
-
-    for(uint8_t i=0; i<num_tasks; i++) {
-        if (edf_tasks[i].task_state != EDF_TASK_SUSPENDED   &&      // Is a non-paused task
-            edf_tasks[i].task_deadline < earliest_deadline          // Has the new earliest deadline 
-            ) {
-            earliest_deadline = edf_tasks[i].task_deadline;
-            next_task_idx = i;
-        }
-    }
-
-    return next_task_idx;
+    return edf_select_task(edf_tasks, num_tasks);
 }
 
 // Helper function that switches from the current task to an indicated next task using FreeRTOS
@@ -251,6 +241,12 @@ static void edf_scheduler_task(void *pvParameters) {
                         edf_schedule();
                     }
                     break;
+                case EDF_SCHEDULER_ACTION_SET_TASK_PERIOD:
+                    if(task_idx != -1) {
+                        set_task_period(task_idx, received_action.task_period);
+                        edf_schedule();
+                    }
+                    break;
             }
         }
     }
@@ -422,7 +418,76 @@ bool edf_complete_task(TaskHandle_t task_handle) {
     bool rc = xQueueSend(scheduler_action_queue, &action, portMAX_DELAY) == pdPASS;
 
     // Delay until next period (or the scheduler task just deletes the task calling this function)
-    vTaskDelay(wakeup_time - xTaskGetTickCount());
+    // A deadline moved up by edf_set_task_period may already have been reached, so don't let the delay wrap
+    TickType_t current_time = xTaskGetTickCount();
+    if(wakeup_time > current_time) {
+        vTaskDelay(wakeup_time - current_time);
+    }
 
     return rc;
+}
+
+// Change the period of a periodic task in the scheduler, such as one whose rate adapts to its inputs
+// Applies to the current job, so calling it before edf_complete_task has the next job released a new period after this
+// one was; the scheduler task has the highest priority, so the change is made before this returns
+// Returns true on success, false otherwise
+bool edf_set_task_period(TaskHandle_t task_handle, TickType_t task_period) {
+    // Indicate failure to set task period (scheduler has not been started yet)
+    if(!scheduler_started) {
+        return false;
+    }
+    // Indicate failure to set task period (illogical input, a period of 0 would make the task non-periodic)
+    if(task_handle == NULL || task_period == 0 || task_period == portMAX_DELAY) {
+        return false;
+    }
+
+    // Create action request to scheduler task
+    edf_scheduler_action_t action = 
+    {
+        .action_type = EDF_SCHEDULER_ACTION_SET_TASK_PERIOD,
+        .task_handle = task_handle,
+        .task_period = task_period,
+    };
+
+    // Send action request to scheduler task and return result
+    return (xQueueSend(scheduler_action_queue, &action, portMAX_DELAY) == pdPASS);
+}
+
+// Determine which task in a tasklist EDF would work on: the non-suspended task with the earliest deadline
+// Returns the index of the selected task, or -1 if no task should currently be worked on
+int8_t edf_select_task(const edf_task_t tasklist[], uint8_t tasklist_length) {
+    // Defaults to this value if no task should currently be worked on
+    int8_t next_task_idx = -1;
+
+    TickType_t earliest_deadline = portMAX_DELAY;
+
+    for(uint8_t i=0; i<tasklist_length; i++) {
+        if (tasklist[i].task_state != EDF_TASK_SUSPENDED   &&      // Is a non-paused task
+            tasklist[i].task_deadline < earliest_deadline          // Has the new earliest deadline 
+            ) {
+            earliest_deadline = tasklist[i].task_deadline;
+            next_task_idx = i;
+        }
+    }
+
+    return next_task_idx;
+}
+
+// Change the period of a periodic task, re-basing its pending deadline on its last release (deadline - period) so the
+// new period applies from the current job on, rather than one job later
+// The deadline is never moved before current_time, a release the new period puts in the past happens straight away
+// Returns true on success, false for a non-periodic task or a period of 0
+bool edf_update_task_period(edf_task_t * task, TickType_t task_period, TickType_t current_time) {
+    // Leave non-periodic tasks alone, they are removed when they complete
+    if(task == NULL || task->task_period == 0 || task_period == 0) {
+        return false;
+    }
+
+    TickType_t last_release = task->task_deadline - task->task_period;
+    TickType_t deadline = last_release + task_period;
+
+    task->task_deadline = (deadline < current_time) ? current_time : deadline;
+    task->task_period = task_period;
+
+    return true;
 }
\ No newline at end of file
@@ -34,8 +34,8 @@ i2c_general_rc_t i2c_read_regs(i2c_inst_t * i2c_inst, uint8_t addr, const uint8_
 
     // Read the contiguous block of data
     int read_result = i2c_read_blocking(i2c_inst, addr, dst, len, false);
-    // Indicate I2C read failure if it occurs
-    if(read_result != 1) {
+    // Indicate I2C read failure if it occurs, the result is the number of bytes read
+    if(read_result != (int)len) {
         return I2C_GENERAL_RC_READ_FAILURE;
     }
 
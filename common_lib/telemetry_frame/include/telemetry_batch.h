@@ -0,0 +1,134 @@
+/**
+ * @file    telemetry_batch.h
+ * @brief   Defines a batching encoder that packs IMU samples into one compact telemetry payload, and its decoder.
+ * @details A batch holds up to TELEMETRY_BATCH_MAX_SAMPLES (44) telemetry_imu_raw_t samples, each stored as the difference
+ *          from the sample before it:
+ *
+ *              batch   = sample_count (1) | sample * sample_count
+ *              sample  = varint(timestamp_us delta) | zigzag varint(accel[0..2] delta) | zigzag varint(gyro[0..2] delta)
+ *
+ *          Varints are little-endian base 128 (LEB128); zig-zag maps small negative deltas to small unsigned numbers, so a
+ *          delta within +-63 takes one byte. Deltas wrap like the values' own types, so any value is representable.
+ *          The first sample of every batch is a delta from zero, so each batch decodes on its own and a lost frame only
+ *          loses its own samples. Send a batch as one frame with the TELEMETRY_MSG_IMU_BATCH message ID.
+ *
+ *          The encoder writes each sample into a caller-provided buffer as it is added, and the decoder passes each sample
+ *          to a handler as it is decoded, so both use a fixed amount of memory and can run in a periodic task.
+ *          The library has no hardware dependencies, so host tools link the same code to decode the stream.
+ *
+ *          Example:
+ *              static uint8_t batch_buffer[TELEMETRY_BATCH_MAX_LEN(16)];
+ *              telemetry_batch_encoder_init(&encoder, batch_buffer, sizeof(batch_buffer), 16);
+ *
+ *              // Every sample period
+ *              telemetry_batch_encoder_add(&encoder, &sample);
+ *              if(telemetry_batch_encoder_is_full(&encoder)) {
+ *                  telemetry_batch_encoder_flush(&encoder, &batch, &batch_len);
+ *                  hc06_tx_frame(&hc06, TELEMETRY_MSG_IMU_BATCH, batch, batch_len);
+ *              }
+ *
+ *              // On the host, for each TELEMETRY_MSG_IMU_BATCH frame
+ *              telemetry_batch_decode(payload, payload_len, handle_sample, NULL);
+ *
+ * @section Dependencies
+ * - 'telemetry_frame.h':   Provides the IMU sample struct and message IDs.
+ */
+
+#ifndef TELEMETRY_BATCH_H
+#define TELEMETRY_BATCH_H
+
+#include "telemetry_frame.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define TELEMETRY_BATCH_CHANNELS        6u
+
+// Worst case length of a batch: a 5 byte timestamp varint and six 3 byte channel varints per sample, plus the count
+#define TELEMETRY_BATCH_MAX_LEN(samples)    (1u + (samples) * (5u + TELEMETRY_BATCH_CHANNELS * 3u))
+
+// The most samples a batch can hold and still fit a frame's payload at worst case length, 44
+#define TELEMETRY_BATCH_MAX_SAMPLES         ((TELEMETRY_FRAME_MAX_PAYLOAD - 1u) / (5u + TELEMETRY_BATCH_CHANNELS * 3u))
+
+typedef enum {
+    TELEMETRY_BATCH_RC_OK           = 0,
+    TELEMETRY_BATCH_RC_BAD_ARG      = 1,
+    TELEMETRY_BATCH_RC_FULL         = 2,    // The batch already holds samples_per_batch samples, flush it first
+    TELEMETRY_BATCH_RC_BAD_BATCH    = 3,    // The batch is truncated, has trailing bytes or a malformed varint
+} telemetry_batch_rc_t;
+
+// Called by telemetry_batch_decode for each sample; sample is only valid during the call
+typedef void (*telemetry_batch_handler_t)(const telemetry_imu_raw_t * sample, void * context);
+
+typedef struct {
+    uint8_t * buffer;
+    uint16_t buffer_size;
+    uint8_t samples_per_batch;
+    uint8_t sample_count;
+    uint16_t len;
+    telemetry_imu_raw_t previous;   // The last sample added, which the next one is encoded against
+} telemetry_batch_encoder_t;
+
+/**
+ * @brief   Initialize a batch encoder and start its first batch.
+ * @param   encoder             The encoder.
+ * @param   buffer              Buffer the batch is encoded in.
+ * @param   buffer_size         The size of buffer, at least TELEMETRY_BATCH_MAX_LEN(samples_per_batch).
+ * @param   samples_per_batch   The number of samples a batch is full at, 1 to TELEMETRY_BATCH_MAX_SAMPLES.
+ * @return  telemetry_batch_rc_t    Return code indicating operation success/failure.
+ *                                  - TELEMETRY_BATCH_RC_OK:        Operation successful.
+ *                                  - TELEMETRY_BATCH_RC_BAD_ARG:   An invalid argument was provided.
+ */
+telemetry_batch_rc_t telemetry_batch_encoder_init(telemetry_batch_encoder_t * encoder, uint8_t * buffer, uint16_t buffer_size, uint8_t samples_per_batch);
+
+/**
+ * @brief   Encode a sample into the current batch.
+ * @param   encoder             The encoder.
+ * @param   sample              The sample.
+ * @return  telemetry_batch_rc_t    Return code indicating operation success/failure.
+ *                                  - TELEMETRY_BATCH_RC_OK:        Operation successful.
+ *                                  - TELEMETRY_BATCH_RC_BAD_ARG:   An invalid argument was provided.
+ *                                  - TELEMETRY_BATCH_RC_FULL:      The batch is full, the sample was not added.
+ */
+telemetry_batch_rc_t telemetry_batch_encoder_add(telemetry_batch_encoder_t * encoder, const telemetry_imu_raw_t * sample);
+
+/**
+ * @brief   Check whether the current batch holds samples_per_batch samples.
+ * @param   encoder             The encoder.
+ * @return  bool                true if the batch is full, false otherwise or if encoder is NULL.
+ */
+bool telemetry_batch_encoder_is_full(telemetry_batch_encoder_t * encoder);
+
+/**
+ * @brief   Get the current batch, full or not, and start a new one.
+ * @details The batch is left in the encoder's buffer, so it is only valid until the next call to telemetry_batch_encoder_add.
+ * @param   encoder             The encoder.
+ * @param   batch               The encoded batch (returned by reference).
+ * @param   batch_len           The number of bytes in batch, 0 if it held no samples (returned by reference).
+ * @return  telemetry_batch_rc_t    Return code indicating operation success/failure.
+ *                                  - TELEMETRY_BATCH_RC_OK:        Operation successful.
+ *                                  - TELEMETRY_BATCH_RC_BAD_ARG:   An invalid argument was provided.
+ */
+telemetry_batch_rc_t telemetry_batch_encoder_flush(telemetry_batch_encoder_t * encoder, const uint8_t ** batch, uint16_t * batch_len);
+
+/**
+ * @brief   Decode a batch, calling handler for each sample in order.
+ * @details Samples are decoded one at a time, so a malformed batch may have passed some samples to handler before the
+ *          error is found; batches sent as telemetry frames are CRC checked before they get here.
+ * @param   batch               The encoded batch.
+ * @param   batch_len           The number of bytes in batch.
+ * @param   handler             Called for each sample.
+ * @param   context             Passed to handler.
+ * @return  telemetry_batch_rc_t    Return code indicating operation success/failure.
+ *                                  - TELEMETRY_BATCH_RC_OK:        Operation successful.
+ *                                  - TELEMETRY_BATCH_RC_BAD_ARG:   An invalid argument was provided.
+ *                                  - TELEMETRY_BATCH_RC_BAD_BATCH: The batch is malformed.
+ */
+telemetry_batch_rc_t telemetry_batch_decode(const uint8_t * batch, uint16_t batch_len, telemetry_batch_handler_t handler, void * context);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // TELEMETRY_BATCH_H
@@ -0,0 +1,178 @@
+/**
+ * @file    telemetry_frame.h
+ * @brief   Defines a binary framing layer for typed telemetry messages over a serial byte stream.
+ * @details A frame carries a message ID, a binary payload and a CRC16 of both, COBS encoded so it can be delimited:
+ *
+ *              body    = msg_id (1) | payload (0..TELEMETRY_FRAME_MAX_PAYLOAD) | crc16 (2, little-endian)
+ *              frame   = (COBS(body) XOR TELEMETRY_FRAME_DELIMITER) | TELEMETRY_FRAME_DELIMITER
+ *
+ *          COBS removes every zero from the body, and XOR-ing the encoded bytes with the delimiter moves the one value
+ *          they can never take from zero to the delimiter. The delimiter is a newline, so frames pass through
+ *          newline-framed links such as the HC-06 driver unchanged, and a receiver that loses sync only loses one frame.
+ *          The CRC is CRC-16/CCITT-FALSE (polynomial 0x1021, initial value 0xFFFF).
+ *
+ *          Encoding is a single pass that writes straight into up to two regions, so it can fill the free regions of a
+ *          circular buffer without an intermediate copy (see hc06_tx_frame). Decoding can be done in place.
+ *          The library has no hardware dependencies, so host tools link the same code to decode the stream.
+ *
+ *          Payloads are sent in the sender's byte order; both the RP2040 and common hosts are little-endian, and the
+ *          typed payload structs below are packed so their layout matches on both ends.
+ *
+ *          Example:
+ *              telemetry_imu_raw_t sample = {.timestamp_us = time_us_32()};
+ *              memcpy(sample.accel, &mpu_6050.accel_raw, sizeof(sample.accel));
+ *              hc06_tx_frame(&hc06, TELEMETRY_MSG_IMU_RAW, &sample, sizeof(sample));
+ *
+ *              // On the host
+ *              telemetry_frame_decoder_feed(&decoder, serial_data, serial_len, handle_frame, NULL);
+ */
+
+#ifndef TELEMETRY_FRAME_H
+#define TELEMETRY_FRAME_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define TELEMETRY_FRAME_DELIMITER       '\n'
+#define TELEMETRY_FRAME_MAX_PAYLOAD     1024u
+
+// Worst case length of an encoded frame, including its delimiter: one COBS code byte per 254 body bytes, plus one
+#define TELEMETRY_FRAME_MAX_ENCODED_LEN(payload_len)    ((payload_len) + 3u + ((payload_len) + 3u) / 254u + 2u)
+
+typedef enum {
+    TELEMETRY_FRAME_RC_OK           = 0,
+    TELEMETRY_FRAME_RC_BAD_ARG      = 1,
+    TELEMETRY_FRAME_RC_OVERFLOW     = 2,    // The output buffer is too small
+    TELEMETRY_FRAME_RC_BAD_FRAME    = 3,    // The frame is not valid COBS or is too short to hold an ID and CRC
+    TELEMETRY_FRAME_RC_BAD_CRC      = 4,
+} telemetry_frame_rc_t;
+
+// Message IDs, IDs from TELEMETRY_MSG_USER up are free for application messages
+typedef enum {
+    TELEMETRY_MSG_TEXT              = 0x01, // Text, not null terminated
+    TELEMETRY_MSG_IMU_RAW           = 0x10, // telemetry_imu_raw_t
+    TELEMETRY_MSG_IMU_BATCH         = 0x11, // telemetry_imu_raw_t samples encoded by telemetry_batch.h
+    TELEMETRY_MSG_USER              = 0x80,
+} telemetry_msg_id_t;
+
+// Raw MPU-6050 registers, scale with the configured ranges on the receiving end
+typedef struct __attribute__((packed)) {
+    uint32_t timestamp_us;
+    int16_t accel[3];
+    int16_t gyro[3];
+} telemetry_imu_raw_t;
+
+// Called by telemetry_frame_decoder_feed for each valid frame; payload is only valid during the call
+typedef void (*telemetry_frame_handler_t)(uint8_t msg_id, const uint8_t * payload, uint16_t payload_len, void * context);
+
+typedef struct {
+    uint8_t * buffer;
+    uint16_t buffer_size;
+    uint16_t len;
+    bool is_discarding;     // The current frame overflowed the buffer, drop bytes up to the next delimiter
+
+    // Statistics
+    uint32_t frames_decoded;
+    uint32_t frames_dropped;
+} telemetry_frame_decoder_t;
+
+/**
+ * @brief   Update a CRC-16/CCITT-FALSE with more data.
+ * @param   crc         The CRC so far, 0xFFFF to start a new one.
+ * @param   data        The data to add.
+ * @param   len         The number of bytes in data.
+ * @return  uint16_t    The updated CRC.
+ */
+uint16_t telemetry_frame_crc16(uint16_t crc, const uint8_t * data, uint16_t len);
+
+/**
+ * @brief   Encode a message into a frame that is split across up to two regions, e.g. the free regions of a circular buffer.
+ * @details Single pass over the payload; the CRC is computed and the COBS code bytes are patched in as it goes.
+ *          The frame fills first before continuing in second. The regions must have room for the worst case length, so
+ *          the check is done once up front instead of per byte; an encoded frame is at most one byte per 254 longer.
+ * @param   msg_id          The message ID.
+ * @param   payload         The payload. Can be NULL if payload_len is 0.
+ * @param   payload_len     The number of bytes in payload. Cannot exceed TELEMETRY_FRAME_MAX_PAYLOAD.
+ * @param   first           The first region to encode into.
+ * @param   first_len       The size of first.
+ * @param   second          The region to continue in once first is full. Can be NULL if second_len is 0.
+ * @param   second_len      The size of second.
+ * @param   frame_len       The number of bytes in the encoded frame, including its delimiter (returned by reference).
+ * @return  telemetry_frame_rc_t    Return code indicating operation success/failure.
+ *                                  - TELEMETRY_FRAME_RC_OK:        Operation successful.
+ *                                  - TELEMETRY_FRAME_RC_BAD_ARG:   An invalid argument was provided.
+ *                                  - TELEMETRY_FRAME_RC_OVERFLOW:  The regions add up to less than TELEMETRY_FRAME_MAX_ENCODED_LEN(payload_len).
+ */
+telemetry_frame_rc_t telemetry_frame_encode_split(uint8_t msg_id, const void * payload, uint16_t payload_len,
+                                                  uint8_t * first, uint16_t first_len, uint8_t * second, uint16_t second_len,
+                                                  uint16_t * frame_len);
+
+/**
+ * @brief   Encode a message into a frame in a contiguous buffer.
+ * @param   msg_id          The message ID.
+ * @param   payload         The payload. Can be NULL if payload_len is 0.
+ * @param   payload_len     The number of bytes in payload. Cannot exceed TELEMETRY_FRAME_MAX_PAYLOAD.
+ * @param   frame           The buffer to encode into.
+ * @param   frame_size      The size of frame.
+ * @param   frame_len       The number of bytes in the encoded frame, including its delimiter (returned by reference).
+ * @return  telemetry_frame_rc_t    Return code indicating operation success/failure.
+ *                                  - TELEMETRY_FRAME_RC_OK:        Operation successful.
+ *                                  - TELEMETRY_FRAME_RC_BAD_ARG:   An invalid argument was provided.
+ *                                  - TELEMETRY_FRAME_RC_OVERFLOW:  frame_size is less than TELEMETRY_FRAME_MAX_ENCODED_LEN(payload_len).
+ */
+telemetry_frame_rc_t telemetry_frame_encode(uint8_t msg_id, const void * payload, uint16_t payload_len,
+                                            uint8_t * frame, uint16_t frame_size, uint16_t * frame_len);
+
+/**
+ * @brief   Decode one frame and check its CRC.
+ * @details payload can be the same buffer as frame to decode in place; the payload is never written ahead of the frame
+ *          bytes still to be read.
+ * @param   frame           The encoded frame, with or without its trailing delimiter.
+ * @param   frame_len       The number of bytes in frame.
+ * @param   msg_id          The message ID (returned by reference).
+ * @param   payload         Buffer for the payload.
+ * @param   payload_size    The size of payload.
+ * @param   payload_len     The number of bytes in the payload (returned by reference).
+ * @return  telemetry_frame_rc_t    Return code indicating operation success/failure.
+ *                                  - TELEMETRY_FRAME_RC_OK:        Operation successful.
+ *                                  - TELEMETRY_FRAME_RC_BAD_ARG:   An invalid argument was provided.
+ *                                  - TELEMETRY_FRAME_RC_OVERFLOW:  The payload doesn't fit in payload.
+ *                                  - TELEMETRY_FRAME_RC_BAD_FRAME: The frame is malformed.
+ *                                  - TELEMETRY_FRAME_RC_BAD_CRC:   The frame is intact COBS but its CRC doesn't match.
+ */
+telemetry_frame_rc_t telemetry_frame_decode(const uint8_t * frame, uint16_t frame_len, uint8_t * msg_id,
+                                            uint8_t * payload, uint16_t payload_size, uint16_t * payload_len);
+
+/**
+ * @brief   Initialize a stream decoder, which splits a byte stream into frames and decodes them.
+ * @param   decoder         The decoder.
+ * @param   buffer          Buffer to collect a frame in. Frames that don't fit are dropped.
+ * @param   buffer_size     The size of buffer, TELEMETRY_FRAME_MAX_ENCODED_LEN(TELEMETRY_FRAME_MAX_PAYLOAD) fits any frame.
+ * @return  telemetry_frame_rc_t    Return code indicating operation success/failure.
+ *                                  - TELEMETRY_FRAME_RC_OK:        Operation successful.
+ *                                  - TELEMETRY_FRAME_RC_BAD_ARG:   An invalid argument was provided.
+ */
+telemetry_frame_rc_t telemetry_frame_decoder_init(telemetry_frame_decoder_t * decoder, uint8_t * buffer, uint16_t buffer_size);
+
+/**
+ * @brief   Feed bytes from the stream to a decoder, calling handler for every complete, valid frame in them.
+ * @details Data can be split anywhere. Malformed, corrupted and oversized frames are counted in frames_dropped.
+ * @param   decoder         The decoder.
+ * @param   data            The bytes received.
+ * @param   len             The number of bytes in data.
+ * @param   handler         Called for each valid frame.
+ * @param   context         Passed to handler.
+ */
+void telemetry_frame_decoder_feed(telemetry_frame_decoder_t * decoder, const uint8_t * data, size_t len,
+                                  telemetry_frame_handler_t handler, void * context);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // TELEMETRY_FRAME_H
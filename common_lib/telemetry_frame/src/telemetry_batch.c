@@ -0,0 +1,213 @@
+#include "telemetry_batch.h"
+
+// The most bytes a uint32_t varint takes
+#define VARINT_MAX_LEN  5u
+
+/**
+ * @brief   Helper function that maps a signed delta to an unsigned one, so small magnitudes of either sign stay small.
+ * @param   value       The signed delta.
+ * @return  uint32_t    The zig-zag encoded delta: 0, -1, 1, -2, ... map to 0, 1, 2, 3, ...
+ */
+static inline uint32_t zigzag_encode(int16_t value) {
+    return (uint16_t)((uint16_t)value << 1) ^ (uint16_t)(value < 0 ? 0xFFFFu : 0u);
+}
+
+/**
+ * @brief   Helper function that reverses zigzag_encode.
+ * @param   value       The zig-zag encoded delta.
+ * @return  int16_t     The signed delta.
+ */
+static inline int16_t zigzag_decode(uint32_t value) {
+    return (int16_t)(uint16_t)((value >> 1) ^ (0u - (value & 1u)));
+}
+
+/**
+ * @brief   Helper function that writes a varint, 7 bits per byte with the top bit set on all but the last byte.
+ * @details The caller guarantees there is room for VARINT_MAX_LEN bytes.
+ * @param   buffer      Where to write the varint.
+ * @param   value       The value to write.
+ * @return  uint16_t    The number of bytes written.
+ */
+static inline uint16_t write_varint(uint8_t * buffer, uint32_t value) {
+    uint16_t len = 0;
+    while(value >= 0x80u) {
+        buffer[len++] = (uint8_t)(value | 0x80u);
+        value >>= 7;
+    }
+    buffer[len++] = (uint8_t)value;
+    return len;
+}
+
+/**
+ * @brief   Helper function that reads a varint and advances past it.
+ * @param   position    The next byte to read, advanced past the varint (returned by reference).
+ * @param   end         One past the last byte of the batch.
+ * @param   value       The value read (returned by reference).
+ * @return  bool        true if a complete varint of at most VARINT_MAX_LEN bytes was read, false otherwise.
+ */
+static inline bool read_varint(const uint8_t ** position, const uint8_t * end, uint32_t * value) {
+    uint32_t result = 0;
+    for(uint16_t i = 0; i < VARINT_MAX_LEN; i++) {
+        if(*position == end) {
+            return false;
+        }
+        uint8_t byte = *(*position)++;
+        result |= (uint32_t)(byte & 0x7Fu) << (7u * i);
+        if((byte & 0x80u) == 0) {
+            *value = result;
+            return true;
+        }
+    }
+    return false;
+}
+
+/**
+ * @brief   Helper function that starts a new batch, leaving room for the sample count and resetting the delta reference.
+ * @param   encoder     The encoder.
+ */
+static inline void start_batch(telemetry_batch_encoder_t * encoder) {
+    encoder->sample_count = 0;
+    encoder->len = 1;
+    encoder->previous = (telemetry_imu_raw_t){0};
+}
+
+/**
+ * @brief   Initialize a batch encoder and start its first batch.
+ * @param   encoder             The encoder.
+ * @param   buffer              Buffer the batch is encoded in.
+ * @param   buffer_size         The size of buffer, at least TELEMETRY_BATCH_MAX_LEN(samples_per_batch).
+ * @param   samples_per_batch   The number of samples a batch is full at, 1 to TELEMETRY_BATCH_MAX_SAMPLES.
+ * @return  telemetry_batch_rc_t    Return code indicating operation success/failure.
+ *                                  - TELEMETRY_BATCH_RC_OK:        Operation successful.
+ *                                  - TELEMETRY_BATCH_RC_BAD_ARG:   An invalid argument was provided.
+ */
+telemetry_batch_rc_t telemetry_batch_encoder_init(telemetry_batch_encoder_t * encoder, uint8_t * buffer, uint16_t buffer_size, uint8_t samples_per_batch) {
+    if(encoder == NULL || buffer == NULL || samples_per_batch == 0 || samples_per_batch > TELEMETRY_BATCH_MAX_SAMPLES ||
+       buffer_size < TELEMETRY_BATCH_MAX_LEN(samples_per_batch)) {
+        return TELEMETRY_BATCH_RC_BAD_ARG;
+    }
+
+    encoder->buffer = buffer;
+    encoder->buffer_size = buffer_size;
+    encoder->samples_per_batch = samples_per_batch;
+    start_batch(encoder);
+
+    return TELEMETRY_BATCH_RC_OK;
+}
+
+/**
+ * @brief   Encode a sample into the current batch.
+ * @param   encoder             The encoder.
+ * @param   sample              The sample.
+ * @return  telemetry_batch_rc_t    Return code indicating operation success/failure.
+ *                                  - TELEMETRY_BATCH_RC_OK:        Operation successful.
+ *                                  - TELEMETRY_BATCH_RC_BAD_ARG:   An invalid argument was provided.
+ *                                  - TELEMETRY_BATCH_RC_FULL:      The batch is full, the sample was not added.
+ */
+telemetry_batch_rc_t telemetry_batch_encoder_add(telemetry_batch_encoder_t * encoder, const telemetry_imu_raw_t * sample) {
+    if(encoder == NULL || sample == NULL) {
+        return TELEMETRY_BATCH_RC_BAD_ARG;
+    }
+    if(encoder->sample_count == encoder->samples_per_batch) {
+        return TELEMETRY_BATCH_RC_FULL;
+    }
+
+    // init checked the buffer holds samples_per_batch worst case samples, so there is always room here
+    uint8_t * position = encoder->buffer + encoder->len;
+    position += write_varint(position, sample->timestamp_us - encoder->previous.timestamp_us);
+    for(uint8_t i = 0; i < 3; i++) {
+        position += write_varint(position, zigzag_encode((int16_t)(uint16_t)(sample->accel[i] - encoder->previous.accel[i])));
+    }
+    for(uint8_t i = 0; i < 3; i++) {
+        position += write_varint(position, zigzag_encode((int16_t)(uint16_t)(sample->gyro[i] - encoder->previous.gyro[i])));
+    }
+
+    encoder->len = (uint16_t)(position - encoder->buffer);
+    encoder->sample_count++;
+    encoder->previous = *sample;
+
+    return TELEMETRY_BATCH_RC_OK;
+}
+
+/**
+ * @brief   Check whether the current batch holds samples_per_batch samples.
+ * @param   encoder             The encoder.
+ * @return  bool                true if the batch is full, false otherwise or if encoder is NULL.
+ */
+bool telemetry_batch_encoder_is_full(telemetry_batch_encoder_t * encoder) {
+    return encoder != NULL && encoder->sample_count == encoder->samples_per_batch;
+}
+
+/**
+ * @brief   Get the current batch, full or not, and start a new one.
+ * @details The batch is left in the encoder's buffer, so it is only valid until the next call to telemetry_batch_encoder_add.
+ * @param   encoder             The encoder.
+ * @param   batch               The encoded batch (returned by reference).
+ * @param   batch_len           The number of bytes in batch, 0 if it held no samples (returned by reference).
+ * @return  telemetry_batch_rc_t    Return code indicating operation success/failure.
+ *                                  - TELEMETRY_BATCH_RC_OK:        Operation successful.
+ *                                  - TELEMETRY_BATCH_RC_BAD_ARG:   An invalid argument was provided.
+ */
+telemetry_batch_rc_t telemetry_batch_encoder_flush(telemetry_batch_encoder_t * encoder, const uint8_t ** batch, uint16_t * batch_len) {
+    if(encoder == NULL || batch == NULL || batch_len == NULL) {
+        return TELEMETRY_BATCH_RC_BAD_ARG;
+    }
+
+    encoder->buffer[0] = encoder->sample_count;
+    *batch = encoder->buffer;
+    *batch_len = encoder->sample_count == 0 ? 0 : encoder->len;
+    start_batch(encoder);
+
+    return TELEMETRY_BATCH_RC_OK;
+}
+
+/**
+ * @brief   Decode a batch, calling handler for each sample in order.
+ * @details Samples are decoded one at a time, so a malformed batch may have passed some samples to handler before the
+ *          error is found; batches sent as telemetry frames are CRC checked before they get here.
+ * @param   batch               The encoded batch.
+ * @param   batch_len           The number of bytes in batch.
+ * @param   handler             Called for each sample.
+ * @param   context             Passed to handler.
+ * @return  telemetry_batch_rc_t    Return code indicating operation success/failure.
+ *                                  - TELEMETRY_BATCH_RC_OK:        Operation successful.
+ *                                  - TELEMETRY_BATCH_RC_BAD_ARG:   An invalid argument was provided.
+ *                                  - TELEMETRY_BATCH_RC_BAD_BATCH: The batch is malformed.
+ */
+telemetry_batch_rc_t telemetry_batch_decode(const uint8_t * batch, uint16_t batch_len, telemetry_batch_handler_t handler, void * context) {
+    if(batch == NULL || handler == NULL) {
+        return TELEMETRY_BATCH_RC_BAD_ARG;
+    }
+    if(batch_len == 0) {
+        return TELEMETRY_BATCH_RC_BAD_BATCH;
+    }
+
+    const uint8_t * position = batch + 1;
+    const uint8_t * end = batch + batch_len;
+    telemetry_imu_raw_t sample = {0};
+    uint32_t value;
+
+    for(uint8_t n = 0; n < batch[0]; n++) {
+        if(!read_varint(&position, end, &value)) {
+            return TELEMETRY_BATCH_RC_BAD_BATCH;
+        }
+        sample.timestamp_us += value;
+
+        for(uint8_t i = 0; i < 3; i++) {
+            if(!read_varint(&position, end, &value)) {
+                return TELEMETRY_BATCH_RC_BAD_BATCH;
+            }
+            sample.accel[i] = (int16_t)(uint16_t)(sample.accel[i] + zigzag_decode(value));
+        }
+        for(uint8_t i = 0; i < 3; i++) {
+            if(!read_varint(&position, end, &value)) {
+                return TELEMETRY_BATCH_RC_BAD_BATCH;
+            }
+            sample.gyro[i] = (int16_t)(uint16_t)(sample.gyro[i] + zigzag_decode(value));
+        }
+
+        handler(&sample, context);
+    }
+
+    return position == end ? TELEMETRY_BATCH_RC_OK : TELEMETRY_BATCH_RC_BAD_BATCH;
+}
@@ -0,0 +1,327 @@
+#include "telemetry_frame.h"
+
+// A COBS block holds at most 254 data bytes; a full block has this code and no implicit zero after it
+#define COBS_MAX_CODE   0xFFu
+
+// Writes an encoded frame across up to two regions, keeping the position of the current COBS block's code byte
+typedef struct {
+    uint8_t * first;
+    uint16_t first_len;
+    uint8_t * second;
+    uint16_t position;
+    uint16_t code_position;
+    uint8_t code;
+} frame_writer_t;
+
+// Collects a decoded body, holding back its last two bytes since they turn out to be the CRC once the frame ends
+typedef struct {
+    uint8_t * msg_id;
+    uint8_t * payload;
+    uint16_t payload_size;
+    uint16_t payload_len;
+    uint16_t body_len;
+    uint8_t held[2];
+    uint16_t crc;
+} body_reader_t;
+
+/**
+ * @brief   Helper function that adds one byte to a CRC-16/CCITT-FALSE, without a lookup table.
+ * @param   crc         The CRC so far.
+ * @param   data        The byte to add.
+ * @return  uint16_t    The updated CRC.
+ */
+static inline uint16_t crc16_update(uint16_t crc, uint8_t data) {
+    uint8_t x = (uint8_t)(crc >> 8) ^ data;
+    x ^= x >> 4;
+    return (uint16_t)((crc << 8) ^ ((uint16_t)x << 12) ^ ((uint16_t)x << 5) ^ x);
+}
+
+/**
+ * @brief   Helper function that gets a byte of the frame by position, in first or continuing in second.
+ * @param   writer      The frame writer.
+ * @param   index       Position in the frame.
+ * @return  uint8_t *   Pointer to the byte.
+ */
+static inline uint8_t * frame_byte(frame_writer_t * writer, uint16_t index) {
+    if(index < writer->first_len) {
+        return &writer->first[index];
+    }
+    return &writer->second[index - writer->first_len];
+}
+
+/**
+ * @brief   Helper function that ends the current COBS block, patching its code byte in and starting the next block.
+ * @param   writer      The frame writer.
+ */
+static inline void end_block(frame_writer_t * writer) {
+    *frame_byte(writer, writer->code_position) = writer->code ^ TELEMETRY_FRAME_DELIMITER;
+    writer->code_position = writer->position++;
+    writer->code = 1;
+}
+
+/**
+ * @brief   Helper function that COBS encodes one body byte.
+ * @details Zeros end the current block instead of being written, as do 254 non-zero bytes in a row.
+ * @param   writer      The frame writer.
+ * @param   data        The body byte.
+ */
+static inline void encode_byte(frame_writer_t * writer, uint8_t data) {
+    if(data == 0) {
+        end_block(writer);
+        return;
+    }
+
+    *frame_byte(writer, writer->position++) = data ^ TELEMETRY_FRAME_DELIMITER;
+    if(++writer->code == COBS_MAX_CODE) {
+        end_block(writer);
+    }
+}
+
+/**
+ * @brief   Helper function that adds one decoded byte to the body.
+ * @details Bytes are held back two at a time, so the payload never receives the CRC and is never written ahead of the
+ *          frame bytes still to be decoded, which makes decoding in place safe.
+ * @param   reader                  The body reader.
+ * @param   data                    The decoded byte.
+ * @return  telemetry_frame_rc_t    TELEMETRY_FRAME_RC_OK, or TELEMETRY_FRAME_RC_OVERFLOW if the payload doesn't fit.
+ */
+static inline telemetry_frame_rc_t read_byte(body_reader_t * reader, uint8_t data) {
+    uint16_t index = reader->body_len++;
+    if(index == 0) {
+        *reader->msg_id = data;
+        reader->crc = crc16_update(reader->crc, data);
+        return TELEMETRY_FRAME_RC_OK;
+    }
+    if(index < 3) {
+        reader->held[index - 1] = data;
+        return TELEMETRY_FRAME_RC_OK;
+    }
+
+    if(reader->payload_len >= reader->payload_size) {
+        return TELEMETRY_FRAME_RC_OVERFLOW;
+    }
+    reader->payload[reader->payload_len++] = reader->held[0];
+    reader->crc = crc16_update(reader->crc, reader->held[0]);
+    reader->held[0] = reader->held[1];
+    reader->held[1] = data;
+    return TELEMETRY_FRAME_RC_OK;
+}
+
+/**
+ * @brief   Update a CRC-16/CCITT-FALSE with more data.
+ * @param   crc         The CRC so far, 0xFFFF to start a new one.
+ * @param   data        The data to add.
+ * @param   len         The number of bytes in data.
+ * @return  uint16_t    The updated CRC.
+ */
+uint16_t telemetry_frame_crc16(uint16_t crc, const uint8_t * data, uint16_t len) {
+    for(uint16_t i = 0; i < len; i++) {
+        crc = crc16_update(crc, data[i]);
+    }
+    return crc;
+}
+
+/**
+ * @brief   Encode a message into a frame that is split across up to two regions, e.g. the free regions of a circular buffer.
+ * @details Single pass over the payload; the CRC is computed and the COBS code bytes are patched in as it goes.
+ *          The frame fills first before continuing in second. The regions must have room for the worst case length, so
+ *          the check is done once up front instead of per byte; an encoded frame is at most one byte per 254 longer.
+ * @param   msg_id          The message ID.
+ * @param   payload         The payload. Can be NULL if payload_len is 0.
+ * @param   payload_len     The number of bytes in payload. Cannot exceed TELEMETRY_FRAME_MAX_PAYLOAD.
+ * @param   first           The first region to encode into.
+ * @param   first_len       The size of first.
+ * @param   second          The region to continue in once first is full. Can be NULL if second_len is 0.
+ * @param   second_len      The size of second.
+ * @param   frame_len       The number of bytes in the encoded frame, including its delimiter (returned by reference).
+ * @return  telemetry_frame_rc_t    Return code indicating operation success/failure.
+ *                                  - TELEMETRY_FRAME_RC_OK:        Operation successful.
+ *                                  - TELEMETRY_FRAME_RC_BAD_ARG:   An invalid argument was provided.
+ *                                  - TELEMETRY_FRAME_RC_OVERFLOW:  The regions add up to less than TELEMETRY_FRAME_MAX_ENCODED_LEN(payload_len).
+ */
+telemetry_frame_rc_t telemetry_frame_encode_split(uint8_t msg_id, const void * payload, uint16_t payload_len,
+                                                  uint8_t * first, uint16_t first_len, uint8_t * second, uint16_t second_len,
+                                                  uint16_t * frame_len) {
+    if((payload == NULL && payload_len > 0) || payload_len > TELEMETRY_FRAME_MAX_PAYLOAD || first == NULL ||
+       (second == NULL && second_len > 0) || frame_len == NULL) {
+        return TELEMETRY_FRAME_RC_BAD_ARG;
+    }
+    if((uint32_t)first_len + second_len < TELEMETRY_FRAME_MAX_ENCODED_LEN(payload_len)) {
+        return TELEMETRY_FRAME_RC_OVERFLOW;
+    }
+
+    // The first block's code byte is reserved at the start of the frame
+    frame_writer_t writer = {.first = first, .first_len = first_len, .second = second, .position = 1, .code_position = 0, .code = 1};
+    const uint8_t * payload_data = payload;
+
+    uint16_t crc = crc16_update(0xFFFF, msg_id);
+    encode_byte(&writer, msg_id);
+    for(uint16_t i = 0; i < payload_len; i++) {
+        crc = crc16_update(crc, payload_data[i]);
+        encode_byte(&writer, payload_data[i]);
+    }
+    encode_byte(&writer, (uint8_t)crc);
+    encode_byte(&writer, (uint8_t)(crc >> 8));
+
+    // Patch in the last block's code byte and delimit the frame
+    *frame_byte(&writer, writer.code_position) = writer.code ^ TELEMETRY_FRAME_DELIMITER;
+    *frame_byte(&writer, writer.position++) = TELEMETRY_FRAME_DELIMITER;
+    *frame_len = writer.position;
+
+    return TELEMETRY_FRAME_RC_OK;
+}
+
+/**
+ * @brief   Encode a message into a frame in a contiguous buffer.
+ * @param   msg_id          The message ID.
+ * @param   payload         The payload. Can be NULL if payload_len is 0.
+ * @param   payload_len     The number of bytes in payload. Cannot exceed TELEMETRY_FRAME_MAX_PAYLOAD.
+ * @param   frame           The buffer to encode into.
+ * @param   frame_size      The size of frame.
+ * @param   frame_len       The number of bytes in the encoded frame, including its delimiter (returned by reference).
+ * @return  telemetry_frame_rc_t    Return code indicating operation success/failure.
+ *                                  - TELEMETRY_FRAME_RC_OK:        Operation successful.
+ *                                  - TELEMETRY_FRAME_RC_BAD_ARG:   An invalid argument was provided.
+ *                                  - TELEMETRY_FRAME_RC_OVERFLOW:  frame_size is less than TELEMETRY_FRAME_MAX_ENCODED_LEN(payload_len).
+ */
+telemetry_frame_rc_t telemetry_frame_encode(uint8_t msg_id, const void * payload, uint16_t payload_len,
+                                            uint8_t * frame, uint16_t frame_size, uint16_t * frame_len) {
+    return telemetry_frame_encode_split(msg_id, payload, payload_len, frame, frame_size, NULL, 0, frame_len);
+}
+
+/**
+ * @brief   Decode one frame and check its CRC.
+ * @details payload can be the same buffer as frame to decode in place; the payload is never written ahead of the frame
+ *          bytes still to be read.
+ * @param   frame           The encoded frame, with or without its trailing delimiter.
+ * @param   frame_len       The number of bytes in frame.
+ * @param   msg_id          The message ID (returned by reference).
+ * @param   payload         Buffer for the payload.
+ * @param   payload_size    The size of payload.
+ * @param   payload_len     The number of bytes in the payload (returned by reference).
+ * @return  telemetry_frame_rc_t    Return code indicating operation success/failure.
+ *                                  - TELEMETRY_FRAME_RC_OK:        Operation successful.
+ *                                  - TELEMETRY_FRAME_RC_BAD_ARG:   An invalid argument was provided.
+ *                                  - TELEMETRY_FRAME_RC_OVERFLOW:  The payload doesn't fit in payload.
+ *                                  - TELEMETRY_FRAME_RC_BAD_FRAME: The frame is malformed.
+ *                                  - TELEMETRY_FRAME_RC_BAD_CRC:   The frame is intact COBS but its CRC doesn't match.
+ */
+telemetry_frame_rc_t telemetry_frame_decode(const uint8_t * frame, uint16_t frame_len, uint8_t * msg_id,
+                                            uint8_t * payload, uint16_t payload_size, uint16_t * payload_len) {
+    if(frame == NULL || msg_id == NULL || payload == NULL || payload_len == NULL) {
+        return TELEMETRY_FRAME_RC_BAD_ARG;
+    }
+
+    // The delimiter is optional
+    if(frame_len > 0 && frame[frame_len - 1] == TELEMETRY_FRAME_DELIMITER) {
+        frame_len--;
+    }
+
+    body_reader_t reader = {.msg_id = msg_id, .payload = payload, .payload_size = payload_size, .payload_len = 0, .body_len = 0, .crc = 0xFFFF};
+    uint16_t i = 0;
+    while(i < frame_len) {
+        // Each block is a code byte and code - 1 data bytes, then an implicit zero unless the block is full or the last one
+        uint8_t code = frame[i++] ^ TELEMETRY_FRAME_DELIMITER;
+        if(code == 0 || (uint32_t)i + code - 1 > frame_len) {
+            return TELEMETRY_FRAME_RC_BAD_FRAME;
+        }
+
+        for(uint8_t j = 1; j < code; j++) {
+            uint8_t data = frame[i++] ^ TELEMETRY_FRAME_DELIMITER;
+            if(data == 0) {
+                return TELEMETRY_FRAME_RC_BAD_FRAME;
+            }
+            if(read_byte(&reader, data) != TELEMETRY_FRAME_RC_OK) {
+                return TELEMETRY_FRAME_RC_OVERFLOW;
+            }
+        }
+
+        if(code != COBS_MAX_CODE && i < frame_len) {
+            if(read_byte(&reader, 0) != TELEMETRY_FRAME_RC_OK) {
+                return TELEMETRY_FRAME_RC_OVERFLOW;
+            }
+        }
+    }
+
+    // The body must at least hold an ID and a CRC
+    if(reader.body_len < 3) {
+        return TELEMETRY_FRAME_RC_BAD_FRAME;
+    }
+    if(reader.crc != (uint16_t)(reader.held[0] | (reader.held[1] << 8))) {
+        return TELEMETRY_FRAME_RC_BAD_CRC;
+    }
+
+    *payload_len = reader.payload_len;
+    return TELEMETRY_FRAME_RC_OK;
+}
+
+/**
+ * @brief   Initialize a stream decoder, which splits a byte stream into frames and decodes them.
+ * @param   decoder         The decoder.
+ * @param   buffer          Buffer to collect a frame in. Frames that don't fit are dropped.
+ * @param   buffer_size     The size of buffer, TELEMETRY_FRAME_MAX_ENCODED_LEN(TELEMETRY_FRAME_MAX_PAYLOAD) fits any frame.
+ * @return  telemetry_frame_rc_t    Return code indicating operation success/failure.
+ *                                  - TELEMETRY_FRAME_RC_OK:        Operation successful.
+ *                                  - TELEMETRY_FRAME_RC_BAD_ARG:   An invalid argument was provided.
+ */
+telemetry_frame_rc_t telemetry_frame_decoder_init(telemetry_frame_decoder_t * decoder, uint8_t * buffer, uint16_t buffer_size) {
+    if(decoder == NULL || buffer == NULL || buffer_size == 0) {
+        return TELEMETRY_FRAME_RC_BAD_ARG;
+    }
+
+    decoder->buffer = buffer;
+    decoder->buffer_size = buffer_size;
+    decoder->len = 0;
+    decoder->is_discarding = false;
+    decoder->frames_decoded = 0;
+    decoder->frames_dropped = 0;
+
+    return TELEMETRY_FRAME_RC_OK;
+}
+
+/**
+ * @brief   Feed bytes from the stream to a decoder, calling handler for every complete, valid frame in them.
+ * @details Data can be split anywhere. Malformed, corrupted and oversized frames are counted in frames_dropped.
+ * @param   decoder         The decoder.
+ * @param   data            The bytes received.
+ * @param   len             The number of bytes in data.
+ * @param   handler         Called for each valid frame.
+ * @param   context         Passed to handler.
+ */
+void telemetry_frame_decoder_feed(telemetry_frame_decoder_t * decoder, const uint8_t * data, size_t len,
+                                  telemetry_frame_handler_t handler, void * context) {
+    if(decoder == NULL || data == NULL || handler == NULL) {
+        return;
+    }
+
+    for(size_t i = 0; i < len; i++) {
+        if(data[i] != TELEMETRY_FRAME_DELIMITER) {
+            // Collect the frame, or drop the rest of it once it has overflowed the buffer
+            if(decoder->len == decoder->buffer_size) {
+                decoder->is_discarding = true;
+            }
+            if(!decoder->is_discarding) {
+                decoder->buffer[decoder->len++] = data[i];
+            }
+            continue;
+        }
+
+        // End of frame, decode it in place; back to back delimiters are empty frames and are skipped
+        if(decoder->is_discarding) {
+            decoder->frames_dropped++;
+        }
+        else if(decoder->len > 0) {
+            uint8_t msg_id;
+            uint16_t payload_len;
+            if(telemetry_frame_decode(decoder->buffer, decoder->len, &msg_id, decoder->buffer, decoder->buffer_size, &payload_len) == TELEMETRY_FRAME_RC_OK) {
+                decoder->frames_decoded++;
+                handler(msg_id, decoder->buffer, payload_len, context);
+            }
+            else {
+                decoder->frames_dropped++;
+            }
+        }
+        decoder->len = 0;
+        decoder->is_discarding = false;
+    }
+}
@@ -0,0 +1,166 @@
+/**
+ * @file    timestamped_buffer.h
+ * @brief   Defines an interface to keep a history of timestamped sensor samples and query it by time.
+ * @details Samples are stored oldest first in a circular_buffer_t that overwrites the oldest sample when full.
+ *          Timestamps must be non-decreasing, which keeps the history sorted so lookups by time are a binary search.
+ *          This lets fusion code align readings from different sensors (e.g. IMU and ultrasonic) after the fact,
+ *          instead of only seeing the latest value in each driver struct.
+ *
+ *          Pushing and querying are not synchronized with each other. If samples are pushed from an interrupt,
+ *          queries from another context must be done with that interrupt disabled.
+ *
+ *          Example:
+ *              static timestamped_sample_t accel_samples[64];
+ *              timestamped_buffer_t accel_history;
+ *              timestamped_buffer_init(&accel_history, accel_samples, 64);
+ *              timestamped_buffer_push_now(&accel_history, &mpu_6050.accel_data);
+ *              ...
+ *              vec_double_t accel_at_echo;
+ *              timestamped_buffer_interpolate(&accel_history, echo_time_us, &accel_at_echo);
+ *
+ * @section Dependencies
+ * - 'circular_buffer.h':   Stores the samples.
+ * - 'vector_lib.h':        Provides the sample value type.
+ * - 'pico/stdlib.h':       Provides time_us_64 for timestamping.
+ */
+
+#ifndef TIMESTAMPED_BUFFER_H
+#define TIMESTAMPED_BUFFER_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "circular_buffer.h"
+#include "vector_lib.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef enum {
+    TIMESTAMPED_BUFFER_RC_OK            = 0,
+    TIMESTAMPED_BUFFER_RC_BAD_ARG       = 1,
+    TIMESTAMPED_BUFFER_RC_EMPTY         = 2,
+    TIMESTAMPED_BUFFER_RC_OUT_OF_ORDER  = 3,
+    TIMESTAMPED_BUFFER_RC_OUT_OF_RANGE  = 4,
+} timestamped_buffer_rc_t;
+
+typedef struct {
+    uint64_t timestamp_us;  // Time the sample was taken, in microseconds since boot
+    vec_double_t value;     // Sample value, single-axis sensors only use x
+} timestamped_sample_t;
+
+typedef struct {
+    circular_buffer_t samples;
+} timestamped_buffer_t;
+
+/**
+ * @brief   Initialize a timestamped buffer.
+ * @param   timestamped_buffer          The timestamped buffer struct.
+ * @param   buffer                      The fixed-size sample array used to store the history.
+ * @param   buffer_capacity             The number of samples in the array. One slot is kept free, so buffer_capacity - 1 samples are stored.
+ * @return  timestamped_buffer_rc_t     Return code indicating operation success/failure.
+ *                                      - TIMESTAMPED_BUFFER_RC_OK:         Operation successful.
+ *                                      - TIMESTAMPED_BUFFER_RC_BAD_ARG:    An invalid argument was provided.
+ */
+timestamped_buffer_rc_t timestamped_buffer_init(timestamped_buffer_t * timestamped_buffer, timestamped_sample_t * buffer, uint16_t buffer_capacity);
+
+/**
+ * @brief   Get the number of samples stored in the timestamped buffer.
+ * @details Skips null arg checking for easier usage.
+ * @param   timestamped_buffer  The timestamped buffer struct.
+ * @return  uint16_t            The number of samples stored.
+ */
+uint16_t timestamped_buffer_get_size(timestamped_buffer_t * timestamped_buffer);
+
+/**
+ * @brief   Push a sample taken at a given time onto the timestamped buffer.
+ * @details Overwrites the oldest sample if the buffer is full.
+ * @param   timestamped_buffer          The timestamped buffer struct.
+ * @param   timestamp_us                Time the sample was taken. Must not be earlier than the newest stored sample.
+ * @param   value                       The sample value.
+ * @return  timestamped_buffer_rc_t     Return code indicating operation success/failure.
+ *                                      - TIMESTAMPED_BUFFER_RC_OK:             Operation successful.
+ *                                      - TIMESTAMPED_BUFFER_RC_BAD_ARG:        An invalid argument was provided.
+ *                                      - TIMESTAMPED_BUFFER_RC_OUT_OF_ORDER:   timestamp_us is earlier than the newest stored sample, nothing was pushed.
+ */
+timestamped_buffer_rc_t timestamped_buffer_push(timestamped_buffer_t * timestamped_buffer, uint64_t timestamp_us, const vec_double_t * value);
+
+/**
+ * @brief   Push a sample taken now onto the timestamped buffer, timestamped with time_us_64().
+ * @param   timestamped_buffer          The timestamped buffer struct.
+ * @param   value                       The sample value.
+ * @return  timestamped_buffer_rc_t     Return code indicating operation success/failure, see timestamped_buffer_push.
+ */
+timestamped_buffer_rc_t timestamped_buffer_push_now(timestamped_buffer_t * timestamped_buffer, const vec_double_t * value);
+
+/**
+ * @brief   Get a stored sample by position.
+ * @param   timestamped_buffer          The timestamped buffer struct.
+ * @param   index                       Position of the sample, 0 is the oldest stored sample.
+ * @param   sample                      The sample (returned by reference).
+ * @return  timestamped_buffer_rc_t     Return code indicating operation success/failure.
+ *                                      - TIMESTAMPED_BUFFER_RC_OK:             Operation successful.
+ *                                      - TIMESTAMPED_BUFFER_RC_BAD_ARG:        An invalid argument was provided.
+ *                                      - TIMESTAMPED_BUFFER_RC_OUT_OF_RANGE:   index is not less than the number of stored samples.
+ */
+timestamped_buffer_rc_t timestamped_buffer_get(timestamped_buffer_t * timestamped_buffer, uint16_t index, timestamped_sample_t * sample);
+
+/**
+ * @brief   Get the newest stored sample.
+ * @param   timestamped_buffer          The timestamped buffer struct.
+ * @param   sample                      The newest sample (returned by reference).
+ * @return  timestamped_buffer_rc_t     Return code indicating operation success/failure.
+ *                                      - TIMESTAMPED_BUFFER_RC_OK:         Operation successful.
+ *                                      - TIMESTAMPED_BUFFER_RC_BAD_ARG:    An invalid argument was provided.
+ *                                      - TIMESTAMPED_BUFFER_RC_EMPTY:      No samples are stored.
+ */
+timestamped_buffer_rc_t timestamped_buffer_get_latest(timestamped_buffer_t * timestamped_buffer, timestamped_sample_t * sample);
+
+/**
+ * @brief   Find the oldest stored sample taken at or after a given time.
+ * @details Binary search over the stored samples, O(log n).
+ * @param   timestamped_buffer          The timestamped buffer struct.
+ * @param   timestamp_us                The time to search for.
+ * @param   index                       Position of the found sample, 0 is the oldest stored sample (returned by reference).
+ * @return  timestamped_buffer_rc_t     Return code indicating operation success/failure.
+ *                                      - TIMESTAMPED_BUFFER_RC_OK:             Operation successful.
+ *                                      - TIMESTAMPED_BUFFER_RC_BAD_ARG:        An invalid argument was provided.
+ *                                      - TIMESTAMPED_BUFFER_RC_EMPTY:          No samples are stored.
+ *                                      - TIMESTAMPED_BUFFER_RC_OUT_OF_RANGE:   Every stored sample was taken before timestamp_us.
+ */
+timestamped_buffer_rc_t timestamped_buffer_find(timestamped_buffer_t * timestamped_buffer, uint64_t timestamp_us, uint16_t * index);
+
+/**
+ * @brief   Copy all stored samples taken at or after a given time, oldest first.
+ * @details Copies at most max_count samples, keeping the oldest matching ones.
+ * @param   timestamped_buffer          The timestamped buffer struct.
+ * @param   timestamp_us                The earliest time to copy samples from.
+ * @param   samples                     Array to copy the samples to.
+ * @param   max_count                   Number of samples that fit in the array.
+ * @param   count                       Number of samples copied (returned by reference).
+ * @return  timestamped_buffer_rc_t     Return code indicating operation success/failure.
+ *                                      - TIMESTAMPED_BUFFER_RC_OK:         Operation successful, count may be 0.
+ *                                      - TIMESTAMPED_BUFFER_RC_BAD_ARG:    An invalid argument was provided.
+ */
+timestamped_buffer_rc_t timestamped_buffer_since(timestamped_buffer_t * timestamped_buffer, uint64_t timestamp_us, timestamped_sample_t * samples, uint16_t max_count, uint16_t * count);
+
+/**
+ * @brief   Estimate the sample value at a given time by linearly interpolating between the stored samples around it.
+ * @details Does not extrapolate; timestamp_us must lie between the oldest and newest stored samples.
+ * @param   timestamped_buffer          The timestamped buffer struct.
+ * @param   timestamp_us                The time to estimate the value at.
+ * @param   value                       The estimated value (returned by reference).
+ * @return  timestamped_buffer_rc_t     Return code indicating operation success/failure.
+ *                                      - TIMESTAMPED_BUFFER_RC_OK:             Operation successful.
+ *                                      - TIMESTAMPED_BUFFER_RC_BAD_ARG:        An invalid argument was provided.
+ *                                      - TIMESTAMPED_BUFFER_RC_EMPTY:          No samples are stored.
+ *                                      - TIMESTAMPED_BUFFER_RC_OUT_OF_RANGE:   timestamp_us is outside the stored samples.
+ */
+timestamped_buffer_rc_t timestamped_buffer_interpolate(timestamped_buffer_t * timestamped_buffer, uint64_t timestamp_us, vec_double_t * value);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // TIMESTAMPED_BUFFER_H
@@ -0,0 +1,291 @@
+#include "timestamped_buffer.h"
+
+#include "pico/stdlib.h"
+
+/**
+ * @brief   Helper function that gets a stored sample in place by position.
+ * @param   regions                 The stored regions of the sample buffer, oldest first.
+ * @param   index                   Position of the sample, 0 is the oldest stored sample. Must be less than the number of stored samples.
+ * @return  timestamped_sample_t *  Pointer to the sample inside the sample buffer.
+ */
+static inline timestamped_sample_t * sample_at(const circular_buffer_regions_t * regions, uint16_t index) {
+    if(index < regions->first_count) {
+        return (timestamped_sample_t *)regions->first + index;
+    }
+    return (timestamped_sample_t *)regions->second + (index - regions->first_count);
+}
+
+/**
+ * @brief   Helper function that finds the position of the oldest stored sample taken at or after a given time.
+ * @details Binary search, relies on the stored samples being sorted by timestamp.
+ * @param   regions         The stored regions of the sample buffer, oldest first.
+ * @param   timestamp_us    The time to search for.
+ * @return  uint16_t        Position of the found sample, or the number of stored samples if every sample is older.
+ */
+static uint16_t lower_bound(const circular_buffer_regions_t * regions, uint64_t timestamp_us) {
+    uint16_t low = 0;
+    uint16_t high = regions->first_count + regions->second_count;
+
+    while(low < high) {
+        uint16_t mid = low + ((high - low) >> 1);
+        if(sample_at(regions, mid)->timestamp_us < timestamp_us) {
+            low = mid + 1;
+        }
+        else {
+            high = mid;
+        }
+    }
+
+    return low;
+}
+
+/**
+ * @brief   Initialize a timestamped buffer.
+ * @param   timestamped_buffer          The timestamped buffer struct.
+ * @param   buffer                      The fixed-size sample array used to store the history.
+ * @param   buffer_capacity             The number of samples in the array. One slot is kept free, so buffer_capacity - 1 samples are stored.
+ * @return  timestamped_buffer_rc_t     Return code indicating operation success/failure.
+ *                                      - TIMESTAMPED_BUFFER_RC_OK:         Operation successful.
+ *                                      - TIMESTAMPED_BUFFER_RC_BAD_ARG:    An invalid argument was provided.
+ */
+timestamped_buffer_rc_t timestamped_buffer_init(timestamped_buffer_t * timestamped_buffer, timestamped_sample_t * buffer, uint16_t buffer_capacity) {
+    if(timestamped_buffer == NULL || buffer == NULL || buffer_capacity < 2) {
+        return TIMESTAMPED_BUFFER_RC_BAD_ARG;
+    }
+
+    // Default mode keeps the newest history by overwriting the oldest sample when full
+    circular_buffer_init(&timestamped_buffer->samples, buffer, buffer_capacity, sizeof(timestamped_sample_t));
+    circular_buffer_set_overflow_policy(&timestamped_buffer->samples, CIRCULAR_BUFFER_OVERWRITE_OLDEST);
+
+    return TIMESTAMPED_BUFFER_RC_OK;
+}
+
+/**
+ * @brief   Get the number of samples stored in the timestamped buffer.
+ * @details Skips null arg checking for easier usage.
+ * @param   timestamped_buffer  The timestamped buffer struct.
+ * @return  uint16_t            The number of samples stored.
+ */
+uint16_t timestamped_buffer_get_size(timestamped_buffer_t * timestamped_buffer) {
+    return circular_buffer_get_size(&timestamped_buffer->samples);
+}
+
+/**
+ * @brief   Push a sample taken at a given time onto the timestamped buffer.
+ * @details Overwrites the oldest sample if the buffer is full.
+ * @param   timestamped_buffer          The timestamped buffer struct.
+ * @param   timestamp_us                Time the sample was taken. Must not be earlier than the newest stored sample.
+ * @param   value                       The sample value.
+ * @return  timestamped_buffer_rc_t     Return code indicating operation success/failure.
+ *                                      - TIMESTAMPED_BUFFER_RC_OK:             Operation successful.
+ *                                      - TIMESTAMPED_BUFFER_RC_BAD_ARG:        An invalid argument was provided.
+ *                                      - TIMESTAMPED_BUFFER_RC_OUT_OF_ORDER:   timestamp_us is earlier than the newest stored sample, nothing was pushed.
+ */
+timestamped_buffer_rc_t timestamped_buffer_push(timestamped_buffer_t * timestamped_buffer, uint64_t timestamp_us, const vec_double_t * value) {
+    if(timestamped_buffer == NULL || value == NULL) {
+        return TIMESTAMPED_BUFFER_RC_BAD_ARG;
+    }
+
+    // Keep the history sorted so it can be binary searched
+    circular_buffer_regions_t regions;
+    if(circular_buffer_peek(&timestamped_buffer->samples, &regions) == CIRCULAR_BUFFER_RC_OK) {
+        uint16_t size = regions.first_count + regions.second_count;
+        if(timestamp_us < sample_at(&regions, size - 1)->timestamp_us) {
+            return TIMESTAMPED_BUFFER_RC_OUT_OF_ORDER;
+        }
+    }
+
+    // Overflow only means the oldest sample was overwritten
+    timestamped_sample_t sample = {
+        .timestamp_us = timestamp_us,
+        .value = *value,
+    };
+    circular_buffer_push(&timestamped_buffer->samples, &sample, sizeof(sample));
+
+    return TIMESTAMPED_BUFFER_RC_OK;
+}
+
+/**
+ * @brief   Push a sample taken now onto the timestamped buffer, timestamped with time_us_64().
+ * @param   timestamped_buffer          The timestamped buffer struct.
+ * @param   value                       The sample value.
+ * @return  timestamped_buffer_rc_t     Return code indicating operation success/failure, see timestamped_buffer_push.
+ */
+timestamped_buffer_rc_t timestamped_buffer_push_now(timestamped_buffer_t * timestamped_buffer, const vec_double_t * value) {
+    return timestamped_buffer_push(timestamped_buffer, time_us_64(), value);
+}
+
+/**
+ * @brief   Get a stored sample by position.
+ * @param   timestamped_buffer          The timestamped buffer struct.
+ * @param   index                       Position of the sample, 0 is the oldest stored sample.
+ * @param   sample                      The sample (returned by reference).
+ * @return  timestamped_buffer_rc_t     Return code indicating operation success/failure.
+ *                                      - TIMESTAMPED_BUFFER_RC_OK:             Operation successful.
+ *                                      - TIMESTAMPED_BUFFER_RC_BAD_ARG:        An invalid argument was provided.
+ *                                      - TIMESTAMPED_BUFFER_RC_OUT_OF_RANGE:   index is not less than the number of stored samples.
+ */
+timestamped_buffer_rc_t timestamped_buffer_get(timestamped_buffer_t * timestamped_buffer, uint16_t index, timestamped_sample_t * sample) {
+    if(timestamped_buffer == NULL || sample == NULL) {
+        return TIMESTAMPED_BUFFER_RC_BAD_ARG;
+    }
+
+    circular_buffer_regions_t regions;
+    circular_buffer_peek(&timestamped_buffer->samples, &regions);
+    if(index >= regions.first_count + regions.second_count) {
+        return TIMESTAMPED_BUFFER_RC_OUT_OF_RANGE;
+    }
+
+    *sample = *sample_at(&regions, index);
+
+    return TIMESTAMPED_BUFFER_RC_OK;
+}
+
+/**
+ * @brief   Get the newest stored sample.
+ * @param   timestamped_buffer          The timestamped buffer struct.
+ * @param   sample                      The newest sample (returned by reference).
+ * @return  timestamped_buffer_rc_t     Return code indicating operation success/failure.
+ *                                      - TIMESTAMPED_BUFFER_RC_OK:         Operation successful.
+ *                                      - TIMESTAMPED_BUFFER_RC_BAD_ARG:    An invalid argument was provided.
+ *                                      - TIMESTAMPED_BUFFER_RC_EMPTY:      No samples are stored.
+ */
+timestamped_buffer_rc_t timestamped_buffer_get_latest(timestamped_buffer_t * timestamped_buffer, timestamped_sample_t * sample) {
+    if(timestamped_buffer == NULL || sample == NULL) {
+        return TIMESTAMPED_BUFFER_RC_BAD_ARG;
+    }
+
+    circular_buffer_regions_t regions;
+    if(circular_buffer_peek(&timestamped_buffer->samples, &regions) != CIRCULAR_BUFFER_RC_OK) {
+        return TIMESTAMPED_BUFFER_RC_EMPTY;
+    }
+
+    *sample = *sample_at(&regions, regions.first_count + regions.second_count - 1);
+
+    return TIMESTAMPED_BUFFER_RC_OK;
+}
+
+/**
+ * @brief   Find the oldest stored sample taken at or after a given time.
+ * @details Binary search over the stored samples, O(log n).
+ * @param   timestamped_buffer          The timestamped buffer struct.
+ * @param   timestamp_us                The time to search for.
+ * @param   index                       Position of the found sample, 0 is the oldest stored sample (returned by reference).
+ * @return  timestamped_buffer_rc_t     Return code indicating operation success/failure.
+ *                                      - TIMESTAMPED_BUFFER_RC_OK:             Operation successful.
+ *                                      - TIMESTAMPED_BUFFER_RC_BAD_ARG:        An invalid argument was provided.
+ *                                      - TIMESTAMPED_BUFFER_RC_EMPTY:          No samples are stored.
+ *                                      - TIMESTAMPED_BUFFER_RC_OUT_OF_RANGE:   Every stored sample was taken before timestamp_us.
+ */
+timestamped_buffer_rc_t timestamped_buffer_find(timestamped_buffer_t * timestamped_buffer, uint64_t timestamp_us, uint16_t * index) {
+    if(timestamped_buffer == NULL || index == NULL) {
+        return TIMESTAMPED_BUFFER_RC_BAD_ARG;
+    }
+
+    circular_buffer_regions_t regions;
+    if(circular_buffer_peek(&timestamped_buffer->samples, &regions) != CIRCULAR_BUFFER_RC_OK) {
+        return TIMESTAMPED_BUFFER_RC_EMPTY;
+    }
+
+    uint16_t found = lower_bound(&regions, timestamp_us);
+    if(found == regions.first_count + regions.second_count) {
+        return TIMESTAMPED_BUFFER_RC_OUT_OF_RANGE;
+    }
+
+    *index = found;
+
+    return TIMESTAMPED_BUFFER_RC_OK;
+}
+
+/**
+ * @brief   Copy all stored samples taken at or after a given time, oldest first.
+ * @details Copies at most max_count samples, keeping the oldest matching ones.
+ * @param   timestamped_buffer          The timestamped buffer struct.
+ * @param   timestamp_us                The earliest time to copy samples from.
+ * @param   samples                     Array to copy the samples to.
+ * @param   max_count                   Number of samples that fit in the array.
+ * @param   count                       Number of samples copied (returned by reference).
+ * @return  timestamped_buffer_rc_t     Return code indicating operation success/failure.
+ *                                      - TIMESTAMPED_BUFFER_RC_OK:         Operation successful, count may be 0.
+ *                                      - TIMESTAMPED_BUFFER_RC_BAD_ARG:    An invalid argument was provided.
+ */
+timestamped_buffer_rc_t timestamped_buffer_since(timestamped_buffer_t * timestamped_buffer, uint64_t timestamp_us, timestamped_sample_t * samples, uint16_t max_count, uint16_t * count) {
+    if(timestamped_buffer == NULL || samples == NULL || count == NULL) {
+        return TIMESTAMPED_BUFFER_RC_BAD_ARG;
+    }
+
+    circular_buffer_regions_t regions;
+    circular_buffer_peek(&timestamped_buffer->samples, &regions);
+
+    uint16_t size = regions.first_count + regions.second_count;
+    uint16_t start = lower_bound(&regions, timestamp_us);
+    uint16_t copy_count = size - start;
+    if(copy_count > max_count) {
+        copy_count = max_count;
+    }
+
+    // Matching samples are contiguous within each region, so copy at most two runs
+    uint16_t copied = 0;
+    if(start < regions.first_count) {
+        copied = regions.first_count - start;
+        if(copied > copy_count) {
+            copied = copy_count;
+        }
+        memcpy(samples, sample_at(&regions, start), copied * sizeof(timestamped_sample_t));
+    }
+    if(copied < copy_count) {
+        memcpy(&samples[copied], sample_at(&regions, start + copied), (copy_count - copied) * sizeof(timestamped_sample_t));
+    }
+
+    *count = copy_count;
+
+    return TIMESTAMPED_BUFFER_RC_OK;
+}
+
+/**
+ * @brief   Estimate the sample value at a given time by linearly interpolating between the stored samples around it.
+ * @details Does not extrapolate; timestamp_us must lie between the oldest and newest stored samples.
+ * @param   timestamped_buffer          The timestamped buffer struct.
+ * @param   timestamp_us                The time to estimate the value at.
+ * @param   value                       The estimated value (returned by reference).
+ * @return  timestamped_buffer_rc_t     Return code indicating operation success/failure.
+ *                                      - TIMESTAMPED_BUFFER_RC_OK:             Operation successful.
+ *                                      - TIMESTAMPED_BUFFER_RC_BAD_ARG:        An invalid argument was provided.
+ *                                      - TIMESTAMPED_BUFFER_RC_EMPTY:          No samples are stored.
+ *                                      - TIMESTAMPED_BUFFER_RC_OUT_OF_RANGE:   timestamp_us is outside the stored samples.
+ */
+timestamped_buffer_rc_t timestamped_buffer_interpolate(timestamped_buffer_t * timestamped_buffer, uint64_t timestamp_us, vec_double_t * value) {
+    if(timestamped_buffer == NULL || value == NULL) {
+        return TIMESTAMPED_BUFFER_RC_BAD_ARG;
+    }
+
+    circular_buffer_regions_t regions;
+    if(circular_buffer_peek(&timestamped_buffer->samples, &regions) != CIRCULAR_BUFFER_RC_OK) {
+        return TIMESTAMPED_BUFFER_RC_EMPTY;
+    }
+
+    // Find the first sample at or after the requested time, the sample before it brackets the time from below
+    uint16_t after_index = lower_bound(&regions, timestamp_us);
+    if(after_index == regions.first_count + regions.second_count) {
+        return TIMESTAMPED_BUFFER_RC_OUT_OF_RANGE;
+    }
+
+    timestamped_sample_t * after = sample_at(&regions, after_index);
+    if(after->timestamp_us == timestamp_us) {
+        *value = after->value;
+        return TIMESTAMPED_BUFFER_RC_OK;
+    }
+    if(after_index == 0) {
+        return TIMESTAMPED_BUFFER_RC_OUT_OF_RANGE;
+    }
+
+    // Timestamps strictly increase across the bracket here, so the span is never zero
+    timestamped_sample_t * before = sample_at(&regions, after_index - 1);
+    double fraction = (double)(timestamp_us - before->timestamp_us) / (double)(after->timestamp_us - before->timestamp_us);
+
+    value->x = before->value.x + (after->value.x - before->value.x) * fraction;
+    value->y = before->value.y + (after->value.y - before->value.y) * fraction;
+    value->z = before->value.z + (after->value.z - before->value.z) * fraction;
+
+    return TIMESTAMPED_BUFFER_RC_OK;
+}
@@ -4,6 +4,10 @@
  * 
  * @section Dependencies
  * - 'circular_buffer.h':   Provides circular buffers to store tx and rx message/character data for/from irqs.
+ * - 'circular_buffer_typed.h': Provides the circular buffer used to index the end of each received message.
+ * - 'hardware/dma.h':      Provides the DMA channels used by the optional DMA transmit mode.
+ * - 'hardware/sync.h':     Provides the hardware spinlock that orders tx reservations across tasks and cores.
+ * - 'telemetry_frame.h':   Provides the binary framing used by hc06_tx_frame.
  */
 
 #ifndef HC_06_H
@@ -14,58 +18,240 @@
 #include "hardware/uart.h"
 #include "hardware/sync.h"
 #include "hardware/irq.h"
+#include "hardware/dma.h"
 #include "circular_buffer.h"
+#include "circular_buffer_typed.h"
+#include "telemetry_frame.h"
 
 typedef enum {
-    HC06_DEFAULT_BUFFER_SIZE    = 250,
-    HC06_DEFAULT_MSG_SIZE       = 250,
+    HC06_DEFAULT_BUFFER_SIZE    = 256,
+    HC06_DEFAULT_MSG_SIZE       = 256,
+    HC06_UART_FIFO_DEPTH        = 32,
+    HC06_MAX_PENDING_FRAMES     = 16,
 } hc06_consts_t;
 
+// UART FIFO trigger levels, as a fraction of HC06_UART_FIFO_DEPTH; see hc06_set_fifo_levels
+typedef enum {
+    HC06_FIFO_LEVEL_1_8         = 0,    // 4 characters
+    HC06_FIFO_LEVEL_1_4         = 1,    // 8 characters
+    HC06_FIFO_LEVEL_1_2         = 2,    // 16 characters
+    HC06_FIFO_LEVEL_3_4         = 3,    // 24 characters
+    HC06_FIFO_LEVEL_7_8         = 4,    // 28 characters
+} hc06_fifo_level_t;
+
+// Ring of rx buffer head indices, each marking the end of a received message (one past its newline)
+CIRCULAR_BUFFER_TYPED_DEFINE(hc06_frame_index, uint16_t, HC06_MAX_PENDING_FRAMES)
+
 typedef enum {
     HC06_RC_OK                  = 0,
     HC06_RC_BAD_ARG             = 1,
     HC06_RC_ERROR_TX_BUFFER     = 2,
     HC06_RC_ERROR_RX_BUFFER     = 3,
+    HC06_RC_ERROR_DMA           = 4,
+    HC06_RC_TIMEOUT             = 5,
 } hc06_rc_t;
 
+// One fragment of a message for hc06_tx_msgv
+typedef struct {
+    const void * data;
+    uint16_t len;
+} hc06_iovec_t;
+
+// Events passed to the event callback, see hc06_set_event_callback
+typedef enum {
+    HC06_EVENT_RX_MESSAGE       = 0,    // One or more messages were indexed, or the rx buffer filled without one, and can be received with hc06_rx_msg
+    HC06_EVENT_TX_SPACE         = 1,    // Sent characters were released, leaving the tx buffer at or below its low watermark
+} hc06_event_t;
+
+// Called from the UART and DMA irqs, so it must be short and only use irq-safe calls
+typedef void (*hc06_event_callback_t)(hc06_event_t event, void * context);
+
 typedef struct {
     // UART
     uart_inst_t * uart_id;
     uint32_t uart_baudrate;
     uint8_t uart_irq;
+    uint8_t irq_core;                   // The core hc06_init ran on, which services the device's irqs
 
     // Circular buffers used for non-blocking communication
     circular_buffer_t tx_buffer;
     circular_buffer_t rx_buffer;
+    hc06_frame_index_t rx_frames;
+
+    // Held while reserving and committing tx buffer space and while filling the tx FIFO/starting a tx transfer, shared by devices on the same UART
+    spin_lock_t * tx_lock;
+    uint16_t tx_reserved_count;         // Characters reserved past the tx buffer's head by producers, committed once none is copying
+    uint8_t tx_writers;                 // Producers still copying into their reservation
+
+    // DMA transmit mode, replaces the tx irq once enabled with hc06_enable_tx_dma
+    bool tx_dma_enabled;
+    uint8_t tx_dma_irq;
+    uint8_t tx_dma_channel;             // Sends the first contiguous region of the tx buffer
+    uint8_t tx_dma_wrap_channel;        // Sends the region that wrapped around to the start of the tx buffer, chained from tx_dma_channel
+    volatile uint16_t tx_dma_count;     // Characters in the transfer in flight, 0 if the DMA is idle
+
+    // DMA receive mode, replaces the rx irq once enabled with hc06_enable_rx_dma
+    bool rx_dma_enabled;
+    uint8_t rx_dma_irq;
+    uint8_t rx_dma_channel;             // Writes received characters into the rx buffer, wrapping within it
 
     // Flags used to indicate current status of tx and rx transactions
     volatile bool message_sent;
     volatile bool message_received;
+
+    // Optional callback from the irqs, used to wake a waiting consumer instead of having it poll the flags above
+    hc06_event_callback_t event_callback;
+    void * event_context;
+    uint16_t tx_low_watermark;          // HC06_EVENT_TX_SPACE is raised once the tx buffer holds at most this many characters
+
+    // Hardware RTS/CTS flow control, see hc06_enable_flow_control
+    bool flow_control_enabled;
+    volatile bool rx_paused;            // The rx irqs are stopped until hc06_rx_msg makes room in the full rx buffer
+
+    // Statistics, used to measure interrupt load per link (see hc06_get_irqs_per_char)
+    volatile uint32_t uart_irq_count;
+    volatile uint32_t dma_irq_count;    // Only irqs for this device's own DMA channels
+    volatile uint32_t tx_char_count;    // Characters handed to the UART
+    volatile uint32_t rx_char_count;    // Characters taken from the UART, including any dropped on a full rx buffer
+    volatile uint32_t rx_overrun_count; // Times the rx FIFO overflowed before it was read
 } hc06_t;
 
 /**
  * @brief   Initialize the ability to interface with the HC-06 device.
  * @details Assumes the HC-06 device has already been configured to desired settings.
  *          Assumes the UART pins have already been set to the UART function.
- *          Assumes that the system will only use one HC-06 device.
+ *          One HC-06 device can be used per UART; each is serviced by its own UART irq and never waits on the other.
+ *          The device's irqs run on the core that calls hc06_init. The tx calls can be made from either core, the rest
+ *          (hc06_rx_msg, hc06_rx_frames_pending, hc06_enable_rx_dma, hc06_set_event_callback) keep the irqs out by masking
+ *          them, which only works on that core, so they return HC06_RC_BAD_ARG (or 0) on the other one.
+ *          The tx and rx buffers are shared lock-free between the UART irq and the caller, so their sizes must be powers of two.
+ *          The UART FIFO trigger levels start at HC06_FIFO_LEVEL_1_2 for rx and HC06_FIFO_LEVEL_1_4 for tx.
  * @param   device          The HC-06 device struct.
  * @param   uart_id         The RP2040 UART peripheral to use with this device.
  * @param   uart_tx_pin     tx pin used for UART transmissions.
  * @param   uart_rx_pin     rx pin used for UART transmissions.
  * @param   uart_baudrate   The baudrate to use for UART communication.
- * @param   uart_irq        The handler for UART interrupts.
+ * @param   uart_irq        The UART's interrupt, UART0_IRQ for uart0 and UART1_IRQ for uart1.
  * @param   tx_buffer       Buffer used to store data to transmit over UART.
- * @param   tx_buffer_size  Size of tx_buffer, is usually sizeof(tx_buffer).
+ * @param   tx_buffer_size  Size of tx_buffer, is usually sizeof(tx_buffer). Must be a power of two.
  * @param   rx_buffer       Buffer used to store data to receive from UART.
- * @param   rx_buffer_size  Size of rx_buffer, is usually sizeof(rx_buffer).
+ * @param   rx_buffer_size  Size of rx_buffer, is usually sizeof(rx_buffer). Must be a power of two.
  * @return  hc06_rc_t       Return code indicating operation success/failure.
  *                          - HC06_RC_OK:               Operation successful.
- *                          - HC06_RC_BAD_ARG:          An invalid argument was provided.
+ *                          - HC06_RC_BAD_ARG:          An invalid argument was provided. uart_irq must be the interrupt of uart_id.
  *                          - HC06_RC_ERROR_TX_BUFFER:  Could not initialize tx buffer.
  *                          - HC06_RC_ERROR_RX_BUFFER:  Could not initialize rx buffer.
  */
 hc06_rc_t hc06_init(hc06_t * device, uart_inst_t * uart_id, uint8_t uart_tx_pin, uint8_t uart_rx_pin, uint32_t uart_baudrate, uint8_t uart_irq, uint8_t * tx_buffer, uint16_t tx_buffer_size, uint8_t * rx_buffer, uint16_t rx_buffer_size);
 
+/**
+ * @brief   Set the UART FIFO levels at which the rx and tx interrupts are raised.
+ * @details The rx irq is raised once the rx FIFO holds at least rx_level characters, and the receive timeout irq flushes
+ *          what is left in it once the line has been idle for 32 bit periods, so a higher rx_level means fewer irqs
+ *          without holding back the end of a message. Higher rx levels leave less time to service the irq before the
+ *          FIFO overruns (counted in rx_overrun_count).
+ *          The tx irq is raised once the tx FIFO drains to tx_level characters, so a lower tx_level refills more of the
+ *          FIFO per irq but leaves less time before the line goes idle.
+ *          Has no effect on the directions that use DMA.
+ * @param   device          The HC-06 device struct.
+ * @param   rx_level        The rx FIFO trigger level.
+ * @param   tx_level        The tx FIFO trigger level.
+ * @return  hc06_rc_t       Return code indicating operation success/failure.
+ *                          - HC06_RC_OK:               Operation successful.
+ *                          - HC06_RC_BAD_ARG:          An invalid argument was provided.
+ */
+hc06_rc_t hc06_set_fifo_levels(hc06_t * device, hc06_fifo_level_t rx_level, hc06_fifo_level_t tx_level);
+
+/**
+ * @brief   Set how far the tx buffer must drain before the tx space event is raised.
+ * @details HC06_EVENT_TX_SPACE is only raised when sent characters are released and at most watermark characters are
+ *          left in the tx buffer, so a producer waiting to queue n characters can set it to the tx buffer size minus n
+ *          and be woken once, when they fit. hc06_init sets it to the tx buffer size, raising the event on every release.
+ * @param   device          The HC-06 device struct.
+ * @param   watermark       The tx buffer fill level to raise the event at or below.
+ * @return  hc06_rc_t       Return code indicating operation success/failure.
+ *                          - HC06_RC_OK:               Operation successful.
+ *                          - HC06_RC_BAD_ARG:          An invalid argument was provided, watermark cannot exceed the tx buffer size.
+ */
+hc06_rc_t hc06_set_tx_low_watermark(hc06_t * device, uint16_t watermark);
+
+/**
+ * @brief   Enable hardware RTS/CTS flow control.
+ * @details The UART stops sending while CTS is deasserted, and deasserts RTS while its rx FIFO is full.
+ *          In interrupt receive mode the rx irq also stops draining the rx FIFO while the rx buffer is full, so a sender
+ *          that honours RTS is held off until hc06_rx_msg makes room instead of having characters dropped.
+ *          In DMA receive mode the DMA keeps draining the rx FIFO, so only the FIFO itself is protected.
+ *          The HC-06 module's RTS/CTS pads must be wired to the pins, which must have the UART CTS/RTS function for uart_id.
+ * @param   device          The HC-06 device struct.
+ * @param   uart_cts_pin    CTS pin, input from the HC-06's RTS.
+ * @param   uart_rts_pin    RTS pin, output to the HC-06's CTS.
+ * @return  hc06_rc_t       Return code indicating operation success/failure.
+ *                          - HC06_RC_OK:               Operation successful.
+ *                          - HC06_RC_BAD_ARG:          An invalid argument was provided.
+ */
+hc06_rc_t hc06_enable_flow_control(hc06_t * device, uint8_t uart_cts_pin, uint8_t uart_rts_pin);
+
+/**
+ * @brief   Get the number of UART and DMA interrupts taken per character sent or received since hc06_init.
+ * @param   device          The HC-06 device struct.
+ * @return  float           Interrupts per character, 0 if device is NULL or no characters have moved.
+ */
+float hc06_get_irqs_per_char(hc06_t * device);
+
+/**
+ * @brief   Send tx data with DMA instead of the UART tx interrupt.
+ * @details Each transfer hands the contiguous region(s) of the tx buffer to a DMA channel paced by the UART tx DREQ.
+ *          When the data wraps around the end of the tx buffer, a second channel is chained to send the wrapped region,
+ *          so the CPU is only interrupted once per transfer instead of once per FIFO's worth of characters.
+ *          Messages queued while a transfer is in flight are sent together by the next transfer.
+ *          Must be called after hc06_init. The DMA irq handler is shared, so the irq can also be used by other DMA users.
+ *          The channels are claimed the first time tx DMA is enabled on the UART; hc06_init stops them and enabling tx DMA
+ *          again reuses them.
+ * @param   device          The HC-06 device struct.
+ * @param   dma_irq         The DMA interrupt to signal transfer completion on, DMA_IRQ_0 or DMA_IRQ_1.
+ * @return  hc06_rc_t       Return code indicating operation success/failure.
+ *                          - HC06_RC_OK:               Operation successful.
+ *                          - HC06_RC_BAD_ARG:          An invalid argument was provided, or tx DMA is already enabled.
+ *                          - HC06_RC_ERROR_DMA:        Could not claim two unused DMA channels.
+ */
+hc06_rc_t hc06_enable_tx_dma(hc06_t * device, uint8_t dma_irq);
+
+/**
+ * @brief   Receive rx data with DMA instead of the UART rx interrupt.
+ * @details A DMA channel paced by the UART rx DREQ writes received characters straight into the rx buffer, using the DMA
+ *          ring feature to wrap its write address within the buffer, so no CPU time is spent per received character.
+ *          Characters written by the DMA are published to the rx buffer, and the end of each message indexed, by the UART
+ *          receive timeout interrupt and at the start of hc06_rx_msg and hc06_rx_frames_pending.
+ *          The DMA does not know which characters have been received yet; if more arrive between two hc06_rx_msg calls than
+ *          the rx buffer has room for, unread data is overwritten and what is left of the rx buffer is flushed as one message.
+ *          Must be called after hc06_init. The DMA irq handler is shared, so the irq can also be used by other DMA users.
+ *          The channel is claimed the first time rx DMA is enabled on the UART; hc06_init stops it and enabling rx DMA
+ *          again reuses it.
+ * @param   device          The HC-06 device struct.
+ * @param   dma_irq         The DMA interrupt used to restart the channel after its (very large) transfer count runs out, DMA_IRQ_0 or DMA_IRQ_1.
+ * @return  hc06_rc_t       Return code indicating operation success/failure.
+ *                          - HC06_RC_OK:               Operation successful.
+ *                          - HC06_RC_BAD_ARG:          An invalid argument was provided, rx DMA is already enabled, it was called on the
+ *                                                      other core than hc06_init, or the rx buffer must be aligned to its size
+ *                                                      (e.g. with __attribute__((aligned(HC06_DEFAULT_BUFFER_SIZE)))) and no larger than 32768.
+ *                          - HC06_RC_ERROR_DMA:        Could not claim an unused DMA channel.
+ */
+hc06_rc_t hc06_enable_rx_dma(hc06_t * device, uint8_t dma_irq);
+
+/**
+ * @brief   Set a callback to be called from the irqs when a message is received or tx space frees up.
+ * @details Called once per irq rather than per message or character. In DMA receive mode, messages indexed by
+ *          hc06_rx_msg and hc06_rx_frames_pending themselves are not signalled, since the caller already sees them.
+ *          See hc_06_rtos.h for blocking send/receive calls built on it.
+ * @param   device          The HC-06 device struct.
+ * @param   callback        The callback, NULL to remove it.
+ * @param   context         Passed to callback.
+ * @return  hc06_rc_t       Return code indicating operation success/failure.
+ *                          - HC06_RC_OK:               Operation successful.
+ *                          - HC06_RC_BAD_ARG:          An invalid argument was provided, or it was called on the other core than hc06_init.
+ */
+hc06_rc_t hc06_set_event_callback(hc06_t * device, hc06_event_callback_t callback, void * context);
+
 /**
  * @brief   Transmit a new message through the HC-06 device.
  * @details Assumes that messages are strings terminating with the newline character.
@@ -81,18 +267,62 @@ hc06_rc_t hc06_init(hc06_t * device, uart_inst_t * uart_id, uint8_t uart_tx_pin,
  */
 hc06_rc_t hc06_tx_msg(hc06_t* device, char* tx_buf, uint16_t len, uint16_t * chars_sent);
 
+/**
+ * @brief   Transmit a binary telemetry frame through the HC-06 device.
+ * @details The message is COBS encoded with its ID and CRC (see telemetry_frame.h) in a single pass, straight into the
+ *          free space of the tx buffer, and only handed to the tx irq/DMA once complete. A frame is queued whole or not at all.
+ *          Frames end in a newline, so the receiving end gets them from hc06_rx_msg and decodes them with
+ *          telemetry_frame_decode; its rx buffer must be able to hold TELEMETRY_FRAME_MAX_ENCODED_LEN(len) characters.
+ * @param   device          The HC-06 device struct.
+ * @param   msg_id          The message ID, e.g. one of telemetry_msg_id_t.
+ * @param   payload         The binary payload. Can be NULL if len is 0.
+ * @param   len             Length of the payload. Cannot exceed TELEMETRY_FRAME_MAX_PAYLOAD.
+ * @return  hc06_rc_t       Return code indicating operation success/failure.
+ *                          - HC06_RC_OK:               Operation successful.
+ *                          - HC06_RC_BAD_ARG:          An invalid argument was provided.
+ *                          - HC06_RC_ERROR_TX_BUFFER:  The tx buffer has less than TELEMETRY_FRAME_MAX_ENCODED_LEN(len) free, nothing was queued.
+ */
+hc06_rc_t hc06_tx_frame(hc06_t * device, uint8_t msg_id, const void * payload, uint16_t len);
+
+/**
+ * @brief   Transmit a message made of several fragments through the HC-06 device, e.g. a header, payload and checksum.
+ * @details The fragments are copied straight into the tx buffer one after another and handed to the tx irq/DMA together,
+ *          so no intermediate buffer is needed. The message is queued whole or not at all, into room reserved for it under
+ *          the tx lock, so messages from other tasks or the other core never interleave with it.
+ * @param   device          The HC-06 device struct.
+ * @param   iov             The fragments, in order. A fragment's data can be NULL if its len is 0.
+ * @param   iov_count       The number of fragments in iov.
+ * @return  hc06_rc_t       Return code indicating operation success/failure.
+ *                          - HC06_RC_OK:               Operation successful.
+ *                          - HC06_RC_BAD_ARG:          An invalid argument was provided.
+ *                          - HC06_RC_ERROR_TX_BUFFER:  The tx buffer has less free space than the fragments add up to, nothing was queued.
+ */
+hc06_rc_t hc06_tx_msgv(hc06_t * device, const hc06_iovec_t * iov, uint8_t iov_count);
+
 /**
  * @brief   Receive a new message from the HC-06 device.
  * @details Assumes that messages are strings terminating with the newline character.
  *          Is a non-blocking implementation; message data is obtained from rx interrupt as new data comes in.
+ *          Receives exactly one message, whose end was indexed by the rx interrupt as it arrived.
+ *          No characters are received if no complete message is pending, unless the rx buffer is full, in which case all of it is received.
  * @param   device          The HC-06 device struct.
  * @param   rx_buf          Message buffer to receive in. Its size cannot be less than the capacity of the rx circular buffer.
  * @param   len             Length of message buffer. Cannot be less than the capacity of the rx circular buffer.
  * @param   chars_received  The number of characters from the message buffer that were received (returned by reference)
  * @return  hc06_rc_t       Return code indicating operation success/failure.
  *                          - HC06_RC_OK:               Operation successful.
- *                          - HC06_RC_BAD_ARG:          An invalid argument was provided.
+ *                          - HC06_RC_BAD_ARG:          An invalid argument was provided, or it was called on the other core than hc06_init.
  */
 hc06_rc_t hc06_rx_msg(hc06_t* device, char * rx_buf, uint16_t len, uint16_t * chars_received);
 
+/**
+ * @brief   Get the number of complete messages waiting to be received with hc06_rx_msg.
+ * @details Messages are counted by the rx interrupt as their newline arrives, so no scanning is done.
+ *          In DMA receive mode, characters the DMA has written since they were last published are indexed first.
+ *          At most HC06_MAX_PENDING_FRAMES messages are indexed; further newlines are merged into the following message until one is received.
+ * @param   device          The HC-06 device struct.
+ * @return  uint16_t        Number of pending messages, 0 if device is NULL or it was called on the other core than hc06_init.
+ */
+uint16_t hc06_rx_frames_pending(hc06_t * device);
+
 #endif // HC_06_H
@@ -0,0 +1,118 @@
+/**
+ * @file    hc_06_rtos.h
+ * @brief   Defines blocking send/receive calls for the HC-06 driver, for use from FreeRTOS tasks.
+ * @details The calling task sleeps on its task notification until the UART/DMA irq signals that a message completed or
+ *          tx space freed up (see hc06_set_event_callback), so a task waiting on the link takes no CPU time and wakes as
+ *          soon as the irq has run, instead of on its next poll of message_received.
+ *          One task can wait in hc06_send and one in hc06_receive at a time. The calls use the task's default
+ *          notification (index 0), so the waiting task should not use it for anything else.
+ *
+ *          Example:
+ *              hc06_rtos_t hc06_rtos;
+ *              hc06_rtos_init(&hc06_rtos, &hc06);
+ *
+ *              // In a task
+ *              hc06_receive(&hc06_rtos, rx_buf, sizeof(rx_buf), pdMS_TO_TICKS(100), &chars_received);
+ *
+ * @section Dependencies
+ * - 'hc_06.h':             Provides the HC-06 driver and its event callback.
+ * - 'FreeRTOS.h':          Provides the tick type and ISR yield.
+ * - 'task.h':              Provides task notifications.
+ */
+
+#ifndef HC_06_RTOS_H
+#define HC_06_RTOS_H
+
+// Includes
+#include "hc_06.h"
+#include "FreeRTOS.h"
+#include "task.h"
+
+// How often hc06_receive checks for messages in DMA receive mode, where the irq can't signal them
+#define HC06_RTOS_RX_DMA_POLL_TICKS     1u
+
+typedef struct {
+    hc06_t * device;
+    volatile TaskHandle_t tx_task;      // Task blocked in hc06_send, woken when tx space frees up
+    volatile TaskHandle_t rx_task;      // Task blocked in hc06_receive, woken when a message is received
+} hc06_rtos_t;
+
+/**
+ * @brief   Initialize blocking send/receive for an HC-06 device.
+ * @details Takes over the device's event callback. Must be called after hc06_init.
+ * @param   rtos            The blocking send/receive struct.
+ * @param   device          The HC-06 device struct.
+ * @return  hc06_rc_t       Return code indicating operation success/failure.
+ *                          - HC06_RC_OK:               Operation successful.
+ *                          - HC06_RC_BAD_ARG:          An invalid argument was provided.
+ */
+hc06_rc_t hc06_rtos_init(hc06_rtos_t * rtos, hc06_t * device);
+
+/**
+ * @brief   Transmit a message through the HC-06 device, blocking while the tx buffer is full.
+ * @details Queues as much of the message as fits, then sleeps until the irq frees tx space and queues the rest.
+ *          Returns once the whole message is queued, not once it is sent.
+ * @param   rtos            The blocking send/receive struct.
+ * @param   tx_buf          Message buffer to transmit.
+ * @param   len             Length of message buffer.
+ * @param   timeout         The most ticks to wait for tx space, portMAX_DELAY to wait forever.
+ * @param   chars_sent      The number of characters from the message buffer that were queued (returned by reference)
+ * @return  hc06_rc_t       Return code indicating operation success/failure.
+ *                          - HC06_RC_OK:               Operation successful.
+ *                          - HC06_RC_BAD_ARG:          An invalid argument was provided.
+ *                          - HC06_RC_TIMEOUT:          The timeout ran out before the whole message was queued. Use chars_sent to recover as needed.
+ */
+hc06_rc_t hc06_send(hc06_rtos_t * rtos, const char * tx_buf, uint16_t len, TickType_t timeout, uint16_t * chars_sent);
+
+/**
+ * @brief   Transmit a message made of several fragments with hc06_tx_msgv, blocking until the tx buffer has room for all of it.
+ * @details The task sleeps with the tx low watermark set so it is woken once, when the whole message fits, rather than
+ *          every time some tx space frees up. The message is still queued whole or not at all.
+ * @param   rtos            The blocking send/receive struct.
+ * @param   iov             The fragments, in order. A fragment's data can be NULL if its len is 0.
+ * @param   iov_count       The number of fragments in iov.
+ * @param   timeout         The most ticks to wait for tx space, portMAX_DELAY to wait forever.
+ * @return  hc06_rc_t       Return code indicating operation success/failure.
+ *                          - HC06_RC_OK:               Operation successful.
+ *                          - HC06_RC_BAD_ARG:          An invalid argument was provided.
+ *                          - HC06_RC_ERROR_TX_BUFFER:  The fragments add up to more than the tx buffer can ever hold, nothing was queued.
+ *                          - HC06_RC_TIMEOUT:          The timeout ran out before the message fit, nothing was queued.
+ */
+hc06_rc_t hc06_send_msgv(hc06_rtos_t * rtos, const hc06_iovec_t * iov, uint8_t iov_count, TickType_t timeout);
+
+/**
+ * @brief   Transmit a binary telemetry frame with hc06_tx_frame, blocking until the tx buffer has room for it.
+ * @details The task sleeps with the tx low watermark set so it is woken once, when TELEMETRY_FRAME_MAX_ENCODED_LEN(len)
+ *          characters are free, rather than every time some tx space frees up. The frame is still queued whole or not at all.
+ * @param   rtos            The blocking send/receive struct.
+ * @param   msg_id          The message ID, e.g. one of telemetry_msg_id_t.
+ * @param   payload         The binary payload. Can be NULL if len is 0.
+ * @param   len             Length of the payload. Cannot exceed TELEMETRY_FRAME_MAX_PAYLOAD.
+ * @param   timeout         The most ticks to wait for tx space, portMAX_DELAY to wait forever.
+ * @return  hc06_rc_t       Return code indicating operation success/failure.
+ *                          - HC06_RC_OK:               Operation successful.
+ *                          - HC06_RC_BAD_ARG:          An invalid argument was provided.
+ *                          - HC06_RC_ERROR_TX_BUFFER:  The frame's worst case length is more than the tx buffer can ever hold, nothing was queued.
+ *                          - HC06_RC_TIMEOUT:          The timeout ran out before the frame fit, nothing was queued.
+ */
+hc06_rc_t hc06_send_frame(hc06_rtos_t * rtos, uint8_t msg_id, const void * payload, uint16_t len, TickType_t timeout);
+
+/**
+ * @brief   Receive a message from the HC-06 device, blocking until one is complete.
+ * @details Sleeps until the irq signals that a message was received, then receives it with hc06_rx_msg.
+ *          If the rx buffer fills without a newline, all of it is received instead, like hc06_rx_msg does.
+ *          In DMA receive mode the UART receive timeout never fires while the DMA keeps the FIFO empty, so the task
+ *          also wakes every HC06_RTOS_RX_DMA_POLL_TICKS to publish what the DMA has written (see hc06_enable_rx_dma).
+ * @param   rtos            The blocking send/receive struct.
+ * @param   rx_buf          Message buffer to receive in. Its size cannot be less than the capacity of the rx circular buffer.
+ * @param   len             Length of message buffer. Cannot be less than the capacity of the rx circular buffer.
+ * @param   timeout         The most ticks to wait for a message, portMAX_DELAY to wait forever.
+ * @param   chars_received  The number of characters from the message buffer that were received (returned by reference)
+ * @return  hc06_rc_t       Return code indicating operation success/failure.
+ *                          - HC06_RC_OK:               Operation successful.
+ *                          - HC06_RC_BAD_ARG:          An invalid argument was provided.
+ *                          - HC06_RC_TIMEOUT:          No message was received before the timeout ran out.
+ */
+hc06_rc_t hc06_receive(hc06_rtos_t * rtos, char * rx_buf, uint16_t len, TickType_t timeout, uint16_t * chars_received);
+
+#endif // HC_06_RTOS_H
@@ -1,126 +1,674 @@
 #include "hc_06.h"
 
-// Global information related to hc06 interrupt handler
-hc06_t * hc06 = NULL;
-bool tx_irq_enabled = false;
-bool rx_irq_enabled = false;
+// The hc06 instance on each UART, looked up by the UART and DMA interrupt handlers
+static hc06_t * hc06_instances[NUM_UARTS] = {NULL};
+
+// The hardware spinlock guarding the tx buffer of the hc06 instance on each UART, claimed the first time the UART is used
+static spin_lock_t * tx_locks[NUM_UARTS] = {NULL};
+
+// The tx DMA channels of each UART, claimed the first time tx DMA is enabled on it and -1 until then
+static int tx_dma_channels[NUM_UARTS][2] = {{-1, -1}, {-1, -1}};
+
+// The rx DMA channel of each UART, claimed the first time rx DMA is enabled on it and -1 until then
+static int rx_dma_channels[NUM_UARTS] = {-1, -1};
+
+// Whether the DMA interrupt handler shared by all hc06 instances has been added to DMA_IRQ_0 and DMA_IRQ_1
+static bool dma_irq_handler_added[2] = {false, false};
+
+// The rx DMA channel is restarted whenever this many characters have been received, about 10 hours at 921600 baud
+#define HC06_RX_DMA_TRANSFER_COUNT  0xFFFFFFFFu
+
+// FIFO trigger levels set by hc06_init, the receive timeout irq flushes whatever is below the rx level
+#define HC06_DEFAULT_RX_FIFO_LEVEL  HC06_FIFO_LEVEL_1_2
+#define HC06_DEFAULT_TX_FIFO_LEVEL  HC06_FIFO_LEVEL_1_4
 
 /**
- * @brief   Helper function that sets the status of UART irqs
- * @details We want to be able to independently enable/disable the tx and rx interrupts for their critical selections.
- *          This is done in conjunction with setting tx_irq_enabled and rx_irq_enabled for simplicity since we're assuming only one HC-06 device.
+ * @brief   Helper function that enables/disables the UART tx irq without touching the rx irqs.
+ * @details Uses the atomic set/clear register aliases, so it is safe to call from both the irq and the caller's context.
  * @param   uart_id         The RP2040 UART peripheral to use.
+ * @param   enabled         Whether the tx irq should be enabled.
  */
-static inline void set_uart_irqs(uart_inst_t * uart_id) {
-    uart_set_irq_enables(uart_id, rx_irq_enabled, tx_irq_enabled);
+static inline void set_tx_irq_enabled(uart_inst_t * uart_id, bool enabled) {
+    if(enabled) {
+        hw_set_bits(&uart_get_hw(uart_id)->imsc, UART_UARTIMSC_TXIM_BITS);
+    }
+    else {
+        hw_clear_bits(&uart_get_hw(uart_id)->imsc, UART_UARTIMSC_TXIM_BITS);
+    }
 }
 
 /**
- * @brief   Helper function to send data in tx buffer for interrupt handler
+ * @brief   Helper function that enables/disables the irqs of the DMA channels a device has enabled.
+ * @param   device          The HC-06 device struct.
+ * @param   enabled         Whether the DMA channel irqs should be enabled.
+ */
+static void set_dma_irqs_enabled(hc06_t * device, bool enabled) {
+    if(device->tx_dma_enabled) {
+        uint irq_index = device->tx_dma_irq - DMA_IRQ_0;
+        dma_irqn_set_channel_enabled(irq_index, device->tx_dma_channel, enabled);
+        dma_irqn_set_channel_enabled(irq_index, device->tx_dma_wrap_channel, enabled);
+    }
+    if(device->rx_dma_enabled) {
+        dma_irqn_set_channel_enabled(device->rx_dma_irq - DMA_IRQ_0, device->rx_dma_channel, enabled);
+    }
+}
+
+/**
+ * @brief   Helper function that checks the caller runs on the core that services the device's irqs.
+ * @param   device          The HC-06 device struct.
+ * @return  bool            Whether enter_critical keeps the device's irqs out on the calling core.
+ */
+static inline bool is_on_irq_core(hc06_t * device) {
+    return get_core_num() == device->irq_core;
+}
+
+/**
+ * @brief   Helper function that keeps a device's own interrupts out of a critical section.
+ * @details Only the device's UART irq and DMA channel irqs are masked, so other devices (and everything else on the core)
+ *          keep being serviced. The irqs are only masked on the calling core, so the caller must check is_on_irq_core.
+ *          Must be paired with exit_critical.
+ * @param   device          The HC-06 device struct.
+ */
+static void enter_critical(hc06_t * device) {
+    irq_set_enabled(device->uart_irq, false);
+    set_dma_irqs_enabled(device, false);
+}
+
+/**
+ * @brief   Helper function that ends a critical section started with enter_critical.
+ * @param   device          The HC-06 device struct.
+ */
+static void exit_critical(hc06_t * device) {
+    set_dma_irqs_enabled(device, true);
+    irq_set_enabled(device->uart_irq, true);
+}
+
+/**
+ * @brief   Helper function that passes an event to the device's event callback, if it has one.
+ * @param   device          The HC-06 device struct.
+ * @param   event           The event that happened.
+ */
+static inline void notify_event(hc06_t * device, hc06_event_t event) {
+    hc06_event_callback_t callback = device->event_callback;
+    if(callback != NULL) {
+        callback(event, device->event_context);
+    }
+}
+
+/**
+ * @brief   Helper function that raises the tx space event once the tx buffer has drained to its low watermark.
+ * @param   device          The HC-06 device struct.
+ */
+static inline void notify_tx_space(hc06_t * device) {
+    if(circular_buffer_get_size(&device->tx_buffer) <= device->tx_low_watermark) {
+        notify_event(device, HC06_EVENT_TX_SPACE);
+    }
+}
+
+/**
+ * @brief   Helper function that writes a contiguous region of characters to the UART for as long as it is writable.
+ * @param   uart_id         The RP2040 UART peripheral to use.
+ * @param   data            The characters to write.
+ * @param   len             The number of characters in data.
+ * @return  uint16_t        The number of characters that were written.
+ */
+static uint16_t write_region(uart_inst_t * uart_id, const uint8_t * data, uint16_t len) {
+    uint16_t chars_written = 0;
+    while (chars_written < len && uart_is_writable(uart_id)) {
+        uart_putc(uart_id, data[chars_written]);
+        chars_written++;
+    }
+    return chars_written;
+}
+
+/**
+ * @brief   Helper function that gets the DMA channel config shared by both tx DMA channels.
+ * @param   device              The HC-06 device struct.
+ * @param   channel             The channel the config is for.
+ * @return  dma_channel_config  Config for byte transfers from the tx buffer to the UART data register, paced by the UART tx DREQ.
+ */
+static dma_channel_config get_tx_dma_config(hc06_t * device, uint8_t channel) {
+    dma_channel_config config = dma_channel_get_default_config(channel);
+    channel_config_set_transfer_data_size(&config, DMA_SIZE_8);
+    channel_config_set_read_increment(&config, true);
+    channel_config_set_write_increment(&config, false);
+    channel_config_set_dreq(&config, uart_get_dreq(device->uart_id, true));
+    return config;
+}
+
+/**
+ * @brief   Helper function that starts a DMA transfer of everything in the tx buffer, if no transfer is in flight.
+ * @details Must be called with the device's tx lock held.
+ * @param   device          The HC-06 device struct.
+ */
+static void start_tx_dma(hc06_t * device) {
+    // Only one transfer is in flight at a time, its completion irq starts the next one
+    if(device->tx_dma_count != 0) {
+        return;
+    }
+
+    // If the tx buffer is empty, mark transaction as completed by setting status flag
+    circular_buffer_regions_t regions;
+    if(circular_buffer_peek(&device->tx_buffer, &regions) != CIRCULAR_BUFFER_RC_OK) {
+        device->message_sent = true;
+        return;
+    }
+    device->tx_dma_count = regions.first_count + regions.second_count;
+
+    // Queue the wrapped region on the second channel, the first channel triggers it and stays quiet so only one irq is raised
+    bool is_wrapped = (regions.second_count > 0);
+    dma_channel_config config = get_tx_dma_config(device, device->tx_dma_channel);
+    if(is_wrapped) {
+        dma_channel_set_read_addr(device->tx_dma_wrap_channel, regions.second, false);
+        dma_channel_set_trans_count(device->tx_dma_wrap_channel, regions.second_count, false);
+        channel_config_set_chain_to(&config, device->tx_dma_wrap_channel);
+    }
+    channel_config_set_irq_quiet(&config, is_wrapped);
+
+    dma_channel_configure(device->tx_dma_channel, &config, &uart_get_hw(device->uart_id)->dr, regions.first, regions.first_count, true);
+}
+
+/**
+ * @brief   Helper function to release sent tx data and start the next DMA transfer for the DMA interrupt handler
+ * @details Only acts on the irqs of the device's tx DMA channels.
+ * @param   device          The HC-06 device struct.
  */
-static void handle_tx(void) {
-    // Check if there's data to send and the UART is ready to transmit
-    while (!circular_buffer_is_empty(&hc06->tx_buffer) && uart_is_writable(hc06->uart_id)) {
-        // Get the next character from the tx buffer
-        uint8_t tx_data;
-        circular_buffer_pop(&hc06->tx_buffer, &tx_data, sizeof(uint8_t));
+static void handle_tx_dma_irq(hc06_t * device) {
+    // Whichever channel ended the transfer raised the irq
+    uint irq_index = device->tx_dma_irq - DMA_IRQ_0;
+    bool transfer_done = false;
+    if (dma_irqn_get_channel_status(irq_index, device->tx_dma_channel)) {
+        dma_irqn_acknowledge_channel(irq_index, device->tx_dma_channel);
+        transfer_done = true;
+    }
+    if (dma_irqn_get_channel_status(irq_index, device->tx_dma_wrap_channel)) {
+        dma_irqn_acknowledge_channel(irq_index, device->tx_dma_wrap_channel);
+        transfer_done = true;
+    }
+
+    if (transfer_done) {
+        // Release sent characters back to hc06_tx_msg, then send whatever was queued in the meantime
+        // A producer on the other core may be starting a transfer too, so hold the tx lock
+        uint32_t saved_irq = spin_lock_blocking(device->tx_lock);
+        device->dma_irq_count++;
+        device->tx_char_count += device->tx_dma_count;
+        circular_buffer_consume(&device->tx_buffer, device->tx_dma_count);
+        device->tx_dma_count = 0;
+        start_tx_dma(device);
+        spin_unlock(device->tx_lock, saved_irq);
+
+        notify_tx_space(device);
+    }
+}
+
+/**
+ * @brief   Helper function that indexes the end of each message in newly received characters.
+ * @details End of message is denoted by newline. Must only be called once the characters are published to the rx buffer,
+ *          since hc06_rx_msg relies on an indexed message being completely in the rx buffer.
+ * @param   device          The HC-06 device struct.
+ * @param   data            The newly received characters.
+ * @param   len             The number of characters in data.
+ * @param   first_index     The rx buffer index of the first character in data.
+ * @return  bool            Whether any message ends were found.
+ */
+static bool index_frames(hc06_t * device, const uint8_t * data, uint16_t len, uint16_t first_index) {
+    const uint8_t * newline = memchr(data, '\n', len);
+    bool is_indexed = (newline != NULL);
+    while (newline != NULL) {
+        uint16_t frame_offset = newline - data + 1;
+        uint16_t frame_end = first_index + frame_offset;
+        hc06_frame_index_push(&device->rx_frames, &frame_end);
+
+        // Set flag so user knows to call rx_msg
+        device->message_received = true;
 
-        // Send the character
-        uart_putc(hc06->uart_id, tx_data);
+        newline = memchr(newline + 1, '\n', len - frame_offset);
     }
+    return is_indexed;
+}
+
+/**
+ * @brief   Helper function that publishes the characters written by the rx DMA since the last call to the rx buffer.
+ * @details Acts as the rx buffer's producer, so it must not be preempted by the UART irq; it is either called from the
+ *          UART irq or in a critical section.
+ * @param   device          The HC-06 device struct.
+ * @return  bool            Whether any message ends were indexed.
+ */
+static bool publish_rx_dma(hc06_t * device) {
+    // The DMA write address wraps within the rx buffer, so its distance from head is what arrived since the last publish
+    uint16_t rx_head = device->rx_buffer.head;
+    uint16_t write_index = (uint16_t)(dma_channel_hw_addr(device->rx_dma_channel)->write_addr - (uintptr_t)device->rx_buffer.buffer);
+    uint16_t rx_count = (write_index - rx_head) & device->rx_buffer.index_mask;
+
+    // Characters that overran unread data can't be told apart from it, so only publish as many as there was room for
+    circular_buffer_regions_t regions;
+    circular_buffer_reserve(&device->rx_buffer, &regions);
+    uint16_t free_count = regions.first_count + regions.second_count;
+    if (rx_count > free_count) {
+        rx_count = free_count;
+    }
+    if (rx_count == 0) {
+        return false;
+    }
+    circular_buffer_commit(&device->rx_buffer, rx_count);
+    device->rx_char_count += rx_count;
+
+    // The published characters are already in place, in the free regions that started at head
+    uint16_t first_count = (rx_count < regions.first_count) ? rx_count : regions.first_count;
+    bool is_indexed = index_frames(device, regions.first, first_count, rx_head);
+    is_indexed |= index_frames(device, regions.second, rx_count - first_count, rx_head + first_count);
+    return is_indexed;
+}
+
+/**
+ * @brief   Helper function to restart the rx DMA channel for the DMA interrupt handler
+ * @details Only acts on the irq of the device's rx DMA channel.
+ *          The channel keeps writing into the same ring, so restarting it only needs a new transfer count.
+ * @param   device          The HC-06 device struct.
+ */
+static void handle_rx_dma_irq(hc06_t * device) {
+    uint irq_index = device->rx_dma_irq - DMA_IRQ_0;
+    if (dma_irqn_get_channel_status(irq_index, device->rx_dma_channel)) {
+        dma_irqn_acknowledge_channel(irq_index, device->rx_dma_channel);
+        device->dma_irq_count++;
+        dma_channel_set_trans_count(device->rx_dma_channel, HC06_RX_DMA_TRANSFER_COUNT, true);
+    }
+}
+
+/**
+ * @brief   Helper function that passes a DMA interrupt to the tx/rx DMA handlers of every device using it.
+ * @details Is a shared handler, other DMA users' channels on the same irq are left alone.
+ * @param   irq_index       The DMA interrupt that was raised, 0 for DMA_IRQ_0 and 1 for DMA_IRQ_1.
+ */
+static void handle_dma_irq(uint irq_index) {
+    for (uint i = 0; i < NUM_UARTS; i++) {
+        hc06_t * device = hc06_instances[i];
+        if (device == NULL) {
+            continue;
+        }
+        if (device->tx_dma_enabled && device->tx_dma_irq == DMA_IRQ_0 + irq_index) {
+            handle_tx_dma_irq(device);
+        }
+        if (device->rx_dma_enabled && device->rx_dma_irq == DMA_IRQ_0 + irq_index) {
+            handle_rx_dma_irq(device);
+        }
+    }
+}
+
+static void handle_dma_irq_0(void) {
+    handle_dma_irq(0);
+}
+
+static void handle_dma_irq_1(void) {
+    handle_dma_irq(1);
+}
+
+/**
+ * @brief   Helper function that adds the shared DMA interrupt handler to a DMA irq, once, and enables the irq.
+ * @param   dma_irq         The DMA interrupt, DMA_IRQ_0 or DMA_IRQ_1.
+ */
+static void add_dma_irq_handler(uint8_t dma_irq) {
+    uint irq_index = dma_irq - DMA_IRQ_0;
+    if (!dma_irq_handler_added[irq_index]) {
+        irq_add_shared_handler(dma_irq, (irq_index == 0) ? handle_dma_irq_0 : handle_dma_irq_1, PICO_SHARED_IRQ_HANDLER_DEFAULT_ORDER_PRIORITY);
+        dma_irq_handler_added[irq_index] = true;
+    }
+    irq_set_enabled(dma_irq, true);
+}
+
+/**
+ * @brief   Helper function that stops the DMA channels claimed for a UART, so a device initialized on it again starts
+ *          in interrupt transmit and receive mode and can enable DMA on the same channels.
+ * @param   uart_index      The UART's index.
+ */
+static void stop_uart_dma(uint uart_index) {
+    int channels[3] = {tx_dma_channels[uart_index][0], tx_dma_channels[uart_index][1], rx_dma_channels[uart_index]};
+    for (uint i = 0; i < 3; i++) {
+        int channel = channels[i];
+        if (channel < 0) {
+            continue;
+        }
+        dma_irqn_set_channel_enabled(0, channel, false);
+        dma_irqn_set_channel_enabled(1, channel, false);
+        dma_channel_abort(channel);
+        dma_irqn_acknowledge_channel(0, channel);
+    }
+}
+
+/**
+ * @brief   Helper function that moves characters from the tx buffer into the UART tx FIFO until either runs out.
+ * @details Acts as the tx buffer's consumer, so it must be called with the device's tx lock held.
+ * @param   device          The HC-06 device struct.
+ * @return  uint16_t        The number of characters that were moved.
+ */
+static uint16_t fill_tx_fifo(hc06_t * device) {
+    // Send characters straight out of the tx buffer's regions while the UART is ready to transmit
+    circular_buffer_regions_t regions;
+    if (circular_buffer_peek(&device->tx_buffer, &regions) != CIRCULAR_BUFFER_RC_OK) {
+        return 0;
+    }
+    uint16_t chars_sent = write_region(device->uart_id, regions.first, regions.first_count);
+    if (chars_sent == regions.first_count) {
+        chars_sent += write_region(device->uart_id, regions.second, regions.second_count);
+    }
+
+    // Release sent characters back to hc06_tx_msg
+    circular_buffer_consume(&device->tx_buffer, chars_sent);
+    device->tx_char_count += chars_sent;
+    return chars_sent;
+}
+
+/**
+ * @brief   Helper function to send data in tx buffer for interrupt handler
+ * @details Must be called with the device's tx lock held.
+ * @param   device          The HC-06 device struct.
+ * @return  uint16_t        The number of characters that were sent.
+ */
+static uint16_t handle_tx(hc06_t * device) {
+    uint16_t chars_sent = fill_tx_fifo(device);
 
     // If the tx buffer is empty, mark transaction as completed by setting status flag and disable TX interrupt
-    if (circular_buffer_is_empty(&hc06->tx_buffer)) {
-        hc06->message_sent = true;
-        uart_set_irq_enables(hc06->uart_id, true, false);
+    if (circular_buffer_is_empty(&device->tx_buffer)) {
+        device->message_sent = true;
+        set_tx_irq_enabled(device->uart_id, false);
     }
+    return chars_sent;
 }
 
 /**
  * @brief   Helper function to store received hc06 messages for rx function
- * @details Will replace oldest message data on overrun
+ * @details Will drop newest message data on overrun, since the rx buffer's tail belongs to hc06_rx_msg
+ * @param   device          The HC-06 device struct.
  */
-static void handle_rx(void) {
+static void handle_rx(hc06_t * device) {
     // Read from UART until there's no data left from the current message
-    while (uart_is_readable(hc06->uart_id)) {
-        uint8_t rx_data = uart_getc(hc06->uart_id);
-
-        circular_buffer_push(&hc06->rx_buffer, &rx_data, sizeof(uint8_t));
+    bool is_indexed = false;
+    while (uart_is_readable(device->uart_id)) {
+        // With flow control, leave characters in the rx FIFO once the rx buffer is full, so RTS holds off the sender
+        uint16_t max_count = HC06_UART_FIFO_DEPTH;
+        if (device->flow_control_enabled) {
+            uint16_t free_count = device->rx_buffer.buffer_capacity - circular_buffer_get_size(&device->rx_buffer);
+            if (free_count == 0) {
+                // The rx irqs would keep firing on the full FIFO, so stop them until hc06_rx_msg makes room
+                device->rx_paused = true;
+                hw_clear_bits(&uart_get_hw(device->uart_id)->imsc, UART_UARTIMSC_RXIM_BITS | UART_UARTIMSC_RTIM_BITS);
+                break;
+            }
+            if (free_count < max_count) {
+                max_count = free_count;
+            }
+        }
 
-        // End of message is denoted by newline, set flag so user knows to call rx_msg
-        if(rx_data == '\n') {
-            hc06->message_received = true;
+        // Drain up to a FIFO's worth of data so it can be pushed to the rx buffer in bulk
+        uint8_t rx_data[HC06_UART_FIFO_DEPTH];
+        uint16_t rx_count = 0;
+        while (rx_count < max_count && uart_is_readable(device->uart_id)) {
+            rx_data[rx_count] = uart_getc(device->uart_id);
+            rx_count++;
         }
+
+        // The irq is the rx buffer's only producer, so head can be read directly
+        uint16_t rx_head = device->rx_buffer.head;
+        uint16_t rx_pushed;
+        circular_buffer_push_n(&device->rx_buffer, rx_data, rx_count, &rx_pushed);
+        device->rx_char_count += rx_count;
+
+        // Index the end of each message that made it into the rx buffer
+        is_indexed |= index_frames(device, rx_data, rx_pushed, rx_head);
+    }
+
+    // A full rx buffer without a newline is flushed whole by hc06_rx_msg, so it is signalled like a message
+    if (is_indexed || circular_buffer_is_full(&device->rx_buffer)) {
+        notify_event(device, HC06_EVENT_RX_MESSAGE);
     }
 }
 
 /**
  * @brief   Helper function to handle TX/RX UART interrupts
+ * @param   device          The HC-06 device struct on the UART that raised the irq.
  */
-static void handle_uart_irq(void) {
-    if (hc06 != NULL) {
-        // Check if a TX UART interrupt was raised
-        if (uart_is_writable(hc06->uart_id)) {
-            handle_tx();
+static void handle_uart_irq(hc06_t * device) {
+    device->uart_irq_count++;
+
+    // Act on the sources that raised the irq, rather than on whatever the FIFO status happens to be
+    uint32_t mis = uart_get_hw(device->uart_id)->mis;
+
+    // The tx irq is only enabled while there is tx data for it, and never in DMA transmit mode
+    // A producer on the other core may be filling the tx FIFO too, so hold the tx lock
+    if (mis & UART_UARTMIS_TXMIS_BITS) {
+        uint32_t saved_irq = spin_lock_blocking(device->tx_lock);
+        uint16_t chars_sent = handle_tx(device);
+        spin_unlock(device->tx_lock, saved_irq);
+
+        if (chars_sent > 0) {
+            notify_tx_space(device);
         }
+    }
 
-        // Check if a RX UART interrupt was raised
-        if (uart_is_readable(hc06->uart_id)) {
-            handle_rx();
+    // The rx FIFO overflowed, count it and clear the irq; the characters are already lost
+    if (mis & UART_UARTMIS_OEMIS_BITS) {
+        device->rx_overrun_count++;
+        uart_get_hw(device->uart_id)->icr = UART_UARTICR_OEIC_BITS;
+    }
+
+    // The rx FIFO reached its trigger level, or the line went idle with characters below it
+    if (mis & (UART_UARTMIS_RXMIS_BITS | UART_UARTMIS_RTMIS_BITS)) {
+        if (device->rx_dma_enabled) {
+            // Receive timeout in DMA receive mode, clear it and publish what the DMA has written
+            uart_get_hw(device->uart_id)->icr = UART_UARTICR_RTIC_BITS;
+            if (publish_rx_dma(device)) {
+                notify_event(device, HC06_EVENT_RX_MESSAGE);
+            }
+        }
+        else {
+            // Draining the rx FIFO clears both irqs
+            handle_rx(device);
         }
     }
 }
 
+static void handle_uart0_irq(void) {
+    if (hc06_instances[0] != NULL) {
+        handle_uart_irq(hc06_instances[0]);
+    }
+}
+
+static void handle_uart1_irq(void) {
+    if (hc06_instances[1] != NULL) {
+        handle_uart_irq(hc06_instances[1]);
+    }
+}
+
+/**
+ * @brief   Helper function that starts/resumes sending the tx buffer after new data was queued.
+ * @details Must be called with the device's tx lock held, which also keeps the tx irq/DMA irq on this core out.
+ * @param   device          The HC-06 device struct.
+ */
+static void start_tx(hc06_t * device) {
+    if(device->tx_dma_enabled) {
+        // Start a transfer unless one is in flight, its completion irq starts the next one
+        start_tx_dma(device);
+    }
+    else {
+        // Fill the tx FIFO straight away, so a message that fits in it goes out without taking a tx irq at all
+        fill_tx_fifo(device);
+        if(circular_buffer_is_empty(&device->tx_buffer)) {
+            device->message_sent = true;
+        }
+        else {
+            // Enable tx irq to resume sending tx data once the FIFO drains to its trigger level
+            set_tx_irq_enabled(device->uart_id, true);
+        }
+    }
+}
+
+/**
+ * @brief   Helper function that copies data into the free regions of a circular buffer, starting at an offset into them.
+ * @param   regions         The free regions, from circular_buffer_reserve.
+ * @param   offset          The offset into the regions to start at.
+ * @param   data            The data to copy.
+ * @param   len             The number of bytes in data. Must fit in the regions after offset.
+ */
+static void write_regions(const circular_buffer_regions_t * regions, uint16_t offset, const uint8_t * data, uint16_t len) {
+    if(offset < regions->first_count) {
+        uint16_t first_len = regions->first_count - offset;
+        if(first_len > len) {
+            first_len = len;
+        }
+        memcpy((uint8_t *)regions->first + offset, data, first_len);
+        data += first_len;
+        len -= first_len;
+        offset += first_len;
+    }
+    memcpy((uint8_t *)regions->second + (offset - regions->first_count), data, len);
+}
+
+/**
+ * @brief   Helper function that reserves room in the tx buffer for a producer, after what other producers have reserved.
+ * @details Only the reservation is made under the tx lock, so the caller copies into it with every irq enabled while
+ *          producers in other tasks or on the other core copy into their own. Must be paired with commit_tx if anything
+ *          was reserved.
+ * @param   device          The HC-06 device struct.
+ * @param   min_len         The fewest characters to reserve, nothing is reserved if fewer are free.
+ * @param   max_len         The most characters to reserve.
+ * @param   reservation     The reserved regions of the tx buffer (returned by reference).
+ * @param   offset          The reservation's offset from the tx buffer's head, for commit_tx (returned by reference).
+ * @return  uint16_t        The number of characters reserved, 0 if fewer than min_len were free.
+ */
+static uint16_t reserve_tx(hc06_t * device, uint16_t min_len, uint16_t max_len, circular_buffer_regions_t * reservation, uint16_t * offset) {
+    uint32_t saved_irq = spin_lock_blocking(device->tx_lock);
+    circular_buffer_regions_t regions;
+    circular_buffer_reserve(&device->tx_buffer, &regions);
+    uint16_t free_count = regions.first_count + regions.second_count - device->tx_reserved_count;
+    uint16_t len = (max_len < free_count) ? max_len : free_count;
+    if(len == 0 || len < min_len) {
+        spin_unlock(device->tx_lock, saved_irq);
+        return 0;
+    }
+    *offset = device->tx_reserved_count;
+    device->tx_reserved_count += len;
+    device->tx_writers++;
+    spin_unlock(device->tx_lock, saved_irq);
+
+    // The reservation starts offset characters into the free regions, which stay put until it is committed
+    if(*offset < regions.first_count) {
+        uint16_t first_count = regions.first_count - *offset;
+        reservation->first = (uint8_t *)regions.first + *offset;
+        reservation->first_count = (len < first_count) ? len : first_count;
+        reservation->second = regions.second;
+        reservation->second_count = len - reservation->first_count;
+    }
+    else {
+        reservation->first = (uint8_t *)regions.second + (*offset - regions.first_count);
+        reservation->first_count = len;
+        reservation->second = NULL;
+        reservation->second_count = 0;
+    }
+    return len;
+}
+
+/**
+ * @brief   Helper function that ends a producer's reservation, and hands every reservation to the tx irq/DMA once no
+ *          producer is still copying into one.
+ * @details Reservations are committed together and in the order they were made, so a producer that is preempted while
+ *          copying holds back the ones after it rather than being overtaken. The last reservation gives back what it
+ *          didn't use; any other must have had its unused end filled by the caller.
+ *          Holds the tx lock for the index update and for starting the transfer, at most a FIFO's worth of characters.
+ * @param   device          The HC-06 device struct.
+ * @param   offset          The reservation's offset, from reserve_tx.
+ * @param   reserved        The number of characters reserved, from reserve_tx.
+ * @param   used            The number of characters written to the start of the reservation.
+ */
+static void commit_tx(hc06_t * device, uint16_t offset, uint16_t reserved, uint16_t used) {
+    uint32_t saved_irq = spin_lock_blocking(device->tx_lock);
+    if(offset + reserved == device->tx_reserved_count) {
+        device->tx_reserved_count -= reserved - used;
+    }
+    device->tx_writers--;
+    if(device->tx_writers == 0 && device->tx_reserved_count > 0) {
+        // Mark beginning of tx transaction by clearing status flag, is set once the tx buffer has been sent
+        device->message_sent = false;
+        circular_buffer_commit(&device->tx_buffer, device->tx_reserved_count);
+        device->tx_reserved_count = 0;
+        start_tx(device);
+    }
+    spin_unlock(device->tx_lock, saved_irq);
+}
+
 /**
  * @brief   Initialize the ability to interface with the HC-06 device.
  * @details Assumes the HC-06 device has already been configured to desired settings.
  *          Assumes the UART pins have already been set to the UART function.
- *          Assumes that the system will only use one HC-06 device.
+ *          One HC-06 device can be used per UART; each is serviced by its own UART irq and never waits on the other.
+ *          The device's irqs run on the core that calls hc06_init. The tx calls can be made from either core, the rest
+ *          (hc06_rx_msg, hc06_rx_frames_pending, hc06_enable_rx_dma, hc06_set_event_callback) keep the irqs out by masking
+ *          them, which only works on that core, so they return HC06_RC_BAD_ARG (or 0) on the other one.
+ *          The tx and rx buffers are shared lock-free between the UART irq and the caller, so their sizes must be powers of two.
  * @param   device          The HC-06 device struct.
  * @param   uart_id         The RP2040 UART peripheral to use with this device.
  * @param   uart_tx_pin     tx pin used for UART transmissions.
  * @param   uart_rx_pin     rx pin used for UART transmissions.
  * @param   uart_baudrate   The baudrate to use for UART communication.
- * @param   uart_irq        The handler for UART interrupts.
+ * @param   uart_irq        The UART's interrupt, UART0_IRQ for uart0 and UART1_IRQ for uart1.
  * @param   tx_buffer       Buffer used to store data to transmit over UART.
- * @param   tx_buffer_size  Size of tx_buffer, is usually sizeof(tx_buffer).
+ * @param   tx_buffer_size  Size of tx_buffer, is usually sizeof(tx_buffer). Must be a power of two.
  * @param   rx_buffer       Buffer used to store data to receive from UART.
- * @param   rx_buffer_size  Size of rx_buffer, is usually sizeof(rx_buffer).
+ * @param   rx_buffer_size  Size of rx_buffer, is usually sizeof(rx_buffer). Must be a power of two.
  * @return  hc06_rc_t       Return code indicating operation success/failure.
  *                          - HC06_RC_OK:               Operation successful.
- *                          - HC06_RC_BAD_ARG:          An invalid argument was provided.
+ *                          - HC06_RC_BAD_ARG:          An invalid argument was provided. uart_irq must be the interrupt of uart_id.
  *                          - HC06_RC_ERROR_TX_BUFFER:  Could not initialize tx buffer.
  *                          - HC06_RC_ERROR_RX_BUFFER:  Could not initialize rx buffer.
  */
 hc06_rc_t hc06_init(hc06_t * device, uart_inst_t * uart_id, uint8_t uart_tx_pin, uint8_t uart_rx_pin, uint32_t uart_baudrate, uint8_t uart_irq, uint8_t * tx_buffer, uint16_t tx_buffer_size, uint8_t * rx_buffer, uint16_t rx_buffer_size) {
-    if(device == NULL || uart_id == NULL || tx_buffer == NULL || rx_buffer == NULL) {
+    if(device == NULL || uart_id == NULL || tx_buffer == NULL || rx_buffer == NULL || uart_irq != UART0_IRQ + uart_get_index(uart_id)) {
         return HC06_RC_BAD_ARG;
     }
     
+    // Stop the DMA of a device initialized on this UART before, its irqs must not reach this one
+    stop_uart_dma(uart_get_index(uart_id));
+
     // Register data provided by args into hc06 struct
     device->uart_id = uart_id;
     device->uart_baudrate = uart_baudrate;
     device->uart_irq = uart_irq;
+    device->irq_core = (uint8_t)get_core_num();
 
-    // Set global pointer to hc06 instance
-    hc06 = device;
+    // Register the instance for its UART's interrupt handlers
+    hc06_instances[uart_get_index(uart_id)] = device;
+
+    // Claim the UART's tx lock once, a device initialized on the same UART again keeps using it
+    if(tx_locks[uart_get_index(uart_id)] == NULL) {
+        tx_locks[uart_get_index(uart_id)] = spin_lock_init((uint)spin_lock_claim_unused(true));
+    }
+    device->tx_lock = tx_locks[uart_get_index(uart_id)];
+    device->tx_reserved_count = 0;
+    device->tx_writers = 0;
 
     // Set UART rx and tx pin functions
     gpio_set_function(uart_tx_pin, GPIO_FUNC_UART);
     gpio_set_function(uart_rx_pin, GPIO_FUNC_UART);
 
-    // Initialize tx circular buffer
-    circular_buffer_rc_t tx_buffer_init_rc = circular_buffer_init(&device->tx_buffer, tx_buffer, tx_buffer_size, sizeof(uint8_t));
+    // Initialize tx circular buffer; hc06_tx_msg is the only producer and the irq is the only consumer
+    circular_buffer_rc_t tx_buffer_init_rc = circular_buffer_init_spsc(&device->tx_buffer, tx_buffer, tx_buffer_size, sizeof(uint8_t));
     if(tx_buffer_init_rc != CIRCULAR_BUFFER_RC_OK) {
         return HC06_RC_ERROR_TX_BUFFER;
     }
 
-    // Initialize rx circular buffer
-    circular_buffer_rc_t rx_buffer_init_rc = circular_buffer_init(&device->rx_buffer, rx_buffer, rx_buffer_size, sizeof(uint8_t));
+    // Initialize rx circular buffer; the irq is the only producer and hc06_rx_msg is the only consumer
+    circular_buffer_rc_t rx_buffer_init_rc = circular_buffer_init_spsc(&device->rx_buffer, rx_buffer, rx_buffer_size, sizeof(uint8_t));
     if(rx_buffer_init_rc != CIRCULAR_BUFFER_RC_OK) {
         return HC06_RC_ERROR_RX_BUFFER;
     }
     
+    // Start with no received messages
+    hc06_frame_index_init(&device->rx_frames);
+
+    // Start in interrupt transmit and receive mode
+    device->tx_dma_enabled = false;
+    device->tx_dma_count = 0;
+    device->rx_dma_enabled = false;
+
     // Clear tx and rx buffer data before use
     memset(tx_buffer, 0, tx_buffer_size);
     memset(rx_buffer, 0, rx_buffer_size);
@@ -132,12 +680,284 @@ hc06_rc_t hc06_init(hc06_t * device, uart_inst_t * uart_id, uint8_t uart_tx_pin,
     device->message_sent = false;
     device->message_received = false;
 
+    // No event callback until one is set
+    device->event_callback = NULL;
+    device->event_context = NULL;
+
+    // Send as soon as data is queued, and signal every release of tx space
+    device->tx_low_watermark = tx_buffer_size;
+    device->flow_control_enabled = false;
+    device->rx_paused = false;
+
+    // Start counting interrupt load from zero
+    device->uart_irq_count = 0;
+    device->dma_irq_count = 0;
+    device->tx_char_count = 0;
+    device->rx_char_count = 0;
+    device->rx_overrun_count = 0;
+
     // Set up and enable interrupt handler for UART
-    irq_set_exclusive_handler(device->uart_irq, handle_uart_irq);
+    irq_set_exclusive_handler(device->uart_irq, (uart_get_index(uart_id) == 0) ? handle_uart0_irq : handle_uart1_irq);
     irq_set_enabled(device->uart_irq, true);
-    tx_irq_enabled = false;
-    rx_irq_enabled = true;
-    set_uart_irqs(uart_id);
+    uart_set_irq_enables(uart_id, true, false);
+
+    // Count rx FIFO overruns, and raise the FIFO trigger levels from the lowest ones set by uart_set_irq_enables
+    hw_set_bits(&uart_get_hw(uart_id)->imsc, UART_UARTIMSC_OEIM_BITS);
+    hc06_set_fifo_levels(device, HC06_DEFAULT_RX_FIFO_LEVEL, HC06_DEFAULT_TX_FIFO_LEVEL);
+
+    return HC06_RC_OK;
+}
+
+/**
+ * @brief   Set the UART FIFO levels at which the rx and tx interrupts are raised.
+ * @details The rx irq is raised once the rx FIFO holds at least rx_level characters, and the receive timeout irq flushes
+ *          what is left in it once the line has been idle for 32 bit periods, so a higher rx_level means fewer irqs
+ *          without holding back the end of a message. Higher rx levels leave less time to service the irq before the
+ *          FIFO overruns (counted in rx_overrun_count).
+ *          The tx irq is raised once the tx FIFO drains to tx_level characters, so a lower tx_level refills more of the
+ *          FIFO per irq but leaves less time before the line goes idle.
+ *          Has no effect on the directions that use DMA.
+ * @param   device          The HC-06 device struct.
+ * @param   rx_level        The rx FIFO trigger level.
+ * @param   tx_level        The tx FIFO trigger level.
+ * @return  hc06_rc_t       Return code indicating operation success/failure.
+ *                          - HC06_RC_OK:               Operation successful.
+ *                          - HC06_RC_BAD_ARG:          An invalid argument was provided.
+ */
+hc06_rc_t hc06_set_fifo_levels(hc06_t * device, hc06_fifo_level_t rx_level, hc06_fifo_level_t tx_level) {
+    if(device == NULL || rx_level > HC06_FIFO_LEVEL_7_8 || tx_level > HC06_FIFO_LEVEL_7_8) {
+        return HC06_RC_BAD_ARG;
+    }
+
+    hw_write_masked(&uart_get_hw(device->uart_id)->ifls,
+                    ((uint32_t)rx_level << UART_UARTIFLS_RXIFLSEL_LSB) | ((uint32_t)tx_level << UART_UARTIFLS_TXIFLSEL_LSB),
+                    UART_UARTIFLS_RXIFLSEL_BITS | UART_UARTIFLS_TXIFLSEL_BITS);
+
+    return HC06_RC_OK;
+}
+
+/**
+ * @brief   Set how far the tx buffer must drain before the tx space event is raised.
+ * @details HC06_EVENT_TX_SPACE is only raised when sent characters are released and at most watermark characters are
+ *          left in the tx buffer, so a producer waiting to queue n characters can set it to the tx buffer size minus n
+ *          and be woken once, when they fit. hc06_init sets it to the tx buffer size, raising the event on every release.
+ * @param   device          The HC-06 device struct.
+ * @param   watermark       The tx buffer fill level to raise the event at or below.
+ * @return  hc06_rc_t       Return code indicating operation success/failure.
+ *                          - HC06_RC_OK:               Operation successful.
+ *                          - HC06_RC_BAD_ARG:          An invalid argument was provided, watermark cannot exceed the tx buffer size.
+ */
+hc06_rc_t hc06_set_tx_low_watermark(hc06_t * device, uint16_t watermark) {
+    if(device == NULL || watermark > device->tx_buffer.buffer_capacity) {
+        return HC06_RC_BAD_ARG;
+    }
+
+    device->tx_low_watermark = watermark;
+
+    return HC06_RC_OK;
+}
+
+/**
+ * @brief   Enable hardware RTS/CTS flow control.
+ * @details The UART stops sending while CTS is deasserted, and deasserts RTS while its rx FIFO is full.
+ *          In interrupt receive mode the rx irq also stops draining the rx FIFO while the rx buffer is full, so a sender
+ *          that honours RTS is held off until hc06_rx_msg makes room instead of having characters dropped.
+ *          In DMA receive mode the DMA keeps draining the rx FIFO, so only the FIFO itself is protected.
+ *          The HC-06 module's RTS/CTS pads must be wired to the pins, which must have the UART CTS/RTS function for uart_id.
+ * @param   device          The HC-06 device struct.
+ * @param   uart_cts_pin    CTS pin, input from the HC-06's RTS.
+ * @param   uart_rts_pin    RTS pin, output to the HC-06's CTS.
+ * @return  hc06_rc_t       Return code indicating operation success/failure.
+ *                          - HC06_RC_OK:               Operation successful.
+ *                          - HC06_RC_BAD_ARG:          An invalid argument was provided.
+ */
+hc06_rc_t hc06_enable_flow_control(hc06_t * device, uint8_t uart_cts_pin, uint8_t uart_rts_pin) {
+    if(device == NULL) {
+        return HC06_RC_BAD_ARG;
+    }
+
+    gpio_set_function(uart_cts_pin, GPIO_FUNC_UART);
+    gpio_set_function(uart_rts_pin, GPIO_FUNC_UART);
+    uart_set_hw_flow(device->uart_id, true, true);
+    device->flow_control_enabled = true;
+
+    return HC06_RC_OK;
+}
+
+/**
+ * @brief   Get the number of UART and DMA interrupts taken per character sent or received since hc06_init.
+ * @param   device          The HC-06 device struct.
+ * @return  float           Interrupts per character, 0 if device is NULL or no characters have moved.
+ */
+float hc06_get_irqs_per_char(hc06_t * device) {
+    if(device == NULL) {
+        return 0.0f;
+    }
+
+    uint32_t chars = device->tx_char_count + device->rx_char_count;
+    if(chars == 0) {
+        return 0.0f;
+    }
+
+    return (float)(device->uart_irq_count + device->dma_irq_count) / (float)chars;
+}
+
+/**
+ * @brief   Send tx data with DMA instead of the UART tx interrupt.
+ * @details Each transfer hands the contiguous region(s) of the tx buffer to a DMA channel paced by the UART tx DREQ.
+ *          When the data wraps around the end of the tx buffer, a second channel is chained to send the wrapped region,
+ *          so the CPU is only interrupted once per transfer instead of once per FIFO's worth of characters.
+ *          Messages queued while a transfer is in flight are sent together by the next transfer.
+ *          Must be called after hc06_init. The DMA irq handler is shared, so the irq can also be used by other DMA users.
+ *          The channels are claimed the first time tx DMA is enabled on the UART; hc06_init stops them and enabling tx DMA
+ *          again reuses them.
+ * @param   device          The HC-06 device struct.
+ * @param   dma_irq         The DMA interrupt to signal transfer completion on, DMA_IRQ_0 or DMA_IRQ_1.
+ * @return  hc06_rc_t       Return code indicating operation success/failure.
+ *                          - HC06_RC_OK:               Operation successful.
+ *                          - HC06_RC_BAD_ARG:          An invalid argument was provided, or tx DMA is already enabled.
+ *                          - HC06_RC_ERROR_DMA:        Could not claim two unused DMA channels.
+ */
+hc06_rc_t hc06_enable_tx_dma(hc06_t * device, uint8_t dma_irq) {
+    if(device == NULL || (dma_irq != DMA_IRQ_0 && dma_irq != DMA_IRQ_1) || device->tx_dma_enabled) {
+        return HC06_RC_BAD_ARG;
+    }
+
+    // Claim a channel for each region of the tx buffer once, a device initialized on the same UART again keeps using them
+    int * channels = tx_dma_channels[uart_get_index(device->uart_id)];
+    if(channels[0] < 0) {
+        int tx_dma_channel = dma_claim_unused_channel(false);
+        int tx_dma_wrap_channel = dma_claim_unused_channel(false);
+        if(tx_dma_channel < 0 || tx_dma_wrap_channel < 0) {
+            if(tx_dma_channel >= 0) {
+                dma_channel_unclaim(tx_dma_channel);
+            }
+            if(tx_dma_wrap_channel >= 0) {
+                dma_channel_unclaim(tx_dma_wrap_channel);
+            }
+            return HC06_RC_ERROR_DMA;
+        }
+        channels[0] = tx_dma_channel;
+        channels[1] = tx_dma_wrap_channel;
+    }
+    device->tx_dma_channel = channels[0];
+    device->tx_dma_wrap_channel = channels[1];
+    device->tx_dma_irq = dma_irq;
+
+    // The wrap channel always sends to the UART and raises the irq; only its read address and count change per transfer
+    dma_channel_config wrap_config = get_tx_dma_config(device, device->tx_dma_wrap_channel);
+    dma_channel_set_write_addr(device->tx_dma_wrap_channel, &uart_get_hw(device->uart_id)->dr, false);
+    dma_channel_set_config(device->tx_dma_wrap_channel, &wrap_config, false);
+
+    // Set up and enable the shared DMA interrupt handler for both channels
+    uint irq_index = dma_irq - DMA_IRQ_0;
+    dma_irqn_set_channel_enabled(irq_index, device->tx_dma_channel, true);
+    dma_irqn_set_channel_enabled(irq_index, device->tx_dma_wrap_channel, true);
+    add_dma_irq_handler(dma_irq);
+
+    // Hand any tx data still queued for the tx irq over to the DMA
+    uint32_t saved_irq = spin_lock_blocking(device->tx_lock);
+    set_tx_irq_enabled(device->uart_id, false);
+    device->tx_dma_count = 0;
+    device->tx_dma_enabled = true;
+    start_tx_dma(device);
+    spin_unlock(device->tx_lock, saved_irq);
+
+    return HC06_RC_OK;
+}
+
+/**
+ * @brief   Receive rx data with DMA instead of the UART rx interrupt.
+ * @details A DMA channel paced by the UART rx DREQ writes received characters straight into the rx buffer, using the DMA
+ *          ring feature to wrap its write address within the buffer, so no CPU time is spent per received character.
+ *          Characters written by the DMA are published to the rx buffer, and the end of each message indexed, by the UART
+ *          receive timeout interrupt and at the start of hc06_rx_msg and hc06_rx_frames_pending.
+ *          The DMA does not know which characters have been received yet; if more arrive between two hc06_rx_msg calls than
+ *          the rx buffer has room for, unread data is overwritten and what is left of the rx buffer is flushed as one message.
+ *          Must be called after hc06_init. The DMA irq handler is shared, so the irq can also be used by other DMA users.
+ *          The channel is claimed the first time rx DMA is enabled on the UART; hc06_init stops it and enabling rx DMA
+ *          again reuses it.
+ * @param   device          The HC-06 device struct.
+ * @param   dma_irq         The DMA interrupt used to restart the channel after its (very large) transfer count runs out, DMA_IRQ_0 or DMA_IRQ_1.
+ * @return  hc06_rc_t       Return code indicating operation success/failure.
+ *                          - HC06_RC_OK:               Operation successful.
+ *                          - HC06_RC_BAD_ARG:          An invalid argument was provided, rx DMA is already enabled, it was called on the
+ *                                                      other core than hc06_init, or the rx buffer must be aligned to its size
+ *                                                      (e.g. with __attribute__((aligned(HC06_DEFAULT_BUFFER_SIZE)))) and no larger than 32768.
+ *                          - HC06_RC_ERROR_DMA:        Could not claim an unused DMA channel.
+ */
+hc06_rc_t hc06_enable_rx_dma(hc06_t * device, uint8_t dma_irq) {
+    if(device == NULL || (dma_irq != DMA_IRQ_0 && dma_irq != DMA_IRQ_1) || device->rx_dma_enabled || !is_on_irq_core(device)) {
+        return HC06_RC_BAD_ARG;
+    }
+
+    // The DMA ring wraps the write address on a boundary of its own size, so the rx buffer must be aligned to its size
+    uint16_t rx_capacity = device->rx_buffer.buffer_capacity;
+    if(((uintptr_t)device->rx_buffer.buffer & (rx_capacity - 1)) != 0) {
+        return HC06_RC_BAD_ARG;
+    }
+    uint ring_size_bits = 0;
+    while((1u << ring_size_bits) < rx_capacity) {
+        ring_size_bits++;
+    }
+
+    // Claim the channel once, a device initialized on the same UART again keeps using it
+    int * channel = &rx_dma_channels[uart_get_index(device->uart_id)];
+    if(*channel < 0) {
+        *channel = dma_claim_unused_channel(false);
+        if(*channel < 0) {
+            return HC06_RC_ERROR_DMA;
+        }
+    }
+    device->rx_dma_channel = *channel;
+    device->rx_dma_irq = dma_irq;
+
+    // Byte transfers from the UART data register into the rx buffer, wrapping the write address within it
+    dma_channel_config config = dma_channel_get_default_config(device->rx_dma_channel);
+    channel_config_set_transfer_data_size(&config, DMA_SIZE_8);
+    channel_config_set_read_increment(&config, false);
+    channel_config_set_write_increment(&config, true);
+    channel_config_set_ring(&config, true, ring_size_bits);
+    channel_config_set_dreq(&config, uart_get_dreq(device->uart_id, false));
+
+    // Set up and enable the shared DMA interrupt handler, only used to restart the channel
+    uint irq_index = dma_irq - DMA_IRQ_0;
+    dma_irqn_set_channel_enabled(irq_index, device->rx_dma_channel, true);
+    add_dma_irq_handler(dma_irq);
+
+    // Switch the UART irq from rx data to receive timeouts only, and start writing at the rx buffer's head
+    enter_critical(device);
+    hw_write_masked(&uart_get_hw(device->uart_id)->imsc, UART_UARTIMSC_RTIM_BITS, UART_UARTIMSC_RXIM_BITS | UART_UARTIMSC_RTIM_BITS);
+    uint8_t * rx_head = (uint8_t *)device->rx_buffer.buffer + (device->rx_buffer.head & device->rx_buffer.index_mask);
+    dma_channel_configure(device->rx_dma_channel, &config, rx_head, &uart_get_hw(device->uart_id)->dr, HC06_RX_DMA_TRANSFER_COUNT, true);
+    device->rx_dma_enabled = true;
+    exit_critical(device);
+
+    return HC06_RC_OK;
+}
+
+/**
+ * @brief   Set a callback to be called from the irqs when a message is received or tx space frees up.
+ * @details Called once per irq rather than per message or character. In DMA receive mode, messages indexed by
+ *          hc06_rx_msg and hc06_rx_frames_pending themselves are not signalled, since the caller already sees them.
+ *          See hc_06_rtos.h for blocking send/receive calls built on it.
+ * @param   device          The HC-06 device struct.
+ * @param   callback        The callback, NULL to remove it.
+ * @param   context         Passed to callback.
+ * @return  hc06_rc_t       Return code indicating operation success/failure.
+ *                          - HC06_RC_OK:               Operation successful.
+ *                          - HC06_RC_BAD_ARG:          An invalid argument was provided, or it was called on the other core than hc06_init.
+ */
+hc06_rc_t hc06_set_event_callback(hc06_t * device, hc06_event_callback_t callback, void * context) {
+    if(device == NULL || !is_on_irq_core(device)) {
+        return HC06_RC_BAD_ARG;
+    }
+
+    // Keep the irqs out so they never see a callback with the wrong context
+    enter_critical(device);
+    device->event_callback = callback;
+    device->event_context = context;
+    exit_critical(device);
 
     return HC06_RC_OK;
 }
@@ -160,80 +980,194 @@ hc06_rc_t hc06_tx_msg(hc06_t* device, char* tx_buf, uint16_t len, uint16_t * cha
         return HC06_RC_BAD_ARG;
     }
 
-    // rc is subject to change depending on whether the circular buffer fills during pushing
-    hc06_rc_t rc = HC06_RC_OK;
+    // Reserve as much of the message as fits, copy it in with the tx lock released and hand it to the tx irq/DMA
+    circular_buffer_regions_t reservation;
+    uint16_t offset;
+    *chars_sent = reserve_tx(device, 0, len, &reservation, &offset);
+    if(*chars_sent > 0) {
+        write_regions(&reservation, 0, (const uint8_t *)tx_buf, *chars_sent);
+        commit_tx(device, offset, *chars_sent, *chars_sent);
+    }
 
-    // Mark beginning of tx transaction by clearing status flag, is set in tx interrupt
-    device->message_sent = false;
+    // Only part of the message is queued if the tx buffer fills
+    return (*chars_sent == len) ? HC06_RC_OK : HC06_RC_ERROR_TX_BUFFER;
+}
 
-    // Entering critical selection; disable tx irq when modifying tx buffer to prevent race conditions
-    tx_irq_enabled = false;
-    set_uart_irqs(device->uart_id);
-    {
-        // Push characters from message buffer to tx buffer, stop early if tx buffer fills during pushing
-        for (*chars_sent = 0; *chars_sent < len; ++*chars_sent) {
-            if(circular_buffer_is_full(&device->tx_buffer)) {
-                rc = HC06_RC_ERROR_TX_BUFFER;
-                break;
-            }
+/**
+ * @brief   Transmit a binary telemetry frame through the HC-06 device.
+ * @details The message is COBS encoded with its ID and CRC (see telemetry_frame.h) in a single pass, straight into the
+ *          free space of the tx buffer, and only handed to the tx irq/DMA once complete. A frame is queued whole or not at all.
+ *          Frames end in a newline, so the receiving end gets them from hc06_rx_msg and decodes them with
+ *          telemetry_frame_decode; its rx buffer must be able to hold TELEMETRY_FRAME_MAX_ENCODED_LEN(len) characters.
+ * @param   device          The HC-06 device struct.
+ * @param   msg_id          The message ID, e.g. one of telemetry_msg_id_t.
+ * @param   payload         The binary payload. Can be NULL if len is 0.
+ * @param   len             Length of the payload. Cannot exceed TELEMETRY_FRAME_MAX_PAYLOAD.
+ * @return  hc06_rc_t       Return code indicating operation success/failure.
+ *                          - HC06_RC_OK:               Operation successful.
+ *                          - HC06_RC_BAD_ARG:          An invalid argument was provided.
+ *                          - HC06_RC_ERROR_TX_BUFFER:  The tx buffer has less than TELEMETRY_FRAME_MAX_ENCODED_LEN(len) free, nothing was queued.
+ */
+hc06_rc_t hc06_tx_frame(hc06_t * device, uint8_t msg_id, const void * payload, uint16_t len) {
+    if(device == NULL || (payload == NULL && len > 0) || len > TELEMETRY_FRAME_MAX_PAYLOAD) {
+        return HC06_RC_BAD_ARG;
+    }
 
-            circular_buffer_push(&device->tx_buffer, &tx_buf[*chars_sent], sizeof(char));
+    // Reserve room for the worst case encoding and encode straight into it; nothing is visible to the tx irq/DMA until the commit
+    uint16_t max_frame_len = TELEMETRY_FRAME_MAX_ENCODED_LEN(len);
+    circular_buffer_regions_t reservation;
+    uint16_t offset;
+    if(reserve_tx(device, max_frame_len, max_frame_len, &reservation, &offset) == 0) {
+        return HC06_RC_ERROR_TX_BUFFER;
+    }
+    uint16_t frame_len;
+    telemetry_frame_rc_t frame_rc = telemetry_frame_encode_split(msg_id, payload, len, reservation.first, reservation.first_count,
+                                                                 reservation.second, reservation.second_count, &frame_len);
+    if(frame_rc != TELEMETRY_FRAME_RC_OK) {
+        frame_len = 0;
+    }
+
+    // A reservation followed by another can't give back its unused end, back to back delimiters are skipped as empty frames
+    const uint8_t delimiter = TELEMETRY_FRAME_DELIMITER;
+    for(uint16_t i = frame_len; i < max_frame_len; i++) {
+        write_regions(&reservation, i, &delimiter, 1);
+    }
+    commit_tx(device, offset, max_frame_len, frame_len);
+
+    return (frame_rc == TELEMETRY_FRAME_RC_OK) ? HC06_RC_OK : HC06_RC_ERROR_TX_BUFFER;
+}
+
+/**
+ * @brief   Transmit a message made of several fragments through the HC-06 device, e.g. a header, payload and checksum.
+ * @details The fragments are copied straight into the tx buffer one after another and handed to the tx irq/DMA together,
+ *          so no intermediate buffer is needed. The message is queued whole or not at all, into room reserved for it under
+ *          the tx lock, so messages from other tasks or the other core never interleave with it.
+ * @param   device          The HC-06 device struct.
+ * @param   iov             The fragments, in order. A fragment's data can be NULL if its len is 0.
+ * @param   iov_count       The number of fragments in iov.
+ * @return  hc06_rc_t       Return code indicating operation success/failure.
+ *                          - HC06_RC_OK:               Operation successful.
+ *                          - HC06_RC_BAD_ARG:          An invalid argument was provided.
+ *                          - HC06_RC_ERROR_TX_BUFFER:  The tx buffer has less free space than the fragments add up to, nothing was queued.
+ */
+hc06_rc_t hc06_tx_msgv(hc06_t * device, const hc06_iovec_t * iov, uint8_t iov_count) {
+    if(device == NULL || (iov == NULL && iov_count > 0)) {
+        return HC06_RC_BAD_ARG;
+    }
+
+    uint32_t total_len = 0;
+    for(uint8_t i = 0; i < iov_count; i++) {
+        if(iov[i].data == NULL && iov[i].len > 0) {
+            return HC06_RC_BAD_ARG;
         }
+        total_len += iov[i].len;
     }
-    // Exiting critical selection; enable tx irq to start/resume sending tx data
-    tx_irq_enabled = true;
-    set_uart_irqs(device->uart_id);
 
-    return rc;
+    // Copy every fragment into a reservation of the tx buffer; nothing is visible to the tx irq/DMA until the commit
+    circular_buffer_regions_t reservation;
+    uint16_t offset;
+    if(total_len > device->tx_buffer.buffer_capacity || reserve_tx(device, (uint16_t)total_len, (uint16_t)total_len, &reservation, &offset) == 0) {
+        return (total_len == 0) ? HC06_RC_OK : HC06_RC_ERROR_TX_BUFFER;
+    }
+    uint16_t fragment_offset = 0;
+    for(uint8_t i = 0; i < iov_count; i++) {
+        write_regions(&reservation, fragment_offset, iov[i].data, iov[i].len);
+        fragment_offset += iov[i].len;
+    }
+    commit_tx(device, offset, (uint16_t)total_len, (uint16_t)total_len);
+
+    return HC06_RC_OK;
 }
 
 /**
  * @brief   Receive a new message from the HC-06 device.
  * @details Assumes that messages are strings terminating with the newline character.
  *          Is a non-blocking implementation; message data is obtained from rx interrupt as new data comes in.
+ *          Receives exactly one message, whose end was indexed by the rx interrupt as it arrived.
+ *          No characters are received if no complete message is pending, unless the rx buffer is full, in which case all of it is received.
  * @param   device          The HC-06 device struct.
  * @param   rx_buf          Message buffer to receive in. Its size cannot be less than the capacity of the rx circular buffer.
  * @param   len             Length of message buffer. Cannot be less than the capacity of the rx circular buffer.
  * @param   chars_received  The number of characters from the message buffer that were received (returned by reference)
  * @return  hc06_rc_t       Return code indicating operation success/failure.
  *                          - HC06_RC_OK:               Operation successful.
- *                          - HC06_RC_BAD_ARG:          An invalid argument was provided.
+ *                          - HC06_RC_BAD_ARG:          An invalid argument was provided, or it was called on the other core than hc06_init.
  */
 hc06_rc_t hc06_rx_msg(hc06_t* device, char * rx_buf, uint16_t len, uint16_t * chars_received) {
-    if(device == NULL || rx_buf == NULL || len < device->rx_buffer.buffer_capacity || chars_received == NULL) {
+    if(device == NULL || rx_buf == NULL || len < device->rx_buffer.buffer_capacity || chars_received == NULL || !is_on_irq_core(device)) {
         return HC06_RC_BAD_ARG;
     }
 
-    // Entering critical selection; disable rx irq when modifying rx buffer to prevent race conditions
-    rx_irq_enabled = false;
-    set_uart_irqs(device->uart_id);
-    {
-        // Pop characters from rx buffer and store in message buffer
-        *chars_received = 0;
-        while(!circular_buffer_is_empty(&device->rx_buffer)) {
-            char rx_char;
-            circular_buffer_pop(&device->rx_buffer, &rx_char, sizeof(char));
-            
-            rx_buf[*chars_received] = rx_char;
-            (*chars_received)++;
-
-            // Exit early on newline, as it should denote the end of a message. This covers the circular buffer containing multiple messages.
-            if(rx_char == '\n') {
-                break;
-            }
-        }
+    // In DMA receive mode, publish what the DMA has written first; this acts as the producer, so keep the device's irqs out
+    if(device->rx_dma_enabled) {
+        enter_critical(device);
+        publish_rx_dma(device);
+        exit_critical(device);
+    }
+
+    // The rx buffer is lock-free between the rx irq (producer) and this function (consumer), so no critical section is needed
+    // Take the end of the oldest message before peeking, so the peeked regions are guaranteed to contain all of it
+    *chars_received = 0;
+    uint16_t frame_end;
+    bool frame_pending = (hc06_frame_index_pop(&device->rx_frames, &frame_end) == CIRCULAR_BUFFER_RC_OK);
 
-        // Null terminate the received string if it's smaller than the buffer
-        if(*chars_received < len) {
-            rx_buf[*chars_received] = '\0';
+    circular_buffer_regions_t regions;
+    if(circular_buffer_peek(&device->rx_buffer, &regions) == CIRCULAR_BUFFER_RC_OK) {
+        uint16_t message_len = 0;
+        if(frame_pending) {
+            message_len = frame_end - device->rx_buffer.tail;
+        }
+        else if(regions.first_count + regions.second_count == device->rx_buffer.buffer_capacity) {
+            // A full rx buffer without a newline can never complete a message, so flush all of it
+            message_len = device->rx_buffer.buffer_capacity;
         }
+
+        // Copy the message out of the rx buffer's regions and release them back to the rx irq
+        uint16_t first_len = (message_len < regions.first_count) ? message_len : regions.first_count;
+        memcpy(rx_buf, regions.first, first_len);
+        memcpy(&rx_buf[first_len], regions.second, message_len - first_len);
+        circular_buffer_consume(&device->rx_buffer, message_len);
+        *chars_received = message_len;
+    }
+
+    // Resume the rx irqs if they were stopped on a full rx buffer; draining the rx FIFO releases RTS again
+    if(device->rx_paused && *chars_received > 0) {
+        device->rx_paused = false;
+        hw_set_bits(&uart_get_hw(device->uart_id)->imsc, UART_UARTIMSC_RXIM_BITS | UART_UARTIMSC_RTIM_BITS);
     }
-    // Exiting critical selection; enable rx irq to resume receiving rx data
-    rx_irq_enabled = true;
-    set_uart_irqs(device->uart_id);
 
-    // Mark completion of rx transaction by clearing status flag
+    // Update status flag; clear it before checking for more messages so one indexed by the rx irq in between isn't lost
     device->message_received = false;
+    if(!hc06_frame_index_is_empty(&device->rx_frames)) {
+        device->message_received = true;
+    }
+
+    // Null terminate the received string if it's smaller than the buffer
+    if(*chars_received < len) {
+        rx_buf[*chars_received] = '\0';
+    }
 
     return HC06_RC_OK;
+}
+
+/**
+ * @brief   Get the number of complete messages waiting to be received with hc06_rx_msg.
+ * @details Messages are counted by the rx interrupt as their newline arrives, so no scanning is done.
+ *          In DMA receive mode, characters the DMA has written since they were last published are indexed first.
+ *          At most HC06_MAX_PENDING_FRAMES messages are indexed; further newlines are merged into the following message until one is received.
+ * @param   device          The HC-06 device struct.
+ * @return  uint16_t        Number of pending messages, 0 if device is NULL or it was called on the other core than hc06_init.
+ */
+uint16_t hc06_rx_frames_pending(hc06_t * device) {
+    if(device == NULL || !is_on_irq_core(device)) {
+        return 0;
+    }
+
+    if(device->rx_dma_enabled) {
+        enter_critical(device);
+        publish_rx_dma(device);
+        exit_critical(device);
+    }
+
+    return hc06_frame_index_get_size(&device->rx_frames);
 }
\ No newline at end of file
@@ -0,0 +1,265 @@
+#include "hc_06_rtos.h"
+
+/**
+ * @brief   Helper function that wakes the task waiting on an event, called from the UART/DMA irq.
+ * @param   event           The event that happened.
+ * @param   context         The blocking send/receive struct.
+ */
+static void notify_waiting_task(hc06_event_t event, void * context) {
+    hc06_rtos_t * rtos = context;
+    TaskHandle_t task = (event == HC06_EVENT_RX_MESSAGE) ? rtos->rx_task : rtos->tx_task;
+    if (task != NULL) {
+        BaseType_t higher_priority_task_woken = pdFALSE;
+        vTaskNotifyGiveFromISR(task, &higher_priority_task_woken);
+        portYIELD_FROM_ISR(higher_priority_task_woken);
+    }
+}
+
+/**
+ * @brief   Helper function that sleeps the calling task until it is notified or its timeout runs out.
+ * @details A notification given since the task last checked is kept, so an event between the check and the sleep is not missed.
+ * @param   start           The tick count when the wait started.
+ * @param   timeout         The most ticks to wait since start, portMAX_DELAY to wait forever.
+ * @param   max_ticks       The most ticks to sleep for this time, portMAX_DELAY for no limit.
+ * @return  bool            false if the timeout had already run out, true otherwise.
+ */
+static bool wait_for_event(TickType_t start, TickType_t timeout, TickType_t max_ticks) {
+    TickType_t ticks_to_wait = portMAX_DELAY;
+    if (timeout != portMAX_DELAY) {
+        TickType_t ticks_elapsed = xTaskGetTickCount() - start;
+        if (ticks_elapsed >= timeout) {
+            return false;
+        }
+        ticks_to_wait = timeout - ticks_elapsed;
+    }
+    if (ticks_to_wait > max_ticks) {
+        ticks_to_wait = max_ticks;
+    }
+    ulTaskNotifyTake(pdTRUE, ticks_to_wait);
+    return true;
+}
+
+/**
+ * @brief   Helper function that sleeps the calling task until the tx buffer has room for a number of characters.
+ * @details Sets the tx low watermark for the wait, so the irq only wakes the task once enough has been sent.
+ *          The calling task must already be registered as the tx task.
+ * @param   rtos            The blocking send/receive struct.
+ * @param   chars_needed    The number of free characters to wait for. Cannot exceed the tx buffer size.
+ * @param   start           The tick count when the wait started.
+ * @param   timeout         The most ticks to wait since start, portMAX_DELAY to wait forever.
+ * @return  bool            false if the timeout ran out first, true otherwise.
+ */
+static bool wait_for_tx_space(hc06_rtos_t * rtos, uint16_t chars_needed, TickType_t start, TickType_t timeout) {
+    hc06_t * device = rtos->device;
+    uint16_t tx_capacity = device->tx_buffer.buffer_capacity;
+    uint16_t previous_watermark = device->tx_low_watermark;
+    hc06_set_tx_low_watermark(device, tx_capacity - chars_needed);
+
+    bool is_in_time = true;
+    while(is_in_time && tx_capacity - circular_buffer_get_size(&device->tx_buffer) < chars_needed) {
+        is_in_time = wait_for_event(start, timeout, portMAX_DELAY);
+    }
+
+    hc06_set_tx_low_watermark(device, previous_watermark);
+    return is_in_time;
+}
+
+/**
+ * @brief   Initialize blocking send/receive for an HC-06 device.
+ * @details Takes over the device's event callback. Must be called after hc06_init.
+ * @param   rtos            The blocking send/receive struct.
+ * @param   device          The HC-06 device struct.
+ * @return  hc06_rc_t       Return code indicating operation success/failure.
+ *                          - HC06_RC_OK:               Operation successful.
+ *                          - HC06_RC_BAD_ARG:          An invalid argument was provided.
+ */
+hc06_rc_t hc06_rtos_init(hc06_rtos_t * rtos, hc06_t * device) {
+    if(rtos == NULL || device == NULL) {
+        return HC06_RC_BAD_ARG;
+    }
+
+    rtos->device = device;
+    rtos->tx_task = NULL;
+    rtos->rx_task = NULL;
+
+    return hc06_set_event_callback(device, notify_waiting_task, rtos);
+}
+
+/**
+ * @brief   Transmit a message through the HC-06 device, blocking while the tx buffer is full.
+ * @details Queues as much of the message as fits, then sleeps until the irq frees tx space and queues the rest.
+ *          Returns once the whole message is queued, not once it is sent.
+ * @param   rtos            The blocking send/receive struct.
+ * @param   tx_buf          Message buffer to transmit.
+ * @param   len             Length of message buffer.
+ * @param   timeout         The most ticks to wait for tx space, portMAX_DELAY to wait forever.
+ * @param   chars_sent      The number of characters from the message buffer that were queued (returned by reference)
+ * @return  hc06_rc_t       Return code indicating operation success/failure.
+ *                          - HC06_RC_OK:               Operation successful.
+ *                          - HC06_RC_BAD_ARG:          An invalid argument was provided.
+ *                          - HC06_RC_TIMEOUT:          The timeout ran out before the whole message was queued. Use chars_sent to recover as needed.
+ */
+hc06_rc_t hc06_send(hc06_rtos_t * rtos, const char * tx_buf, uint16_t len, TickType_t timeout, uint16_t * chars_sent) {
+    if(rtos == NULL || tx_buf == NULL || chars_sent == NULL) {
+        return HC06_RC_BAD_ARG;
+    }
+
+    // Register as the waiting task before the first push, so tx space freed from then on is signalled
+    TickType_t start = xTaskGetTickCount();
+    rtos->tx_task = xTaskGetCurrentTaskHandle();
+
+    hc06_rc_t rc = HC06_RC_OK;
+    *chars_sent = 0;
+    while(1) {
+        uint16_t chars_pushed;
+        hc06_tx_msg(rtos->device, (char *)&tx_buf[*chars_sent], len - *chars_sent, &chars_pushed);
+        *chars_sent += chars_pushed;
+        if(*chars_sent == len) {
+            break;
+        }
+
+        // The tx buffer is full, sleep until the irq has sent some of it
+        if(!wait_for_event(start, timeout, portMAX_DELAY)) {
+            rc = HC06_RC_TIMEOUT;
+            break;
+        }
+    }
+
+    rtos->tx_task = NULL;
+
+    return rc;
+}
+
+/**
+ * @brief   Transmit a message made of several fragments with hc06_tx_msgv, blocking until the tx buffer has room for all of it.
+ * @details The task sleeps with the tx low watermark set so it is woken once, when the whole message fits, rather than
+ *          every time some tx space frees up. The message is still queued whole or not at all.
+ * @param   rtos            The blocking send/receive struct.
+ * @param   iov             The fragments, in order. A fragment's data can be NULL if its len is 0.
+ * @param   iov_count       The number of fragments in iov.
+ * @param   timeout         The most ticks to wait for tx space, portMAX_DELAY to wait forever.
+ * @return  hc06_rc_t       Return code indicating operation success/failure.
+ *                          - HC06_RC_OK:               Operation successful.
+ *                          - HC06_RC_BAD_ARG:          An invalid argument was provided.
+ *                          - HC06_RC_ERROR_TX_BUFFER:  The fragments add up to more than the tx buffer can ever hold, nothing was queued.
+ *                          - HC06_RC_TIMEOUT:          The timeout ran out before the message fit, nothing was queued.
+ */
+hc06_rc_t hc06_send_msgv(hc06_rtos_t * rtos, const hc06_iovec_t * iov, uint8_t iov_count, TickType_t timeout) {
+    if(rtos == NULL || (iov == NULL && iov_count > 0)) {
+        return HC06_RC_BAD_ARG;
+    }
+
+    uint32_t total_len = 0;
+    for(uint8_t i = 0; i < iov_count; i++) {
+        total_len += iov[i].len;
+    }
+    if(total_len > rtos->device->tx_buffer.buffer_capacity) {
+        return HC06_RC_ERROR_TX_BUFFER;
+    }
+
+    // Register as the waiting task before the first attempt, so tx space freed from then on is signalled
+    TickType_t start = xTaskGetTickCount();
+    rtos->tx_task = xTaskGetCurrentTaskHandle();
+
+    hc06_rc_t rc;
+    while((rc = hc06_tx_msgv(rtos->device, iov, iov_count)) == HC06_RC_ERROR_TX_BUFFER) {
+        if(!wait_for_tx_space(rtos, (uint16_t)total_len, start, timeout)) {
+            rc = HC06_RC_TIMEOUT;
+            break;
+        }
+    }
+
+    rtos->tx_task = NULL;
+
+    return rc;
+}
+
+/**
+ * @brief   Transmit a binary telemetry frame with hc06_tx_frame, blocking until the tx buffer has room for it.
+ * @details The task sleeps with the tx low watermark set so it is woken once, when TELEMETRY_FRAME_MAX_ENCODED_LEN(len)
+ *          characters are free, rather than every time some tx space frees up. The frame is still queued whole or not at all.
+ * @param   rtos            The blocking send/receive struct.
+ * @param   msg_id          The message ID, e.g. one of telemetry_msg_id_t.
+ * @param   payload         The binary payload. Can be NULL if len is 0.
+ * @param   len             Length of the payload. Cannot exceed TELEMETRY_FRAME_MAX_PAYLOAD.
+ * @param   timeout         The most ticks to wait for tx space, portMAX_DELAY to wait forever.
+ * @return  hc06_rc_t       Return code indicating operation success/failure.
+ *                          - HC06_RC_OK:               Operation successful.
+ *                          - HC06_RC_BAD_ARG:          An invalid argument was provided.
+ *                          - HC06_RC_ERROR_TX_BUFFER:  The frame's worst case length is more than the tx buffer can ever hold, nothing was queued.
+ *                          - HC06_RC_TIMEOUT:          The timeout ran out before the frame fit, nothing was queued.
+ */
+hc06_rc_t hc06_send_frame(hc06_rtos_t * rtos, uint8_t msg_id, const void * payload, uint16_t len, TickType_t timeout) {
+    if(rtos == NULL || len > TELEMETRY_FRAME_MAX_PAYLOAD) {
+        return HC06_RC_BAD_ARG;
+    }
+
+    // hc06_tx_frame needs room for the worst case encoding, however long the frame turns out
+    uint32_t frame_len = TELEMETRY_FRAME_MAX_ENCODED_LEN((uint32_t)len);
+    if(frame_len > rtos->device->tx_buffer.buffer_capacity) {
+        return HC06_RC_ERROR_TX_BUFFER;
+    }
+
+    // Register as the waiting task before the first attempt, so tx space freed from then on is signalled
+    TickType_t start = xTaskGetTickCount();
+    rtos->tx_task = xTaskGetCurrentTaskHandle();
+
+    hc06_rc_t rc;
+    while((rc = hc06_tx_frame(rtos->device, msg_id, payload, len)) == HC06_RC_ERROR_TX_BUFFER) {
+        if(!wait_for_tx_space(rtos, (uint16_t)frame_len, start, timeout)) {
+            rc = HC06_RC_TIMEOUT;
+            break;
+        }
+    }
+
+    rtos->tx_task = NULL;
+
+    return rc;
+}
+
+/**
+ * @brief   Receive a message from the HC-06 device, blocking until one is complete.
+ * @details Sleeps until the irq signals that a message was received, then receives it with hc06_rx_msg.
+ *          If the rx buffer fills without a newline, all of it is received instead, like hc06_rx_msg does.
+ *          In DMA receive mode the UART receive timeout never fires while the DMA keeps the FIFO empty, so the task
+ *          also wakes every HC06_RTOS_RX_DMA_POLL_TICKS to publish what the DMA has written (see hc06_enable_rx_dma).
+ * @param   rtos            The blocking send/receive struct.
+ * @param   rx_buf          Message buffer to receive in. Its size cannot be less than the capacity of the rx circular buffer.
+ * @param   len             Length of message buffer. Cannot be less than the capacity of the rx circular buffer.
+ * @param   timeout         The most ticks to wait for a message, portMAX_DELAY to wait forever.
+ * @param   chars_received  The number of characters from the message buffer that were received (returned by reference)
+ * @return  hc06_rc_t       Return code indicating operation success/failure.
+ *                          - HC06_RC_OK:               Operation successful.
+ *                          - HC06_RC_BAD_ARG:          An invalid argument was provided.
+ *                          - HC06_RC_TIMEOUT:          No message was received before the timeout ran out.
+ */
+hc06_rc_t hc06_receive(hc06_rtos_t * rtos, char * rx_buf, uint16_t len, TickType_t timeout, uint16_t * chars_received) {
+    if(rtos == NULL || rx_buf == NULL || chars_received == NULL) {
+        return HC06_RC_BAD_ARG;
+    }
+
+    // Register as the waiting task before checking for messages, so one completed from then on is signalled
+    TickType_t start = xTaskGetTickCount();
+    rtos->rx_task = xTaskGetCurrentTaskHandle();
+
+    // hc06_rx_frames_pending publishes what the rx DMA has written, which nothing signals, so check back on it regularly
+    TickType_t max_ticks = rtos->device->rx_dma_enabled ? HC06_RTOS_RX_DMA_POLL_TICKS : portMAX_DELAY;
+    bool is_timed_out = false;
+    // A full rx buffer can never complete a message, hc06_rx_msg flushes it whole instead; with flow control the rx irqs
+    // stay stopped until it does
+    while(hc06_rx_frames_pending(rtos->device) == 0 && !circular_buffer_is_full(&rtos->device->rx_buffer)) {
+        if(!wait_for_event(start, timeout, max_ticks)) {
+            is_timed_out = true;
+            break;
+        }
+    }
+
+    rtos->rx_task = NULL;
+
+    if(is_timed_out) {
+        *chars_received = 0;
+        return HC06_RC_TIMEOUT;
+    }
+
+    return hc06_rx_msg(rtos->device, rx_buf, len, chars_received);
+}
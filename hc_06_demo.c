@@ -29,8 +29,8 @@ int main()
     uart_puts(uart0, init_msg);
 
     while(1) {
-        // Wait for a new message to echo
-        if(hc06.message_received) {
+        // Echo every message that has arrived since the last check
+        while(hc06_rx_frames_pending(&hc06) > 0) {
             // Receive it
             char rx_buf[HC06_DEFAULT_MSG_SIZE];
             memset(rx_buf, 0, HC06_DEFAULT_MSG_SIZE);
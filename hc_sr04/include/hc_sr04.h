@@ -1,6 +1,17 @@
 /**
  * @file    hc_sr04.h
  * @brief   Defines a struct for interfacing with the HC-SR04 Ultrasonic Distance Sensor.
+ * @details The echo pulse is timed either by the application calling hcsr04_on_echo_pin_rise/fall from a GPIO IRQ, or,
+ *          after hcsr04_enable_pio_capture, by a PIO state machine that counts the pulse width in system clock cycles
+ *          and pushes the count to its RX FIFO. The PIO needs no CPU time per edge, and its reading is free of interrupt
+ *          latency jitter, with a resolution of HCSR04_PIO_CYCLES_PER_COUNT cycles (16 ns at 125 MHz).
+ *          The trigger pulse is ended, and a measurement with no echo timed out, by an alarm from the SDK's default alarm
+ *          pool, so hcsr04_start_measurement returns straight away and hcsr04_end_measurement eventually returns either
+ *          the distance or HCSR04_RC_TIMEOUT, without the application keeping time.
+ *          The distance is computed in integer millimetres, Q16.16, with one multiply by a scale precomputed from the
+ *          speed of sound, so the FPU-less RP2040 does no soft-float maths per reading; hcsr04_get_distance_cm wraps it for
+ *          callers that want float centimetres. With HCSR04_ENABLE_TEMPERATURE_COMPENSATION, hcsr04_set_temperature
+ *          looks the speed of sound up in a table and rescales.
  */
 
 #ifndef HCSR04_H
@@ -8,7 +19,29 @@
 
 // Includes
 #include "pico/stdlib.h"
+#include "pico/time.h"
 #include "hardware/gpio.h"
+#include "hardware/pio.h"
+#include "hardware/clocks.h"
+
+// System clock cycles per count of the PIO echo capture loop
+#define HCSR04_PIO_CYCLES_PER_COUNT     2u
+
+// Distances are millimetres in Q16.16 fixed point, so (distance >> 16) is whole millimetres
+#define HCSR04_DIST_NONE_MM_Q16         UINT32_MAX
+#define HCSR04_DIST_NONE                -1.0f
+
+// Speed of sound used until hcsr04_set_temperature sets another, about right for dry air at 20 C
+#define HCSR04_DEFAULT_SPEED_OF_SOUND_MM_S  343000u
+
+// The speed of sound table and hcsr04_set_temperature are compiled out unless enabled, see the
+// HCSR04_ENABLE_TEMPERATURE_COMPENSATION CMake option
+#ifndef HCSR04_ENABLE_TEMPERATURE_COMPENSATION
+#define HCSR04_ENABLE_TEMPERATURE_COMPENSATION 0
+#endif
+
+// Time from the end of the trigger pulse to give up on the echo: the 400 cm range's 23.3 ms echo plus the ping burst
+#define HCSR04_DEFAULT_ECHO_TIMEOUT_US  30000u
 
 typedef enum {
     HCSR04_IDLE,
@@ -20,6 +53,10 @@ typedef enum {
     HCSR04_RC_BAD_ARG       = 1,
     HCSR04_RC_BUSY          = 2,
     HCSR04_RC_NO_ECHO       = 3,
+    HCSR04_RC_ERROR_PIO     = 4,
+    HCSR04_RC_TIMEOUT       = 5,
+    HCSR04_RC_ERROR_ALARM   = 6,
+    HCSR04_RC_REJECTED      = 7,    // The filter discarded the reading as an outlier, see hc_sr04_filter.h
 } hcsr04_rc_t;
 
 typedef struct {
@@ -28,11 +65,25 @@ typedef struct {
     uint8_t echo_pin;
    
     // Sensor data
-    float current_distance;
+    uint32_t current_distance_mm_q16;   // HCSR04_DIST_NONE_MM_Q16 until a measurement completes
     volatile bool echo_received;
     volatile absolute_time_t start_time;
     volatile absolute_time_t end_time;
     hcsr04_state_t state;
+
+    // Trigger pulse and echo timeout alarm
+    uint32_t echo_timeout_us;
+    volatile alarm_id_t alarm_id;       // 0 when no alarm is pending
+    volatile bool is_triggering;        // The alarm ends the trigger pulse, otherwise it times out the echo
+    volatile bool timed_out;
+
+    // PIO echo capture, pio is NULL when the echo pin is timed by GPIO IRQ
+    PIO pio;
+    uint8_t pio_sm;
+
+    // Pulse width to distance conversion
+    uint32_t speed_of_sound_mm_s;
+    uint32_t distance_scale;            // Q32 millimetres per unit of pulse width, microseconds or PIO counts, halved for the round trip
 } hcsr04_t;
 
 /**
@@ -57,15 +108,58 @@ hcsr04_rc_t hcsr04_init(hcsr04_t * sensor, uint8_t trigger_pin, uint8_t echo_pin
  */
 hcsr04_rc_t hcsr04_reset(hcsr04_t * sensor);
 
+/**
+ * @brief   Set how long after the trigger pulse a measurement waits for its echo before timing out.
+ * @param   sensor          HC-SR04 sensor struct.
+ * @param   timeout_us      The timeout, 0 to wait forever. Defaults to HCSR04_DEFAULT_ECHO_TIMEOUT_US.
+ * @return  hcsr04_rc_t     Return code indicating operation success/failure.
+ *                          - HCSR04_RC_OK:             Operation successful.
+ *                          - HCSR04_RC_BAD_ARG:        An invalid argument was provided.
+ *                          - HCSR04_RC_BUSY:           The sensor is in the middle of a measurement.
+ */
+hcsr04_rc_t hcsr04_set_echo_timeout(hcsr04_t * sensor, uint32_t timeout_us);
+
+/**
+ * @brief   Time the echo pulse with a PIO state machine instead of the echo pin IRQ handlers.
+ * @details Claims a state machine on pio and loads the echo capture program, once per PIO, so several sensors can share
+ *          it. Once enabled, hcsr04_on_echo_pin_rise/fall are not needed and hcsr04_end_measurement reads the pulse width
+ *          from the state machine's RX FIFO. The distance scale is worked out from clk_sys here, so call this after setting
+ *          the system clock.
+ * @param   sensor          HC-SR04 sensor struct.
+ * @param   pio             The PIO instance to run the echo capture on, pio0 or pio1.
+ * @return  hcsr04_rc_t     Return code indicating operation success/failure.
+ *                          - HCSR04_RC_OK:             Operation successful.
+ *                          - HCSR04_RC_BAD_ARG:        An invalid argument was provided, or PIO capture is already enabled.
+ *                          - HCSR04_RC_BUSY:           The sensor is in the middle of a measurement.
+ *                          - HCSR04_RC_ERROR_PIO:      The PIO has no free state machine or no room for the program.
+ */
+hcsr04_rc_t hcsr04_enable_pio_capture(hcsr04_t * sensor, PIO pio);
+
+#if HCSR04_ENABLE_TEMPERATURE_COMPENSATION
+/**
+ * @brief   Set the air temperature, looking up the speed of sound for it and rescaling the sensor's distances.
+ * @details Interpolates linearly between table entries every 10 C from -20 C to 50 C, clamping outside that range.
+ * @param   sensor          HC-SR04 sensor struct.
+ * @param   temperature_dc  The air temperature in tenths of a degree Celsius.
+ * @return  hcsr04_rc_t     Return code indicating operation success/failure.
+ *                          - HCSR04_RC_OK:             Operation successful.
+ *                          - HCSR04_RC_BAD_ARG:        An invalid argument was provided.
+ *                          - HCSR04_RC_BUSY:           The sensor is in the middle of a measurement.
+ */
+hcsr04_rc_t hcsr04_set_temperature(hcsr04_t * sensor, int16_t temperature_dc);
+#endif
+
 /**
  * @brief   Start measuring distance using HC-SR04 by sending trigger pulse through trigger pin.
  * @details Receives echo pulse through echo pin, width of echo pulse is used to determine distance.
  *          Transaction is finished by calling hcsr04_end_measurement after echo pulse is received. 
+ *          Returns once the trigger pin is raised; an alarm lowers it after the pulse width and then times out the echo.
  * @param   sensor          HC-SR04 sensor struct.
  * @return  hcsr04_rc_t     Return code indicating operation success/failure.
  *                          - HCSR04_RC_OK:             Operation successful.
  *                          - HCSR04_RC_BAD_ARG:        An invalid argument was provided.
  *                          - HCSR04_RC_BUSY:           The sensor is in the middle of another measurement.  
+ *                          - HCSR04_RC_ERROR_ALARM:    No alarm was free to time the trigger pulse, the measurement was not started.
  */
 hcsr04_rc_t hcsr04_start_measurement(hcsr04_t * sensor);
 
@@ -91,14 +185,31 @@ hcsr04_rc_t hcsr04_on_echo_pin_fall(hcsr04_t * sensor);
 
 /**
  * @brief   Finish HC-SR04 distance measurement transaction by calculating distance from received echo pulse width.
- * @details Echo pulse must be received using on_echo_pin_rise and on_echo_pin_fall functions, ideally within a GPIO IRQ.
+ * @details Echo pulse must be received using on_echo_pin_rise and on_echo_pin_fall functions, ideally within a GPIO IRQ,
+ *          or by the PIO once hcsr04_enable_pio_capture has been called.
  *          The raw value of the pulse width is a non-atomic datatype (uint64_t), so it's easier to just calculate and use the distance.
  * @param   sensor          HC-SR04 sensor struct.
  * @return  hcsr04_rc_t     Return code indicating operation success/failure.
  *                          - HCSR04_RC_OK:             Operation successful.
  *                          - HCSR04_RC_BAD_ARG:        An invalid argument was provided.
  *                          - HCSR04_RC_NO_ECHO:        The echo pulse has not been received yet.
+ *                          - HCSR04_RC_TIMEOUT:        No echo was received before the echo timeout, the sensor is idle again.
  */
 hcsr04_rc_t hcsr04_end_measurement(hcsr04_t * sensor);
 
+/**
+ * @brief   Convert an echo pulse width to a distance with the sensor's scale, as hcsr04_end_measurement does.
+ * @param   sensor          HC-SR04 sensor struct, is assumed to be valid.
+ * @param   pulse_width     The echo pulse width, in microseconds, or in PIO counts once PIO capture is enabled.
+ * @return  uint32_t        The distance in millimetres, Q16.16, saturating just below HCSR04_DIST_NONE_MM_Q16.
+ */
+uint32_t hcsr04_convert_pulse_width(const hcsr04_t * sensor, uint32_t pulse_width);
+
+/**
+ * @brief   Get the last measured distance in centimetres, a float wrapper over current_distance_mm_q16.
+ * @param   sensor          HC-SR04 sensor struct.
+ * @return  float           The distance in centimetres, HCSR04_DIST_NONE if there is none or the sensor is NULL.
+ */
+float hcsr04_get_distance_cm(const hcsr04_t * sensor);
+
 #endif // HCSR04_H
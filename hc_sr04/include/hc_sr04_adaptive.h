@@ -0,0 +1,122 @@
+/**
+ * @file    hc_sr04_adaptive.h
+ * @brief   Defines a scheduler that triggers an HC-SR04 sensor at a rate adapted to what it sees.
+ * @details After each measurement the time to the next trigger is chosen so the distance can change by at most
+ *          max_change_percent of itself in between, at the speed the distance is changing, or min_speed_mm_s if that is
+ *          slower:
+ *
+ *              period = distance * max_change_percent / 100 / max(|speed|, min_speed_mm_s)
+ *
+ *          so a close or fast moving obstacle is measured often, and a far or static scene rarely. The period is clamped
+ *          to min_period_us and max_period_us, and never shorter than the echo's round trip at the last distance plus
+ *          HCSR04_ADAPTIVE_ECHO_GUARD_US, so the next ping can't go out before this one's echo is back. A measurement that
+ *          times out waits max_period_us. The speed is the change between readings, smoothed over about four readings.
+ *
+ *          hcsr04_adaptive_poll runs it from a main loop. In an EDF task, each job calls hcsr04_adaptive_collect for the
+ *          measurement the last job started and hcsr04_adaptive_trigger for the next one, then sets its own period to
+ *          the new one before completing:
+ *
+ *              while(1) {
+ *                  hcsr04_adaptive_collect(&adaptive);
+ *                  hcsr04_adaptive_trigger(&adaptive);
+ *                  edf_set_task_period(task_handle, pdMS_TO_TICKS((hcsr04_adaptive_get_period_us(&adaptive) + 999) / 1000));
+ *                  edf_complete_task(task_handle);
+ *              }
+ *
+ * @section Dependencies
+ * - 'hc_sr04.h':           Provides the HC-SR04 driver.
+ */
+
+#ifndef HCSR04_ADAPTIVE_H
+#define HCSR04_ADAPTIVE_H
+
+// Includes
+#include "hc_sr04.h"
+
+// Time added to the echo's round trip for the sensor's delay before its echo pulse starts
+#define HCSR04_ADAPTIVE_ECHO_GUARD_US   1000u
+
+typedef struct {
+    hcsr04_t * sensor;
+
+    // Configuration
+    uint32_t min_period_us;
+    uint32_t max_period_us;
+    uint8_t max_change_percent;
+    uint32_t min_speed_mm_s;
+
+    // Last reading and the smoothed speed the distance is changing at, positive moving away
+    bool has_distance;
+    uint32_t last_distance_mm_q16;
+    uint32_t last_reading_time_us;
+    int32_t speed_mm_s;
+
+    uint32_t period_us;
+    uint32_t trigger_time_us;
+    bool has_triggered;
+
+    // Statistics, the start time 64 bit so the rate stays right past the 32 bit timer's wrap at about 71 minutes
+    uint64_t start_time_us;
+    uint32_t readings;
+    uint32_t timeouts;
+} hcsr04_adaptive_t;
+
+/**
+ * @brief   Initialize an adaptive scheduler for a sensor, starting at max_period_us until the first reading.
+ * @param   adaptive            The adaptive scheduler.
+ * @param   sensor              The HC-SR04 sensor struct, initialized with hcsr04_init.
+ * @param   min_period_us       The shortest time between triggers.
+ * @param   max_period_us       The longest time between triggers, at least min_period_us.
+ * @param   max_change_percent  How much the distance may change between readings, as a percentage of itself. Cannot be 0.
+ * @param   min_speed_mm_s      The speed assumed for a scene that isn't moving, so it is still measured. Cannot be 0.
+ * @return  hcsr04_rc_t         Return code indicating operation success/failure.
+ *                              - HCSR04_RC_OK:             Operation successful.
+ *                              - HCSR04_RC_BAD_ARG:        An invalid argument was provided.
+ */
+hcsr04_rc_t hcsr04_adaptive_init(hcsr04_adaptive_t * adaptive, hcsr04_t * sensor, uint32_t min_period_us, uint32_t max_period_us,
+                                 uint8_t max_change_percent, uint32_t min_speed_mm_s);
+
+/**
+ * @brief   Finish the sensor's measurement if it is done, and choose the period until the next trigger from it.
+ * @param   adaptive            The adaptive scheduler.
+ * @return  hcsr04_rc_t         Return code indicating operation success/failure.
+ *                              - HCSR04_RC_OK:             A reading was collected, the distance is in the sensor.
+ *                              - HCSR04_RC_BAD_ARG:        An invalid argument was provided.
+ *                              - HCSR04_RC_NO_ECHO:        No measurement has finished.
+ *                              - HCSR04_RC_TIMEOUT:        The measurement timed out.
+ */
+hcsr04_rc_t hcsr04_adaptive_collect(hcsr04_adaptive_t * adaptive);
+
+/**
+ * @brief   Trigger the sensor now, whether or not the period has passed.
+ * @param   adaptive            The adaptive scheduler.
+ * @return  hcsr04_rc_t         Return code indicating operation success/failure.
+ *                              - HCSR04_RC_OK:             Operation successful.
+ *                              - Otherwise the return code of hcsr04_start_measurement.
+ */
+hcsr04_rc_t hcsr04_adaptive_trigger(hcsr04_adaptive_t * adaptive);
+
+/**
+ * @brief   Collect a finished measurement, and trigger the sensor once the period since the last trigger has passed.
+ * @details Call often, from the main loop or a periodic task.
+ * @param   adaptive            The adaptive scheduler.
+ * @return  hcsr04_rc_t         Return code indicating operation success/failure.
+ *                              - The return code of hcsr04_adaptive_collect.
+ */
+hcsr04_rc_t hcsr04_adaptive_poll(hcsr04_adaptive_t * adaptive);
+
+/**
+ * @brief   Get the period chosen after the last measurement, the time from its trigger to the next one.
+ * @param   adaptive            The adaptive scheduler.
+ * @return  uint32_t            The period in microseconds, 0 if adaptive is NULL.
+ */
+uint32_t hcsr04_adaptive_get_period_us(const hcsr04_adaptive_t * adaptive);
+
+/**
+ * @brief   Get the rate measurements have finished at since the scheduler was initialized, timeouts included.
+ * @param   adaptive            The adaptive scheduler.
+ * @return  float               Measurements per second, 0 if adaptive is NULL.
+ */
+float hcsr04_adaptive_get_rate(const hcsr04_adaptive_t * adaptive);
+
+#endif // HCSR04_ADAPTIVE_H
@@ -0,0 +1,128 @@
+/**
+ * @file    hc_sr04_array.h
+ * @brief   Defines a manager that interleaves measurements across several HC-SR04 sensors.
+ * @details Sensors facing the same way hear each other's pings, so each sensor is added to a group, and sensors in a
+ *          group are triggered one at a time, round robin, at least group_spacing_us apart and only once the group's
+ *          previous measurement has finished. Sensors in different groups are triggered concurrently, so the array
+ *          takes up to one reading per group every group_spacing_us.
+ *          A measurement with no echo after timeout_us is abandoned, so a sensor facing open space doesn't hold up its
+ *          group; the timeout is the sensor's own echo timeout, set when it is added.
+ *
+ *          The SDK allows one GPIO callback per core, so the application's callback passes echo pin edges to
+ *          hcsr04_array_handle_echo_edge, which finds the sensor by pin in constant time. Sensors using PIO capture
+ *          (see hcsr04_enable_pio_capture) need no edges.
+ *
+ *          Example:
+ *              hcsr04_array_init(&array, 25000, 20000, handle_reading, NULL);
+ *              hcsr04_array_add(&array, &front_left, 0, NULL);
+ *              hcsr04_array_add(&array, &front_right, 0, NULL);
+ *              hcsr04_array_add(&array, &rear, 1, NULL);
+ *              gpio_set_irq_callback(&handle_gpio_irq);    // Calls hcsr04_array_handle_echo_edge
+ *
+ *              // In the main loop or a periodic task
+ *              hcsr04_array_poll(&array);
+ *
+ * @section Dependencies
+ * - 'hc_sr04.h':           Provides the HC-SR04 driver.
+ */
+
+#ifndef HCSR04_ARRAY_H
+#define HCSR04_ARRAY_H
+
+// Includes
+#include "hc_sr04.h"
+
+#define HCSR04_ARRAY_MAX_SENSORS    8u
+#define HCSR04_ARRAY_NO_SENSOR      0xFFu
+
+// Called by hcsr04_array_poll for each completed measurement; the distance is also in the sensor's current_distance_mm_q16
+typedef void (*hcsr04_array_callback_t)(uint8_t index, hcsr04_t * sensor, void * context);
+
+typedef struct {
+    hcsr04_t * sensor;
+    uint8_t group;
+    uint32_t trigger_time_us;
+
+    // Statistics
+    uint32_t readings;
+    uint32_t timeouts;
+} hcsr04_array_entry_t;
+
+typedef struct {
+    hcsr04_array_entry_t entries[HCSR04_ARRAY_MAX_SENSORS];
+    uint8_t num_sensors;
+    uint8_t sensor_by_pin[NUM_BANK0_GPIOS];     // Index of the sensor on each echo pin, for constant time edge dispatch
+
+    // Group state, indexed by group
+    uint8_t group_next[HCSR04_ARRAY_MAX_SENSORS];       // Entry to consider first next time, for round robin
+    uint8_t group_busy[HCSR04_ARRAY_MAX_SENSORS];       // Entry measuring, HCSR04_ARRAY_NO_SENSOR if none
+    uint32_t group_trigger_time_us[HCSR04_ARRAY_MAX_SENSORS];
+    bool group_has_triggered[HCSR04_ARRAY_MAX_SENSORS];
+
+    uint32_t group_spacing_us;
+    uint32_t timeout_us;
+    uint64_t start_time_us;     // 64 bit so the rate stays right past the 32 bit timer's wrap at about 71 minutes
+    hcsr04_array_callback_t callback;
+    void * context;
+} hcsr04_array_t;
+
+/**
+ * @brief   Initialize an empty sensor array.
+ * @param   array               The sensor array.
+ * @param   group_spacing_us    The least time between triggering two sensors in the same group.
+ * @param   timeout_us          The most time after its trigger pulse to wait for a sensor's echo before abandoning the measurement. Cannot be 0.
+ * @param   callback            Called for each completed measurement, can be NULL.
+ * @param   context             Passed to callback.
+ * @return  hcsr04_rc_t         Return code indicating operation success/failure.
+ *                              - HCSR04_RC_OK:             Operation successful.
+ *                              - HCSR04_RC_BAD_ARG:        An invalid argument was provided.
+ */
+hcsr04_rc_t hcsr04_array_init(hcsr04_array_t * array, uint32_t group_spacing_us, uint32_t timeout_us, hcsr04_array_callback_t callback, void * context);
+
+/**
+ * @brief   Add an initialized sensor to the array.
+ * @details Sets the sensor's echo timeout to the array's timeout_us and enables the echo pin's edge interrupts unless the
+ *          sensor uses PIO capture.
+ * @param   array               The sensor array.
+ * @param   sensor              The HC-SR04 sensor struct, initialized with hcsr04_init.
+ * @param   group               The group of sensors it can hear, less than HCSR04_ARRAY_MAX_SENSORS.
+ * @param   index               The sensor's index in the array (returned by reference), can be NULL.
+ * @return  hcsr04_rc_t         Return code indicating operation success/failure.
+ *                              - HCSR04_RC_OK:             Operation successful.
+ *                              - HCSR04_RC_BAD_ARG:        An invalid argument was provided, the array is full or the echo pin is already used.
+ *                              - HCSR04_RC_BUSY:           The sensor is in the middle of a measurement.
+ */
+hcsr04_rc_t hcsr04_array_add(hcsr04_array_t * array, hcsr04_t * sensor, uint8_t group, uint8_t * index);
+
+/**
+ * @brief   Pass an echo pin edge to the sensor on that pin.
+ * @details Call from the application's GPIO callback. Runs in constant time whatever the number of sensors.
+ * @param   array               The sensor array.
+ * @param   gpio                The pin the edge was on.
+ * @param   events              The GPIO_IRQ_EDGE_RISE/FALL events.
+ * @return  hcsr04_rc_t         Return code indicating operation success/failure.
+ *                              - HCSR04_RC_OK:             Operation successful.
+ *                              - HCSR04_RC_BAD_ARG:        An invalid argument was provided, or no sensor's echo pin is gpio.
+ */
+hcsr04_rc_t hcsr04_array_handle_echo_edge(hcsr04_array_t * array, uint gpio, uint32_t events);
+
+/**
+ * @brief   Collect finished measurements, abandon timed out ones and trigger the next sensor of every group that is ready.
+ * @details Call often, at least every group_spacing_us, from the main loop or a periodic task. Never blocks, the trigger
+ *          pulses are ended by alarms.
+ * @param   array               The sensor array.
+ * @return  hcsr04_rc_t         Return code indicating operation success/failure.
+ *                              - HCSR04_RC_OK:             Operation successful.
+ *                              - HCSR04_RC_BAD_ARG:        An invalid argument was provided.
+ */
+hcsr04_rc_t hcsr04_array_poll(hcsr04_array_t * array);
+
+/**
+ * @brief   Get the rate a sensor has completed measurements at since the array was initialized.
+ * @param   array               The sensor array.
+ * @param   index               The sensor's index in the array.
+ * @return  float               Readings per second, 0 if the arguments are invalid.
+ */
+float hcsr04_array_get_rate(hcsr04_array_t * array, uint8_t index);
+
+#endif // HCSR04_ARRAY_H
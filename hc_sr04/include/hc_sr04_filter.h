@@ -0,0 +1,126 @@
+/**
+ * @file    hc_sr04_filter.h
+ * @brief   Defines a streaming filter that rejects outliers from an HC-SR04 sensor's readings and smooths the rest.
+ * @details Each reading goes through two stages:
+ *          - A gate, which rejects readings beyond HCSR04_FILTER_MAX_RANGE_MM, the sensor's spurious max-range values,
+ *            and readings that moved further from the last accepted one than max_rate_mm_s allows for the time between
+ *            them, such as multipath echoes. After max_rejects readings in a row are rejected the gate accepts the next
+ *            one anyway, so a real step, like an obstacle appearing, gets through.
+ *          - A rolling window of the last window accepted readings, with its median, mean and variance.
+ *
+ *          The median is kept by two heaps sharing one array, a max-heap of the lower half and a min-heap of the upper
+ *          half with the median between them, and each window slot knows where its reading is in the heaps. A new
+ *          reading replaces the oldest in place and is sifted up or down, so an update is O(log window), with no
+ *          sorting or shifting of the window. The mean and variance come from running sums, updated in O(1).
+ *          Everything lives in the filter struct, up to HCSR04_FILTER_MAX_WINDOW readings, so memory per sensor is fixed.
+ *          Distances are millimetres in Q16.16 fixed point, like the sensor's current_distance_mm_q16.
+ *
+ *          Example:
+ *              hcsr04_filter_init(&filter, 5, 2000000, 3);     // 5 reading median, 2 m/s gate
+ *
+ *              // Instead of hcsr04_end_measurement
+ *              if(hcsr04_filter_end_measurement(&filter, &sensor) == HCSR04_RC_OK) {
+ *                  distance = hcsr04_filter_get_median(&filter);
+ *              }
+ *
+ * @section Dependencies
+ * - 'hc_sr04.h':           Provides the HC-SR04 driver.
+ */
+
+#ifndef HCSR04_FILTER_H
+#define HCSR04_FILTER_H
+
+// Includes
+#include "hc_sr04.h"
+
+#define HCSR04_FILTER_MAX_WINDOW    31u
+
+// Readings further than the HC-SR04's 4 m range are the sensor's own "nothing heard" values, not distances
+#define HCSR04_FILTER_MAX_RANGE_MM  4000u
+
+typedef struct {
+    // Rolling window, slot values in the order they arrived, oldest at next_slot once full
+    uint32_t values[HCSR04_FILTER_MAX_WINDOW];
+    int8_t slot_positions[HCSR04_FILTER_MAX_WINDOW];    // Where each slot is in the heaps
+    uint8_t heap_slots[HCSR04_FILTER_MAX_WINDOW];       // The heaps, holding slots; see heap_slot in hc_sr04_filter.c
+    uint8_t window;
+    uint8_t count;
+    uint8_t next_slot;
+
+    // Running sums for the mean and variance; the variance's are taken at 8 fractional bits so its terms fit in 64 bits
+    uint64_t sum;
+    uint32_t sum_q8;
+    uint64_t sum_of_squares_q16;
+
+    // Rate-of-change gate
+    uint32_t max_rate_mm_s;
+    uint8_t max_rejects;
+    uint8_t consecutive_rejects;
+    bool has_accepted;
+    uint32_t last_value;
+    uint32_t last_time_us;
+
+    // Statistics
+    uint32_t accepted;
+    uint32_t rejected;
+} hcsr04_filter_t;
+
+/**
+ * @brief   Initialize an empty filter.
+ * @param   filter          The filter.
+ * @param   window          The number of accepted readings the median, mean and variance are taken over, 1 to
+ *                          HCSR04_FILTER_MAX_WINDOW.
+ * @param   max_rate_mm_s   The fastest a distance can change between accepted readings, 0 to turn the rate gate off.
+ * @param   max_rejects     The number of readings in a row the rate gate rejects before accepting one anyway.
+ * @return  hcsr04_rc_t     Return code indicating operation success/failure.
+ *                          - HCSR04_RC_OK:             Operation successful.
+ *                          - HCSR04_RC_BAD_ARG:        An invalid argument was provided.
+ */
+hcsr04_rc_t hcsr04_filter_init(hcsr04_filter_t * filter, uint8_t window, uint32_t max_rate_mm_s, uint8_t max_rejects);
+
+/**
+ * @brief   Pass a reading through the gate and, if it is accepted, into the rolling window.
+ * @param   filter          The filter.
+ * @param   distance_mm_q16 The reading in millimetres, Q16.16.
+ * @param   time_us         The time of the reading, for the rate gate.
+ * @return  hcsr04_rc_t     Return code indicating operation success/failure.
+ *                          - HCSR04_RC_OK:             The reading was accepted.
+ *                          - HCSR04_RC_BAD_ARG:        An invalid argument was provided.
+ *                          - HCSR04_RC_REJECTED:       The reading was out of range or changed too fast, and was dropped.
+ */
+hcsr04_rc_t hcsr04_filter_update(hcsr04_filter_t * filter, uint32_t distance_mm_q16, uint32_t time_us);
+
+/**
+ * @brief   Finish a measurement with hcsr04_end_measurement and pass its distance through the filter.
+ * @param   filter          The filter.
+ * @param   sensor          The HC-SR04 sensor struct the filter is for.
+ * @return  hcsr04_rc_t     Return code indicating operation success/failure.
+ *                          - HCSR04_RC_OK:             The measurement finished and the reading was accepted.
+ *                          - HCSR04_RC_REJECTED:       The measurement finished but the reading was dropped.
+ *                          - Otherwise the return code of hcsr04_end_measurement.
+ */
+hcsr04_rc_t hcsr04_filter_end_measurement(hcsr04_filter_t * filter, hcsr04_t * sensor);
+
+/**
+ * @brief   Get the median of the window, the mean of the middle two readings if it holds an even number.
+ * @param   filter          The filter.
+ * @return  uint32_t        The median in millimetres, Q16.16, HCSR04_DIST_NONE_MM_Q16 if empty or filter is NULL.
+ */
+uint32_t hcsr04_filter_get_median(const hcsr04_filter_t * filter);
+
+/**
+ * @brief   Get the mean of the window.
+ * @param   filter          The filter.
+ * @return  uint32_t        The mean in millimetres, Q16.16, HCSR04_DIST_NONE_MM_Q16 if empty or filter is NULL.
+ */
+uint32_t hcsr04_filter_get_mean(const hcsr04_filter_t * filter);
+
+/**
+ * @brief   Get the population variance of the window.
+ * @param   filter          The filter.
+ * @return  uint64_t        The variance in square millimetres, Q16.16, 0 if the window holds fewer than two readings
+ *                          or filter is NULL.
+ */
+uint64_t hcsr04_filter_get_variance(const hcsr04_filter_t * filter);
+
+#endif // HCSR04_FILTER_H
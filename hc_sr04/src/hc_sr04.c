@@ -1,19 +1,54 @@
 #include "hc_sr04.h"
 
-const float HCSR04_SPEED_OF_SOUND_CM_US = 0.0343;
-const float HCSR04_DIST_NONE = -1.0;
-const uint8_t HCSR04_RESET_TRIGGER_TIME_US = 2;
 const uint8_t HCSR04_TRIGGER_PULSE_WIDTH_US = 10;
 
+#if HCSR04_ENABLE_TEMPERATURE_COMPENSATION
+// Speed of sound in dry air, 331.3 m/s * sqrt(1 + T / 273.15), every HCSR04_TEMPERATURE_STEP_DC from HCSR04_TEMPERATURE_MIN_DC
+#define HCSR04_TEMPERATURE_MIN_DC   -200
+#define HCSR04_TEMPERATURE_STEP_DC  100
+#define HCSR04_TEMPERATURE_ENTRIES  8u
+
+static const uint32_t speed_of_sound_table_mm_s[HCSR04_TEMPERATURE_ENTRIES] = {
+    318941, 325179, 331300, 337310, 343215, 349019, 354729, 360349,
+};
+#endif
+
+// PIO echo capture program, counts down X once per HCSR04_PIO_CYCLES_PER_COUNT cycles while the echo pin is high:
+//  0: mov x, ~null     ; X = 0xFFFFFFFF
+//  1: wait 0 pin 0     ; skip the rest of a pulse already in progress, e.g. after a restart
+//  2: wait 1 pin 0     ; wait for the echo pulse to start
+//  3: jmp x-- 4        ; count
+//  4: jmp pin 3        ; until the echo pulse ends
+//  5: mov isr, ~x      ; ISR = number of counts
+//  6: push noblock     ; then wrap back to 0
+// Built with the SDK's instruction encoders, JMP targets are relative to the program and relocated when it is loaded
+#define ECHO_PROGRAM_LENGTH         7u
+#define ECHO_PROGRAM_WRAP_TARGET    0u
+#define ECHO_PROGRAM_WRAP           6u
+
+static uint16_t echo_program_instructions[ECHO_PROGRAM_LENGTH];
+static const pio_program_t echo_program = {
+    .instructions = echo_program_instructions,
+    .length = ECHO_PROGRAM_LENGTH,
+    .origin = -1,
+};
+
+// Where the echo program is loaded on each PIO, it is shared by every sensor using that PIO
+static bool is_echo_program_loaded[NUM_PIOS];
+static uint8_t echo_program_offsets[NUM_PIOS];
+
 /**
  * @brief   Helper function that sets the interfacing mechanism with HC-SR04 sensor to a default state.
  * @param   sensor          The HC-SR04 sensor struct, is assumed to be valid.
  */
 static inline void reset_sensor(hcsr04_t * sensor) {
     // Set initial values for other fields in hcsr04 struct
-    sensor->current_distance = HCSR04_DIST_NONE;
+    sensor->current_distance_mm_q16 = HCSR04_DIST_NONE_MM_Q16;
     sensor->echo_received = false;
     sensor->state = HCSR04_IDLE;
+    sensor->alarm_id = 0;
+    sensor->is_triggering = false;
+    sensor->timed_out = false;
 
     // Set up trigger pin as output and echo pin as input
     gpio_init(sensor->trigger_pin);
@@ -24,29 +59,78 @@ static inline void reset_sensor(hcsr04_t * sensor) {
 
 /**
  * @brief   Helper function that sets initial state on HC-SR04 before taking a measurement.
+ * @details The trigger pin is already low, it is only raised for the trigger pulse, so there is no need to wait here.
  * @param   sensor          The HC-SR04 sensor struct, is assumed to be valid.
  */
 static inline void prepare_for_measurement(hcsr04_t * sensor) {
     // Default initial value for distance indicates an error if it occurs 
-    sensor->current_distance = HCSR04_DIST_NONE;
+    sensor->current_distance_mm_q16 = HCSR04_DIST_NONE_MM_Q16;
     
-    // Clear echo received flag
+    // Clear echo received and timed out flags
     sensor->echo_received = false;
+    sensor->timed_out = false;
+}
+
+/**
+ * @brief   Helper function that ends the trigger pulse, then times out the echo, called from the alarm irq.
+ * @param   id              The alarm ID.
+ * @param   user_data       The HC-SR04 sensor struct.
+ * @return  int64_t         Microseconds after this alarm to fire again, 0 not to.
+ */
+static int64_t handle_alarm(alarm_id_t id, void * user_data) {
+    (void)id;
+    hcsr04_t * sensor = user_data;
+
+    // The same alarm ends the trigger pulse and is then rescheduled as the echo timeout
+    if(sensor->is_triggering) {
+        gpio_put(sensor->trigger_pin, 0);
+        sensor->is_triggering = false;
+        if(sensor->echo_timeout_us > 0) {
+            return sensor->echo_timeout_us;
+        }
+    }
+    else {
+        sensor->timed_out = true;
+    }
 
-    // Make sure trigger pin is low
-    gpio_put(sensor->trigger_pin, 0);
-    sleep_us(HCSR04_RESET_TRIGGER_TIME_US);
+    sensor->alarm_id = 0;
+    return 0;
 }
 
 /**
  * @brief   Helper function that sends a trigger pulse to the HC-SR04 sensor. 
  * @details The HC-SR04 should send a pulse back through the echo pin, which is used to measure distance.
+ *          Raises the trigger pin and sets an alarm to lower it, so it returns without waiting for the pulse to end.
  * @param   sensor          The HC-SR04 sensor struct, is assumed to be valid.
+ * @return  bool            true if the alarm was set, false if no alarm was free and the trigger pin was left low.
  */
-static inline void send_trigger_pulse(hcsr04_t * sensor) {
+static inline bool send_trigger_pulse(hcsr04_t * sensor) {
+    sensor->is_triggering = true;
     gpio_put(sensor->trigger_pin, 1);
-    sleep_us(HCSR04_TRIGGER_PULSE_WIDTH_US);
-    gpio_put(sensor->trigger_pin, 0);
+
+    alarm_id_t alarm_id = add_alarm_in_us(HCSR04_TRIGGER_PULSE_WIDTH_US, handle_alarm, sensor, false);
+    if(alarm_id <= 0) {
+        gpio_put(sensor->trigger_pin, 0);
+        sensor->is_triggering = false;
+        return false;
+    }
+    sensor->alarm_id = alarm_id;
+    return true;
+}
+
+/**
+ * @brief   Helper function that cancels the sensor's alarm, ending the trigger pulse if it is still going.
+ * @param   sensor          The HC-SR04 sensor struct, is assumed to be valid.
+ */
+static inline void cancel_sensor_alarm(hcsr04_t * sensor) {
+    if(sensor->alarm_id > 0) {
+        cancel_alarm(sensor->alarm_id);
+        sensor->alarm_id = 0;
+    }
+    if(sensor->is_triggering) {
+        gpio_put(sensor->trigger_pin, 0);
+        sensor->is_triggering = false;
+    }
 }
 
 /**
@@ -55,7 +139,53 @@ static inline void send_trigger_pulse(hcsr04_t * sensor) {
  */
 static inline void calculate_distance(hcsr04_t * sensor) {
     uint32_t duration = absolute_time_diff_us(sensor->start_time, sensor->end_time);
-    sensor->current_distance = ((float)duration * HCSR04_SPEED_OF_SOUND_CM_US) / 2.0f;
+    sensor->current_distance_mm_q16 = hcsr04_convert_pulse_width(sensor, duration);
+}
+
+/**
+ * @brief   Helper function that calculates the distance from the echo pulse width counted by the PIO echo capture program.
+ * @param   sensor          The HC-SR04 sensor struct, is assumed to be valid.
+ * @param   count           The number of counts the echo pulse lasted.
+ */
+static inline void calculate_pio_distance(hcsr04_t * sensor, uint32_t count) {
+    sensor->current_distance_mm_q16 = hcsr04_convert_pulse_width(sensor, count);
+}
+
+/**
+ * @brief   Helper function that works out the sensor's distance scale from its speed of sound and pulse width unit.
+ * @details The only division in the conversion, done when the speed of sound or the unit changes rather than per reading.
+ * @param   sensor          The HC-SR04 sensor struct, is assumed to be valid.
+ */
+static inline void update_distance_scale(hcsr04_t * sensor) {
+    // Pulse width units per second: microseconds, or PIO counts of HCSR04_PIO_CYCLES_PER_COUNT system clock cycles
+    uint64_t units_per_s = sensor->pio != NULL ? clock_get_hz(clk_sys) / HCSR04_PIO_CYCLES_PER_COUNT : 1000000u;
+    sensor->distance_scale = (uint32_t)(((uint64_t)sensor->speed_of_sound_mm_s << 32) / (2u * units_per_s));
+}
+
+/**
+ * @brief   Helper function that encodes the PIO echo capture program.
+ */
+static inline void build_echo_program(void) {
+    echo_program_instructions[0] = (uint16_t)pio_encode_mov_not(pio_x, pio_null);
+    echo_program_instructions[1] = (uint16_t)pio_encode_wait_pin(false, 0);
+    echo_program_instructions[2] = (uint16_t)pio_encode_wait_pin(true, 0);
+    echo_program_instructions[3] = (uint16_t)pio_encode_jmp_x_dec(4);
+    echo_program_instructions[4] = (uint16_t)pio_encode_jmp_pin(3);
+    echo_program_instructions[5] = (uint16_t)pio_encode_mov_not(pio_isr, pio_x);
+    echo_program_instructions[6] = (uint16_t)pio_encode_push(false, false);
+}
+
+/**
+ * @brief   Helper function that restarts the sensor's PIO state machine at the top of the echo program with empty FIFOs.
+ * @details Discards a count in progress, e.g. from an echo pulse that never ended; the rest of that pulse is not counted.
+ * @param   sensor          The HC-SR04 sensor struct, is assumed to be valid and to have PIO capture enabled.
+ */
+static inline void restart_pio_capture(hcsr04_t * sensor) {
+    pio_sm_set_enabled(sensor->pio, sensor->pio_sm, false);
+    pio_sm_clear_fifos(sensor->pio, sensor->pio_sm);
+    pio_sm_restart(sensor->pio, sensor->pio_sm);
+    pio_sm_exec(sensor->pio, sensor->pio_sm, pio_encode_jmp(echo_program_offsets[pio_get_index(sensor->pio)]));
+    pio_sm_set_enabled(sensor->pio, sensor->pio_sm, true);
 }
 
 /**
@@ -76,6 +206,10 @@ hcsr04_rc_t hcsr04_init(hcsr04_t * sensor, uint8_t trigger_pin, uint8_t echo_pin
     // Register data provided by args into hcsr04 struct
     sensor->trigger_pin = trigger_pin;
     sensor->echo_pin = echo_pin;
+    sensor->pio = NULL;
+    sensor->echo_timeout_us = HCSR04_DEFAULT_ECHO_TIMEOUT_US;
+    sensor->speed_of_sound_mm_s = HCSR04_DEFAULT_SPEED_OF_SOUND_MM_S;
+    update_distance_scale(sensor);
 
     // Set sensor interfacing values to default state
     reset_sensor(sensor);
@@ -99,21 +233,152 @@ hcsr04_rc_t hcsr04_reset(hcsr04_t * sensor) {
     // Disable any active interrupts on the echo pin
     gpio_set_irq_enabled(sensor->echo_pin, GPIO_IRQ_EDGE_RISE | GPIO_IRQ_EDGE_FALL, false);
 
+    // Stop the alarm before clearing its ID, so it can't fire on the reset sensor
+    cancel_sensor_alarm(sensor);
+
     // Reset sensor interfacing values to default state
     reset_sensor(sensor);
 
+    // Drop any count in progress on the PIO
+    if(sensor->pio != NULL) {
+        restart_pio_capture(sensor);
+    }
+
+    return HCSR04_RC_OK;
+}
+
+/**
+ * @brief   Set how long after the trigger pulse a measurement waits for its echo before timing out.
+ * @param   sensor          HC-SR04 sensor struct.
+ * @param   timeout_us      The timeout, 0 to wait forever. Defaults to HCSR04_DEFAULT_ECHO_TIMEOUT_US.
+ * @return  hcsr04_rc_t     Return code indicating operation success/failure.
+ *                          - HCSR04_RC_OK:             Operation successful.
+ *                          - HCSR04_RC_BAD_ARG:        An invalid argument was provided.
+ *                          - HCSR04_RC_BUSY:           The sensor is in the middle of a measurement.
+ */
+hcsr04_rc_t hcsr04_set_echo_timeout(hcsr04_t * sensor, uint32_t timeout_us) {
+    if(sensor == NULL) {
+        return HCSR04_RC_BAD_ARG;
+    }
+
+    if(sensor->state != HCSR04_IDLE) {
+        return HCSR04_RC_BUSY;
+    }
+
+    sensor->echo_timeout_us = timeout_us;
+
+    return HCSR04_RC_OK;
+}
+
+/**
+ * @brief   Time the echo pulse with a PIO state machine instead of the echo pin IRQ handlers.
+ * @details Claims a state machine on pio and loads the echo capture program, once per PIO, so several sensors can share
+ *          it. Once enabled, hcsr04_on_echo_pin_rise/fall are not needed and hcsr04_end_measurement reads the pulse width
+ *          from the state machine's RX FIFO.
+ * @param   sensor          HC-SR04 sensor struct.
+ * @param   pio             The PIO instance to run the echo capture on, pio0 or pio1.
+ * @return  hcsr04_rc_t     Return code indicating operation success/failure.
+ *                          - HCSR04_RC_OK:             Operation successful.
+ *                          - HCSR04_RC_BAD_ARG:        An invalid argument was provided, or PIO capture is already enabled.
+ *                          - HCSR04_RC_BUSY:           The sensor is in the middle of a measurement.
+ *                          - HCSR04_RC_ERROR_PIO:      The PIO has no free state machine or no room for the program.
+ */
+hcsr04_rc_t hcsr04_enable_pio_capture(hcsr04_t * sensor, PIO pio) {
+    if(sensor == NULL || pio == NULL || sensor->pio != NULL) {
+        return HCSR04_RC_BAD_ARG;
+    }
+
+    if(sensor->state != HCSR04_IDLE) {
+        return HCSR04_RC_BUSY;
+    }
+
+    // Load the echo program the first time a sensor uses this PIO
+    uint pio_index = pio_get_index(pio);
+    if(!is_echo_program_loaded[pio_index]) {
+        build_echo_program();
+        if(!pio_can_add_program(pio, &echo_program)) {
+            return HCSR04_RC_ERROR_PIO;
+        }
+        echo_program_offsets[pio_index] = (uint8_t)pio_add_program(pio, &echo_program);
+        is_echo_program_loaded[pio_index] = true;
+    }
+
+    int sm = pio_claim_unused_sm(pio, false);
+    if(sm < 0) {
+        return HCSR04_RC_ERROR_PIO;
+    }
+
+    // The echo pin is both the input the program waits on and the pin its loop jumps on; RX only, so join the FIFOs
+    uint offset = echo_program_offsets[pio_index];
+    pio_sm_config config = pio_get_default_sm_config();
+    sm_config_set_wrap(&config, offset + ECHO_PROGRAM_WRAP_TARGET, offset + ECHO_PROGRAM_WRAP);
+    sm_config_set_in_pins(&config, sensor->echo_pin);
+    sm_config_set_jmp_pin(&config, sensor->echo_pin);
+    sm_config_set_fifo_join(&config, PIO_FIFO_JOIN_RX);
+    sm_config_set_clkdiv_int_frac(&config, 1, 0);
+    pio_sm_set_consecutive_pindirs(pio, (uint)sm, sensor->echo_pin, 1, false);
+    pio_sm_init(pio, (uint)sm, offset, &config);
+    pio_sm_set_enabled(pio, (uint)sm, true);
+
+    sensor->pio = pio;
+    sensor->pio_sm = (uint8_t)sm;
+
+    // The pulse width is now in PIO counts
+    update_distance_scale(sensor);
+
+    return HCSR04_RC_OK;
+}
+
+#if HCSR04_ENABLE_TEMPERATURE_COMPENSATION
+/**
+ * @brief   Set the air temperature, looking up the speed of sound for it and rescaling the sensor's distances.
+ * @details Interpolates linearly between table entries every 10 C from -20 C to 50 C, clamping outside that range.
+ * @param   sensor          HC-SR04 sensor struct.
+ * @param   temperature_dc  The air temperature in tenths of a degree Celsius.
+ * @return  hcsr04_rc_t     Return code indicating operation success/failure.
+ *                          - HCSR04_RC_OK:             Operation successful.
+ *                          - HCSR04_RC_BAD_ARG:        An invalid argument was provided.
+ *                          - HCSR04_RC_BUSY:           The sensor is in the middle of a measurement.
+ */
+hcsr04_rc_t hcsr04_set_temperature(hcsr04_t * sensor, int16_t temperature_dc) {
+    if(sensor == NULL) {
+        return HCSR04_RC_BAD_ARG;
+    }
+
+    if(sensor->state != HCSR04_IDLE) {
+        return HCSR04_RC_BUSY;
+    }
+
+    // Clamp to the table, the last entry is only reached exactly
+    int32_t offset = (int32_t)temperature_dc - HCSR04_TEMPERATURE_MIN_DC;
+    int32_t max_offset = (int32_t)(HCSR04_TEMPERATURE_ENTRIES - 1) * HCSR04_TEMPERATURE_STEP_DC;
+    offset = offset < 0 ? 0 : (offset > max_offset ? max_offset : offset);
+
+    uint32_t index = (uint32_t)(offset / HCSR04_TEMPERATURE_STEP_DC);
+    uint32_t fraction = (uint32_t)(offset % HCSR04_TEMPERATURE_STEP_DC);
+    uint32_t speed = speed_of_sound_table_mm_s[index];
+    if(fraction > 0) {
+        speed += (speed_of_sound_table_mm_s[index + 1] - speed) * fraction / HCSR04_TEMPERATURE_STEP_DC;
+    }
+
+    sensor->speed_of_sound_mm_s = speed;
+    update_distance_scale(sensor);
+
     return HCSR04_RC_OK;
 }
+#endif
 
 /**
  * @brief   Start measuring distance using HC-SR04 by sending trigger pulse through trigger pin.
  * @details Receives echo pulse through echo pin, width of echo pulse is used to determine distance.
  *          Transaction is finished by calling hcsr04_end_measurement after echo pulse is received. 
+ *          Returns once the trigger pin is raised; an alarm lowers it after the pulse width and then times out the echo.
  * @param   sensor          HC-SR04 sensor struct.
  * @return  hcsr04_rc_t     Return code indicating operation success/failure.
  *                          - HCSR04_RC_OK:             Operation successful.
  *                          - HCSR04_RC_BAD_ARG:        An invalid argument was provided.
  *                          - HCSR04_RC_BUSY:           The sensor is in the middle of another measurement.  
+ *                          - HCSR04_RC_ERROR_ALARM:    No alarm was free to time the trigger pulse, the measurement was not started.
  */
 hcsr04_rc_t hcsr04_start_measurement(hcsr04_t * sensor) {
     if(sensor == NULL) {
@@ -130,8 +395,16 @@ hcsr04_rc_t hcsr04_start_measurement(hcsr04_t * sensor) {
     // Set sensor values and pins to an initial state before starting a measurement
     prepare_for_measurement(sensor);
 
+    // Discard a count left over from an echo nobody collected
+    if(sensor->pio != NULL) {
+        pio_sm_clear_fifos(sensor->pio, sensor->pio_sm);
+    }
+
     // Send pulse to trigger pin to start measurement
-    send_trigger_pulse(sensor);
+    if(!send_trigger_pulse(sensor)) {
+        sensor->state = HCSR04_IDLE;
+        return HCSR04_RC_ERROR_ALARM;
+    }
 
     return HCSR04_RC_OK;
 }
@@ -179,28 +452,78 @@ hcsr04_rc_t hcsr04_on_echo_pin_fall(hcsr04_t * sensor) {
 
 /**
  * @brief   Finish HC-SR04 distance measurement transaction by calculating distance from received echo pulse width.
- * @details Echo pulse must be received using on_echo_pin_rise and on_echo_pin_fall functions, ideally within a GPIO IRQ.
+ * @details Echo pulse must be received using on_echo_pin_rise and on_echo_pin_fall functions, ideally within a GPIO IRQ,
+ *          or by the PIO once hcsr04_enable_pio_capture has been called.
  *          The raw value of the pulse width is a non-atomic datatype (uint64_t), so it's easier to just calculate and use the distance.
  * @param   sensor          HC-SR04 sensor struct.
  * @return  hcsr04_rc_t     Return code indicating operation success/failure.
  *                          - HCSR04_RC_OK:             Operation successful.
  *                          - HCSR04_RC_BAD_ARG:        An invalid argument was provided.
  *                          - HCSR04_RC_NO_ECHO:        The echo pulse has not been received yet.
+ *                          - HCSR04_RC_TIMEOUT:        No echo was received before the echo timeout, the sensor is idle again.
  */
 hcsr04_rc_t hcsr04_end_measurement(hcsr04_t * sensor) {
     if(sensor == NULL) {
         return HCSR04_RC_BAD_ARG;
     }
 
-    if(!sensor->echo_received) {
-        return HCSR04_RC_NO_ECHO;
+    // The PIO pushes the pulse width once the echo pulse has ended
+    bool is_echo_ready = sensor->pio != NULL ? !pio_sm_is_rx_fifo_empty(sensor->pio, sensor->pio_sm) : sensor->echo_received;
+
+    // An echo that ended before the timeout is still used if the alarm fired before this was called
+    if(!is_echo_ready) {
+        if(!sensor->timed_out) {
+            return HCSR04_RC_NO_ECHO;
+        }
+
+        // Drop a PIO count stuck waiting for an echo that never came
+        if(sensor->pio != NULL) {
+            restart_pio_capture(sensor);
+        }
+        sensor->state = HCSR04_IDLE;
+        return HCSR04_RC_TIMEOUT;
     }
 
-    // Calculate distance from duration and store in sensor struct
-    calculate_distance(sensor);
+    // The echo timeout is no longer needed
+    cancel_sensor_alarm(sensor);
+
+    if(sensor->pio != NULL) {
+        calculate_pio_distance(sensor, pio_sm_get(sensor->pio, sensor->pio_sm));
+        sensor->echo_received = true;
+    }
+    else {
+        // Calculate distance from duration and store in sensor struct
+        calculate_distance(sensor);
+    }
 
     // Set sensor state to idle now that measurement is complete
     sensor->state = HCSR04_IDLE;
 
     return HCSR04_RC_OK;
 }
+
+/**
+ * @brief   Convert an echo pulse width to a distance with the sensor's scale, as hcsr04_end_measurement does.
+ * @param   sensor          HC-SR04 sensor struct, is assumed to be valid.
+ * @param   pulse_width     The echo pulse width, in microseconds, or in PIO counts once PIO capture is enabled.
+ * @return  uint32_t        The distance in millimetres, Q16.16, saturating just below HCSR04_DIST_NONE_MM_Q16.
+ */
+uint32_t hcsr04_convert_pulse_width(const hcsr04_t * sensor, uint32_t pulse_width) {
+    // Q32 scale to Q16 distance, rounded to nearest
+    uint64_t distance = ((uint64_t)pulse_width * sensor->distance_scale + (1u << 15)) >> 16;
+    return distance < HCSR04_DIST_NONE_MM_Q16 ? (uint32_t)distance : HCSR04_DIST_NONE_MM_Q16 - 1u;
+}
+
+/**
+ * @brief   Get the last measured distance in centimetres, a float wrapper over current_distance_mm_q16.
+ * @param   sensor          HC-SR04 sensor struct.
+ * @return  float           The distance in centimetres, HCSR04_DIST_NONE if there is none or the sensor is NULL.
+ */
+float hcsr04_get_distance_cm(const hcsr04_t * sensor) {
+    if(sensor == NULL || sensor->current_distance_mm_q16 == HCSR04_DIST_NONE_MM_Q16) {
+        return HCSR04_DIST_NONE;
+    }
+
+    // Q16.16 millimetres to centimetres
+    return (float)sensor->current_distance_mm_q16 * (1.0f / (65536.0f * 10.0f));
+}
@@ -0,0 +1,187 @@
+#include "hc_sr04_adaptive.h"
+
+/**
+ * @brief   Helper function that clamps a period to the configured range and the echo's round trip.
+ * @param   adaptive        The adaptive scheduler, is assumed to be valid.
+ * @param   period_us       The period wanted.
+ * @param   distance_mm     The last distance, to bound the period by its echo's round trip.
+ * @return  uint32_t        The period to use.
+ */
+static inline uint32_t clamp_period(hcsr04_adaptive_t * adaptive, uint64_t period_us, uint32_t distance_mm) {
+    uint64_t round_trip_us = (uint64_t)distance_mm * 2000000u / adaptive->sensor->speed_of_sound_mm_s + HCSR04_ADAPTIVE_ECHO_GUARD_US;
+    uint64_t min_period_us = round_trip_us > adaptive->min_period_us ? round_trip_us : adaptive->min_period_us;
+
+    period_us = period_us > adaptive->max_period_us ? adaptive->max_period_us : period_us;
+    period_us = period_us < min_period_us ? min_period_us : period_us;
+    return (uint32_t)period_us;
+}
+
+/**
+ * @brief   Helper function that updates the speed from a new reading and chooses the next period from both.
+ * @param   adaptive        The adaptive scheduler, is assumed to be valid.
+ * @param   distance        The reading in millimetres, Q16.16.
+ * @param   time_us         The time of the reading.
+ */
+static inline void update_period(hcsr04_adaptive_t * adaptive, uint32_t distance, uint32_t time_us) {
+    uint32_t elapsed_us = time_us - adaptive->last_reading_time_us;
+    if(adaptive->has_distance && elapsed_us > 0) {
+        // Exponential moving average, 1/4 of each new speed
+        int64_t change = (int64_t)distance - (int64_t)adaptive->last_distance_mm_q16;
+        int32_t speed = (int32_t)(change * 1000000 / 65536 / (int64_t)elapsed_us);
+        adaptive->speed_mm_s += (speed - adaptive->speed_mm_s) / 4;
+    }
+    adaptive->has_distance = true;
+    adaptive->last_distance_mm_q16 = distance;
+    adaptive->last_reading_time_us = time_us;
+
+    uint32_t speed = adaptive->speed_mm_s < 0 ? (uint32_t)-adaptive->speed_mm_s : (uint32_t)adaptive->speed_mm_s;
+    speed = speed < adaptive->min_speed_mm_s ? adaptive->min_speed_mm_s : speed;
+
+    // distance * max_change_percent / 100 mm at speed mm/s, in microseconds
+    uint32_t distance_mm = distance >> 16;
+    uint64_t period_us = (uint64_t)distance_mm * adaptive->max_change_percent * 10000u / speed;
+    adaptive->period_us = clamp_period(adaptive, period_us, distance_mm);
+}
+
+/**
+ * @brief   Initialize an adaptive scheduler for a sensor, starting at max_period_us until the first reading.
+ * @param   adaptive            The adaptive scheduler.
+ * @param   sensor              The HC-SR04 sensor struct, initialized with hcsr04_init.
+ * @param   min_period_us       The shortest time between triggers.
+ * @param   max_period_us       The longest time between triggers, at least min_period_us.
+ * @param   max_change_percent  How much the distance may change between readings, as a percentage of itself. Cannot be 0.
+ * @param   min_speed_mm_s      The speed assumed for a scene that isn't moving, so it is still measured. Cannot be 0.
+ * @return  hcsr04_rc_t         Return code indicating operation success/failure.
+ *                              - HCSR04_RC_OK:             Operation successful.
+ *                              - HCSR04_RC_BAD_ARG:        An invalid argument was provided.
+ */
+hcsr04_rc_t hcsr04_adaptive_init(hcsr04_adaptive_t * adaptive, hcsr04_t * sensor, uint32_t min_period_us, uint32_t max_period_us,
+                                 uint8_t max_change_percent, uint32_t min_speed_mm_s) {
+    if(adaptive == NULL || sensor == NULL || min_period_us > max_period_us || max_change_percent == 0 || min_speed_mm_s == 0) {
+        return HCSR04_RC_BAD_ARG;
+    }
+
+    adaptive->sensor = sensor;
+    adaptive->min_period_us = min_period_us;
+    adaptive->max_period_us = max_period_us;
+    adaptive->max_change_percent = max_change_percent;
+    adaptive->min_speed_mm_s = min_speed_mm_s;
+
+    adaptive->has_distance = false;
+    adaptive->last_distance_mm_q16 = HCSR04_DIST_NONE_MM_Q16;
+    adaptive->last_reading_time_us = 0;
+    adaptive->speed_mm_s = 0;
+
+    adaptive->period_us = max_period_us;
+    adaptive->trigger_time_us = 0;
+    adaptive->has_triggered = false;
+
+    adaptive->start_time_us = time_us_64();
+    adaptive->readings = 0;
+    adaptive->timeouts = 0;
+
+    return HCSR04_RC_OK;
+}
+
+/**
+ * @brief   Finish the sensor's measurement if it is done, and choose the period until the next trigger from it.
+ * @param   adaptive            The adaptive scheduler.
+ * @return  hcsr04_rc_t         Return code indicating operation success/failure.
+ *                              - HCSR04_RC_OK:             A reading was collected, the distance is in the sensor.
+ *                              - HCSR04_RC_BAD_ARG:        An invalid argument was provided.
+ *                              - HCSR04_RC_NO_ECHO:        No measurement has finished.
+ *                              - HCSR04_RC_TIMEOUT:        The measurement timed out.
+ */
+hcsr04_rc_t hcsr04_adaptive_collect(hcsr04_adaptive_t * adaptive) {
+    if(adaptive == NULL) {
+        return HCSR04_RC_BAD_ARG;
+    }
+
+    // Nothing to collect from an idle sensor
+    if(adaptive->sensor->state != HCSR04_BUSY) {
+        return HCSR04_RC_NO_ECHO;
+    }
+
+    hcsr04_rc_t rc = hcsr04_end_measurement(adaptive->sensor);
+    if(rc == HCSR04_RC_OK) {
+        adaptive->readings++;
+        update_period(adaptive, adaptive->sensor->current_distance_mm_q16, time_us_32());
+    }
+    else if(rc == HCSR04_RC_TIMEOUT) {
+        // Nothing in range, so there is no speed to track either
+        adaptive->timeouts++;
+        adaptive->has_distance = false;
+        adaptive->speed_mm_s = 0;
+        adaptive->period_us = adaptive->max_period_us;
+    }
+
+    return rc;
+}
+
+/**
+ * @brief   Trigger the sensor now, whether or not the period has passed.
+ * @param   adaptive            The adaptive scheduler.
+ * @return  hcsr04_rc_t         Return code indicating operation success/failure.
+ *                              - HCSR04_RC_OK:             Operation successful.
+ *                              - Otherwise the return code of hcsr04_start_measurement.
+ */
+hcsr04_rc_t hcsr04_adaptive_trigger(hcsr04_adaptive_t * adaptive) {
+    if(adaptive == NULL) {
+        return HCSR04_RC_BAD_ARG;
+    }
+
+    hcsr04_rc_t rc = hcsr04_start_measurement(adaptive->sensor);
+    if(rc == HCSR04_RC_OK) {
+        adaptive->trigger_time_us = time_us_32();
+        adaptive->has_triggered = true;
+    }
+
+    return rc;
+}
+
+/**
+ * @brief   Collect a finished measurement, and trigger the sensor once the period since the last trigger has passed.
+ * @details Call often, from the main loop or a periodic task.
+ * @param   adaptive            The adaptive scheduler.
+ * @return  hcsr04_rc_t         Return code indicating operation success/failure.
+ *                              - The return code of hcsr04_adaptive_collect.
+ */
+hcsr04_rc_t hcsr04_adaptive_poll(hcsr04_adaptive_t * adaptive) {
+    hcsr04_rc_t rc = hcsr04_adaptive_collect(adaptive);
+    if(rc == HCSR04_RC_BAD_ARG) {
+        return rc;
+    }
+
+    if(adaptive->sensor->state == HCSR04_IDLE &&
+       (!adaptive->has_triggered || time_us_32() - adaptive->trigger_time_us >= adaptive->period_us)) {
+        hcsr04_adaptive_trigger(adaptive);
+    }
+
+    return rc;
+}
+
+/**
+ * @brief   Get the period chosen after the last measurement, the time from its trigger to the next one.
+ * @param   adaptive            The adaptive scheduler.
+ * @return  uint32_t            The period in microseconds, 0 if adaptive is NULL.
+ */
+uint32_t hcsr04_adaptive_get_period_us(const hcsr04_adaptive_t * adaptive) {
+    return adaptive != NULL ? adaptive->period_us : 0;
+}
+
+/**
+ * @brief   Get the rate measurements have finished at since the scheduler was initialized, timeouts included.
+ * @param   adaptive            The adaptive scheduler.
+ * @return  float               Measurements per second, 0 if adaptive is NULL.
+ */
+float hcsr04_adaptive_get_rate(const hcsr04_adaptive_t * adaptive) {
+    if(adaptive == NULL) {
+        return 0.0f;
+    }
+
+    uint64_t elapsed_us = time_us_64() - adaptive->start_time_us;
+    if(elapsed_us == 0) {
+        return 0.0f;
+    }
+    return (float)(adaptive->readings + adaptive->timeouts) * 1000000.0f / (float)elapsed_us;
+}
@@ -0,0 +1,211 @@
+#include "hc_sr04_array.h"
+
+#include <string.h>
+
+/**
+ * @brief   Helper function that enables a sensor's echo pin edge interrupts, unless it uses PIO capture.
+ * @param   sensor          The HC-SR04 sensor struct, is assumed to be valid.
+ */
+static inline void enable_echo_irq(hcsr04_t * sensor) {
+    if(sensor->pio == NULL) {
+        gpio_set_irq_enabled(sensor->echo_pin, GPIO_IRQ_EDGE_RISE | GPIO_IRQ_EDGE_FALL, true);
+    }
+}
+
+/**
+ * @brief   Helper function that finishes a group's measurement if its echo was received, or abandons it if it timed out.
+ * @details The sensor's own echo timeout alarm times the measurement out, so the sensor is idle again either way.
+ * @param   array           The sensor array, is assumed to be valid.
+ * @param   group           The group, is assumed to have a measurement in progress.
+ */
+static inline void collect_measurement(hcsr04_array_t * array, uint8_t group) {
+    uint8_t index = array->group_busy[group];
+    hcsr04_array_entry_t * entry = &array->entries[index];
+
+    hcsr04_rc_t rc = hcsr04_end_measurement(entry->sensor);
+    if(rc == HCSR04_RC_OK) {
+        entry->readings++;
+        array->group_busy[group] = HCSR04_ARRAY_NO_SENSOR;
+        if(array->callback != NULL) {
+            array->callback(index, entry->sensor, array->context);
+        }
+    }
+    else if(rc == HCSR04_RC_TIMEOUT) {
+        entry->timeouts++;
+        array->group_busy[group] = HCSR04_ARRAY_NO_SENSOR;
+    }
+}
+
+/**
+ * @brief   Helper function that triggers the next sensor of a group, round robin.
+ * @param   array           The sensor array, is assumed to be valid.
+ * @param   group           The group, is assumed to have no measurement in progress.
+ * @param   now             The current time in microseconds.
+ */
+static inline void trigger_next(hcsr04_array_t * array, uint8_t group, uint32_t now) {
+    for(uint8_t i = 0; i < array->num_sensors; i++) {
+        uint8_t index = (array->group_next[group] + i) % array->num_sensors;
+        hcsr04_array_entry_t * entry = &array->entries[index];
+        if(entry->group != group || hcsr04_start_measurement(entry->sensor) != HCSR04_RC_OK) {
+            continue;
+        }
+
+        entry->trigger_time_us = now;
+        array->group_busy[group] = index;
+        array->group_next[group] = (index + 1) % array->num_sensors;
+        array->group_trigger_time_us[group] = now;
+        array->group_has_triggered[group] = true;
+        return;
+    }
+}
+
+/**
+ * @brief   Initialize an empty sensor array.
+ * @param   array               The sensor array.
+ * @param   group_spacing_us    The least time between triggering two sensors in the same group.
+ * @param   timeout_us          The most time after its trigger pulse to wait for a sensor's echo before abandoning the measurement. Cannot be 0.
+ * @param   callback            Called for each completed measurement, can be NULL.
+ * @param   context             Passed to callback.
+ * @return  hcsr04_rc_t         Return code indicating operation success/failure.
+ *                              - HCSR04_RC_OK:             Operation successful.
+ *                              - HCSR04_RC_BAD_ARG:        An invalid argument was provided.
+ */
+hcsr04_rc_t hcsr04_array_init(hcsr04_array_t * array, uint32_t group_spacing_us, uint32_t timeout_us, hcsr04_array_callback_t callback, void * context) {
+    if(array == NULL || timeout_us == 0) {
+        return HCSR04_RC_BAD_ARG;
+    }
+
+    array->num_sensors = 0;
+    memset(array->sensor_by_pin, HCSR04_ARRAY_NO_SENSOR, sizeof(array->sensor_by_pin));
+    for(uint8_t group = 0; group < HCSR04_ARRAY_MAX_SENSORS; group++) {
+        array->group_next[group] = 0;
+        array->group_busy[group] = HCSR04_ARRAY_NO_SENSOR;
+        array->group_has_triggered[group] = false;
+    }
+
+    array->group_spacing_us = group_spacing_us;
+    array->timeout_us = timeout_us;
+    array->start_time_us = time_us_64();
+    array->callback = callback;
+    array->context = context;
+
+    return HCSR04_RC_OK;
+}
+
+/**
+ * @brief   Add an initialized sensor to the array.
+ * @details Sets the sensor's echo timeout to the array's timeout_us and enables the echo pin's edge interrupts unless the
+ *          sensor uses PIO capture.
+ * @param   array               The sensor array.
+ * @param   sensor              The HC-SR04 sensor struct, initialized with hcsr04_init.
+ * @param   group               The group of sensors it can hear, less than HCSR04_ARRAY_MAX_SENSORS.
+ * @param   index               The sensor's index in the array (returned by reference), can be NULL.
+ * @return  hcsr04_rc_t         Return code indicating operation success/failure.
+ *                              - HCSR04_RC_OK:             Operation successful.
+ *                              - HCSR04_RC_BAD_ARG:        An invalid argument was provided, the array is full or the echo pin is already used.
+ *                              - HCSR04_RC_BUSY:           The sensor is in the middle of a measurement.
+ */
+hcsr04_rc_t hcsr04_array_add(hcsr04_array_t * array, hcsr04_t * sensor, uint8_t group, uint8_t * index) {
+    if(array == NULL || sensor == NULL || group >= HCSR04_ARRAY_MAX_SENSORS || array->num_sensors == HCSR04_ARRAY_MAX_SENSORS ||
+       sensor->echo_pin >= NUM_BANK0_GPIOS || array->sensor_by_pin[sensor->echo_pin] != HCSR04_ARRAY_NO_SENSOR) {
+        return HCSR04_RC_BAD_ARG;
+    }
+
+    hcsr04_rc_t rc = hcsr04_set_echo_timeout(sensor, array->timeout_us);
+    if(rc != HCSR04_RC_OK) {
+        return rc;
+    }
+
+    uint8_t new_index = array->num_sensors;
+    hcsr04_array_entry_t * entry = &array->entries[new_index];
+    entry->sensor = sensor;
+    entry->group = group;
+    entry->trigger_time_us = 0;
+    entry->readings = 0;
+    entry->timeouts = 0;
+
+    // Publish the entry before its pin, an edge may arrive as soon as the interrupt is enabled
+    array->num_sensors++;
+    array->sensor_by_pin[sensor->echo_pin] = new_index;
+    enable_echo_irq(sensor);
+
+    if(index != NULL) {
+        *index = new_index;
+    }
+
+    return HCSR04_RC_OK;
+}
+
+/**
+ * @brief   Pass an echo pin edge to the sensor on that pin.
+ * @details Call from the application's GPIO callback. Runs in constant time whatever the number of sensors.
+ * @param   array               The sensor array.
+ * @param   gpio                The pin the edge was on.
+ * @param   events              The GPIO_IRQ_EDGE_RISE/FALL events.
+ * @return  hcsr04_rc_t         Return code indicating operation success/failure.
+ *                              - HCSR04_RC_OK:             Operation successful.
+ *                              - HCSR04_RC_BAD_ARG:        An invalid argument was provided, or no sensor's echo pin is gpio.
+ */
+hcsr04_rc_t hcsr04_array_handle_echo_edge(hcsr04_array_t * array, uint gpio, uint32_t events) {
+    if(array == NULL || gpio >= NUM_BANK0_GPIOS || array->sensor_by_pin[gpio] == HCSR04_ARRAY_NO_SENSOR) {
+        return HCSR04_RC_BAD_ARG;
+    }
+
+    hcsr04_t * sensor = array->entries[array->sensor_by_pin[gpio]].sensor;
+    if(events & GPIO_IRQ_EDGE_RISE) {
+        hcsr04_on_echo_pin_rise(sensor);
+    }
+    if(events & GPIO_IRQ_EDGE_FALL) {
+        hcsr04_on_echo_pin_fall(sensor);
+    }
+
+    return HCSR04_RC_OK;
+}
+
+/**
+ * @brief   Collect finished measurements, abandon timed out ones and trigger the next sensor of every group that is ready.
+ * @details Call often, at least every group_spacing_us, from the main loop or a periodic task. Never blocks, the trigger
+ *          pulses are ended by alarms.
+ * @param   array               The sensor array.
+ * @return  hcsr04_rc_t         Return code indicating operation success/failure.
+ *                              - HCSR04_RC_OK:             Operation successful.
+ *                              - HCSR04_RC_BAD_ARG:        An invalid argument was provided.
+ */
+hcsr04_rc_t hcsr04_array_poll(hcsr04_array_t * array) {
+    if(array == NULL) {
+        return HCSR04_RC_BAD_ARG;
+    }
+
+    for(uint8_t group = 0; group < HCSR04_ARRAY_MAX_SENSORS; group++) {
+        uint32_t now = time_us_32();
+        if(array->group_busy[group] != HCSR04_ARRAY_NO_SENSOR) {
+            collect_measurement(array, group);
+        }
+
+        // A group only pings once its last ping has been heard or given up on, and has had time to die down
+        if(array->group_busy[group] == HCSR04_ARRAY_NO_SENSOR &&
+           (!array->group_has_triggered[group] || now - array->group_trigger_time_us[group] >= array->group_spacing_us)) {
+            trigger_next(array, group, now);
+        }
+    }
+
+    return HCSR04_RC_OK;
+}
+
+/**
+ * @brief   Get the rate a sensor has completed measurements at since the array was initialized.
+ * @param   array               The sensor array.
+ * @param   index               The sensor's index in the array.
+ * @return  float               Readings per second, 0 if the arguments are invalid.
+ */
+float hcsr04_array_get_rate(hcsr04_array_t * array, uint8_t index) {
+    if(array == NULL || index >= array->num_sensors) {
+        return 0.0f;
+    }
+
+    uint64_t elapsed_us = time_us_64() - array->start_time_us;
+    if(elapsed_us == 0) {
+        return 0.0f;
+    }
+    return (float)array->entries[index].readings * 1000000.0f / (float)elapsed_us;
+}
@@ -0,0 +1,335 @@
+#include "hc_sr04_filter.h"
+
+// The heaps are stored around the median at position 0: positions -1, -2, ... are the max-heap of the lower half, with
+// its root at -1 and the children of p at 2p and 2p + 1 (2p - 1 on the negative side), and positions 1, 2, ... are the
+// min-heap of the upper half, rooted at 1. C's division towards zero makes p / 2 the parent of p on both sides.
+
+/**
+ * @brief   Helper function that gets the slot stored at a heap position.
+ * @param   filter          The filter, is assumed to be valid.
+ * @param   position        The heap position, -window / 2 to (window - 1) / 2.
+ * @return  uint8_t *       The heap entry, holding the window slot at that position.
+ */
+static inline uint8_t * heap_slot(hcsr04_filter_t * filter, int32_t position) {
+    return &filter->heap_slots[position + filter->window / 2];
+}
+
+/**
+ * @brief   Helper function that gets the reading at a heap position.
+ * @param   filter          The filter, is assumed to be valid.
+ * @param   position        The heap position.
+ * @return  uint32_t        The reading.
+ */
+static inline uint32_t heap_value(hcsr04_filter_t * filter, int32_t position) {
+    return filter->values[*heap_slot(filter, position)];
+}
+
+/**
+ * @brief   Helper function that swaps the readings at two heap positions if the first is the smaller.
+ * @param   filter          The filter, is assumed to be valid.
+ * @param   lower           The position that should hold the smaller reading.
+ * @param   upper           The position that should hold the larger reading.
+ * @return  bool            true if they were swapped, false if already in order.
+ */
+static inline bool order_positions(hcsr04_filter_t * filter, int32_t lower, int32_t upper) {
+    if(heap_value(filter, upper) >= heap_value(filter, lower)) {
+        return false;
+    }
+
+    uint8_t * lower_slot = heap_slot(filter, lower);
+    uint8_t * upper_slot = heap_slot(filter, upper);
+    uint8_t slot = *lower_slot;
+    *lower_slot = *upper_slot;
+    *upper_slot = slot;
+    filter->slot_positions[*lower_slot] = (int8_t)lower;
+    filter->slot_positions[*upper_slot] = (int8_t)upper;
+    return true;
+}
+
+/**
+ * @brief   Helper function that sifts a reading down the min-heap until its children are no smaller.
+ * @param   filter          The filter, is assumed to be valid.
+ * @param   position        The reading's position, 1 or more, or 0 to sift the median down into the min-heap.
+ */
+static inline void sift_down_min_heap(hcsr04_filter_t * filter, int32_t position) {
+    // The median's only child on this side is the min-heap's root
+    int32_t size = (filter->count - 1) / 2;
+    for(int32_t child = position == 0 ? 1 : position * 2; child <= size; child *= 2) {
+        if(child > 1 && child < size && heap_value(filter, child + 1) < heap_value(filter, child)) {
+            child++;
+        }
+        if(!order_positions(filter, child / 2, child)) {
+            break;
+        }
+    }
+}
+
+/**
+ * @brief   Helper function that sifts a reading down the max-heap until its children are no larger.
+ * @param   filter          The filter, is assumed to be valid.
+ * @param   position        The reading's position, -1 or less, or 0 to sift the median down into the max-heap.
+ */
+static inline void sift_down_max_heap(hcsr04_filter_t * filter, int32_t position) {
+    // The median's only child on this side is the max-heap's root
+    int32_t size = filter->count / 2;
+    for(int32_t child = position == 0 ? -1 : position * 2; child >= -size; child *= 2) {
+        if(child < -1 && child > -size && heap_value(filter, child - 1) > heap_value(filter, child)) {
+            child--;
+        }
+        if(!order_positions(filter, child, child / 2)) {
+            break;
+        }
+    }
+}
+
+/**
+ * @brief   Helper function that sifts a reading up the min-heap, possibly past its root into the median.
+ * @param   filter          The filter, is assumed to be valid.
+ * @param   position        The reading's position, 1 or more.
+ * @return  bool            true if the reading became the median.
+ */
+static inline bool sift_up_min_heap(hcsr04_filter_t * filter, int32_t position) {
+    while(position > 0 && order_positions(filter, position / 2, position)) {
+        position /= 2;
+    }
+    return position == 0;
+}
+
+/**
+ * @brief   Helper function that sifts a reading up the max-heap, possibly past its root into the median.
+ * @param   filter          The filter, is assumed to be valid.
+ * @param   position        The reading's position, -1 or less.
+ * @return  bool            true if the reading became the median.
+ */
+static inline bool sift_up_max_heap(hcsr04_filter_t * filter, int32_t position) {
+    while(position < 0 && order_positions(filter, position, position / 2)) {
+        position /= 2;
+    }
+    return position == 0;
+}
+
+/**
+ * @brief   Helper function that puts an accepted reading in the window, in place of the oldest once it is full.
+ * @param   filter          The filter, is assumed to be valid.
+ * @param   value           The reading.
+ */
+static inline void insert_value(hcsr04_filter_t * filter, uint32_t value) {
+    uint8_t slot = filter->next_slot;
+    int32_t position = filter->slot_positions[slot];
+    bool is_new = filter->count < filter->window;
+    uint32_t old_value = filter->values[slot];
+
+    // Running sums
+    if(!is_new) {
+        filter->sum -= old_value;
+        filter->sum_q8 -= old_value >> 8;
+        filter->sum_of_squares_q16 -= (uint64_t)(old_value >> 8) * (old_value >> 8);
+    }
+    filter->sum += value;
+    filter->sum_q8 += value >> 8;
+    filter->sum_of_squares_q16 += (uint64_t)(value >> 8) * (value >> 8);
+
+    filter->values[slot] = value;
+    filter->next_slot = (uint8_t)((slot + 1) % filter->window);
+    if(is_new) {
+        filter->count++;
+    }
+
+    // The reading takes the old one's place in the heaps, so only it can be out of order
+    if(position > 0) {
+        if(!is_new && value > old_value) {
+            sift_down_min_heap(filter, position);
+        }
+        else if(sift_up_min_heap(filter, position)) {
+            sift_down_max_heap(filter, 0);
+        }
+    }
+    else if(position < 0) {
+        if(!is_new && value < old_value) {
+            sift_down_max_heap(filter, position);
+        }
+        else if(sift_up_max_heap(filter, position)) {
+            sift_down_min_heap(filter, 0);
+        }
+    }
+    else {
+        // A new median may belong in either heap
+        sift_down_max_heap(filter, 0);
+        sift_down_min_heap(filter, 0);
+    }
+}
+
+/**
+ * @brief   Helper function that checks a reading against the range and rate-of-change gate, counting rate rejections.
+ * @param   filter          The filter, is assumed to be valid.
+ * @param   value           The reading.
+ * @param   time_us         The time of the reading.
+ * @return  bool            true if the reading passes.
+ */
+static inline bool passes_gate(hcsr04_filter_t * filter, uint32_t value, uint32_t time_us) {
+    if(value > (HCSR04_FILTER_MAX_RANGE_MM << 16)) {
+        return false;
+    }
+
+    if(!filter->has_accepted || filter->max_rate_mm_s == 0 || filter->consecutive_rejects >= filter->max_rejects) {
+        return true;
+    }
+
+    // delta / 2^16 mm > rate mm/s * dt / 10^6 s, rearranged to avoid dividing; a long enough gap passes anything
+    uint32_t delta = value > filter->last_value ? value - filter->last_value : filter->last_value - value;
+    uint64_t budget = (uint64_t)filter->max_rate_mm_s * (time_us - filter->last_time_us);
+    if(budget >= ((uint64_t)1 << 48)) {
+        return true;
+    }
+    if((uint64_t)delta * 1000000u > (budget << 16)) {
+        filter->consecutive_rejects++;
+        return false;
+    }
+    return true;
+}
+
+/**
+ * @brief   Initialize an empty filter.
+ * @param   filter          The filter.
+ * @param   window          The number of accepted readings the median, mean and variance are taken over, 1 to
+ *                          HCSR04_FILTER_MAX_WINDOW.
+ * @param   max_rate_mm_s   The fastest a distance can change between accepted readings, 0 to turn the rate gate off.
+ * @param   max_rejects     The number of readings in a row the rate gate rejects before accepting one anyway.
+ * @return  hcsr04_rc_t     Return code indicating operation success/failure.
+ *                          - HCSR04_RC_OK:             Operation successful.
+ *                          - HCSR04_RC_BAD_ARG:        An invalid argument was provided.
+ */
+hcsr04_rc_t hcsr04_filter_init(hcsr04_filter_t * filter, uint8_t window, uint32_t max_rate_mm_s, uint8_t max_rejects) {
+    if(filter == NULL || window == 0 || window > HCSR04_FILTER_MAX_WINDOW) {
+        return HCSR04_RC_BAD_ARG;
+    }
+
+    filter->window = window;
+    filter->count = 0;
+    filter->next_slot = 0;
+
+    // Slots alternate between the heaps, 0 at the median, 1 at -1, 2 at 1, 3 at -2, ..., so the heaps stay balanced as
+    // the window fills
+    for(uint8_t slot = 0; slot < window; slot++) {
+        int32_t position = ((slot + 1) / 2) * ((slot & 1u) ? -1 : 1);
+        filter->values[slot] = 0;
+        filter->slot_positions[slot] = (int8_t)position;
+        *heap_slot(filter, position) = slot;
+    }
+
+    filter->sum = 0;
+    filter->sum_q8 = 0;
+    filter->sum_of_squares_q16 = 0;
+
+    filter->max_rate_mm_s = max_rate_mm_s;
+    filter->max_rejects = max_rejects;
+    filter->consecutive_rejects = 0;
+    filter->has_accepted = false;
+    filter->last_value = 0;
+    filter->last_time_us = 0;
+
+    filter->accepted = 0;
+    filter->rejected = 0;
+
+    return HCSR04_RC_OK;
+}
+
+/**
+ * @brief   Pass a reading through the gate and, if it is accepted, into the rolling window.
+ * @param   filter          The filter.
+ * @param   distance_mm_q16 The reading in millimetres, Q16.16.
+ * @param   time_us         The time of the reading, for the rate gate.
+ * @return  hcsr04_rc_t     Return code indicating operation success/failure.
+ *                          - HCSR04_RC_OK:             The reading was accepted.
+ *                          - HCSR04_RC_BAD_ARG:        An invalid argument was provided.
+ *                          - HCSR04_RC_REJECTED:       The reading was out of range or changed too fast, and was dropped.
+ */
+hcsr04_rc_t hcsr04_filter_update(hcsr04_filter_t * filter, uint32_t distance_mm_q16, uint32_t time_us) {
+    if(filter == NULL) {
+        return HCSR04_RC_BAD_ARG;
+    }
+
+    if(!passes_gate(filter, distance_mm_q16, time_us)) {
+        filter->rejected++;
+        return HCSR04_RC_REJECTED;
+    }
+
+    filter->consecutive_rejects = 0;
+    filter->has_accepted = true;
+    filter->last_value = distance_mm_q16;
+    filter->last_time_us = time_us;
+    filter->accepted++;
+    insert_value(filter, distance_mm_q16);
+
+    return HCSR04_RC_OK;
+}
+
+/**
+ * @brief   Finish a measurement with hcsr04_end_measurement and pass its distance through the filter.
+ * @param   filter          The filter.
+ * @param   sensor          The HC-SR04 sensor struct the filter is for.
+ * @return  hcsr04_rc_t     Return code indicating operation success/failure.
+ *                          - HCSR04_RC_OK:             The measurement finished and the reading was accepted.
+ *                          - HCSR04_RC_REJECTED:       The measurement finished but the reading was dropped.
+ *                          - Otherwise the return code of hcsr04_end_measurement.
+ */
+hcsr04_rc_t hcsr04_filter_end_measurement(hcsr04_filter_t * filter, hcsr04_t * sensor) {
+    if(filter == NULL) {
+        return HCSR04_RC_BAD_ARG;
+    }
+
+    hcsr04_rc_t rc = hcsr04_end_measurement(sensor);
+    if(rc != HCSR04_RC_OK) {
+        return rc;
+    }
+
+    return hcsr04_filter_update(filter, sensor->current_distance_mm_q16, time_us_32());
+}
+
+/**
+ * @brief   Get the median of the window, the mean of the middle two readings if it holds an even number.
+ * @param   filter          The filter.
+ * @return  uint32_t        The median in millimetres, Q16.16, HCSR04_DIST_NONE_MM_Q16 if empty or filter is NULL.
+ */
+uint32_t hcsr04_filter_get_median(const hcsr04_filter_t * filter) {
+    if(filter == NULL || filter->count == 0) {
+        return HCSR04_DIST_NONE_MM_Q16;
+    }
+
+    // The median is at position 0, and with an even count the max-heap's root is the other middle reading
+    uint8_t center = filter->window / 2;
+    uint32_t median = filter->values[filter->heap_slots[center]];
+    if((filter->count & 1u) == 0) {
+        median = (uint32_t)(((uint64_t)median + filter->values[filter->heap_slots[center - 1]]) / 2);
+    }
+    return median;
+}
+
+/**
+ * @brief   Get the mean of the window.
+ * @param   filter          The filter.
+ * @return  uint32_t        The mean in millimetres, Q16.16, HCSR04_DIST_NONE_MM_Q16 if empty or filter is NULL.
+ */
+uint32_t hcsr04_filter_get_mean(const hcsr04_filter_t * filter) {
+    if(filter == NULL || filter->count == 0) {
+        return HCSR04_DIST_NONE_MM_Q16;
+    }
+
+    return (uint32_t)(filter->sum / filter->count);
+}
+
+/**
+ * @brief   Get the population variance of the window.
+ * @param   filter          The filter.
+ * @return  uint64_t        The variance in square millimetres, Q16.16, 0 if the window holds fewer than two readings
+ *                          or filter is NULL.
+ */
+uint64_t hcsr04_filter_get_variance(const hcsr04_filter_t * filter) {
+    if(filter == NULL || filter->count < 2) {
+        return 0;
+    }
+
+    // (n * sum(x^2) - sum(x)^2) / n^2, with x at 8 fractional bits so x^2 has 16
+    uint64_t count = filter->count;
+    return (count * filter->sum_of_squares_q16 - (uint64_t)filter->sum_q8 * filter->sum_q8) / (count * count);
+}
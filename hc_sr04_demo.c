@@ -6,6 +6,7 @@ const uint8_t ECHO_PIN = 6;
 const uint8_t TRIGGER_PIN = 7;
 
 hcsr04_t hcsr04;
+hcsr04_t hcsr04_pio; // The same sensor, with its echo pulse timed by PIO
 
 /**
  * @brief   Handler for all GPIO pin interrupts; is currently just for a single HCSR04 sensor.
@@ -44,7 +45,7 @@ void blocking_implementation_test() {
 
     // Complete measurement and print result
     hcsr04_end_measurement(&hcsr04);
-    printf("Distance: %.2f cm\n", hcsr04.current_distance);
+    printf("Distance: %.2f cm\n", hcsr04_get_distance_cm(&hcsr04));
 }
 
 /**
@@ -60,10 +61,15 @@ void nonblocking_implementation_test() {
     hcsr04_start_measurement(&hcsr04);
 
     // Wait for measurement to complete and print result
-    while (hcsr04_end_measurement(&hcsr04) != HCSR04_RC_OK) {
+    hcsr04_rc_t rc;
+    while ((rc = hcsr04_end_measurement(&hcsr04)) == HCSR04_RC_NO_ECHO) {
         sleep_ms(100); // Wait a bit before checking again
     }
-    printf("Distance: %.2f cm\n", hcsr04.current_distance);
+    if (rc == HCSR04_RC_TIMEOUT) {
+        printf("No echo\n");
+        return;
+    }
+    printf("Distance: %.2f cm\n", hcsr04_get_distance_cm(&hcsr04));
 }
 
 /**
@@ -79,7 +85,28 @@ void repeated_calls_test() {
     hcsr04_rc_t rc_2 = hcsr04_start_measurement(&hcsr04);
     while(!hcsr04_end_measurement(&hcsr04));
 
-    printf("calling start_measurement twice returns %d and %d, final distance is %f\n", rc_1, rc_2, hcsr04.current_distance);
+    printf("calling start_measurement twice returns %d and %d, final distance is %f\n", rc_1, rc_2, hcsr04_get_distance_cm(&hcsr04));
+}
+
+/**
+ * @brief   Test PIO implementation of sensor
+ */
+void pio_implementation_test() {
+    printf("Measuring with PIO...\n");
+
+    // No GPIO IRQ needed, the PIO times the echo pulse by itself
+    hcsr04_start_measurement(&hcsr04_pio);
+
+    // Wait for the PIO to push the pulse width and print result
+    hcsr04_rc_t rc;
+    while ((rc = hcsr04_end_measurement(&hcsr04_pio)) == HCSR04_RC_NO_ECHO) {
+        sleep_ms(10); // Wait a bit before checking again
+    }
+    if (rc == HCSR04_RC_TIMEOUT) {
+        printf("No echo\n");
+        return;
+    }
+    printf("Distance: %.4f cm\n", hcsr04_get_distance_cm(&hcsr04_pio));
 }
 
 int main() {
@@ -94,6 +121,10 @@ int main() {
     // Initialize sensor
     hcsr04_init(&hcsr04, TRIGGER_PIN, ECHO_PIN);
 
+    // Initialize the PIO timed copy of the sensor
+    hcsr04_init(&hcsr04_pio, TRIGGER_PIN, ECHO_PIN);
+    hcsr04_enable_pio_capture(&hcsr04_pio, pio0);
+
     // Register callback function for non-blocking implementation
     gpio_set_irq_enabled_with_callback(hcsr04.echo_pin, GPIO_IRQ_EDGE_RISE | GPIO_IRQ_EDGE_FALL, true, &handle_gpio_irq);
 
@@ -113,5 +144,9 @@ int main() {
         // Reset the sensor to guarantee initial state for next loop iteration
         hcsr04_reset(&hcsr04);
         sleep_ms(1000);
+
+        // Test PIO implementation of sensor, with the GPIO IRQ disabled by the reset
+        pio_implementation_test();
+        sleep_ms(1000);
     }
 }
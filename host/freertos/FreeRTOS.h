@@ -0,0 +1,31 @@
+/**
+ * @file    FreeRTOS.h
+ * @brief   Host stand-in for the parts of FreeRTOS.h used by common_lib.
+ * @details Shares FreeRTOSConfig.h with the RP2040 build so priorities and tick rates match.
+ */
+
+#ifndef HOST_FREERTOS_H
+#define HOST_FREERTOS_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+#include "FreeRTOSConfig.h"
+
+typedef uint32_t TickType_t;
+typedef long BaseType_t;
+typedef unsigned long UBaseType_t;
+
+#define portMAX_DELAY           ((TickType_t)0xffffffffUL)
+#define portTICK_PERIOD_MS      ((TickType_t)1000 / configTICK_RATE_HZ)
+
+#define pdFALSE                 ((BaseType_t)0)
+#define pdTRUE                  ((BaseType_t)1)
+#define pdFAIL                  (pdFALSE)
+#define pdPASS                  (pdTRUE)
+#define pdMS_TO_TICKS(xTimeInMs) ((TickType_t)(((TickType_t)(xTimeInMs) * (TickType_t)configTICK_RATE_HZ) / (TickType_t)1000U))
+
+// There is no scheduler to switch to, a woken task runs when the simulated irq returns
+#define portYIELD_FROM_ISR(xSwitchRequired) ((void)(xSwitchRequired))
+
+#endif // HOST_FREERTOS_H
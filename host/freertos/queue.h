@@ -0,0 +1,18 @@
+/**
+ * @file    queue.h
+ * @brief   Host stand-in for the parts of FreeRTOS queue.h used by common_lib.
+ * @details Queues never block; sending to a full queue or receiving from an empty one fails immediately.
+ */
+
+#ifndef HOST_FREERTOS_QUEUE_H
+#define HOST_FREERTOS_QUEUE_H
+
+#include "FreeRTOS.h"
+
+typedef struct QueueDefinition * QueueHandle_t;
+
+QueueHandle_t xQueueCreate(UBaseType_t uxQueueLength, UBaseType_t uxItemSize);
+BaseType_t xQueueSend(QueueHandle_t xQueue, const void * const pvItemToQueue, TickType_t xTicksToWait);
+BaseType_t xQueueReceive(QueueHandle_t xQueue, void * const pvBuffer, TickType_t xTicksToWait);
+
+#endif // HOST_FREERTOS_QUEUE_H
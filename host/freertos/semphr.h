@@ -0,0 +1,18 @@
+/**
+ * @file    semphr.h
+ * @brief   Host stand-in for the parts of FreeRTOS semphr.h used by common_lib.
+ * @details Mutexes are always available since tasks are never run concurrently.
+ */
+
+#ifndef HOST_FREERTOS_SEMPHR_H
+#define HOST_FREERTOS_SEMPHR_H
+
+#include "queue.h"
+
+typedef QueueHandle_t SemaphoreHandle_t;
+
+SemaphoreHandle_t xSemaphoreCreateMutex(void);
+BaseType_t xSemaphoreTake(SemaphoreHandle_t xSemaphore, TickType_t xBlockTime);
+BaseType_t xSemaphoreGive(SemaphoreHandle_t xSemaphore);
+
+#endif // HOST_FREERTOS_SEMPHR_H
@@ -0,0 +1,30 @@
+/**
+ * @file    task.h
+ * @brief   Host stand-in for the parts of FreeRTOS task.h used by common_lib.
+ * @details Tasks can be created and have their priority/state changed, but are never run.
+ *          The caller is treated as the one running task. Waiting on its notification runs the simulated hardware
+ *          (see host_hardware.h) instead of sleeping, since that is where notifications from irqs come from.
+ */
+
+#ifndef HOST_FREERTOS_TASK_H
+#define HOST_FREERTOS_TASK_H
+
+#include "FreeRTOS.h"
+
+typedef struct tskTaskControlBlock * TaskHandle_t;
+typedef void (*TaskFunction_t)(void *);
+
+BaseType_t xTaskCreate(TaskFunction_t pxTaskCode, const char * const pcName, const uint32_t usStackDepth, void * const pvParameters, UBaseType_t uxPriority, TaskHandle_t * const pxCreatedTask);
+void vTaskDelete(TaskHandle_t xTaskToDelete);
+void vTaskPrioritySet(TaskHandle_t xTask, UBaseType_t uxNewPriority);
+UBaseType_t uxTaskPriorityGet(TaskHandle_t xTask);
+void vTaskSuspend(TaskHandle_t xTaskToSuspend);
+void vTaskResume(TaskHandle_t xTaskToResume);
+void vTaskDelay(const TickType_t xTicksToDelay);
+void vTaskStartScheduler(void);
+TickType_t xTaskGetTickCount(void);
+TaskHandle_t xTaskGetCurrentTaskHandle(void);
+void vTaskNotifyGiveFromISR(TaskHandle_t xTaskToNotify, BaseType_t * pxHigherPriorityTaskWoken);
+uint32_t ulTaskNotifyTake(BaseType_t xClearCountOnExit, TickType_t xTicksToWait);
+
+#endif // HOST_FREERTOS_TASK_H
@@ -0,0 +1,28 @@
+/**
+ * @file    address_mapped.h
+ * @brief   Host stand-in for hardware/address_mapped.h.
+ * @details Registers are plain memory on the host, the atomic set/clear aliases are atomic read-modify-writes.
+ */
+
+#ifndef HOST_HARDWARE_ADDRESS_MAPPED_H
+#define HOST_HARDWARE_ADDRESS_MAPPED_H
+
+#include "pico/stdlib.h"
+
+typedef volatile uint32_t io_rw_32;
+typedef volatile uint32_t io_ro_32;
+typedef volatile uint32_t io_wo_32;
+
+static inline void hw_set_bits(io_rw_32 * addr, uint32_t mask) {
+    __atomic_fetch_or(addr, mask, __ATOMIC_SEQ_CST);
+}
+
+static inline void hw_clear_bits(io_rw_32 * addr, uint32_t mask) {
+    __atomic_fetch_and(addr, ~mask, __ATOMIC_SEQ_CST);
+}
+
+static inline void hw_write_masked(io_rw_32 * addr, uint32_t values, uint32_t write_mask) {
+    *addr = (*addr & ~write_mask) | (values & write_mask);
+}
+
+#endif // HOST_HARDWARE_ADDRESS_MAPPED_H
@@ -0,0 +1,31 @@
+/**
+ * @file    clocks.h
+ * @brief   Host stand-in for hardware/clocks.h. The simulated system clock runs at the SDK's default 125 MHz.
+ */
+
+#ifndef HOST_HARDWARE_CLOCKS_H
+#define HOST_HARDWARE_CLOCKS_H
+
+#include "pico/stdlib.h"
+
+#define HOST_CLK_SYS_HZ     125000000u
+
+enum clock_index {
+    clk_gpout0 = 0,
+    clk_gpout1,
+    clk_gpout2,
+    clk_gpout3,
+    clk_ref,
+    clk_sys,
+    clk_peri,
+    clk_usb,
+    clk_adc,
+    clk_rtc,
+    CLK_COUNT
+};
+
+static inline uint32_t clock_get_hz(enum clock_index clk_index) {
+    return clk_index == clk_sys ? HOST_CLK_SYS_HZ : 0u;
+}
+
+#endif // HOST_HARDWARE_CLOCKS_H
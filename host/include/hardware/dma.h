@@ -0,0 +1,114 @@
+/**
+ * @file    dma.h
+ * @brief   Host stand-in for hardware/dma.h, backed by a simulated DMA controller (see host_hardware.h).
+ * @details Transfers really copy host memory, paced by the simulated UART DREQs, and support chaining, ring wrapping and IRQ quiet.
+ *          Control register bits match the RP2040's, so channel configs are built the same way as on hardware.
+ */
+
+#ifndef HOST_HARDWARE_DMA_H
+#define HOST_HARDWARE_DMA_H
+
+#include "pico/stdlib.h"
+#include "hardware/address_mapped.h"
+#include "hardware/irq.h"
+
+#define NUM_DMA_CHANNELS    12u
+
+#define DMA_CH0_CTRL_TRIG_EN_BITS               0x00000001u
+#define DMA_CH0_CTRL_TRIG_DATA_SIZE_LSB         2u
+#define DMA_CH0_CTRL_TRIG_DATA_SIZE_BITS        0x0000000cu
+#define DMA_CH0_CTRL_TRIG_INCR_READ_BITS        0x00000010u
+#define DMA_CH0_CTRL_TRIG_INCR_WRITE_BITS       0x00000020u
+#define DMA_CH0_CTRL_TRIG_RING_SIZE_LSB         6u
+#define DMA_CH0_CTRL_TRIG_RING_SIZE_BITS        0x000003c0u
+#define DMA_CH0_CTRL_TRIG_RING_SEL_BITS         0x00000400u
+#define DMA_CH0_CTRL_TRIG_CHAIN_TO_LSB          11u
+#define DMA_CH0_CTRL_TRIG_CHAIN_TO_BITS         0x00007800u
+#define DMA_CH0_CTRL_TRIG_TREQ_SEL_LSB          15u
+#define DMA_CH0_CTRL_TRIG_TREQ_SEL_BITS         0x001f8000u
+#define DMA_CH0_CTRL_TRIG_IRQ_QUIET_BITS        0x00200000u
+#define DMA_CH0_CTRL_TRIG_BUSY_BITS             0x01000000u
+
+#define DREQ_UART0_TX       20u
+#define DREQ_UART0_RX       21u
+#define DREQ_UART1_TX       22u
+#define DREQ_UART1_RX       23u
+#define DREQ_FORCE          0x3fu
+
+enum dma_channel_transfer_size {
+    DMA_SIZE_8  = 0,
+    DMA_SIZE_16 = 1,
+    DMA_SIZE_32 = 2,
+};
+
+// Addresses are host pointers, so they are pointer sized instead of 32 bits
+typedef struct {
+    volatile uintptr_t read_addr;
+    volatile uintptr_t write_addr;
+    volatile uint32_t transfer_count;
+    volatile uint32_t ctrl_trig;
+} dma_channel_hw_t;
+
+typedef struct {
+    uint32_t ctrl;
+} dma_channel_config;
+
+extern dma_channel_hw_t host_dma_channel_hw[NUM_DMA_CHANNELS];
+
+static inline dma_channel_hw_t * dma_channel_hw_addr(uint channel) {
+    return &host_dma_channel_hw[channel];
+}
+
+static inline void channel_config_set_read_increment(dma_channel_config * c, bool incr) {
+    c->ctrl = incr ? (c->ctrl | DMA_CH0_CTRL_TRIG_INCR_READ_BITS) : (c->ctrl & ~DMA_CH0_CTRL_TRIG_INCR_READ_BITS);
+}
+
+static inline void channel_config_set_write_increment(dma_channel_config * c, bool incr) {
+    c->ctrl = incr ? (c->ctrl | DMA_CH0_CTRL_TRIG_INCR_WRITE_BITS) : (c->ctrl & ~DMA_CH0_CTRL_TRIG_INCR_WRITE_BITS);
+}
+
+static inline void channel_config_set_dreq(dma_channel_config * c, uint dreq) {
+    c->ctrl = (c->ctrl & ~DMA_CH0_CTRL_TRIG_TREQ_SEL_BITS) | (dreq << DMA_CH0_CTRL_TRIG_TREQ_SEL_LSB);
+}
+
+static inline void channel_config_set_chain_to(dma_channel_config * c, uint chain_to) {
+    c->ctrl = (c->ctrl & ~DMA_CH0_CTRL_TRIG_CHAIN_TO_BITS) | (chain_to << DMA_CH0_CTRL_TRIG_CHAIN_TO_LSB);
+}
+
+static inline void channel_config_set_transfer_data_size(dma_channel_config * c, enum dma_channel_transfer_size size) {
+    c->ctrl = (c->ctrl & ~DMA_CH0_CTRL_TRIG_DATA_SIZE_BITS) | ((uint32_t)size << DMA_CH0_CTRL_TRIG_DATA_SIZE_LSB);
+}
+
+static inline void channel_config_set_ring(dma_channel_config * c, bool write, uint size_bits) {
+    c->ctrl = (c->ctrl & ~(DMA_CH0_CTRL_TRIG_RING_SIZE_BITS | DMA_CH0_CTRL_TRIG_RING_SEL_BITS)) |
+              (size_bits << DMA_CH0_CTRL_TRIG_RING_SIZE_LSB) | (write ? DMA_CH0_CTRL_TRIG_RING_SEL_BITS : 0u);
+}
+
+static inline void channel_config_set_irq_quiet(dma_channel_config * c, bool irq_quiet) {
+    c->ctrl = irq_quiet ? (c->ctrl | DMA_CH0_CTRL_TRIG_IRQ_QUIET_BITS) : (c->ctrl & ~DMA_CH0_CTRL_TRIG_IRQ_QUIET_BITS);
+}
+
+static inline void channel_config_set_enable(dma_channel_config * c, bool enable) {
+    c->ctrl = enable ? (c->ctrl | DMA_CH0_CTRL_TRIG_EN_BITS) : (c->ctrl & ~DMA_CH0_CTRL_TRIG_EN_BITS);
+}
+
+dma_channel_config dma_channel_get_default_config(uint channel);
+
+int dma_claim_unused_channel(bool required);
+void dma_channel_claim(uint channel);
+void dma_channel_unclaim(uint channel);
+
+void dma_channel_set_config(uint channel, const dma_channel_config * config, bool trigger);
+void dma_channel_set_read_addr(uint channel, const volatile void * read_addr, bool trigger);
+void dma_channel_set_write_addr(uint channel, volatile void * write_addr, bool trigger);
+void dma_channel_set_trans_count(uint channel, uint32_t trans_count, bool trigger);
+void dma_channel_configure(uint channel, const dma_channel_config * config, volatile void * write_addr, const volatile void * read_addr, uint transfer_count, bool trigger);
+void dma_channel_start(uint channel);
+void dma_channel_abort(uint channel);
+bool dma_channel_is_busy(uint channel);
+
+void dma_irqn_set_channel_enabled(uint irq_index, uint channel, bool enabled);
+bool dma_irqn_get_channel_status(uint irq_index, uint channel);
+void dma_irqn_acknowledge_channel(uint irq_index, uint channel);
+
+#endif // HOST_HARDWARE_DMA_H
@@ -0,0 +1,53 @@
+/**
+ * @file    gpio.h
+ * @brief   Host stand-in for the pin function and SIO parts of hardware/gpio.h.
+ * @details Each pin holds a level: an output drives it with gpio_put, an input follows host_gpio_set_input (see host_hardware.h).
+ *          The simulated PIO reads the same levels. There are no GPIO interrupts on the host, so enabling them does nothing.
+ */
+
+#ifndef HOST_HARDWARE_GPIO_H
+#define HOST_HARDWARE_GPIO_H
+
+#include "pico/stdlib.h"
+
+#define NUM_BANK0_GPIOS     30u
+
+#define GPIO_OUT    1
+#define GPIO_IN     0
+
+enum gpio_function {
+    GPIO_FUNC_SPI   = 1,
+    GPIO_FUNC_UART  = 2,
+    GPIO_FUNC_I2C   = 3,
+    GPIO_FUNC_PWM   = 4,
+    GPIO_FUNC_SIO   = 5,
+    GPIO_FUNC_PIO0  = 6,
+    GPIO_FUNC_PIO1  = 7,
+    GPIO_FUNC_NULL  = 0x1f,
+};
+
+// Interrupt event bits match the RP2040's
+enum gpio_irq_level {
+    GPIO_IRQ_LEVEL_LOW  = 0x1u,
+    GPIO_IRQ_LEVEL_HIGH = 0x2u,
+    GPIO_IRQ_EDGE_FALL  = 0x4u,
+    GPIO_IRQ_EDGE_RISE  = 0x8u,
+};
+
+static inline void gpio_set_function(uint gpio, enum gpio_function fn) {
+    (void)gpio;
+    (void)fn;
+}
+
+static inline void gpio_set_irq_enabled(uint gpio, uint32_t events, bool enabled) {
+    (void)gpio;
+    (void)events;
+    (void)enabled;
+}
+
+void gpio_init(uint gpio);
+void gpio_set_dir(uint gpio, bool out);
+void gpio_put(uint gpio, bool value);
+bool gpio_get(uint gpio);
+
+#endif // HOST_HARDWARE_GPIO_H
@@ -0,0 +1,39 @@
+/**
+ * @file    irq.h
+ * @brief   Host stand-in for hardware/irq.h.
+ * @details Handlers are only ever called by host_hardware_run (see host_hardware.h), never asynchronously,
+ *          so code between host_hardware_run calls behaves as if interrupts were disabled.
+ */
+
+#ifndef HOST_HARDWARE_IRQ_H
+#define HOST_HARDWARE_IRQ_H
+
+#include "pico/stdlib.h"
+
+#define NUM_IRQS                                    32u
+#define PICO_SHARED_IRQ_HANDLER_DEFAULT_ORDER_PRIORITY  0x80u
+
+// Interrupt numbers match the RP2040's
+#define TIMER_IRQ_0     0u
+#define TIMER_IRQ_1     1u
+#define TIMER_IRQ_2     2u
+#define TIMER_IRQ_3     3u
+#define PIO0_IRQ_0      7u
+#define PIO0_IRQ_1      8u
+#define PIO1_IRQ_0      9u
+#define PIO1_IRQ_1      10u
+#define DMA_IRQ_0       11u
+#define DMA_IRQ_1       12u
+#define IO_IRQ_BANK0    13u
+#define UART0_IRQ       20u
+#define UART1_IRQ       21u
+
+typedef void (*irq_handler_t)(void);
+
+void irq_set_exclusive_handler(uint num, irq_handler_t handler);
+void irq_add_shared_handler(uint num, irq_handler_t handler, uint8_t order_priority);
+void irq_remove_handler(uint num, irq_handler_t handler);
+void irq_set_enabled(uint num, bool enabled);
+bool irq_is_enabled(uint num);
+
+#endif // HOST_HARDWARE_IRQ_H
@@ -0,0 +1,109 @@
+/**
+ * @file    pio.h
+ * @brief   Host stand-in for hardware/pio.h, backed by a simulated PIO (see host_hardware.h).
+ * @details Each state machine interprets its program instruction by instruction, one per system clock cycle divided by its
+ *          integer clock divider, with delays, wrapping and a 4 word RX FIFO (8 when joined). Pins are read from the GPIO
+ *          stand-in. The subset of the instruction set modelled is JMP, WAIT on a pin or GPIO, MOV between pins, X, Y,
+ *          NULL and ISR, PUSH and SET of X and Y; a program using anything else aborts the simulation.
+ *          State machines only run in host_pio_run, never in the background.
+ */
+
+#ifndef HOST_HARDWARE_PIO_H
+#define HOST_HARDWARE_PIO_H
+
+#include "pico/stdlib.h"
+#include "hardware/gpio.h"
+#include "hardware/pio_instructions.h"
+
+#define NUM_PIOS                    2u
+#define NUM_PIO_STATE_MACHINES      4u
+#define PIO_INSTRUCTION_COUNT       32u
+
+typedef struct host_pio host_pio_t;
+typedef host_pio_t * PIO;
+
+extern host_pio_t * const host_pios[NUM_PIOS];
+
+#define pio0    (host_pios[0])
+#define pio1    (host_pios[1])
+
+typedef struct {
+    const uint16_t * instructions;
+    uint8_t length;
+    int8_t origin;      // Offset the program must be loaded at, -1 for anywhere
+} pio_program_t;
+
+enum pio_fifo_join {
+    PIO_FIFO_JOIN_NONE  = 0,
+    PIO_FIFO_JOIN_TX    = 1,
+    PIO_FIFO_JOIN_RX    = 2,
+};
+
+typedef struct {
+    uint16_t clkdiv_int;
+    uint8_t wrap_target;
+    uint8_t wrap;
+    uint8_t in_base;
+    uint8_t jmp_pin;
+    enum pio_fifo_join fifo_join;
+} pio_sm_config;
+
+// Program memory, loading relocates JMP targets by the offset the program is loaded at, like the SDK
+bool pio_can_add_program(PIO pio, const pio_program_t * program);
+uint pio_add_program(PIO pio, const pio_program_t * program);
+void pio_remove_program(PIO pio, const pio_program_t * program, uint loaded_offset);
+
+uint pio_get_index(PIO pio);
+int pio_claim_unused_sm(PIO pio, bool required);
+void pio_sm_unclaim(PIO pio, uint sm);
+
+pio_sm_config pio_get_default_sm_config(void);
+
+static inline void sm_config_set_wrap(pio_sm_config * c, uint wrap_target, uint wrap) {
+    c->wrap_target = (uint8_t)wrap_target;
+    c->wrap = (uint8_t)wrap;
+}
+
+static inline void sm_config_set_in_pins(pio_sm_config * c, uint in_base) {
+    c->in_base = (uint8_t)in_base;
+}
+
+static inline void sm_config_set_jmp_pin(pio_sm_config * c, uint pin) {
+    c->jmp_pin = (uint8_t)pin;
+}
+
+// The fractional part of the divider is not modelled
+static inline void sm_config_set_clkdiv_int_frac(pio_sm_config * c, uint16_t div_int, uint8_t div_frac) {
+    (void)div_frac;
+    c->clkdiv_int = div_int;
+}
+
+static inline void sm_config_set_fifo_join(pio_sm_config * c, enum pio_fifo_join join) {
+    c->fifo_join = join;
+}
+
+static inline void pio_gpio_init(PIO pio, uint pin) {
+    (void)pio;
+    (void)pin;
+}
+
+static inline void pio_sm_set_consecutive_pindirs(PIO pio, uint sm, uint pin_base, uint pin_count, bool is_out) {
+    (void)pio;
+    (void)sm;
+    (void)pin_base;
+    (void)pin_count;
+    (void)is_out;
+}
+
+// Apply a config, clear the FIFOs and restart the state machine at initial_pc, leaving it disabled
+void pio_sm_init(PIO pio, uint sm, uint initial_pc, const pio_sm_config * config);
+void pio_sm_set_enabled(PIO pio, uint sm, bool enabled);
+void pio_sm_restart(PIO pio, uint sm);
+void pio_sm_exec(PIO pio, uint sm, uint instr);
+
+void pio_sm_clear_fifos(PIO pio, uint sm);
+uint pio_sm_get_rx_fifo_level(PIO pio, uint sm);
+bool pio_sm_is_rx_fifo_empty(PIO pio, uint sm);
+uint32_t pio_sm_get(PIO pio, uint sm);
+
+#endif // HOST_HARDWARE_PIO_H
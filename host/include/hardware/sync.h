@@ -0,0 +1,34 @@
+/**
+ * @file    sync.h
+ * @brief   Host stand-in for the hardware spinlock and interrupt masking parts of hardware/sync.h.
+ * @details Spinlocks are host atomics, so they give real mutual exclusion between host threads the way the RP2040's
+ *          SIO spinlocks do between cores. There are no interrupts on the host, so masking them does nothing.
+ */
+
+#ifndef HOST_HARDWARE_SYNC_H
+#define HOST_HARDWARE_SYNC_H
+
+#include "pico/stdlib.h"
+
+#define NUM_SPIN_LOCKS  32u
+
+typedef volatile uint32_t spin_lock_t;
+
+static inline uint32_t save_and_disable_interrupts(void) {
+    return 0;
+}
+
+static inline void restore_interrupts(uint32_t status) {
+    (void)status;
+}
+
+spin_lock_t * spin_lock_instance(uint lock_num);
+uint spin_lock_get_num(spin_lock_t * lock);
+spin_lock_t * spin_lock_init(uint lock_num);
+int spin_lock_claim_unused(bool required);
+void spin_lock_unclaim(uint lock_num);
+
+uint32_t spin_lock_blocking(spin_lock_t * lock);
+void spin_unlock(spin_lock_t * lock, uint32_t saved_irq);
+
+#endif // HOST_HARDWARE_SYNC_H
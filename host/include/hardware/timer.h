@@ -0,0 +1,11 @@
+/**
+ * @file    timer.h
+ * @brief   Host stand-in for hardware/timer.h, the time functions are provided by the pico/stdlib.h stand-in.
+ */
+
+#ifndef HOST_HARDWARE_TIMER_H
+#define HOST_HARDWARE_TIMER_H
+
+#include "pico/stdlib.h"
+
+#endif // HOST_HARDWARE_TIMER_H
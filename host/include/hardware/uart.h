@@ -0,0 +1,113 @@
+/**
+ * @file    uart.h
+ * @brief   Host stand-in for hardware/uart.h, backed by a simulated PL011 UART (see host_hardware.h).
+ * @details The register block is plain memory. The simulation reads control registers (imsc, ifls, lcr_h, dmacr, icr)
+ *          and keeps status registers (fr, ris, mis) up to date; data only moves through the functions below or the DMA stand-in.
+ */
+
+#ifndef HOST_HARDWARE_UART_H
+#define HOST_HARDWARE_UART_H
+
+#include "pico/stdlib.h"
+#include "hardware/address_mapped.h"
+#include "hardware/gpio.h"
+#include "hardware/irq.h"
+
+#define NUM_UARTS   2u
+
+typedef struct {
+    io_rw_32 dr;
+    io_rw_32 rsr;
+    uint32_t _pad0[4];
+    io_ro_32 fr;
+    uint32_t _pad1;
+    io_rw_32 ilpr;
+    io_rw_32 ibrd;
+    io_rw_32 fbrd;
+    io_rw_32 lcr_h;
+    io_rw_32 cr;
+    io_rw_32 ifls;
+    io_rw_32 imsc;
+    io_ro_32 ris;
+    io_ro_32 mis;
+    io_wo_32 icr;
+    io_rw_32 dmacr;
+} uart_hw_t;
+
+typedef struct uart_inst uart_inst_t;
+
+extern uart_hw_t host_uart_hw[NUM_UARTS];
+
+#define uart0_hw    (&host_uart_hw[0])
+#define uart1_hw    (&host_uart_hw[1])
+#define uart0       ((uart_inst_t *)uart0_hw)
+#define uart1       ((uart_inst_t *)uart1_hw)
+
+// Register bits match the RP2040's
+#define UART_UARTFR_CTS_BITS            0x00000001u
+#define UART_UARTFR_BUSY_BITS           0x00000008u
+#define UART_UARTFR_RXFE_BITS           0x00000010u
+#define UART_UARTFR_TXFF_BITS           0x00000020u
+#define UART_UARTFR_RXFF_BITS           0x00000040u
+#define UART_UARTFR_TXFE_BITS           0x00000080u
+#define UART_UARTLCR_H_FEN_BITS         0x00000010u
+#define UART_UARTCR_RTSEN_BITS          0x00004000u
+#define UART_UARTCR_CTSEN_BITS          0x00008000u
+#define UART_UARTIFLS_TXIFLSEL_LSB      0u
+#define UART_UARTIFLS_TXIFLSEL_BITS     0x00000007u
+#define UART_UARTIFLS_RXIFLSEL_LSB      3u
+#define UART_UARTIFLS_RXIFLSEL_BITS     0x00000038u
+#define UART_UARTIMSC_RXIM_BITS         0x00000010u
+#define UART_UARTIMSC_TXIM_BITS         0x00000020u
+#define UART_UARTIMSC_RTIM_BITS         0x00000040u
+#define UART_UARTIMSC_FEIM_BITS         0x00000080u
+#define UART_UARTIMSC_PEIM_BITS         0x00000100u
+#define UART_UARTIMSC_BEIM_BITS         0x00000200u
+#define UART_UARTIMSC_OEIM_BITS         0x00000400u
+#define UART_UARTRIS_RXRIS_BITS         0x00000010u
+#define UART_UARTRIS_TXRIS_BITS         0x00000020u
+#define UART_UARTRIS_RTRIS_BITS         0x00000040u
+#define UART_UARTRIS_OERIS_BITS         0x00000400u
+#define UART_UARTMIS_RXMIS_BITS         0x00000010u
+#define UART_UARTMIS_TXMIS_BITS         0x00000020u
+#define UART_UARTMIS_RTMIS_BITS         0x00000040u
+#define UART_UARTMIS_FEMIS_BITS         0x00000080u
+#define UART_UARTMIS_PEMIS_BITS         0x00000100u
+#define UART_UARTMIS_BEMIS_BITS         0x00000200u
+#define UART_UARTMIS_OEMIS_BITS         0x00000400u
+#define UART_UARTICR_RXIC_BITS          0x00000010u
+#define UART_UARTICR_TXIC_BITS          0x00000020u
+#define UART_UARTICR_RTIC_BITS          0x00000040u
+#define UART_UARTICR_FEIC_BITS          0x00000080u
+#define UART_UARTICR_PEIC_BITS          0x00000100u
+#define UART_UARTICR_BEIC_BITS          0x00000200u
+#define UART_UARTICR_OEIC_BITS          0x00000400u
+#define UART_UARTICR_BITS               0x000007ffu
+#define UART_UARTDMACR_RXDMAE_BITS      0x00000001u
+#define UART_UARTDMACR_TXDMAE_BITS      0x00000002u
+
+static inline uart_hw_t * uart_get_hw(uart_inst_t * uart) {
+    return (uart_hw_t *)uart;
+}
+
+static inline uint uart_get_index(uart_inst_t * uart) {
+    return (uart == uart1) ? 1u : 0u;
+}
+
+static inline uint uart_get_dreq(uart_inst_t * uart, bool is_tx) {
+    return 20u + 2u * uart_get_index(uart) + (is_tx ? 0u : 1u);
+}
+
+uint uart_init(uart_inst_t * uart, uint baudrate);
+void uart_set_fifo_enabled(uart_inst_t * uart, bool enabled);
+void uart_set_hw_flow(uart_inst_t * uart, bool cts, bool rts);
+void uart_set_irq_enables(uart_inst_t * uart, bool rx_has_data, bool tx_needs_data);
+
+bool uart_is_writable(uart_inst_t * uart);
+bool uart_is_readable(uart_inst_t * uart);
+void uart_putc_raw(uart_inst_t * uart, char c);
+void uart_putc(uart_inst_t * uart, char c);
+void uart_puts(uart_inst_t * uart, const char * s);
+char uart_getc(uart_inst_t * uart);
+
+#endif // HOST_HARDWARE_UART_H
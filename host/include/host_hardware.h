@@ -0,0 +1,53 @@
+/**
+ * @file    host_hardware.h
+ * @brief   Controls the simulated RP2040 UARTs, DMA controller, interrupts, GPIOs and PIOs behind the host stand-ins.
+ * @details Nothing happens in the background; host_hardware_run advances the simulation until it settles, moving data on
+ *          the UART lines, performing paced DMA transfers and calling the handlers of raised and enabled interrupts.
+ *          A UART line moves HOST_UART_CHARS_PER_STEP characters per step in each direction, so FIFOs can fill and drain.
+ *          The PIOs run on their own clock: host_pio_run advances them by system clock cycles, reading the GPIO levels set
+ *          with host_gpio_set_input, so a test can drive a pin and count exactly how many cycles it was held.
+ *          Time can be switched to a fake clock that only moves when the test advances it, firing alarms as it passes them.
+ */
+
+#ifndef HOST_HARDWARE_H
+#define HOST_HARDWARE_H
+
+#include "pico/stdlib.h"
+#include "hardware/uart.h"
+#include "hardware/irq.h"
+
+#define HOST_UART_CHARS_PER_STEP    4u
+
+// Advance the simulation until no more data moves and no interrupt is pending, or max_steps is reached
+// Returns the number of steps taken
+uint32_t host_hardware_run(uint32_t max_steps);
+
+// Advance the simulation by one step, returns whether any data moved or interrupt was serviced
+bool host_hardware_step(void);
+
+// Get the number of steps taken since the program started, the simulation's clock
+uint64_t host_hardware_get_step_count(void);
+
+// Queue characters to arrive on a UART's rx line
+void host_uart_inject_rx(uart_inst_t * uart, const uint8_t * data, size_t len);
+
+// Take the characters that have left a UART's tx line since the last call, returns how many were copied
+size_t host_uart_take_tx(uart_inst_t * uart, uint8_t * data, size_t max_len);
+
+// Get the number of times an interrupt's handlers have been called
+uint32_t host_irq_get_count(uint num);
+
+// Drive a GPIO's input level, as an external device would
+void host_gpio_set_input(uint gpio, bool value);
+
+// Run every enabled PIO state machine for a number of system clock cycles
+void host_pio_run(uint32_t cycles);
+
+// Switch time_us_64 and the other time functions to a fake clock starting at start_us, so time only moves with
+// host_time_advance_us and sleep_us
+void host_time_use_fake(uint64_t start_us);
+
+// Advance the fake clock, calling each alarm that comes due in order, with the clock set to its due time
+void host_time_advance_us(uint64_t us);
+
+#endif // HOST_HARDWARE_H
@@ -0,0 +1,45 @@
+/**
+ * @file    stdlib.h
+ * @brief   Host stand-in for the parts of pico/stdlib.h used by common_lib.
+ * @details Time is taken from the host's monotonic clock, so time_us_64() behaves like the RP2040 timer, unless the
+ *          simulation switches to a fake clock (see host_time_use_fake in host_hardware.h).
+ *          Alarms only fire as the fake clock is advanced; with the real clock they never fire.
+ */
+
+#ifndef HOST_PICO_STDLIB_H
+#define HOST_PICO_STDLIB_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <string.h>
+
+typedef unsigned int uint;
+typedef uint64_t absolute_time_t;
+typedef int32_t alarm_id_t;
+
+// Return 0 to not reschedule, >0 to reschedule that many microseconds after the alarm was due, <0 to reschedule
+// that many microseconds after the callback returns
+typedef int64_t (*alarm_callback_t)(alarm_id_t id, void * user_data);
+
+uint64_t time_us_64(void);
+uint32_t time_us_32(void);
+absolute_time_t get_absolute_time(void);
+int64_t absolute_time_diff_us(absolute_time_t from, absolute_time_t to);
+
+void sleep_us(uint64_t us);
+void sleep_ms(uint32_t ms);
+
+// Returns the alarm's ID, 0 if it was already due and fire_if_past is false, or -1 if there are no free alarms
+alarm_id_t add_alarm_in_us(uint64_t us, alarm_callback_t callback, void * user_data, bool fire_if_past);
+bool cancel_alarm(alarm_id_t alarm_id);
+
+static inline void tight_loop_contents(void) {}
+
+// Everything on the host runs as core 0
+static inline uint get_core_num(void) {
+    return 0;
+}
+
+#endif // HOST_PICO_STDLIB_H
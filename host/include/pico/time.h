@@ -0,0 +1,11 @@
+/**
+ * @file    time.h
+ * @brief   Host stand-in for pico/time.h, the time functions are provided by the pico/stdlib.h stand-in.
+ */
+
+#ifndef HOST_PICO_TIME_H
+#define HOST_PICO_TIME_H
+
+#include "pico/stdlib.h"
+
+#endif // HOST_PICO_TIME_H
@@ -0,0 +1,196 @@
+#include "FreeRTOS.h"
+#include "task.h"
+#include "queue.h"
+#include "semphr.h"
+
+#include "pico/stdlib.h"
+#include "host_hardware.h"
+
+#include <stdlib.h>
+
+// Tasks only keep track of what the scheduler would need to know about them
+struct tskTaskControlBlock {
+    TaskFunction_t task_code;
+    void * parameters;
+    UBaseType_t priority;
+    bool is_suspended;
+    uint32_t notify_value;
+};
+
+// The caller, the only task that ever runs
+static struct tskTaskControlBlock current_task = {.priority = 1};
+
+// Ticks skipped by waits that timed out, since nothing on the host could have ended them early
+static TickType_t skipped_ticks = 0;
+
+// Queues are a fixed-size ring of items
+struct QueueDefinition {
+    uint8_t * items;
+    UBaseType_t length;
+    UBaseType_t item_size;
+    UBaseType_t head;
+    UBaseType_t count;
+};
+
+// Create a task, it is never run
+BaseType_t xTaskCreate(TaskFunction_t pxTaskCode, const char * const pcName, const uint32_t usStackDepth, void * const pvParameters, UBaseType_t uxPriority, TaskHandle_t * const pxCreatedTask) {
+    TaskHandle_t task = calloc(1, sizeof(struct tskTaskControlBlock));
+    if(task == NULL) {
+        return pdFAIL;
+    }
+
+    task->task_code = pxTaskCode;
+    task->parameters = pvParameters;
+    task->priority = uxPriority;
+
+    if(pxCreatedTask != NULL) {
+        *pxCreatedTask = task;
+    }
+
+    return pdPASS;
+}
+
+// Delete a task
+void vTaskDelete(TaskHandle_t xTaskToDelete) {
+    free(xTaskToDelete);
+}
+
+// Set the priority of a task
+void vTaskPrioritySet(TaskHandle_t xTask, UBaseType_t uxNewPriority) {
+    if(xTask != NULL) {
+        xTask->priority = uxNewPriority;
+    }
+}
+
+// Get the priority of a task
+UBaseType_t uxTaskPriorityGet(TaskHandle_t xTask) {
+    return (xTask != NULL) ? xTask->priority : 0;
+}
+
+// Mark a task as suspended
+void vTaskSuspend(TaskHandle_t xTaskToSuspend) {
+    if(xTaskToSuspend != NULL) {
+        xTaskToSuspend->is_suspended = true;
+    }
+}
+
+// Mark a task as resumed
+void vTaskResume(TaskHandle_t xTaskToResume) {
+    if(xTaskToResume != NULL) {
+        xTaskToResume->is_suspended = false;
+    }
+}
+
+// Delay the calling thread for a number of ticks
+void vTaskDelay(const TickType_t xTicksToDelay) {
+    sleep_ms(xTicksToDelay * portTICK_PERIOD_MS);
+}
+
+// There is no scheduler on the host, return straight away
+void vTaskStartScheduler(void) {
+}
+
+// Get the number of ticks since boot from the host's monotonic clock, plus the ticks skipped by timed out waits
+TickType_t xTaskGetTickCount(void) {
+    return (TickType_t)(time_us_64() / (1000000u / configTICK_RATE_HZ)) + skipped_ticks;
+}
+
+// Get the caller's task
+TaskHandle_t xTaskGetCurrentTaskHandle(void) {
+    return &current_task;
+}
+
+// Give a task's notification, from a simulated irq
+void vTaskNotifyGiveFromISR(TaskHandle_t xTaskToNotify, BaseType_t * pxHigherPriorityTaskWoken) {
+    if(xTaskToNotify == NULL) {
+        return;
+    }
+    xTaskToNotify->notify_value++;
+    if(pxHigherPriorityTaskWoken != NULL) {
+        *pxHigherPriorityTaskWoken = pdTRUE;
+    }
+}
+
+// Take the caller's notification, running the simulated hardware until it is given
+// Times out once the simulation settles without giving it, moving the tick count to the end of the wait
+uint32_t ulTaskNotifyTake(BaseType_t xClearCountOnExit, TickType_t xTicksToWait) {
+    while(current_task.notify_value == 0 && xTicksToWait > 0 && host_hardware_step()) {
+    }
+
+    uint32_t value = current_task.notify_value;
+    if(value == 0) {
+        if(xTicksToWait != portMAX_DELAY) {
+            skipped_ticks += xTicksToWait;
+        }
+        return 0;
+    }
+
+    current_task.notify_value = xClearCountOnExit ? 0 : value - 1;
+    return value;
+}
+
+// Create a queue
+QueueHandle_t xQueueCreate(UBaseType_t uxQueueLength, UBaseType_t uxItemSize) {
+    QueueHandle_t queue = calloc(1, sizeof(struct QueueDefinition));
+    if(queue == NULL) {
+        return NULL;
+    }
+
+    queue->items = calloc(uxQueueLength, (uxItemSize > 0) ? uxItemSize : 1);
+    if(queue->items == NULL) {
+        free(queue);
+        return NULL;
+    }
+
+    queue->length = uxQueueLength;
+    queue->item_size = uxItemSize;
+
+    return queue;
+}
+
+// Send an item to the back of a queue, fails immediately if the queue is full
+BaseType_t xQueueSend(QueueHandle_t xQueue, const void * const pvItemToQueue, TickType_t xTicksToWait) {
+    if(xQueue == NULL || xQueue->count >= xQueue->length) {
+        return pdFAIL;
+    }
+
+    UBaseType_t tail = (xQueue->head + xQueue->count) % xQueue->length;
+    if(pvItemToQueue != NULL) {
+        memcpy(&xQueue->items[tail * xQueue->item_size], pvItemToQueue, xQueue->item_size);
+    }
+    xQueue->count++;
+
+    return pdPASS;
+}
+
+// Receive an item from the front of a queue, fails immediately if the queue is empty
+BaseType_t xQueueReceive(QueueHandle_t xQueue, void * const pvBuffer, TickType_t xTicksToWait) {
+    if(xQueue == NULL || xQueue->count == 0) {
+        return pdFALSE;
+    }
+
+    if(pvBuffer != NULL) {
+        memcpy(pvBuffer, &xQueue->items[xQueue->head * xQueue->item_size], xQueue->item_size);
+    }
+    xQueue->head = (xQueue->head + 1) % xQueue->length;
+    xQueue->count--;
+
+    return pdTRUE;
+}
+
+// Create a mutex as a queue holding a single token
+SemaphoreHandle_t xSemaphoreCreateMutex(void) {
+    SemaphoreHandle_t mutex = xQueueCreate(1, 0);
+    xQueueSend(mutex, NULL, 0);
+    return mutex;
+}
+
+// Take a mutex, fails immediately if it is already taken
+BaseType_t xSemaphoreTake(SemaphoreHandle_t xSemaphore, TickType_t xBlockTime) {
+    return xQueueReceive(xSemaphore, NULL, xBlockTime);
+}
+
+// Give a mutex back
+BaseType_t xSemaphoreGive(SemaphoreHandle_t xSemaphore) {
+    return xQueueSend(xSemaphore, NULL, 0);
+}
@@ -0,0 +1,194 @@
+#include "hardware/dma.h"
+#include "host_hardware_internal.h"
+
+#include <stdlib.h>
+
+dma_channel_hw_t host_dma_channel_hw[NUM_DMA_CHANNELS];
+
+static uint32_t claimed_channels;
+static uint32_t irq_enabled_channels[2];
+static uint32_t raised_channels;
+
+dma_channel_config dma_channel_get_default_config(uint channel) {
+    dma_channel_config c = {0};
+    channel_config_set_read_increment(&c, true);
+    channel_config_set_write_increment(&c, false);
+    channel_config_set_dreq(&c, DREQ_FORCE);
+    channel_config_set_chain_to(&c, channel);
+    channel_config_set_transfer_data_size(&c, DMA_SIZE_32);
+    channel_config_set_ring(&c, false, 0);
+    channel_config_set_irq_quiet(&c, false);
+    channel_config_set_enable(&c, true);
+    return c;
+}
+
+int dma_claim_unused_channel(bool required) {
+    for(uint i = 0; i < NUM_DMA_CHANNELS; i++) {
+        if((claimed_channels & (1u << i)) == 0) {
+            claimed_channels |= (1u << i);
+            return (int)i;
+        }
+    }
+
+    if(required) {
+        fprintf(stderr, "No DMA channels are available\n");
+        abort();
+    }
+    return -1;
+}
+
+void dma_channel_claim(uint channel) {
+    claimed_channels |= (1u << channel);
+}
+
+void dma_channel_unclaim(uint channel) {
+    claimed_channels &= ~(1u << channel);
+}
+
+void dma_channel_start(uint channel) {
+    dma_channel_hw_t * hw = &host_dma_channel_hw[channel];
+    if(hw->ctrl_trig & DMA_CH0_CTRL_TRIG_EN_BITS) {
+        hw->ctrl_trig |= DMA_CH0_CTRL_TRIG_BUSY_BITS;
+    }
+}
+
+void dma_channel_set_config(uint channel, const dma_channel_config * config, bool trigger) {
+    dma_channel_hw_t * hw = &host_dma_channel_hw[channel];
+    hw->ctrl_trig = (config->ctrl & ~DMA_CH0_CTRL_TRIG_BUSY_BITS) | (hw->ctrl_trig & DMA_CH0_CTRL_TRIG_BUSY_BITS);
+    if(trigger) {
+        dma_channel_start(channel);
+    }
+}
+
+void dma_channel_set_read_addr(uint channel, const volatile void * read_addr, bool trigger) {
+    host_dma_channel_hw[channel].read_addr = (uintptr_t)read_addr;
+    if(trigger) {
+        dma_channel_start(channel);
+    }
+}
+
+void dma_channel_set_write_addr(uint channel, volatile void * write_addr, bool trigger) {
+    host_dma_channel_hw[channel].write_addr = (uintptr_t)write_addr;
+    if(trigger) {
+        dma_channel_start(channel);
+    }
+}
+
+void dma_channel_set_trans_count(uint channel, uint32_t trans_count, bool trigger) {
+    host_dma_channel_hw[channel].transfer_count = trans_count;
+    if(trigger) {
+        dma_channel_start(channel);
+    }
+}
+
+void dma_channel_configure(uint channel, const dma_channel_config * config, volatile void * write_addr, const volatile void * read_addr, uint transfer_count, bool trigger) {
+    dma_channel_set_read_addr(channel, read_addr, false);
+    dma_channel_set_write_addr(channel, write_addr, false);
+    dma_channel_set_trans_count(channel, transfer_count, false);
+    dma_channel_set_config(channel, config, trigger);
+}
+
+void dma_channel_abort(uint channel) {
+    host_dma_channel_hw[channel].ctrl_trig &= ~DMA_CH0_CTRL_TRIG_BUSY_BITS;
+}
+
+bool dma_channel_is_busy(uint channel) {
+    return (host_dma_channel_hw[channel].ctrl_trig & DMA_CH0_CTRL_TRIG_BUSY_BITS) != 0;
+}
+
+void dma_irqn_set_channel_enabled(uint irq_index, uint channel, bool enabled) {
+    if(enabled) {
+        irq_enabled_channels[irq_index] |= (1u << channel);
+    }
+    else {
+        irq_enabled_channels[irq_index] &= ~(1u << channel);
+    }
+}
+
+bool dma_irqn_get_channel_status(uint irq_index, uint channel) {
+    return (raised_channels & irq_enabled_channels[irq_index] & (1u << channel)) != 0;
+}
+
+void dma_irqn_acknowledge_channel(uint irq_index, uint channel) {
+    (void)irq_index;
+    raised_channels &= ~(1u << channel);
+}
+
+// Advance an address by one transfer, wrapping it within its ring if the ring applies to it
+static uintptr_t advance_address(uintptr_t addr, uint32_t ctrl, uint32_t size, bool is_write) {
+    uint32_t ring_size_bits = (ctrl & DMA_CH0_CTRL_TRIG_RING_SIZE_BITS) >> DMA_CH0_CTRL_TRIG_RING_SIZE_LSB;
+    bool ring_is_write = (ctrl & DMA_CH0_CTRL_TRIG_RING_SEL_BITS) != 0;
+    uintptr_t next = addr + size;
+    if(ring_size_bits != 0 && ring_is_write == is_write) {
+        uintptr_t ring_mask = ((uintptr_t)1 << ring_size_bits) - 1;
+        next = (addr & ~ring_mask) | (next & ring_mask);
+    }
+    return next;
+}
+
+// Perform one transfer of a channel, going through the UART stand-in for UART data registers
+static void transfer(dma_channel_hw_t * hw, uint32_t size) {
+    uint32_t data = 0;
+    if(host_uart_is_data_register(hw->read_addr)) {
+        data = host_uart_dma_read(hw->read_addr);
+    }
+    else {
+        memcpy(&data, (const void *)hw->read_addr, size);
+    }
+
+    if(host_uart_is_data_register(hw->write_addr)) {
+        host_uart_dma_write(hw->write_addr, (uint8_t)data);
+    }
+    else {
+        memcpy((void *)hw->write_addr, &data, size);
+    }
+
+    uint32_t ctrl = hw->ctrl_trig;
+    if(ctrl & DMA_CH0_CTRL_TRIG_INCR_READ_BITS) {
+        hw->read_addr = advance_address(hw->read_addr, ctrl, size, false);
+    }
+    if(ctrl & DMA_CH0_CTRL_TRIG_INCR_WRITE_BITS) {
+        hw->write_addr = advance_address(hw->write_addr, ctrl, size, true);
+    }
+    hw->transfer_count--;
+}
+
+bool host_dma_step(void) {
+    bool progress = false;
+
+    for(uint channel = 0; channel < NUM_DMA_CHANNELS; channel++) {
+        dma_channel_hw_t * hw = &host_dma_channel_hw[channel];
+        if(!(hw->ctrl_trig & DMA_CH0_CTRL_TRIG_BUSY_BITS)) {
+            continue;
+        }
+
+        // Transfer for as long as the channel's DREQ allows
+        uint32_t ctrl = hw->ctrl_trig;
+        uint32_t size = 1u << ((ctrl & DMA_CH0_CTRL_TRIG_DATA_SIZE_BITS) >> DMA_CH0_CTRL_TRIG_DATA_SIZE_LSB);
+        uint treq = (ctrl & DMA_CH0_CTRL_TRIG_TREQ_SEL_BITS) >> DMA_CH0_CTRL_TRIG_TREQ_SEL_LSB;
+        while(hw->transfer_count > 0 && (treq == DREQ_FORCE || host_uart_dreq(treq))) {
+            transfer(hw, size);
+            progress = true;
+        }
+        host_uart_update_status();
+
+        // Complete the channel, raising its interrupt and triggering the channel it chains to
+        if(hw->transfer_count == 0) {
+            hw->ctrl_trig &= ~DMA_CH0_CTRL_TRIG_BUSY_BITS;
+            if(!(ctrl & DMA_CH0_CTRL_TRIG_IRQ_QUIET_BITS)) {
+                raised_channels |= (1u << channel);
+            }
+            uint chain_to = (ctrl & DMA_CH0_CTRL_TRIG_CHAIN_TO_BITS) >> DMA_CH0_CTRL_TRIG_CHAIN_TO_LSB;
+            if(chain_to != channel) {
+                dma_channel_start(chain_to);
+            }
+            progress = true;
+        }
+    }
+
+    return progress;
+}
+
+bool host_dma_irq_pending(uint irq_index) {
+    return (raised_channels & irq_enabled_channels[irq_index]) != 0;
+}
@@ -0,0 +1,32 @@
+#include "hardware/gpio.h"
+#include "host_hardware.h"
+
+typedef struct {
+    bool is_output;
+    bool output;
+    bool input;
+} host_gpio_t;
+
+static host_gpio_t gpios[NUM_BANK0_GPIOS];
+
+void gpio_init(uint gpio) {
+    gpios[gpio].is_output = false;
+    gpios[gpio].output = false;
+}
+
+void gpio_set_dir(uint gpio, bool out) {
+    gpios[gpio].is_output = out;
+}
+
+void gpio_put(uint gpio, bool value) {
+    gpios[gpio].output = value;
+}
+
+// An output pin reads back the level it drives, like the RP2040's pad input does
+bool gpio_get(uint gpio) {
+    return gpios[gpio].is_output ? gpios[gpio].output : gpios[gpio].input;
+}
+
+void host_gpio_set_input(uint gpio, bool value) {
+    gpios[gpio].input = value;
+}
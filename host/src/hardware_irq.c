@@ -0,0 +1,97 @@
+#include "hardware/irq.h"
+#include "host_hardware.h"
+#include "host_hardware_internal.h"
+
+#define HOST_IRQ_MAX_HANDLERS   4u
+
+typedef struct {
+    irq_handler_t handlers[HOST_IRQ_MAX_HANDLERS];
+    uint8_t num_handlers;
+    bool is_enabled;
+    uint32_t count;
+} host_irq_t;
+
+static host_irq_t host_irqs[NUM_IRQS];
+
+// Steps taken by host_hardware_step since the program started
+static uint64_t step_count = 0;
+
+void irq_set_exclusive_handler(uint num, irq_handler_t handler) {
+    host_irqs[num].handlers[0] = handler;
+    host_irqs[num].num_handlers = 1;
+}
+
+void irq_add_shared_handler(uint num, irq_handler_t handler, uint8_t order_priority) {
+    (void)order_priority;
+    host_irq_t * irq = &host_irqs[num];
+    for(uint8_t i = 0; i < irq->num_handlers; i++) {
+        if(irq->handlers[i] == handler) {
+            return;
+        }
+    }
+    if(irq->num_handlers < HOST_IRQ_MAX_HANDLERS) {
+        irq->handlers[irq->num_handlers++] = handler;
+    }
+}
+
+void irq_remove_handler(uint num, irq_handler_t handler) {
+    host_irq_t * irq = &host_irqs[num];
+    for(uint8_t i = 0; i < irq->num_handlers; i++) {
+        if(irq->handlers[i] == handler) {
+            irq->handlers[i] = irq->handlers[--irq->num_handlers];
+            return;
+        }
+    }
+}
+
+void irq_set_enabled(uint num, bool enabled) {
+    host_irqs[num].is_enabled = enabled;
+}
+
+bool irq_is_enabled(uint num) {
+    return host_irqs[num].is_enabled;
+}
+
+uint32_t host_irq_get_count(uint num) {
+    return host_irqs[num].count;
+}
+
+// Call the handlers of an interrupt if it is raised and enabled, returns whether they were called
+static bool service(uint num, bool is_raised) {
+    host_irq_t * irq = &host_irqs[num];
+    if(!is_raised || !irq->is_enabled || irq->num_handlers == 0) {
+        return false;
+    }
+
+    irq->count++;
+    for(uint8_t i = 0; i < irq->num_handlers; i++) {
+        irq->handlers[i]();
+    }
+    host_uart_update_status();
+    return true;
+}
+
+bool host_hardware_step(void) {
+    bool progress = host_uart_step();
+    progress |= host_dma_step();
+    progress |= service(DMA_IRQ_0, host_dma_irq_pending(0));
+    progress |= service(DMA_IRQ_1, host_dma_irq_pending(1));
+    progress |= service(UART0_IRQ, host_uart_irq_pending(0));
+    progress |= service(UART1_IRQ, host_uart_irq_pending(1));
+    step_count++;
+    return progress;
+}
+
+uint64_t host_hardware_get_step_count(void) {
+    return step_count;
+}
+
+uint32_t host_hardware_run(uint32_t max_steps) {
+    uint32_t steps = 0;
+    bool progress = true;
+    while(progress && steps < max_steps) {
+        progress = host_hardware_step();
+        steps++;
+    }
+    return steps;
+}
@@ -0,0 +1,344 @@
+#include "hardware/pio.h"
+#include "host_hardware.h"
+
+#include <stdlib.h>
+
+#define PIO_RX_FIFO_DEPTH           4u
+#define PIO_JOINED_RX_FIFO_DEPTH    8u
+
+typedef struct {
+    bool is_claimed;
+    bool is_enabled;
+    pio_sm_config config;
+
+    // Execution state
+    uint8_t pc;
+    uint32_t x;
+    uint32_t y;
+    uint32_t isr;
+    uint8_t delay;              // State machine cycles left of the current instruction's delay
+    uint32_t clkdiv_count;      // System clock cycles since the last state machine cycle
+    bool has_exec;              // An instruction from pio_sm_exec stalled and is retried instead of fetching
+    uint16_t exec_instr;
+
+    uint32_t rx_fifo[PIO_JOINED_RX_FIFO_DEPTH];
+    uint8_t rx_head;
+    uint8_t rx_level;
+} host_pio_sm_t;
+
+struct host_pio {
+    uint16_t instructions[PIO_INSTRUCTION_COUNT];
+    uint32_t used_instructions;
+    host_pio_sm_t sms[NUM_PIO_STATE_MACHINES];
+};
+
+static host_pio_t pios[NUM_PIOS];
+
+host_pio_t * const host_pios[NUM_PIOS] = {&pios[0], &pios[1]};
+
+// Stop the simulation on an instruction the model doesn't cover, rather than silently running it wrong
+static void unsupported(uint16_t instr) {
+    fprintf(stderr, "host PIO: unsupported instruction 0x%04x\n", instr);
+    abort();
+}
+
+// Get a program's instruction mask if it fits at offset, or 0 if it doesn't
+static uint32_t program_mask(PIO pio, const pio_program_t * program, uint offset) {
+    if(offset + program->length > PIO_INSTRUCTION_COUNT) {
+        return 0;
+    }
+    uint32_t mask = (program->length == 32 ? 0xFFFFFFFFu : (1u << program->length) - 1u) << offset;
+    return (pio->used_instructions & mask) == 0 ? mask : 0;
+}
+
+// Find where a program can be loaded, searching from the top of instruction memory like the SDK, or -1 if it can't
+static int find_offset(PIO pio, const pio_program_t * program) {
+    if(program->origin >= 0) {
+        return program_mask(pio, program, (uint)program->origin) != 0 ? program->origin : -1;
+    }
+    for(int offset = PIO_INSTRUCTION_COUNT - program->length; offset >= 0; offset--) {
+        if(program_mask(pio, program, (uint)offset) != 0) {
+            return offset;
+        }
+    }
+    return -1;
+}
+
+bool pio_can_add_program(PIO pio, const pio_program_t * program) {
+    return find_offset(pio, program) >= 0;
+}
+
+uint pio_add_program(PIO pio, const pio_program_t * program) {
+    int offset = find_offset(pio, program);
+    if(offset < 0) {
+        fprintf(stderr, "host PIO: no program space\n");
+        abort();
+    }
+
+    for(uint8_t i = 0; i < program->length; i++) {
+        uint16_t instr = program->instructions[i];
+        pio->instructions[offset + i] = (instr & 0xE000u) == pio_instr_bits_jmp ? (uint16_t)(instr + offset) : instr;
+    }
+    pio->used_instructions |= program_mask(pio, program, (uint)offset);
+    return (uint)offset;
+}
+
+void pio_remove_program(PIO pio, const pio_program_t * program, uint loaded_offset) {
+    uint32_t mask = (program->length == 32 ? 0xFFFFFFFFu : (1u << program->length) - 1u) << loaded_offset;
+    pio->used_instructions &= ~mask;
+}
+
+uint pio_get_index(PIO pio) {
+    return (uint)(pio - pios);
+}
+
+// Claim a state machine nobody else is using, panicking like the SDK if none are left and one is required
+int pio_claim_unused_sm(PIO pio, bool required) {
+    for(uint sm = 0; sm < NUM_PIO_STATE_MACHINES; sm++) {
+        if(!pio->sms[sm].is_claimed) {
+            pio->sms[sm].is_claimed = true;
+            return (int)sm;
+        }
+    }
+    if(required) {
+        fprintf(stderr, "host PIO: no state machines are available\n");
+        abort();
+    }
+    return -1;
+}
+
+void pio_sm_unclaim(PIO pio, uint sm) {
+    pio->sms[sm].is_claimed = false;
+}
+
+pio_sm_config pio_get_default_sm_config(void) {
+    pio_sm_config config = {
+        .clkdiv_int = 1,
+        .wrap_target = 0,
+        .wrap = PIO_INSTRUCTION_COUNT - 1,
+        .in_base = 0,
+        .jmp_pin = 0,
+        .fifo_join = PIO_FIFO_JOIN_NONE,
+    };
+    return config;
+}
+
+// Read the 32 pins starting at the state machine's in base, wrapping like the RP2040's
+static uint32_t read_in_pins(host_pio_sm_t * sm) {
+    uint32_t value = 0;
+    for(uint i = 0; i < 32; i++) {
+        uint gpio = (sm->config.in_base + i) % 32u;
+        if(gpio < NUM_BANK0_GPIOS && gpio_get(gpio)) {
+            value |= 1u << i;
+        }
+    }
+    return value;
+}
+
+static uint32_t reverse_bits(uint32_t value) {
+    uint32_t result = 0;
+    for(uint i = 0; i < 32; i++) {
+        result = (result << 1) | ((value >> i) & 1u);
+    }
+    return result;
+}
+
+// Push the ISR to the RX FIFO, returns false if the FIFO is full and the push blocks
+static bool push(host_pio_sm_t * sm, bool block) {
+    uint8_t depth = sm->config.fifo_join == PIO_FIFO_JOIN_RX ? PIO_JOINED_RX_FIFO_DEPTH : PIO_RX_FIFO_DEPTH;
+    if(sm->rx_level == depth) {
+        if(block) {
+            return false;
+        }
+        // A non-blocking push to a full FIFO drops the ISR
+        sm->isr = 0;
+        return true;
+    }
+    sm->rx_fifo[(sm->rx_head + sm->rx_level) % PIO_JOINED_RX_FIFO_DEPTH] = sm->isr;
+    sm->rx_level++;
+    sm->isr = 0;
+    return true;
+}
+
+// Execute one instruction, returns false if it stalled; the program counter is only moved by fetched instructions and jumps
+static bool execute(host_pio_sm_t * sm, uint16_t instr, bool is_fetched) {
+    uint8_t arg1 = (instr >> 5) & 0x07u;
+    uint8_t arg2 = instr & 0x1Fu;
+    bool is_jump = false;
+
+    switch(instr & 0xE000u) {
+        case pio_instr_bits_jmp: {
+            bool condition;
+            switch(arg1) {
+                case 0: condition = true; break;
+                case 1: condition = sm->x == 0; break;
+                case 2: condition = sm->x-- != 0; break;
+                case 3: condition = sm->y == 0; break;
+                case 4: condition = sm->y-- != 0; break;
+                case 5: condition = sm->x != sm->y; break;
+                case 6: condition = gpio_get(sm->config.jmp_pin); break;
+                default: unsupported(instr); return false;
+            }
+            if(condition) {
+                sm->pc = arg2;
+                is_jump = true;
+            }
+            break;
+        }
+        case pio_instr_bits_wait: {
+            bool polarity = (arg1 & 0x04u) != 0;
+            uint gpio;
+            switch(arg1 & 0x03u) {
+                case 0: gpio = arg2; break;
+                case 1: gpio = (sm->config.in_base + arg2) % 32u; break;
+                default: unsupported(instr); return false;
+            }
+            if((gpio < NUM_BANK0_GPIOS && gpio_get(gpio)) != polarity) {
+                return false;
+            }
+            break;
+        }
+        case pio_instr_bits_push: {
+            // PULL and PUSH IFFULL need the shift counters, which aren't modelled
+            if((instr & 0x80u) != 0 || (arg1 & 0x02u) != 0) {
+                unsupported(instr);
+            }
+            if(!push(sm, (arg1 & 0x01u) != 0)) {
+                return false;
+            }
+            break;
+        }
+        case pio_instr_bits_mov: {
+            uint32_t value;
+            switch(arg2 & 0x07u) {
+                case 0: value = read_in_pins(sm); break;
+                case 1: value = sm->x; break;
+                case 2: value = sm->y; break;
+                case 3: value = 0; break;
+                case 6: value = sm->isr; break;
+                default: unsupported(instr); return false;
+            }
+            switch((arg2 >> 3) & 0x03u) {
+                case 0: break;
+                case 1: value = ~value; break;
+                case 2: value = reverse_bits(value); break;
+                default: unsupported(instr); return false;
+            }
+            switch(arg1) {
+                case 1: sm->x = value; break;
+                case 2: sm->y = value; break;
+                case 5: sm->pc = (uint8_t)(value % PIO_INSTRUCTION_COUNT); is_jump = true; break;
+                case 6: sm->isr = value; break;
+                default: unsupported(instr); return false;
+            }
+            break;
+        }
+        case pio_instr_bits_set: {
+            switch(arg1) {
+                case 1: sm->x = arg2; break;
+                case 2: sm->y = arg2; break;
+                default: unsupported(instr); return false;
+            }
+            break;
+        }
+        default:
+            unsupported(instr);
+            return false;
+    }
+
+    if(is_fetched && !is_jump) {
+        sm->pc = sm->pc == sm->config.wrap ? sm->config.wrap_target : (uint8_t)(sm->pc + 1);
+    }
+    sm->delay = (instr >> 8) & 0x1Fu;
+    return true;
+}
+
+// Run one state machine cycle: count down a delay, or retry a stalled instruction, or fetch and execute the next one
+// Returns false if the state machine is stalled
+static bool step_sm(PIO pio, host_pio_sm_t * sm) {
+    if(sm->delay > 0) {
+        sm->delay--;
+        return true;
+    }
+    if(sm->has_exec) {
+        sm->has_exec = !execute(sm, sm->exec_instr, false);
+        return !sm->has_exec;
+    }
+    return execute(sm, pio->instructions[sm->pc], true);
+}
+
+void pio_sm_init(PIO pio, uint sm, uint initial_pc, const pio_sm_config * config) {
+    host_pio_sm_t * state = &pio->sms[sm];
+    state->is_enabled = false;
+    state->config = *config;
+    pio_sm_clear_fifos(pio, sm);
+    pio_sm_restart(pio, sm);
+    state->pc = (uint8_t)initial_pc;
+}
+
+void pio_sm_set_enabled(PIO pio, uint sm, bool enabled) {
+    pio->sms[sm].is_enabled = enabled;
+}
+
+void pio_sm_restart(PIO pio, uint sm) {
+    host_pio_sm_t * state = &pio->sms[sm];
+    state->isr = 0;
+    state->delay = 0;
+    state->clkdiv_count = 0;
+    state->has_exec = false;
+}
+
+// Execute an instruction immediately, it is retried each cycle if it stalls
+void pio_sm_exec(PIO pio, uint sm, uint instr) {
+    host_pio_sm_t * state = &pio->sms[sm];
+    state->exec_instr = (uint16_t)instr;
+    state->has_exec = !execute(state, (uint16_t)instr, false);
+}
+
+void pio_sm_clear_fifos(PIO pio, uint sm) {
+    pio->sms[sm].rx_head = 0;
+    pio->sms[sm].rx_level = 0;
+}
+
+uint pio_sm_get_rx_fifo_level(PIO pio, uint sm) {
+    return pio->sms[sm].rx_level;
+}
+
+bool pio_sm_is_rx_fifo_empty(PIO pio, uint sm) {
+    return pio->sms[sm].rx_level == 0;
+}
+
+// Reading an empty FIFO returns 0 here; on the RP2040 it returns garbage
+uint32_t pio_sm_get(PIO pio, uint sm) {
+    host_pio_sm_t * state = &pio->sms[sm];
+    if(state->rx_level == 0) {
+        return 0;
+    }
+    uint32_t value = state->rx_fifo[state->rx_head];
+    state->rx_head = (state->rx_head + 1) % PIO_JOINED_RX_FIFO_DEPTH;
+    state->rx_level--;
+    return value;
+}
+
+// Pins only change between calls and the state machines don't interact, so each one runs through all the cycles in turn,
+// and one that stalls stays stalled until the next call
+void host_pio_run(uint32_t cycles) {
+    for(uint p = 0; p < NUM_PIOS; p++) {
+        for(uint sm = 0; sm < NUM_PIO_STATE_MACHINES; sm++) {
+            host_pio_sm_t * state = &pios[p].sms[sm];
+            if(!state->is_enabled) {
+                continue;
+            }
+            uint32_t clkdiv = state->config.clkdiv_int == 0 ? 65536u : state->config.clkdiv_int;
+            for(uint32_t cycle = 0; cycle < cycles; cycle++) {
+                if(++state->clkdiv_count < clkdiv) {
+                    continue;
+                }
+                state->clkdiv_count = 0;
+                if(!step_sm(&pios[p], state)) {
+                    break;
+                }
+            }
+        }
+    }
+}
@@ -0,0 +1,60 @@
+#include "hardware/sync.h"
+
+#include <sched.h>
+#include <stdlib.h>
+
+static spin_lock_t spin_locks[NUM_SPIN_LOCKS];
+static uint32_t claimed_spin_locks;
+
+// Get a spinlock by number
+spin_lock_t * spin_lock_instance(uint lock_num) {
+    return &spin_locks[lock_num];
+}
+
+// Get the number of a spinlock
+uint spin_lock_get_num(spin_lock_t * lock) {
+    return (uint)(lock - spin_locks);
+}
+
+// Reset a spinlock to unlocked and get it
+spin_lock_t * spin_lock_init(uint lock_num) {
+    spin_lock_t * lock = spin_lock_instance(lock_num);
+    __atomic_store_n(lock, 0, __ATOMIC_RELEASE);
+    return lock;
+}
+
+// Claim a spinlock nobody else is using, panicking like the SDK if none are left and one is required
+int spin_lock_claim_unused(bool required) {
+    for(uint i = 0; i < NUM_SPIN_LOCKS; i++) {
+        uint32_t mask = 1u << i;
+        if((__atomic_fetch_or(&claimed_spin_locks, mask, __ATOMIC_ACQ_REL) & mask) == 0) {
+            return (int)i;
+        }
+    }
+
+    if(required) {
+        fprintf(stderr, "No spin locks are available\n");
+        abort();
+    }
+    return -1;
+}
+
+// Release a claimed spinlock
+void spin_lock_unclaim(uint lock_num) {
+    __atomic_fetch_and(&claimed_spin_locks, ~(1u << lock_num), __ATOMIC_ACQ_REL);
+}
+
+// Acquire a spinlock, yielding while it is held so a contended lock doesn't burn a whole timeslice
+uint32_t spin_lock_blocking(spin_lock_t * lock) {
+    uint32_t saved_irq = save_and_disable_interrupts();
+    while(__atomic_exchange_n(lock, 1, __ATOMIC_ACQUIRE) != 0) {
+        sched_yield();
+    }
+    return saved_irq;
+}
+
+// Release a spinlock
+void spin_unlock(spin_lock_t * lock, uint32_t saved_irq) {
+    __atomic_store_n(lock, 0, __ATOMIC_RELEASE);
+    restore_interrupts(saved_irq);
+}
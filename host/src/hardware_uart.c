@@ -0,0 +1,297 @@
+#include "hardware/uart.h"
+#include "hardware/dma.h"
+#include "host_hardware.h"
+#include "host_hardware_internal.h"
+
+#include <stdlib.h>
+
+#define HOST_UART_FIFO_DEPTH    32u
+
+// Simulated state of a UART beyond its register block
+typedef struct {
+    uint8_t tx_fifo[HOST_UART_FIFO_DEPTH];
+    uint8_t tx_head;
+    uint8_t tx_count;
+    uint8_t rx_fifo[HOST_UART_FIFO_DEPTH];
+    uint8_t rx_head;
+    uint8_t rx_count;
+    bool rx_timeout;
+    bool rx_overrun;
+
+    // Characters queued to arrive on the rx line
+    uint8_t * rx_line;
+    size_t rx_line_len;
+    size_t rx_line_pos;
+
+    // Characters that have left on the tx line
+    uint8_t * tx_line;
+    size_t tx_line_len;
+    size_t tx_line_taken;
+} host_uart_t;
+
+uart_hw_t host_uart_hw[NUM_UARTS];
+static host_uart_t host_uarts[NUM_UARTS];
+
+// FIFO trigger levels for IFLS select values 0-4 (1/8, 1/4, 1/2, 3/4, 7/8 full)
+static const uint8_t fifo_trigger_levels[] = {4, 8, 16, 24, 28};
+
+// Append a character to a growable byte array, whose capacity doubles from 64 each time its length reaches a power of two
+static void append(uint8_t ** data, size_t * len, uint8_t c) {
+    if(*len == 0) {
+        *data = realloc(*data, 64);
+    }
+    else if(*len >= 64 && (*len & (*len - 1)) == 0) {
+        *data = realloc(*data, *len * 2);
+    }
+    (*data)[(*len)++] = c;
+}
+
+// Get the FIFO depth, which is 1 when the FIFOs are disabled
+static uint8_t fifo_depth(uint uart_index) {
+    return (host_uart_hw[uart_index].lcr_h & UART_UARTLCR_H_FEN_BITS) ? HOST_UART_FIFO_DEPTH : 1u;
+}
+
+static void push_tx(uint uart_index, uint8_t c) {
+    host_uart_t * state = &host_uarts[uart_index];
+    state->tx_fifo[(state->tx_head + state->tx_count) % HOST_UART_FIFO_DEPTH] = c;
+    state->tx_count++;
+}
+
+static uint8_t pop_rx(uint uart_index) {
+    host_uart_t * state = &host_uarts[uart_index];
+    if(state->rx_count == 0) {
+        return 0;
+    }
+    uint8_t c = state->rx_fifo[state->rx_head];
+    state->rx_head = (state->rx_head + 1) % HOST_UART_FIFO_DEPTH;
+    state->rx_count--;
+
+    // Reading the FIFO empty clears the receive timeout
+    if(state->rx_count == 0) {
+        state->rx_timeout = false;
+    }
+    return c;
+}
+
+// Move characters on one UART's lines, returns whether any moved
+static bool step_uart(uint uart_index) {
+    uart_hw_t * hw = &host_uart_hw[uart_index];
+    host_uart_t * state = &host_uarts[uart_index];
+    bool progress = false;
+
+    // Apply interrupt clears written by the driver
+    uint32_t icr = hw->icr;
+    hw->icr = 0;
+    if(icr & UART_UARTICR_RTIC_BITS) {
+        state->rx_timeout = false;
+    }
+    if(icr & UART_UARTICR_OEIC_BITS) {
+        state->rx_overrun = false;
+    }
+
+    // Transmit from the tx FIFO
+    for(uint8_t i = 0; i < HOST_UART_CHARS_PER_STEP && state->tx_count > 0; i++) {
+        append(&state->tx_line, &state->tx_line_len, state->tx_fifo[state->tx_head]);
+        state->tx_head = (state->tx_head + 1) % HOST_UART_FIFO_DEPTH;
+        state->tx_count--;
+        progress = true;
+    }
+
+    // Receive into the rx FIFO; with RTS flow control the sender is held off instead of overrunning
+    bool received = false;
+    for(uint8_t i = 0; i < HOST_UART_CHARS_PER_STEP && state->rx_line_pos < state->rx_line_len; i++) {
+        if(state->rx_count >= fifo_depth(uart_index)) {
+            if(hw->cr & UART_UARTCR_RTSEN_BITS) {
+                break;
+            }
+            state->rx_overrun = true;
+        }
+        else {
+            state->rx_fifo[(state->rx_head + state->rx_count) % HOST_UART_FIFO_DEPTH] = state->rx_line[state->rx_line_pos];
+            state->rx_count++;
+        }
+        state->rx_line_pos++;
+        received = true;
+        progress = true;
+    }
+
+    // The receive timeout is raised once the rx line goes idle with characters left in the FIFO
+    if(!received && state->rx_count > 0) {
+        state->rx_timeout = true;
+    }
+
+    return progress;
+}
+
+bool host_uart_step(void) {
+    bool progress = false;
+    for(uint i = 0; i < NUM_UARTS; i++) {
+        progress |= step_uart(i);
+    }
+    host_uart_update_status();
+    return progress;
+}
+
+void host_uart_update_status(void) {
+    for(uint i = 0; i < NUM_UARTS; i++) {
+        uart_hw_t * hw = &host_uart_hw[i];
+        host_uart_t * state = &host_uarts[i];
+        uint8_t depth = fifo_depth(i);
+        bool fifo_enabled = (depth > 1);
+
+        uint32_t fr = 0;
+        fr |= (state->rx_count == 0) ? UART_UARTFR_RXFE_BITS : 0;
+        fr |= (state->rx_count >= depth) ? UART_UARTFR_RXFF_BITS : 0;
+        fr |= (state->tx_count >= depth) ? UART_UARTFR_TXFF_BITS : 0;
+        fr |= (state->tx_count == 0) ? UART_UARTFR_TXFE_BITS : UART_UARTFR_BUSY_BITS;
+        hw->fr = fr;
+
+        uint8_t tx_level = fifo_enabled ? fifo_trigger_levels[(hw->ifls & UART_UARTIFLS_TXIFLSEL_BITS) >> UART_UARTIFLS_TXIFLSEL_LSB] : 0;
+        uint8_t rx_level = fifo_enabled ? fifo_trigger_levels[(hw->ifls & UART_UARTIFLS_RXIFLSEL_BITS) >> UART_UARTIFLS_RXIFLSEL_LSB] : 1;
+
+        uint32_t ris = 0;
+        ris |= (state->tx_count <= tx_level) ? UART_UARTRIS_TXRIS_BITS : 0;
+        ris |= (state->rx_count >= rx_level) ? UART_UARTRIS_RXRIS_BITS : 0;
+        ris |= state->rx_timeout ? UART_UARTRIS_RTRIS_BITS : 0;
+        ris |= state->rx_overrun ? UART_UARTRIS_OERIS_BITS : 0;
+        hw->ris = ris;
+        hw->mis = ris & hw->imsc;
+    }
+}
+
+bool host_uart_dreq(uint dreq) {
+    uint uart_index = (dreq - DREQ_UART0_TX) / 2;
+    if(uart_index >= NUM_UARTS) {
+        return false;
+    }
+
+    bool is_tx = ((dreq - DREQ_UART0_TX) % 2) == 0;
+    if(is_tx) {
+        return (host_uart_hw[uart_index].dmacr & UART_UARTDMACR_TXDMAE_BITS) && host_uarts[uart_index].tx_count < fifo_depth(uart_index);
+    }
+    return (host_uart_hw[uart_index].dmacr & UART_UARTDMACR_RXDMAE_BITS) && host_uarts[uart_index].rx_count > 0;
+}
+
+bool host_uart_is_data_register(uintptr_t addr) {
+    return addr == (uintptr_t)&host_uart_hw[0].dr || addr == (uintptr_t)&host_uart_hw[1].dr;
+}
+
+uint8_t host_uart_dma_read(uintptr_t addr) {
+    return pop_rx((addr == (uintptr_t)&host_uart_hw[1].dr) ? 1 : 0);
+}
+
+void host_uart_dma_write(uintptr_t addr, uint8_t data) {
+    push_tx((addr == (uintptr_t)&host_uart_hw[1].dr) ? 1 : 0, data);
+}
+
+bool host_uart_irq_pending(uint uart_index) {
+    return host_uart_hw[uart_index].mis != 0;
+}
+
+void host_uart_inject_rx(uart_inst_t * uart, const uint8_t * data, size_t len) {
+    host_uart_t * state = &host_uarts[uart_get_index(uart)];
+    for(size_t i = 0; i < len; i++) {
+        append(&state->rx_line, &state->rx_line_len, data[i]);
+    }
+}
+
+size_t host_uart_take_tx(uart_inst_t * uart, uint8_t * data, size_t max_len) {
+    host_uart_t * state = &host_uarts[uart_get_index(uart)];
+    size_t len = state->tx_line_len - state->tx_line_taken;
+    if(len > max_len) {
+        len = max_len;
+    }
+    memcpy(data, &state->tx_line[state->tx_line_taken], len);
+    state->tx_line_taken += len;
+    return len;
+}
+
+uint uart_init(uart_inst_t * uart, uint baudrate) {
+    uint uart_index = uart_get_index(uart);
+    uart_hw_t * hw = uart_get_hw(uart);
+
+    // Keep anything queued on the lines, reset the rest like uart_init does on hardware
+    host_uart_t * state = &host_uarts[uart_index];
+    state->tx_head = state->tx_count = 0;
+    state->rx_head = state->rx_count = 0;
+    state->rx_timeout = state->rx_overrun = false;
+
+    hw->lcr_h = UART_UARTLCR_H_FEN_BITS;
+    hw->cr = 0x301u;
+    hw->ifls = (2u << UART_UARTIFLS_RXIFLSEL_LSB) | (2u << UART_UARTIFLS_TXIFLSEL_LSB);
+    hw->imsc = 0;
+    hw->icr = 0;
+    hw->dmacr = UART_UARTDMACR_TXDMAE_BITS | UART_UARTDMACR_RXDMAE_BITS;
+    host_uart_update_status();
+
+    return baudrate;
+}
+
+void uart_set_fifo_enabled(uart_inst_t * uart, bool enabled) {
+    if(enabled) {
+        hw_set_bits(&uart_get_hw(uart)->lcr_h, UART_UARTLCR_H_FEN_BITS);
+    }
+    else {
+        hw_clear_bits(&uart_get_hw(uart)->lcr_h, UART_UARTLCR_H_FEN_BITS);
+    }
+    host_uart_update_status();
+}
+
+void uart_set_hw_flow(uart_inst_t * uart, bool cts, bool rts) {
+    hw_write_masked(&uart_get_hw(uart)->cr, (cts ? UART_UARTCR_CTSEN_BITS : 0u) | (rts ? UART_UARTCR_RTSEN_BITS : 0u),
+                    UART_UARTCR_CTSEN_BITS | UART_UARTCR_RTSEN_BITS);
+}
+
+// Matches the SDK, which also moves the FIFO thresholds to their lowest settings
+void uart_set_irq_enables(uart_inst_t * uart, bool rx_has_data, bool tx_needs_data) {
+    uart_hw_t * hw = uart_get_hw(uart);
+    hw->imsc = (tx_needs_data ? UART_UARTIMSC_TXIM_BITS : 0u) |
+               (rx_has_data ? (UART_UARTIMSC_RXIM_BITS | UART_UARTIMSC_RTIM_BITS) : 0u);
+    if(rx_has_data) {
+        hw_write_masked(&hw->ifls, 0u << UART_UARTIFLS_RXIFLSEL_LSB, UART_UARTIFLS_RXIFLSEL_BITS);
+    }
+    if(tx_needs_data) {
+        hw_write_masked(&hw->ifls, 0u << UART_UARTIFLS_TXIFLSEL_LSB, UART_UARTIFLS_TXIFLSEL_BITS);
+    }
+    host_uart_update_status();
+}
+
+bool uart_is_writable(uart_inst_t * uart) {
+    uint uart_index = uart_get_index(uart);
+    return host_uarts[uart_index].tx_count < fifo_depth(uart_index);
+}
+
+bool uart_is_readable(uart_inst_t * uart) {
+    return host_uarts[uart_get_index(uart)].rx_count > 0;
+}
+
+// Blocks like the SDK by letting the tx line drain until there is room
+void uart_putc_raw(uart_inst_t * uart, char c) {
+    while(!uart_is_writable(uart)) {
+        step_uart(uart_get_index(uart));
+    }
+    push_tx(uart_get_index(uart), (uint8_t)c);
+    host_uart_update_status();
+}
+
+void uart_putc(uart_inst_t * uart, char c) {
+    uart_putc_raw(uart, c);
+}
+
+void uart_puts(uart_inst_t * uart, const char * s) {
+    while(*s) {
+        uart_putc(uart, *s++);
+    }
+}
+
+// Blocks like the SDK by letting the rx line deliver, returns 0 if nothing is left to arrive
+char uart_getc(uart_inst_t * uart) {
+    uint uart_index = uart_get_index(uart);
+    host_uart_t * state = &host_uarts[uart_index];
+    while(state->rx_count == 0 && state->rx_line_pos < state->rx_line_len) {
+        step_uart(uart_index);
+    }
+    char c = (char)pop_rx(uart_index);
+    host_uart_update_status();
+    return c;
+}
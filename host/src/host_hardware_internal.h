@@ -0,0 +1,35 @@
+/**
+ * @file    host_hardware_internal.h
+ * @brief   Hooks shared between the simulated UART, DMA and interrupt stand-ins.
+ */
+
+#ifndef HOST_HARDWARE_INTERNAL_H
+#define HOST_HARDWARE_INTERNAL_H
+
+#include "pico/stdlib.h"
+
+// Move one step's worth of characters on every UART line and update the UART status registers
+// Returns whether any character moved
+bool host_uart_step(void);
+
+// Refresh the UART status registers (fr, ris, mis) after the driver or DMA changed FIFO state
+void host_uart_update_status(void);
+
+// Whether a UART DREQ is asserted
+bool host_uart_dreq(uint dreq);
+
+// Whether an address is a UART data register, and access to it as the DMA would
+bool host_uart_is_data_register(uintptr_t addr);
+uint8_t host_uart_dma_read(uintptr_t addr);
+void host_uart_dma_write(uintptr_t addr, uint8_t data);
+
+// Whether a UART has a raised and unmasked interrupt
+bool host_uart_irq_pending(uint uart_index);
+
+// Perform paced transfers on every busy DMA channel, returns whether anything was transferred or completed
+bool host_dma_step(void);
+
+// Whether a DMA interrupt line has a raised and enabled channel interrupt
+bool host_dma_irq_pending(uint irq_index);
+
+#endif // HOST_HARDWARE_INTERNAL_H
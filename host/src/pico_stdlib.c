@@ -0,0 +1,140 @@
+#define _POSIX_C_SOURCE 199309L
+
+#include "pico/stdlib.h"
+#include "host_hardware.h"
+
+#include <time.h>
+
+#define HOST_MAX_ALARMS     16u
+
+typedef struct {
+    alarm_id_t id;              // 0 when the slot is free
+    uint64_t due_us;
+    alarm_callback_t callback;
+    void * user_data;
+} host_alarm_t;
+
+static host_alarm_t alarms[HOST_MAX_ALARMS];
+static alarm_id_t next_alarm_id = 1;
+
+// The fake clock, used instead of the host's monotonic clock once host_time_use_fake is called
+static bool is_time_fake = false;
+static uint64_t fake_time_us;
+
+// Get the time since boot in microseconds, using the host's monotonic clock
+uint64_t time_us_64(void) {
+    if(is_time_fake) {
+        return fake_time_us;
+    }
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (uint64_t)now.tv_sec * 1000000u + (uint64_t)now.tv_nsec / 1000u;
+}
+
+// Get the lower 32 bits of the time since boot in microseconds
+uint32_t time_us_32(void) {
+    return (uint32_t)time_us_64();
+}
+
+// Get the current absolute time
+absolute_time_t get_absolute_time(void) {
+    return time_us_64();
+}
+
+// Get the difference in microseconds between two absolute times
+int64_t absolute_time_diff_us(absolute_time_t from, absolute_time_t to) {
+    return (int64_t)(to - from);
+}
+
+// Sleep for a number of microseconds, on the fake clock this advances it instead
+void sleep_us(uint64_t us) {
+    if(is_time_fake) {
+        host_time_advance_us(us);
+        return;
+    }
+    struct timespec duration = {
+        .tv_sec = us / 1000000u,
+        .tv_nsec = (us % 1000000u) * 1000u,
+    };
+    nanosleep(&duration, NULL);
+}
+
+// Sleep for a number of milliseconds
+void sleep_ms(uint32_t ms) {
+    sleep_us((uint64_t)ms * 1000u);
+}
+
+// Call an alarm's callback and reschedule or free it as the return value asks
+static void fire_alarm(host_alarm_t * alarm) {
+    int64_t reschedule = alarm->callback(alarm->id, alarm->user_data);
+    if(reschedule > 0) {
+        alarm->due_us += (uint64_t)reschedule;
+    }
+    else if(reschedule < 0) {
+        alarm->due_us = time_us_64() + (uint64_t)(-reschedule);
+    }
+    else {
+        alarm->id = 0;
+    }
+}
+
+alarm_id_t add_alarm_in_us(uint64_t us, alarm_callback_t callback, void * user_data, bool fire_if_past) {
+    for(uint i = 0; i < HOST_MAX_ALARMS; i++) {
+        host_alarm_t * alarm = &alarms[i];
+        if(alarm->id != 0) {
+            continue;
+        }
+
+        alarm->id = next_alarm_id++;
+        alarm->due_us = time_us_64() + us;
+        alarm->callback = callback;
+        alarm->user_data = user_data;
+
+        // Only a zero delay is already due, the clock can't move during this call
+        if(us == 0) {
+            if(!fire_if_past) {
+                alarm->id = 0;
+                return 0;
+            }
+            fire_alarm(alarm);
+        }
+        return alarm->id;
+    }
+    return -1;
+}
+
+bool cancel_alarm(alarm_id_t alarm_id) {
+    for(uint i = 0; i < HOST_MAX_ALARMS; i++) {
+        if(alarm_id > 0 && alarms[i].id == alarm_id) {
+            alarms[i].id = 0;
+            return true;
+        }
+    }
+    return false;
+}
+
+void host_time_use_fake(uint64_t start_us) {
+    is_time_fake = true;
+    fake_time_us = start_us;
+}
+
+void host_time_advance_us(uint64_t us) {
+    uint64_t end_us = fake_time_us + us;
+    while(true) {
+        // Fire the earliest alarm due by the end, callbacks may add, cancel or reschedule alarms
+        host_alarm_t * next = NULL;
+        for(uint i = 0; i < HOST_MAX_ALARMS; i++) {
+            if(alarms[i].id != 0 && alarms[i].due_us <= end_us && (next == NULL || alarms[i].due_us < next->due_us)) {
+                next = &alarms[i];
+            }
+        }
+        if(next == NULL) {
+            break;
+        }
+        if(next->due_us > fake_time_us) {
+            fake_time_us = next->due_us;
+        }
+        fire_alarm(next);
+    }
+    fake_time_us = end_us;
+}
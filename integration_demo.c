@@ -1,6 +1,8 @@
 #include <stdio.h>
 #include <pico/stdlib.h>
 #include "mpu_6050.h"
+#include "hc_sr04.h"
+#include "hc_sr04_adaptive.h"
 #include "edf.h"
 
 #include <FreeRTOS.h>
@@ -10,11 +12,23 @@
 const double GYRO_WEIGHT = 0.8;
 const uint32_t SAMPLES_CALIBRATION = 10000;
 
+const uint8_t HCSR04_ECHO_PIN = 6;
+const uint8_t HCSR04_TRIGGER_PIN = 7;
+
+// Measure every 10 to 200 ms, often enough that the distance changes by at most 5% between readings
+const uint32_t HCSR04_MIN_PERIOD_US = 10000;
+const uint32_t HCSR04_MAX_PERIOD_US = 200000;
+const uint8_t HCSR04_MAX_CHANGE_PERCENT = 5;
+const uint32_t HCSR04_MIN_SPEED_MM_S = 50;
+
 TaskHandle_t mpu_6050_task_handle = NULL;
 TaskHandle_t print_angles_task_handle = NULL;
+TaskHandle_t hcsr04_task_handle = NULL;
 
 const TickType_t mpu_6050_task_period = pdMS_TO_TICKS(10);
 const TickType_t print_angles_task_period = pdMS_TO_TICKS(100);
+// Only the first period, the HC-SR04 task chooses the rest
+const TickType_t hcsr04_task_period = pdMS_TO_TICKS(200);
 
 typedef struct {
     mpu_6050_t * mpu_6050;
@@ -51,20 +65,16 @@ void mpu_6050_task(void *pvParameters)
     vec_double_t * angles = mpu_6050_task_data->angles;
 
     while(1) {
-        if(mpu_6050_read_raw(mpu_6050) != MPU_6050_RC_OK) {
-            continue;
-        }
-
-        if(mpu_6050_convert_read(mpu_6050) != MPU_6050_RC_OK) {
-            continue;
-        }
-
-        xSemaphoreTake(angles_mutex, portMAX_DELAY);
-        {
-            estimate_angles(mpu_6050->accel_data, mpu_6050->gyro_data, mpu_6050->dt, angles);
+        if(mpu_6050_read_raw(mpu_6050) == MPU_6050_RC_OK && mpu_6050_convert_read(mpu_6050) == MPU_6050_RC_OK) {
+            xSemaphoreTake(angles_mutex, portMAX_DELAY);
+            {
+                estimate_angles(mpu_6050->accel_data, mpu_6050->gyro_data, mpu_6050->dt, angles);
+            }
+            xSemaphoreGive(angles_mutex);
         }
-        xSemaphoreGive(angles_mutex);
 
+        // Complete the job even if the read failed, retrying straight away would hold the bus and starve the other tasks
+        // The next job retries, and its dt covers the missed period
         edf_complete_task(mpu_6050_task_handle);
     }
 }
@@ -89,6 +99,26 @@ void print_angles_task(void *pvParameters)
     }
 }
 
+// Measures distance at a rate adapted to how close and how fast obstacles are
+void hcsr04_task(void *pvParameters)
+{
+    hcsr04_adaptive_t * adaptive = (hcsr04_adaptive_t *)pvParameters;
+
+    while (1) {
+        // Collect the measurement the last period started, then start the next one
+        if(hcsr04_adaptive_collect(adaptive) == HCSR04_RC_OK) {
+            printf("%.1f cm, %.1f Hz\n", hcsr04_get_distance_cm(adaptive->sensor), hcsr04_adaptive_get_rate(adaptive));
+        }
+        hcsr04_adaptive_trigger(adaptive);
+
+        // Round the period up to whole ticks, so the next trigger is never early
+        TickType_t period = pdMS_TO_TICKS((hcsr04_adaptive_get_period_us(adaptive) + 999) / 1000);
+        edf_set_task_period(hcsr04_task_handle, period > 0 ? period : 1);
+
+        edf_complete_task(hcsr04_task_handle);
+    }
+}
+
 int main()
 {
     stdio_init_all();
@@ -118,7 +148,14 @@ int main()
     mpu_6050_reset(&mpu_6050);
 
     printf("starting calibration\n");
-    mpu_6050_calibrate(&mpu_6050, SAMPLES_CALIBRATION);
+    rc = mpu_6050_calibrate(&mpu_6050, SAMPLES_CALIBRATION);
+    while(rc != MPU_6050_RC_OK)
+    {
+        // Repeatedly try to calibrate until the bus recovers
+        printf("calibration failed, rc = %d\n", rc);
+        sleep_ms(1000);
+        rc = mpu_6050_calibrate(&mpu_6050, SAMPLES_CALIBRATION);
+    }
     printf("calibration done\n");
 
     // Create other variables used for tasks
@@ -131,19 +168,29 @@ int main()
 
     angles_mutex = xSemaphoreCreateMutex();
 
+    // Initialize HC-SR04, with its echo pulse timed by PIO so the task only has to collect it
+    hcsr04_t hcsr04;
+    hcsr04_init(&hcsr04, HCSR04_TRIGGER_PIN, HCSR04_ECHO_PIN);
+    hcsr04_enable_pio_capture(&hcsr04, pio0);
+
+    hcsr04_adaptive_t hcsr04_adaptive;
+    hcsr04_adaptive_init(&hcsr04_adaptive, &hcsr04, HCSR04_MIN_PERIOD_US, HCSR04_MAX_PERIOD_US, HCSR04_MAX_CHANGE_PERCENT, HCSR04_MIN_SPEED_MM_S);
+
     // Create tasks, passing the arguments to use by reference
     xTaskCreate(mpu_6050_task, "MPU-6050 Task", 256, (void*)&mpu_6050_task_data, EDF_UNSELECTED_PRIORITY, &mpu_6050_task_handle);
     xTaskCreate(print_angles_task, "MPU-6050 Print Task", 256, (void*)&angles, EDF_UNSELECTED_PRIORITY, &print_angles_task_handle);
+    xTaskCreate(hcsr04_task, "HC-SR04 Task", 256, (void*)&hcsr04_adaptive, EDF_UNSELECTED_PRIORITY, &hcsr04_task_handle);
 
     // Define initial tasklist for EDF scheduler
-    edf_task_t tasklist[2] = 
+    edf_task_t tasklist[3] = 
     {
         {.task_handle=mpu_6050_task_handle, .task_deadline=mpu_6050_task_period, .task_period=mpu_6050_task_period, .task_state=EDF_TASK_READY},
         {.task_handle=print_angles_task_handle, .task_deadline=print_angles_task_period, .task_period=print_angles_task_period, .task_state=EDF_TASK_READY},
+        {.task_handle=hcsr04_task_handle, .task_deadline=hcsr04_task_period, .task_period=hcsr04_task_period, .task_state=EDF_TASK_READY},
     };
 
    printf("starting scheduler\n");
-   edf_start(tasklist, 2);
+   edf_start(tasklist, 3);
 
     while(1);
 }
\ No newline at end of file
@@ -18,6 +18,7 @@
 #define MPU_6050_PWR_MGMT_1     0x6B
 #define MPU_6050_WHO_AM_I       0x75
 #define MPU_6050_ACCEL_XOUT_H   0x3B
+#define MPU_6050_TEMP_OUT_H     0x41
 #define MPU_6050_GYRO_XOUT_H    0x43
 #define MPU_6050_GYRO_CONFIG    0x1B
 #define MPU_6050_ACCEL_CONFIG   0x1C
@@ -26,6 +27,16 @@
 #define MPU_6050_ZMOT_THRESHOLD 0x21
 #define MPU_6050ZMOT_DURATION   0x22
 
+// Accel, temperature and gyro data are contiguous from ACCEL_XOUT_H to GYRO_ZOUT_L, 2 bytes each
+#define MPU_6050_SAMPLE_LENGTH  14
+
+// Reads in a row that may fail during calibration before it gives up
+#define MPU_6050_CALIBRATION_MAX_FAILURES  10
+
+// Temperature in degrees C is raw / 340 + 36.53
+#define MPU_6050_TEMP_SENSITIVITY   340.0
+#define MPU_6050_TEMP_OFFSET        36.53
+
 // Expected value in the who_am_i register of MPU_6050; used to validate I2C connections
 #define MPU_6050_EXPECTED_ID   0x68
 
@@ -40,6 +51,7 @@ typedef enum {
     MPU_6050_RC_ERROR_NULL_INST = -1,
     MPU_6050_RC_ERROR_BAD_ID = -2,
     MPU_6050_RC_ERROR_INVALID_ARG = -3,
+    MPU_6050_RC_ERROR_I2C = -4,
 } mpu_6050_rc_t;
 
 typedef struct {
@@ -87,9 +99,11 @@ typedef struct {
 
     vec_int16_t accel_raw;
     vec_int16_t gyro_raw;
+    int16_t temp_raw;
     double dt;
     vec_double_t accel_data;
     vec_double_t gyro_data;
+    double temp_data;
     mpu_6050_offsets_t offsets;
 } mpu_6050_t;
 
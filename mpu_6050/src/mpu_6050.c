@@ -151,12 +151,14 @@ mpu_6050_rc_t mpu_6050_reset(mpu_6050_t* mpu_6050) {
         return MPU_6050_RC_ERROR_BAD_ID;
     }
 
-    // Reset accel and gyro readings data
+    // Reset accel, temperature and gyro readings data
     clear_int16_vector(&mpu_6050->accel_raw);
     clear_int16_vector(&mpu_6050->gyro_raw);
+    mpu_6050->temp_raw = 0;
     mpu_6050->dt = 0;
     clear_double_vector(&mpu_6050->accel_data);
     clear_double_vector(&mpu_6050->gyro_data);
+    mpu_6050->temp_data = 0;
     clear_double_vector(&mpu_6050->offsets.accel_offsets);
     clear_double_vector(&mpu_6050->offsets.gyro_offsets);
 
@@ -191,6 +193,8 @@ mpu_6050_rc_t mpu_6050_reset(mpu_6050_t* mpu_6050) {
 
 // Calibrate the MPU-6050 by calculating offsets for roll, pitch, and gyro z
 // MPU-6050 must be in a fixed position during calibration!
+// A failed read is retried rather than averaged in; gives up with MPU_6050_RC_ERROR_I2C and no offsets after
+// MPU_6050_CALIBRATION_MAX_FAILURES failed reads in a row
 mpu_6050_rc_t mpu_6050_calibrate(mpu_6050_t* mpu_6050, uint32_t samples) {
     // Check if the pointer is valid
     if(!mpu_6050) {
@@ -211,8 +215,17 @@ mpu_6050_rc_t mpu_6050_calibrate(mpu_6050_t* mpu_6050, uint32_t samples) {
     vec_double_t gyro_offsets = {0.0, 0.0, 0.0};
 
     // Calculate offsets by taking the average of repeated samples
-    for(uint32_t i=0; i<samples; ++i) {
-        mpu_6050_read_raw(mpu_6050);
+    uint32_t failures = 0;
+    for(uint32_t i=0; i<samples; ) {
+        // Only average in fresh samples, a failed read leaves the last one in place
+        if(mpu_6050_read_raw(mpu_6050) != MPU_6050_RC_OK) {
+            if(++failures >= MPU_6050_CALIBRATION_MAX_FAILURES) {
+                return MPU_6050_RC_ERROR_I2C;
+            }
+            sleep_ms(1);
+            continue;
+        }
+        failures = 0;
         mpu_6050_convert_read(mpu_6050);
 
         accel_offsets.x += mpu_6050->accel_data.x / (double)samples;
@@ -223,6 +236,7 @@ mpu_6050_rc_t mpu_6050_calibrate(mpu_6050_t* mpu_6050, uint32_t samples) {
         gyro_offsets.y += mpu_6050->gyro_data.y / (double)samples;
         gyro_offsets.z += mpu_6050->gyro_data.z / (double)samples;
 
+        ++i;
         sleep_ms(1);
     }
 
@@ -234,7 +248,8 @@ mpu_6050_rc_t mpu_6050_calibrate(mpu_6050_t* mpu_6050, uint32_t samples) {
     return MPU_6050_RC_OK;
 }
 
-// Read raw accelerometer and gyro data from the MPU-6050
+// Read raw accelerometer, temperature and gyro data from the MPU-6050
+// All three are read in one burst, during which the MPU-6050 holds its data registers, so they are from the same sample
 mpu_6050_rc_t mpu_6050_read_raw(mpu_6050_t* mpu_6050) {
     // Check if the pointer is valid
     if(!mpu_6050) {
@@ -245,13 +260,14 @@ mpu_6050_rc_t mpu_6050_read_raw(mpu_6050_t* mpu_6050) {
         return MPU_6050_RC_ERROR_BAD_ID;
     }
     
-    // int16_t, so 2 bytes per axis
-    uint8_t accel_regs[6];
-    uint8_t gyro_regs[6];
+    // int16_t, so 2 bytes per axis and for the temperature
+    uint8_t sample_regs[MPU_6050_SAMPLE_LENGTH];
 
-    // Accel and gyro data is contiguous from XOUT_H to ZOUT_L
-    i2c_read_regs(mpu_6050->i2c_inst, MPU_6050_ADDR, MPU_6050_ACCEL_XOUT_H, accel_regs, 6);
-    i2c_read_regs(mpu_6050->i2c_inst, MPU_6050_ADDR, MPU_6050_GYRO_XOUT_H, gyro_regs, 6);
+    // Accel, temperature and gyro data is contiguous from ACCEL_XOUT_H to GYRO_ZOUT_L, so read it in a single transaction
+    // Leave the last sample in place if the read fails, rather than mixing in a partial one
+    if(i2c_read_regs(mpu_6050->i2c_inst, MPU_6050_ADDR, MPU_6050_ACCEL_XOUT_H, sample_regs, MPU_6050_SAMPLE_LENGTH) != I2C_GENERAL_RC_OK) {
+        return MPU_6050_RC_ERROR_I2C;
+    }
 
     // Keep track of the time of last read using a static variable
     static double t_prev = -1.0;
@@ -266,10 +282,16 @@ mpu_6050_rc_t mpu_6050_read_raw(mpu_6050_t* mpu_6050) {
     t_prev = t_curr;
 
     // Combine high and low bytes into int16_t values for each axis
+    const uint8_t * accel_regs = &sample_regs[0];
+    const uint8_t * temp_regs = &sample_regs[MPU_6050_TEMP_OUT_H - MPU_6050_ACCEL_XOUT_H];
+    const uint8_t * gyro_regs = &sample_regs[MPU_6050_GYRO_XOUT_H - MPU_6050_ACCEL_XOUT_H];
+
     mpu_6050->accel_raw.x = (int16_t)((accel_regs[0] << 8) | accel_regs[1]);
     mpu_6050->accel_raw.y = (int16_t)((accel_regs[2] << 8) | accel_regs[3]);
     mpu_6050->accel_raw.z = (int16_t)((accel_regs[4] << 8) | accel_regs[5]);
 
+    mpu_6050->temp_raw = (int16_t)((temp_regs[0] << 8) | temp_regs[1]);
+
     mpu_6050->gyro_raw.x = (int16_t)((gyro_regs[0] << 8) | gyro_regs[1]);
     mpu_6050->gyro_raw.y = (int16_t)((gyro_regs[2] << 8) | gyro_regs[3]);
     mpu_6050->gyro_raw.z = (int16_t)((gyro_regs[4] << 8) | gyro_regs[5]);
@@ -277,7 +299,7 @@ mpu_6050_rc_t mpu_6050_read_raw(mpu_6050_t* mpu_6050) {
     return MPU_6050_RC_OK;
 }
 
-// Convert raw accelerometer and gyro data to meaningful units (dependent on configured accelerometer and gyro ranges)
+// Convert raw accelerometer, temperature and gyro data to meaningful units (dependent on configured accelerometer and gyro ranges)
 mpu_6050_rc_t mpu_6050_convert_read(mpu_6050_t* mpu_6050) {
     // Check if the pointer is valid
     if(!mpu_6050) {
@@ -302,5 +324,8 @@ mpu_6050_rc_t mpu_6050_convert_read(mpu_6050_t* mpu_6050) {
     mpu_6050->gyro_data.y = mpu_6050->gyro_raw.y / gyro_conversion_factor - mpu_6050->offsets.gyro_offsets.y;
     mpu_6050->gyro_data.z = mpu_6050->gyro_raw.z / gyro_conversion_factor - mpu_6050->offsets.gyro_offsets.z;
 
+    // Convert raw temperature data to degrees C, which doesn't depend on any configured range
+    mpu_6050->temp_data = mpu_6050->temp_raw / MPU_6050_TEMP_SENSITIVITY + MPU_6050_TEMP_OFFSET;
+
     return MPU_6050_RC_OK;
 }
\ No newline at end of file
@@ -108,14 +108,25 @@ int main() {
 
     printf("calibrate mpu\n");
 
-    mpu_6050_calibrate(&mpu_6050, SAMPLES_CALIBRATION);
+    // Repeatedly try to calibrate until the bus recovers
+    rc = mpu_6050_calibrate(&mpu_6050, SAMPLES_CALIBRATION);
+    while(rc != MPU_6050_RC_OK)
+    {
+        printf("rc = %d, calibration failed\n", rc);
+        sleep_ms(1000);
+        rc = mpu_6050_calibrate(&mpu_6050, SAMPLES_CALIBRATION);
+    }
 
     vec_double_t angles = {0.0, 0.0, 0.0};
     while (1) {
         // Better to just do this on its own, commenting out everything else
         //estimate_noise(&mpu_6050);
         
-        mpu_6050_read_raw(&mpu_6050);
+        // Skip a failed read rather than estimate from the last sample again
+        if(mpu_6050_read_raw(&mpu_6050) != MPU_6050_RC_OK) {
+            sleep_ms(10);
+            continue;
+        }
         mpu_6050_convert_read(&mpu_6050);
 
         // Put data readings through a filter?